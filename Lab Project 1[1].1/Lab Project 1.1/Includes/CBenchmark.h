@@ -0,0 +1,48 @@
+//-----------------------------------------------------------------------------
+// File: CBenchmark.h
+//
+// Desc: Micro-benchmarks for the software pipeline, run instead of the demo
+//       when the application is started with the '-bench' switch.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CBENCHMARK_H_
+#define _CBENCHMARK_H_
+
+//-----------------------------------------------------------------------------
+// CBenchmark Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+#include "CObject.h"
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CBenchmark (Class)
+// Desc : Times each stage of the pipeline in isolation, writing the results
+//        to a text file (and to stdout when one is attached).
+//-----------------------------------------------------------------------------
+class CBenchmark
+{
+public:
+	//-------------------------------------------------------------------------
+	// Public Static Functions for This Class
+	//-------------------------------------------------------------------------
+    static bool     Run             ( LPCTSTR strFileName );
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Static Functions for This Class
+	//-------------------------------------------------------------------------
+    static double   GetTime         ( );
+    static void     Report          ( FILE * pFile, const char * strFormat, ... );
+    static bool     BuildTestMesh   ( CMesh & Mesh, ULONG QuadsX, ULONG QuadsY );
+    static void     BenchMeshBuild  ( FILE * pFile );
+    static void     BenchTransform  ( FILE * pFile );
+    static void     BenchTexture    ( FILE * pFile );
+    static void     BenchHiZ        ( FILE * pFile );
+};
+
+#endif // _CBENCHMARK_H_
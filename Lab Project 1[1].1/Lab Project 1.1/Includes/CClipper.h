@@ -0,0 +1,91 @@
+//-----------------------------------------------------------------------------
+// File: CClipper.h
+//
+// Desc: Homogeneous clip space polygon clipper. Faces are classified using
+//       the per vertex clip codes generated by the vertex cache, and only
+//       those crossing the near plane or the guard band are clipped (using
+//       Sutherland-Hodgman) before the perspective divide.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CCLIPPER_H_
+#define _CCLIPPER_H_
+
+//-----------------------------------------------------------------------------
+// CClipper Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+#include "CVertexCache.h"
+#include "CRasterizer.h"
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Main Structure Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CLIPVERTEX (Structure)
+// Desc : Clip space (pre perspective divide) vertex.
+//-----------------------------------------------------------------------------
+struct CLIPVERTEX
+{
+    float       x;
+    float       y;
+    float       z;
+    float       w;
+    float       u;          // Texture coordinates
+    float       v;
+};
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CClipper (Class)
+// Desc : Produces the screen space outline of a face, clipped where required.
+// Note : Uses the guard band and viewport of the vertex cache supplied.
+//-----------------------------------------------------------------------------
+class CClipper
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+	         CClipper();
+	virtual ~CClipper();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    ULONG           ClipPolygon     ( const CVertexCache & Cache, const ULONG * pIndices, ULONG Count,
+                                      RASTERVERTEX ** ppVertices, const D3DXVECTOR2 * pTexCoords = NULL );
+    void            ResetStats      ( );
+
+	//-------------------------------------------------------------------------
+	// Public Variables for This Class
+	//-------------------------------------------------------------------------
+    ULONG           m_nAccepted;        // Faces trivially accepted since ResetStats
+    ULONG           m_nRejected;        // Faces trivially rejected since ResetStats
+    ULONG           m_nClipped;         // Faces passed through the clipper since ResetStats
+
+private:
+    //-------------------------------------------------------------------------
+	// Private Type Definitions
+	//-------------------------------------------------------------------------
+    typedef std::vector<CLIPVERTEX>     VectorClipVertex;
+    typedef std::vector<RASTERVERTEX>   VectorRasterVertex;
+
+	//-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+    void            ClipToPlane     ( const VectorClipVertex & In, VectorClipVertex & Out,
+                                      const float Plane[4] );
+
+	//-------------------------------------------------------------------------
+	// Private Variables for This Class
+	//-------------------------------------------------------------------------
+    VectorClipVertex    m_Clip[2];      // Ping-pong buffers used while clipping
+    VectorRasterVertex  m_Output;       // Final screen space outline
+};
+
+#endif // _CCLIPPER_H_
@@ -0,0 +1,72 @@
+//-----------------------------------------------------------------------------
+// File: CCpuInfo.h
+//
+// Desc: Processor feature detection, used to select between the scalar and
+//       SIMD (SSE / AVX) code paths at runtime.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CCPUINFO_H_
+#define _CCPUINFO_H_
+
+//-----------------------------------------------------------------------------
+// CCpuInfo Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+// AVX intrinsics require Visual C++ 2010 or later, GCC / Clang always have them
+#if !defined(_MSC_VER) || (_MSC_VER >= 1600)
+#define SIMD_AVX_SUPPORTED
+#include <immintrin.h>
+#endif
+
+// GCC / Clang need each function using AVX instructions to be tagged, since
+// the remainder of the module is compiled for the baseline instruction set.
+#if defined(_MSC_VER)
+#define SIMD_TARGET_AVX
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_AVX     __attribute__((target("avx")))
+#define SIMD_TARGET_AVX2    __attribute__((target("avx2,fma")))
+#endif
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CCpuInfo (Class)
+// Desc : Queries (once) and reports the SIMD instruction sets supported by
+//        both the processor and the operating system.
+//-----------------------------------------------------------------------------
+class CCpuInfo
+{
+public:
+	//-------------------------------------------------------------------------
+	// Public Static Functions for This Class
+	//-------------------------------------------------------------------------
+    static bool     HasSSE2     ( );
+    static bool     HasAVX      ( );
+    static bool     HasAVX2     ( );
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Static Functions for This Class
+	//-------------------------------------------------------------------------
+    static void     Detect      ( );
+
+	//-------------------------------------------------------------------------
+	// Private Static Variables for This Class
+	//-------------------------------------------------------------------------
+    static bool     m_bDetected;        // Has detection been run?
+    static bool     m_bSSE2;            // SSE2 available
+    static bool     m_bAVX;             // AVX available (including OS support)
+    static bool     m_bAVX2;            // AVX2 + FMA available (including OS support)
+};
+
+#endif // _CCPUINFO_H_
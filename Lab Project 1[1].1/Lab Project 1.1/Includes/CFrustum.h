@@ -0,0 +1,50 @@
+//-----------------------------------------------------------------------------
+// File: CFrustum.h
+//
+// Desc: View frustum class, used to cull bounding volumes that can not be
+//       seen before any of their geometry is processed.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CFRUSTUM_H_
+#define _CFRUSTUM_H_
+
+//-----------------------------------------------------------------------------
+// CFrustum Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CFrustum (Class)
+// Desc : Stores the six planes of a view frustum, extracted from a combined
+//        matrix. Plane normals face out of the frustum.
+// Note : Planes extracted from view * projection are in world space, planes
+//        extracted from world * view * projection are in that object's space.
+//-----------------------------------------------------------------------------
+class CFrustum
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+	         CFrustum();
+	         CFrustum( const D3DXMATRIX & mtx );
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    void        CalcFrustumPlanes   ( const D3DXMATRIX & mtx );
+    bool        SphereInFrustum     ( const D3DXVECTOR3 & Centre, float Radius ) const;
+    bool        BoundsInFrustum     ( const D3DXVECTOR3 & Min, const D3DXVECTOR3 & Max ) const;
+
+	//-------------------------------------------------------------------------
+	// Public Variables for This Class
+	//-------------------------------------------------------------------------
+    D3DXPLANE   m_Planes[6];        // Left, Right, Top, Bottom, Near, Far
+};
+
+#endif // _CFRUSTUM_H_
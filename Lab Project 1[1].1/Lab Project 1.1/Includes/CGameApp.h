@@ -15,6 +15,30 @@
 #include "Main.h"
 #include "CTimer.h"
 #include "CObject.h"
+#include "CRasterizer.h"
+#include "CThreadPool.h"
+#include "CVertexCache.h"
+#include "CClipper.h"
+#include "CFrustum.h"
+#include "CTexture.h"
+#include "CHiZBuffer.h"
+#include "CPresentQueue.h"
+#include <vector>
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const float GUARD_BAND          = 2.0f;     // Guard band extents (1.0 = the viewport edges)
+const float OCCLUDER_MIN_AREA   = 0.02f;    // Screen area (fraction of the viewport) needed to act as an occluder
+const ULONG DEFAULT_OBJECT_COUNT= 2;        // Objects created unless '-objects N' is specified
+const ULONG MAX_OBJECT_COUNT    = 1000000;  // Upper limit on the number of objects
+const ULONG OBJECT_BATCH_SIZE   = 256;      // Objects processed by each worker pool job
+const ULONG DEFAULT_PRESENT_LATENCY = 2;    // Frames queued for the present thread unless '-latency N' is specified
+const ULONG DEFAULT_HEADLESS_WIDTH  = 640;  // Headless frame buffer size unless '-width N' / '-height N' is specified
+const ULONG DEFAULT_HEADLESS_HEIGHT = 480;
+const ULONG DEFAULT_HEADLESS_FRAMES = 300;  // Frames rendered by a headless run unless '-frames N' is specified
+const float HEADLESS_TIME_STEP      = 1.0f / 60.0f; // Fixed animation step, so headless output is repeatable
 
 //-----------------------------------------------------------------------------
 // Main Class Declarations
@@ -26,6 +50,17 @@
 class CGameApp
 {
 public:
+    //-------------------------------------------------------------------------
+    // Enumerators
+    //-------------------------------------------------------------------------
+    enum RENDER_MODE {
+        RENDER_WIREFRAME    = 1,
+        RENDER_FLAT         = 2,
+        RENDER_TEXTURED     = 3,
+
+        RENDER_FORCE_32BIT  = 0x7FFFFFFF
+    };
+
     //-------------------------------------------------------------------------
 	// Constructors & Destructors for This Class.
 	//-------------------------------------------------------------------------
@@ -35,7 +70,9 @@ public:
 	//-------------------------------------------------------------------------
 	// Public Functions for This Class
 	//-------------------------------------------------------------------------
+#ifdef _WIN32
     LRESULT     DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM lParam );
+#endif
 	bool        InitInstance( HANDLE hInstance, LPCTSTR lpCmdLine, int iCmdShow );
     int         BeginGame( );
 	bool        ShutDown( );
@@ -47,18 +84,62 @@ private:
     bool        BuildObjects( );
     void        FrameAdvance( );
     bool        CreateDisplay( );
+    bool        CreateHeadless( );
+    int         RunHeadless( );
+    bool        WriteResults( LPCTSTR strFileName, const std::vector<double> & FrameTimes );
+    bool        WriteFrame( LPCTSTR strFileName, const ULONG * pBuffer, ULONG Width, ULONG Height, ULONG Pitch );
     void        SetupGameState( );
     void        AnimateObjects( );
+    void        AnimateBatch( ULONG Batch );
+    void        CullBatch( ULONG Batch, ULONG ThreadIndex );
+    void        DrawBatch( ULONG Batch, ULONG ThreadIndex );
     void        PresentFrameBuffer( );
+    void        PresentBuffer( const ULONG * pBuffer, ULONG Width, ULONG Height, ULONG Pitch );
     void        ClearFrameBuffer( ULONG Color );
     bool        BuildFrameBuffer( ULONG Width, ULONG Height );
-    void        DrawPrimitive( CPolygon * pPoly, D3DXMATRIX * pmtxWorld );
-    void        DrawLine( const D3DXVECTOR3 & vtx1, const D3DXVECTOR3 & vtx2, ULONG Color );
+    void        DrawPrimitive( CMesh * pMesh, ULONG Face, D3DXMATRIX * pmtxWorld, ULONG ThreadIndex );
+    bool        ObjectInFrustum( const CObject * pObject );
+    bool        GetScreenBounds( const CMesh * pMesh, const D3DXMATRIX & mtxWVP, float & MinX, float & MinY,
+                                 float & MaxX, float & MaxY, float & NearZ, ULONG ThreadIndex );
+    void        DrawObject( CObject * pObject, const D3DXMATRIX & mtxWV, const D3DXMATRIX & mtxWVP, ULONG ThreadIndex );
+
+    //-------------------------------------------------------------------------
+	// Private Structures For This Class
+	//-------------------------------------------------------------------------
+    struct VisibleObject
+    {
+        CObject   * pObject;            // Object that passed the frustum tests
+        D3DXMATRIX  mtxWV;              // World * View
+        D3DXMATRIX  mtxWVP;             // World * View * Projection
+        float       MinX, MinY;         // Screen space bounding rectangle
+        float       MaxX, MaxY;
+        float       NearZ;              // Nearest depth of the bounding box
+        bool        bVisible;           // Passed the frustum tests this frame
+        bool        bOccluder;          // Drawn before the occlusion buffer is built
+    };
+
+    struct WorkerData
+    {
+        CVertexCache VertexCache;       // Transformed positions of the mesh being drawn
+        CClipper    Clipper;            // Near plane / guard band clipper
+        ULONG       nOccluded;          // Objects rejected by the occlusion test this frame
+    };
+
+    typedef std::vector<CObject>        VectorObject;
+    typedef std::vector<VisibleObject>  VectorVisibleObject;
+    typedef std::vector<VisibleObject*> VectorVisiblePtr;
 
     //-------------------------------------------------------------------------
 	// Private Static Functions For This Class
 	//-------------------------------------------------------------------------
+#ifdef _WIN32
     static LRESULT CALLBACK StaticWndProc(HWND hWnd, UINT Message, WPARAM wParam, LPARAM lParam);
+#endif
+    static bool CompareNearZ( const VisibleObject * a, const VisibleObject * b ) { return a->NearZ < b->NearZ; }
+    static void AnimateJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex );
+    static void CullJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex );
+    static void DrawJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex );
+    static void StaticPresent( void * pContext, const ULONG * pBuffer, ULONG Width, ULONG Height, ULONG Pitch );
 
     //-------------------------------------------------------------------------
 	// Private Variables For This Class
@@ -67,14 +148,41 @@ private:
     D3DXMATRIX  m_mtxProjection;    // Projection matrix
 
     CMesh       m_Mesh;             // Mesh to be rendered
-    CObject     m_pObject[2];       // Objects storing mesh instances
+    VectorObject m_Objects;         // Objects storing mesh instances (all sharing m_Mesh)
+    ULONG       m_nObjectCount;     // Number of objects requested on the command line
+    WorkerData *m_pWorkers;         // Per thread transform / clipping state
+    ULONG       m_nWorkerCount;     // Number of entries in m_pWorkers (one per pool thread)
+    CFrustum    m_Frustum;          // World space view frustum (updated each frame)
+    CTexture    m_Texture;          // Texture applied in textured mode
+    bool        m_bCullBackFaces;   // Back face culling enabled / disabled
+    bool        m_bBilinear;        // Bilinear texture filtering enabled / disabled
+    bool        m_bOcclusionCull;   // Hierarchical depth occlusion culling enabled / disabled
+    CHiZBuffer  m_HiZBuffer;        // Depth pyramid built from the occluders each frame
+    VectorVisibleObject m_VisibleObjects; // Per object frustum test results this frame
+    VectorVisiblePtr m_Occluders;   // Visible objects drawn before the occlusion buffer is built
+    VectorVisiblePtr m_DrawList;    // Remaining visible objects
+    const VectorVisiblePtr * m_pDrawList; // List being processed by DrawJob
+    bool        m_bTestOcclusion;   // DrawJob should test against the occlusion buffer
+    ULONG       m_nVisibleCount;    // Number of objects surviving the frustum tests last frame
+    ULONG       m_nOccludedCount;   // Number of objects rejected by the occlusion test last frame
     
     CTimer      m_Timer;            // Game timer
+    ULONG       m_LastFrameRate;    // Used for making sure we update only when fps changes.
     
     HWND        m_hWnd;             // Main window HWND
-    HDC         m_hdcFrameBuffer;   // Frame Buffers Device Context
-    HBITMAP     m_hbmFrameBuffer;   // Frame buffers Bitmap
-    HBITMAP     m_hbmSelectOut;     // Used for selecting out of the DC
+    CRasterizer m_Rasterizer;       // Software rasterizer (owns the depth buffer)
+    CPresentQueue m_PresentQueue;   // Color buffers being drawn / waiting to be presented
+    ULONG       m_nPresentLatency;  // Frames which may be queued ahead of the one being presented
+    CThreadPool m_ThreadPool;       // Worker threads used for object processing & tile rasterization
+    RENDER_MODE m_RenderMode;       // Wireframe, flat shaded or textured output
+
+    bool        m_bHeadless;        // Rendering to memory only, with no window (see RunHeadless)
+    ULONG       m_nFrameCount;      // Number of frames rendered by a headless run
+    ULONG       m_nSeed;            // Seed used to scatter the additional objects
+    std::vector<ULONG> m_DumpFrames;// Headless frames to be written out as images (sorted)
+    ULONG       m_nPresentFrame;    // Number of frames presented so far
+    float       m_fTimeStep;        // Animation time step for the current frame (Seconds)
+    bool        m_bFrameStats;      // Write the timer's frame statistics out at shut down
 
     bool        m_bRotation1;       // Object 1 rotation enabled / disabled 
     bool        m_bRotation2;       // Object 2 rotation enabled / disabled 
@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+// File: CHiZBuffer.h
+//
+// Desc: Hierarchical depth buffer used for occlusion culling. A pyramid of
+//       minimum / maximum depth values is built from the rasterizer's depth
+//       buffer, and screen space rectangles can then be tested against it
+//       using only a handful of reads.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CHIZBUFFER_H_
+#define _CHIZBUFFER_H_
+
+//-----------------------------------------------------------------------------
+// CHiZBuffer Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+#include "CThreadPool.h"
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const ULONG HIZ_CELL_SIZE       = 8;        // Pixels covered by each level 0 cell (on each axis)
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CHiZBuffer (Class)
+// Desc : Stores the minimum and maximum depth of each cell at every level of
+//        the pyramid. Level 0 cells cover HIZ_CELL_SIZE square pixels, and
+//        each level above covers 2x2 cells of the level below.
+//-----------------------------------------------------------------------------
+class CHiZBuffer
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+	         CHiZBuffer();
+	virtual ~CHiZBuffer();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    bool            Build           ( const float * pDepth, ULONG Width, ULONG Height, ULONG Pitch );
+    bool            IsVisible       ( float MinX, float MinY, float MaxX, float MaxY, float NearZ ) const;
+    void            SetThreadPool   ( CThreadPool * pThreadPool ) { m_pThreadPool = pThreadPool; }
+    void            Release         ( );
+
+    ULONG           GetLevelCount   ( ) const { return (ULONG)m_Levels.size(); }
+    ULONG           GetLevelWidth   ( ULONG Level ) const { return m_Levels[Level].Width; }
+    ULONG           GetLevelHeight  ( ULONG Level ) const { return m_Levels[Level].Height; }
+    float           GetMinDepth     ( ULONG Level, ULONG x, ULONG y ) const { return m_Levels[Level].pMin[ y * m_Levels[Level].Width + x ]; }
+    float           GetMaxDepth     ( ULONG Level, ULONG x, ULONG y ) const { return m_Levels[Level].pMax[ y * m_Levels[Level].Width + x ]; }
+
+private:
+    //-------------------------------------------------------------------------
+	// Private Structures For This Class
+	//-------------------------------------------------------------------------
+    struct Level
+    {
+        ULONG           Width;          // Number of cells horizontally
+        ULONG           Height;         // Number of cells vertically
+        float         * pMin;           // Nearest depth within each cell
+        float         * pMax;           // Furthest depth within each cell
+    };
+
+    typedef std::vector<Level> VectorLevel;
+
+    //-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+    bool            Allocate        ( ULONG Width, ULONG Height );
+    void            BuildRow        ( ULONG Row );
+
+    //-------------------------------------------------------------------------
+	// Private Static Functions For This Class
+	//-------------------------------------------------------------------------
+    static void     BuildJob        ( void * pContext, ULONG JobIndex, ULONG ThreadIndex );
+
+    //-------------------------------------------------------------------------
+	// Private Variables For This Class
+	//-------------------------------------------------------------------------
+    ULONG           m_nWidth;           // Size of the depth buffer the pyramid was built from
+    ULONG           m_nHeight;
+    VectorLevel     m_Levels;           // Pyramid levels, finest first
+
+    const float   * m_pSource;          // Depth buffer being read (during Build only)
+    ULONG           m_nSourcePitch;     // Distance between depth buffer rows, in pixels
+
+    CThreadPool   * m_pThreadPool;      // Pool used to build level 0 (may be NULL)
+};
+
+#endif // _CHIZBUFFER_H_
@@ -1,118 +1,192 @@
-//-----------------------------------------------------------------------------
-// File: CObject.h
-//
-// Desc: This file houses the various object / mesh related classes.
-//
-// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
-//-----------------------------------------------------------------------------
-
-#ifndef _COBJECT_H_
-#define _COBJECT_H_
-
-//-----------------------------------------------------------------------------
-// CObject Specific Includes
-//-----------------------------------------------------------------------------
-#include "Main.h"
-
-//-----------------------------------------------------------------------------
-// Main Class Declarations
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-// Name : CVertex (Class)
-// Desc : Vertex class used to construct & store vertex components.
-//-----------------------------------------------------------------------------
-class CVertex
-{
-public:
-    //-------------------------------------------------------------------------
-    // Constructors & Destructors for This Class.
-    //-------------------------------------------------------------------------
-    CVertex( float fX, float fY, float fZ ) { x = fX; y = fY; z = fZ; }
-    CVertex() { x = 0.0f; y = 0.0f; z = 0.0f; }
-
-    //-------------------------------------------------------------------------
-    // Public Variables for This Class
-    //-------------------------------------------------------------------------
-    float       x;          // Vertex Position X Component
-    float       y;          // Vertex Position Y Component
-    float       z;          // Vertex Position Z Component
-    
-};
-
-//-----------------------------------------------------------------------------
-// Name : CPolygon (Class)
-// Desc : Basic polygon class used to store this polygons vertex data.
-//-----------------------------------------------------------------------------
-class CPolygon
-{
-public:
-    //-------------------------------------------------------------------------
-	// Constructors & Destructors for This Class.
-	//-------------------------------------------------------------------------
-             CPolygon( USHORT VertexCount );
-	         CPolygon();
-	virtual ~CPolygon();
-
-	//-------------------------------------------------------------------------
-	// Public Functions for This Class
-	//-------------------------------------------------------------------------
-    long        AddVertex( USHORT Count = 1 );
-
-    //-------------------------------------------------------------------------
-	// Public Variables for This Class
-	//-------------------------------------------------------------------------
-    USHORT      m_nVertexCount;         // Number of vertices stored.
-    CVertex    *m_pVertex;              // Simple vertex array
-
-};
-
-//-----------------------------------------------------------------------------
-// Name : CMesh (Class)
-// Desc : Basic mesh class used to store individual mesh data.
-//-----------------------------------------------------------------------------
-class CMesh
-{
-public:
-    //-------------------------------------------------------------------------
-	// Constructors & Destructors for This Class.
-	//-------------------------------------------------------------------------
-             CMesh( ULONG Count );
-	         CMesh();
-	virtual ~CMesh();
-
-	//-------------------------------------------------------------------------
-	// Public Functions for This Class
-	//-------------------------------------------------------------------------
-    long        AddPolygon( ULONG Count = 1 );
-
-    //-------------------------------------------------------------------------
-	// Public Variables for This Class
-	//-------------------------------------------------------------------------
-    ULONG       m_nPolygonCount;        // Number of polygons stored
-    CPolygon  **m_pPolygon;             // Simply polygon array.
-
-};
-
-//-----------------------------------------------------------------------------
-// Name : CObject (Class)
-// Desc : Mesh container class used to store instances of meshes.
-//-----------------------------------------------------------------------------
-class CObject
-{
-public:
-    //-------------------------------------------------------------------------
-	// Constructors & Destructors for This Class.
-	//-------------------------------------------------------------------------
-     CObject( CMesh * pMesh );
-	 CObject();
-
-	//-------------------------------------------------------------------------
-	// Public Variables for This Class
-	//-------------------------------------------------------------------------
-    D3DXMATRIX  m_mtxWorld;             // Objects world matrix
-    CMesh      *m_pMesh;                // Mesh we are instancing
-
-};
-
-
+//-----------------------------------------------------------------------------
+// File: CObject.h
+//
+// Desc: This file houses the various object / mesh related classes.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _COBJECT_H_
+#define _COBJECT_H_
+
+//-----------------------------------------------------------------------------
+// CObject Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CVertex (Class)
+// Desc : Vertex class used to construct & store vertex components.
+//-----------------------------------------------------------------------------
+class CVertex
+{
+public:
+    //-------------------------------------------------------------------------
+    // Constructors & Destructors for This Class.
+    //-------------------------------------------------------------------------
+    CVertex( float fX, float fY, float fZ, float fU = 0.0f, float fV = 0.0f ) { x = fX; y = fY; z = fZ; tu = fU; tv = fV; }
+    CVertex() { x = 0.0f; y = 0.0f; z = 0.0f; tu = 0.0f; tv = 0.0f; }
+
+    //-------------------------------------------------------------------------
+    // Public Variables for This Class
+    //-------------------------------------------------------------------------
+    float       x;          // Vertex Position X Component
+    float       y;          // Vertex Position Y Component
+    float       z;          // Vertex Position Z Component
+    float       tu;         // Texture Coordinate U Component
+    float       tv;         // Texture Coordinate V Component
+    
+};
+
+//-----------------------------------------------------------------------------
+// Name : MESHFACE (Support Structure)
+// Desc : Describes a single face within a mesh's index buffer, along with
+//        the (object space) plane in which it lies.
+//-----------------------------------------------------------------------------
+struct MESHFACE
+{
+    ULONG       FirstIndex;             // Offset of the face's first index
+    ULONG       IndexCount;             // Number of indices (vertices) in the face
+    D3DXVECTOR3 Normal;                 // Unit length face normal (front facing side)
+    float       Distance;               // Plane distance, Dot( Normal, P ) + Distance = 0
+};
+
+//-----------------------------------------------------------------------------
+// Name : CPolygon (Class)
+// Desc : Basic polygon class used to store this polygons vertex data.
+// Note : Only used to stage geometry while building a mesh, see CMesh::Commit.
+//-----------------------------------------------------------------------------
+class CPolygon
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+             CPolygon( USHORT VertexCount );
+	         CPolygon();
+	virtual ~CPolygon();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    long        AddVertex( USHORT Count = 1 );
+
+    //-------------------------------------------------------------------------
+	// Public Variables for This Class
+	//-------------------------------------------------------------------------
+    USHORT      m_nVertexCount;         // Number of vertices stored.
+    CVertex    *m_pVertex;              // Simple vertex array
+
+private:
+    //-------------------------------------------------------------------------
+	// Private Variables for This Class
+	//-------------------------------------------------------------------------
+    USHORT      m_nVertexCapacity;      // Number of vertices allocated.
+
+};
+
+//-----------------------------------------------------------------------------
+// Name : CMesh (Class)
+// Desc : Basic mesh class used to store individual mesh data. Geometry lives
+//        in one contiguous vertex pool, one index buffer, and a face table
+//        giving each face's offset and count within that index buffer.
+// Note : Texture coordinates belong to the face corner rather than to the
+//        position, so they are stored alongside the index buffer. This keeps
+//        the pool welded (a cube still has 8 positions to transform).
+//-----------------------------------------------------------------------------
+class CMesh
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+             CMesh( ULONG Count );
+	         CMesh();
+	virtual ~CMesh();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    bool        Reserve( ULONG VertexCount, ULONG IndexCount, ULONG FaceCount );
+    long        AddVertices( const CVertex * pVertices, ULONG Count );
+    long        AddFace( const ULONG * pIndices, ULONG Count, const D3DXVECTOR2 * pTexCoords = NULL );
+    long        AddFaces( const ULONG * pIndices, ULONG FaceCount, ULONG VerticesPerFace, const D3DXVECTOR2 * pTexCoords = NULL );
+    void        Release( );
+
+    // Polygon staging interface
+    long        AddPolygon( ULONG Count = 1 );
+    bool        Commit( );
+
+    //-------------------------------------------------------------------------
+	// Public Variables for This Class
+	//-------------------------------------------------------------------------
+    ULONG       m_nPositionCount;       // Number of vertices in the pool
+    float      *m_pPositionX;           // Vertex pool in structure of arrays form,
+    float      *m_pPositionY;           // 32 byte aligned and padded with zeros to a
+    float      *m_pPositionZ;           // multiple of 8 (for the SIMD transforms).
+
+    ULONG       m_nIndexCount;          // Number of indices stored
+    ULONG      *m_pIndex;               // Index buffer, referencing the vertex pool
+    D3DXVECTOR2*m_pTexCoord;            // Texture coordinates, one per index
+
+    ULONG       m_nFaceCount;           // Number of faces stored
+    MESHFACE   *m_pFace;                // Face table, referencing the index buffer
+
+    ULONG       m_nPolygonCount;        // Number of polygons staged (until Commit)
+    CPolygon  **m_pPolygon;             // Simply polygon array.
+
+    D3DXVECTOR3 m_BoundsMin;            // Bounding box minimum extents
+    D3DXVECTOR3 m_BoundsMax;            // Bounding box maximum extents
+    D3DXVECTOR3 m_BoundsCentre;         // Bounding sphere centre
+    float       m_fBoundsRadius;        // Bounding sphere radius
+
+private:
+    //-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+    bool        ReservePositions( ULONG Count );
+    bool        ReserveIndices  ( ULONG Count );
+    bool        ReserveFaces    ( ULONG Count );
+    void        ReleasePolygons ( );
+    void        ResetBounds     ( );
+    void        UpdateBounds    ( ULONG FirstVertex, ULONG Count );
+    void        CalcFacePlanes  ( ULONG FirstFace, ULONG Count );
+
+    //-------------------------------------------------------------------------
+	// Private Variables for This Class
+	//-------------------------------------------------------------------------
+    ULONG       m_nPositionCapacity;    // Allocated sizes, each array grows
+    ULONG       m_nIndexCapacity;       // geometrically as data is added.
+    ULONG       m_nFaceCapacity;
+    ULONG       m_nPolygonCapacity;
+
+};
+
+//-----------------------------------------------------------------------------
+// Name : CObject (Class)
+// Desc : Mesh container class used to store instances of meshes.
+// Note : Many objects may share a single mesh.
+//-----------------------------------------------------------------------------
+class CObject
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+     CObject( CMesh * pMesh );
+	 CObject();
+
+	//-------------------------------------------------------------------------
+	// Public Variables for This Class
+	//-------------------------------------------------------------------------
+    D3DXMATRIX  m_mtxWorld;             // Objects world matrix
+    CMesh      *m_pMesh;                // Mesh we are instancing
+    D3DXVECTOR3 m_vecSpin;              // Rotation rate about Y, X & Z (degrees per second)
+
+};
+
+
 #endif // !_COBJECT_H_
\ No newline at end of file
@@ -0,0 +1,118 @@
+//-----------------------------------------------------------------------------
+// File: CPresentQueue.h
+//
+// Desc: Multiple buffered frame presentation. Finished frames are handed to
+//       a dedicated present thread, so that the next frame can be drawn
+//       while the previous one is still being copied to the window.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CPRESENTQUEUE_H_
+#define _CPRESENTQUEUE_H_
+
+//-----------------------------------------------------------------------------
+// CPresentQueue Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const ULONG MAX_PRESENT_LATENCY = 3;        // Maximum frames queued ahead of the one being drawn
+
+//-----------------------------------------------------------------------------
+// Typedefs
+//-----------------------------------------------------------------------------
+// Present callback. Called on the present thread, in submission order, for
+// each frame handed over via Submit(). The buffer is 'Pitch' pixels wide.
+typedef void (*PRESENTFUNC)( void * pContext, const ULONG * pBuffer, ULONG Width, ULONG Height, ULONG Pitch );
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CPresentQueue (Class)
+// Desc : Owns a ring of color buffers. The renderer acquires a buffer, draws
+//        into it and submits it, after which the present thread presents it
+//        and returns it to the ring.
+// Note : 'MaxLatency' is the number of submitted frames which may still be
+//        waiting to be presented when the next buffer is acquired. 1 gives
+//        double buffering, 2 triple buffering, and 0 presents each frame
+//        directly on the submitting thread with no present thread at all.
+//-----------------------------------------------------------------------------
+class CPresentQueue
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+	         CPresentQueue();
+	virtual ~CPresentQueue();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    bool            Create          ( ULONG Width, ULONG Height, ULONG Pitch, ULONG MaxLatency,
+                                      PRESENTFUNC pFunction, void * pContext );
+    void            Release         ( );
+
+    ULONG         * AcquireBuffer   ( );
+    void            Submit          ( );
+    void            Flush           ( );
+
+    ULONG           GetBufferCount  ( ) const { return m_nBufferCount; }
+    ULONG           GetMaxLatency   ( ) const { return m_nBufferCount ? m_nBufferCount - 1 : 0; }
+    ULONG           GetPresentCount ( ) const { return m_nPresentCount; }
+
+private:
+    //-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+    void            PresentProc     ( );
+
+    //-------------------------------------------------------------------------
+	// Private Static Functions For This Class
+	//-------------------------------------------------------------------------
+#ifdef _WIN32
+    static unsigned __stdcall StaticPresentProc( void * pParam );
+#else
+    static void *   StaticPresentProc( void * pParam );
+#endif
+
+    //-------------------------------------------------------------------------
+	// Private Variables For This Class
+	//-------------------------------------------------------------------------
+    ULONG           m_nWidth;           // Size of each buffer
+    ULONG           m_nHeight;
+    ULONG           m_nPitch;           // Distance between rows, in pixels
+
+    ULONG         * m_pBuffers[MAX_PRESENT_LATENCY + 1]; // Buffer ring (32 byte aligned)
+    ULONG           m_nBufferCount;     // Number of buffers in the ring
+    ULONG           m_nAcquireIndex;    // Next buffer to be handed to the renderer
+    ULONG           m_nPresentIndex;    // Next buffer to be presented
+    bool            m_bAcquired;        // The renderer holds m_nAcquireIndex
+    volatile ULONG  m_nPresentCount;    // Frames presented since Create
+
+    PRESENTFUNC     m_pFunction;        // Present callback
+    void          * m_pContext;         // Present callback context
+    bool            m_bThread;          // Present thread is running
+    volatile bool   m_bQuit;            // Present thread should exit when woken
+
+#ifdef _WIN32
+    HANDLE          m_hThread;          // Present thread handle
+    HANDLE          m_hFree;            // Semaphore counting buffers available to the renderer
+    HANDLE          m_hReady;           // Semaphore counting frames waiting to be presented
+#else
+    pthread_t       m_hThread;          // Present thread handle
+    sem_t           m_hFree;            // Semaphore counting buffers available to the renderer
+    sem_t           m_hReady;           // Semaphore counting frames waiting to be presented
+#endif
+};
+
+#endif // _CPRESENTQUEUE_H_
@@ -0,0 +1,197 @@
+//-----------------------------------------------------------------------------
+// File: CRasterizer.h
+//
+// Desc: Tile based software rasterizer. Screen space primitives are binned
+//       into fixed size tiles, and each tile is then rasterized into the
+//       in-memory color and depth buffers independently of the others so
+//       that the work may be spread over a pool of worker threads.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CRASTERIZER_H_
+#define _CRASTERIZER_H_
+
+//-----------------------------------------------------------------------------
+// CRasterizer Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+#include "CThreadPool.h"
+#include "CTexture.h"
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const ULONG RASTER_TILE_SIZE    = 64;       // Width / height of a single tile in pixels
+const ULONG RASTER_SUBPIXEL     = 16;       // Sub-pixel precision (28.4 fixed point)
+const float RASTER_MAX_COORD    = 8192.0f;  // Largest screen coordinate accepted by the rasterizer
+
+//-----------------------------------------------------------------------------
+// Main Structure Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : RASTERVERTEX (Structure)
+// Desc : Screen space vertex passed to the rasterizer. Z is the post
+//        projection depth value in the range 0 - 1.
+// Note : rhw, u and v are only used by textured triangles.
+//-----------------------------------------------------------------------------
+struct RASTERVERTEX
+{
+    float       x;          // Screen space X coordinate (pixels)
+    float       y;          // Screen space Y coordinate (pixels)
+    float       z;          // Depth value (0 - 1)
+    float       rhw;        // Reciprocal of clip space W
+    float       u;          // Texture coordinates (1.0 = texture width / height)
+    float       v;
+};
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CRasterizer (Class)
+// Desc : Stores the frame's color and depth buffers, bins submitted screen
+//        space primitives per tile and rasterizes the tiles in parallel.
+// Note : Primitives are only queued by DrawTriangle / DrawLine. Nothing is
+//        written to the buffers until Flush() or EndFrame() is called. Rows
+//        of the buffers are padded to a multiple of 8 pixels (see GetPitch).
+//        Several threads may queue primitives at once, provided each uses a
+//        different queue (see SetQueueCount). Each tile draws the contents of
+//        queue 0 first, then queue 1 and so on.
+//-----------------------------------------------------------------------------
+class CRasterizer
+{
+public:
+    //-------------------------------------------------------------------------
+    // Enumerators
+    //-------------------------------------------------------------------------
+    enum SPAN_PATH {
+        SPAN_AUTO           = 0,        // Best path supported by this processor
+        SPAN_SCALAR         = 1,        // Plain C++, one pixel at a time
+        SPAN_SSE2           = 2,        // SSE2, four pixels at a time
+        SPAN_AVX2           = 3,        // AVX2, eight pixels at a time
+
+        SPAN_FORCE_32BIT    = 0x7FFFFFFF
+    };
+
+    enum RASTER_FLAGS {
+        RASTER_DEPTHTEST    = 0x1,      // Discard pixels failing the less-than depth test
+        RASTER_DEPTHWRITE   = 0x2,      // Write the depth of every pixel drawn
+        RASTER_BILINEAR     = 0x4,      // Bilinear texture filtering (nearest otherwise)
+
+        RASTER_FORCE_32BIT  = 0x7FFFFFFF
+    };
+
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+	         CRasterizer();
+	virtual ~CRasterizer();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    bool            SetBufferSize   ( ULONG Width, ULONG Height );
+    void            SetThreadPool   ( CThreadPool * pThreadPool ) { m_pThreadPool = pThreadPool; }
+    bool            SetSpanPath     ( SPAN_PATH Path );
+    bool            SetQueueCount   ( ULONG Count );
+    void            SetColorBuffer  ( ULONG * pBuffer );
+    void            Release         ( );
+
+    void            BeginFrame      ( ULONG ClearColor, float ClearDepth = 1.0f );
+    void            DrawTriangle    ( const RASTERVERTEX & v0, const RASTERVERTEX & v1, const RASTERVERTEX & v2, ULONG Color, ULONG Queue = 0 );
+    void            DrawTexturedTriangle( const RASTERVERTEX & v0, const RASTERVERTEX & v1, const RASTERVERTEX & v2,
+                                          const CTexture * pTexture, ULONG Flags = RASTER_DEPTHTEST | RASTER_DEPTHWRITE, ULONG Queue = 0 );
+    void            DrawLine        ( const RASTERVERTEX & v0, const RASTERVERTEX & v1, ULONG Color, ULONG Queue = 0 );
+    void            Flush           ( );
+    void            EndFrame        ( );
+
+    ULONG         * GetColorBuffer  ( ) const { return m_pColorBuffer; }
+    float         * GetDepthBuffer  ( ) const { return m_pDepthBuffer; }
+    ULONG           GetWidth        ( ) const { return m_nWidth; }
+    ULONG           GetHeight       ( ) const { return m_nHeight; }
+    ULONG           GetPitch        ( ) const { return m_nPitch; }
+    ULONG           GetQueueCount   ( ) const { return m_nQueueCount; }
+
+private:
+    //-------------------------------------------------------------------------
+	// Private Structures For This Class
+	//-------------------------------------------------------------------------
+    enum PRIMITIVETYPE { PRIMITIVE_TRIANGLE = 0, PRIMITIVE_LINE = 1, PRIMITIVE_TEXTURED = 2 };
+
+    struct Primitive
+    {
+        PRIMITIVETYPE   Type;           // Triangle or line
+        ULONG           Color;          // Flat color (0xAARRGGBB)
+        long            MinX, MinY;     // Pixel bounding box (inclusive, clipped to screen)
+        long            MaxX, MaxY;
+
+        // Triangle setup (28.4 fixed point edge equations E = A*x + B*y + C)
+        long            A[3], B[3];     // Edge function coefficients
+        __int64         C[3];           // Edge function constants (fill rule bias included)
+        float           Z0, DZDX, DZDY; // Depth plane equation (relative to pixel 0,0 centre)
+
+        // Textured triangle setup (perspective correct attributes, in texels)
+        const CTexture *pTexture;       // Texture to sample
+        ULONG           Flags;          // Combination of RASTER_FLAGS
+        float           W0, DWDX, DWDY; // 1/w plane equation
+        float           U0, DUDX, DUDY; // u/w plane equation
+        float           V0, DVDX, DVDY; // v/w plane equation
+
+        // Line setup
+        float           X0, Y0;         // Start point
+        float           X1, Y1;         // End point
+    };
+
+    typedef std::vector<Primitive>  VectorPrimitive;
+    typedef std::vector<ULONG>      VectorULONG;
+
+    //-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+    bool            SetupTriangle   ( Primitive & Prim, const RASTERVERTEX * pVertex[3], float fX[3], float fY[3] );
+    bool            AllocateBins    ( );
+    void            BinPrimitive    ( ULONG Queue, ULONG PrimitiveIndex );
+    void            RasterizeTile   ( ULONG TileIndex );
+    void            RasterTriangle  ( const Primitive & Prim, long X0, long Y0, long X1, long Y1 );
+    void            RasterLine      ( const Primitive & Prim, long X0, long Y0, long X1, long Y1 );
+
+    // Textured span kernels
+    void            RasterTexturedScalar( const Primitive & Prim, long X0, long Y0, long X1, long Y1 );
+    void            RasterTexturedSSE2  ( const Primitive & Prim, long X0, long Y0, long X1, long Y1 );
+    void            RasterTexturedAVX2  ( const Primitive & Prim, long X0, long Y0, long X1, long Y1 );
+
+    //-------------------------------------------------------------------------
+	// Private Static Functions For This Class
+	//-------------------------------------------------------------------------
+    static void     TileJob         ( void * pContext, ULONG JobIndex, ULONG ThreadIndex );
+    static bool     SetupEdges      ( const Primitive & Prim, long X0, long Y0, long X1, long Y1,
+                                      long E[3], long StepX[3], long StepY[3] );
+    static void     SetupPlane      ( const float fX[3], const float fY[3], const float Value[3],
+                                      float & Origin, float & DX, float & DY );
+
+    //-------------------------------------------------------------------------
+	// Private Variables For This Class
+	//-------------------------------------------------------------------------
+    ULONG           m_nWidth;           // Width of the frame buffer
+    ULONG           m_nHeight;          // Height of the frame buffer
+    ULONG           m_nPitch;           // Distance between rows, in pixels (multiple of 8)
+    ULONG         * m_pColorBuffer;     // Color buffer being drawn to (32bit XRGB, top down)
+    ULONG         * m_pOwnColorBuffer;  // Color buffer allocated by SetBufferSize
+    float         * m_pDepthBuffer;     // Depth buffer (32bit float)
+
+    ULONG           m_nTilesX;          // Number of tiles horizontally
+    ULONG           m_nTilesY;          // Number of tiles vertically
+    ULONG           m_nQueueCount;      // Number of primitive queues
+    VectorULONG   * m_pTileBins;        // Per queue, per tile list of primitive indices
+    VectorPrimitive*m_pPrimitives;      // Per queue list of primitives queued this frame
+    ULONG           m_ClearColor;       // Color used to clear each tile
+    float           m_ClearDepth;       // Depth used to clear each tile
+    bool            m_bClearPending;    // Tiles still need clearing this frame
+
+    CThreadPool   * m_pThreadPool;      // Pool used to rasterize tiles (may be NULL)
+    SPAN_PATH       m_SpanPath;         // Textured span kernel in use
+};
+
+#endif // _CRASTERIZER_H_
@@ -0,0 +1,78 @@
+//-----------------------------------------------------------------------------
+// File: CTexture.h
+//
+// Desc: Texture storage for the software rasterizer. Texels are stored in
+//       4x4 tiles (one 64 byte cache line each) so that the texels sampled
+//       by neighbouring pixels, on either axis, are likely to share a line.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CTEXTURE_H_
+#define _CTEXTURE_H_
+
+//-----------------------------------------------------------------------------
+// CTexture Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const ULONG TEXTURE_TILE_SHIFT  = 2;        // Log2 of the tile width / height
+const ULONG TEXTURE_TILE_SIZE   = 4;        // Width / height of a single tile in texels
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CTexture (Class)
+// Desc : Stores a 32bit XRGB texture in tiled order. Dimensions must be
+//        powers of two (and at least one tile) so that texture coordinates
+//        wrap using a simple mask.
+//-----------------------------------------------------------------------------
+class CTexture
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+	         CTexture();
+	virtual ~CTexture();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    bool            Create          ( ULONG Width, ULONG Height );
+    bool            CreateChecker   ( ULONG Size, ULONG CheckSize, ULONG Color1, ULONG Color2 );
+    void            SetTexels       ( const ULONG * pSource, ULONG Pitch );
+    void            Release         ( );
+
+    ULONG           GetWidth        ( ) const { return m_nWidth; }
+    ULONG           GetHeight       ( ) const { return m_nHeight; }
+    ULONG           GetWidthShift   ( ) const { return m_nWidthShift; }
+    const UINT    * GetTexels       ( ) const { return m_pTexels; }
+
+	//-------------------------------------------------------------------------
+	// Public Inline Functions for This Class
+	//-------------------------------------------------------------------------
+    // Offset of texel ( x, y ) within the tiled texel array, coordinates wrap
+    ULONG           GetTexelOffset  ( ULONG x, ULONG y ) const
+    {
+        x &= m_nWidth - 1; y &= m_nHeight - 1;
+        return ((y & ~3) << m_nWidthShift) | ((x & ~3) << 2) | ((y & 3) << 2) | (x & 3);
+    }
+
+    ULONG           GetTexel        ( ULONG x, ULONG y ) const { return m_pTexels[ GetTexelOffset( x, y ) ]; }
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Variables for This Class
+	//-------------------------------------------------------------------------
+    ULONG           m_nWidth;           // Width of the texture in texels
+    ULONG           m_nHeight;          // Height of the texture in texels
+    ULONG           m_nWidthShift;      // Log2 of the texture width
+    UINT          * m_pTexels;          // Tiled texel data (32 byte aligned)
+};
+
+#endif // _CTEXTURE_H_
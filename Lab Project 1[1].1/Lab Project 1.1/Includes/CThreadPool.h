@@ -0,0 +1,112 @@
+//-----------------------------------------------------------------------------
+// File: CThreadPool.h
+//
+// Desc: Simple worker thread pool used to split per-frame processing (such as
+//       tile rasterization) across all of the available processor cores.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CTHREADPOOL_H_
+#define _CTHREADPOOL_H_
+
+//-----------------------------------------------------------------------------
+// CThreadPool Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const ULONG MAX_POOL_THREADS = 64;      // Maximum number of threads (including caller)
+
+//-----------------------------------------------------------------------------
+// Typedefs
+//-----------------------------------------------------------------------------
+// Job callback. Called once for each job index in the range [0, JobCount).
+// ThreadIndex is unique to the executing thread in the range [0, GetThreadCount())
+// and can be used to index any per-thread scratch data.
+typedef void (*THREADJOBFUNC)( void * pContext, ULONG JobIndex, ULONG ThreadIndex );
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CThreadPool (Class)
+// Desc : Maintains a fixed set of worker threads which sleep until a batch of
+//        jobs is submitted via Execute(). The calling thread takes part in
+//        the batch, and Execute() only returns once every job has completed.
+//-----------------------------------------------------------------------------
+class CThreadPool
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+	         CThreadPool();
+	virtual ~CThreadPool();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    bool            Create          ( ULONG ThreadCount = 0 );
+    void            Release         ( );
+    void            Execute         ( THREADJOBFUNC pFunction, void * pContext, ULONG JobCount );
+    ULONG           GetThreadCount  ( ) const { return m_nThreadCount; }
+
+    static ULONG    GetProcessorCount( );
+
+private:
+    //-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+    void            WorkerProc      ( ULONG ThreadIndex );
+    void            ProcessJobs     ( ULONG ThreadIndex );
+
+    //-------------------------------------------------------------------------
+	// Private Static Functions For This Class
+	//-------------------------------------------------------------------------
+#ifdef _WIN32
+    static unsigned __stdcall StaticWorkerProc( void * pParam );
+#else
+    static void *   StaticWorkerProc( void * pParam );
+#endif
+
+    //-------------------------------------------------------------------------
+	// Private Structures For This Class
+	//-------------------------------------------------------------------------
+    struct WorkerParam
+    {
+        CThreadPool   * pPool;          // Owning pool
+        ULONG           Index;          // Thread index passed to each job
+    };
+
+    //-------------------------------------------------------------------------
+	// Private Variables For This Class
+	//-------------------------------------------------------------------------
+    ULONG           m_nThreadCount;     // Total thread count, including the caller
+    WorkerParam     m_Params[MAX_POOL_THREADS]; // Parameters passed to each worker
+
+#ifdef _WIN32
+    HANDLE          m_hThreads[MAX_POOL_THREADS]; // Worker thread handles
+    HANDLE          m_hStart;           // Semaphore signalled once per worker per batch
+    HANDLE          m_hDone;            // Semaphore signalled by each worker on completion
+#else
+    pthread_t       m_hThreads[MAX_POOL_THREADS]; // Worker thread handles
+    sem_t           m_hStart;           // Semaphore signalled once per worker per batch
+    sem_t           m_hDone;            // Semaphore signalled by each worker on completion
+#endif
+
+    volatile LONG   m_nNextJob;         // Next job index to be claimed
+    ULONG           m_nJobCount;        // Number of jobs in the current batch
+    THREADJOBFUNC   m_pFunction;        // Job function for the current batch
+    void          * m_pContext;         // Job context for the current batch
+    bool            m_bQuit;            // Workers should exit when woken
+};
+
+#endif // _CTHREADPOOL_H_
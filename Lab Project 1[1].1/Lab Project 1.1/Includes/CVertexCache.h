@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+// File: CVertexCache.h
+//
+// Desc: Post-transform vertex cache. Transforms a mesh's unique positions
+//       by a single combined world / view / projection matrix, four or eight
+//       at a time, and stores the results for the polygon drawing to index.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CVERTEXCACHE_H_
+#define _CVERTEXCACHE_H_
+
+//-----------------------------------------------------------------------------
+// CVertexCache Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+#include "CObject.h"
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CVertexCache (Class)
+// Desc : Stores the clip space and screen space position of every unique
+//        vertex in a mesh, in structure of arrays form.
+//-----------------------------------------------------------------------------
+class CVertexCache
+{
+public:
+    //-------------------------------------------------------------------------
+    // Enumerators
+    //-------------------------------------------------------------------------
+    enum TRANSFORM_PATH {
+        PATH_AUTO           = 0,        // Best path supported by this processor
+        PATH_SCALAR         = 1,        // Plain C++, one vertex at a time
+        PATH_SSE            = 2,        // SSE, four vertices at a time
+        PATH_AVX            = 3,        // AVX, eight vertices at a time
+
+        PATH_FORCE_32BIT    = 0x7FFFFFFF
+    };
+
+    enum CLIP_CODE {
+        CLIP_LEFT           = 0x001,    // x < -w
+        CLIP_RIGHT          = 0x002,    // x >  w
+        CLIP_BOTTOM         = 0x004,    // y < -w
+        CLIP_TOP            = 0x008,    // y >  w
+        CLIP_NEAR           = 0x010,    // z <  0
+        CLIP_FAR            = 0x020,    // z >  w
+        CLIP_GUARD_LEFT     = 0x100,    // x < -w * GuardBandX
+        CLIP_GUARD_RIGHT    = 0x200,    // x >  w * GuardBandX
+        CLIP_GUARD_BOTTOM   = 0x400,    // y < -w * GuardBandY
+        CLIP_GUARD_TOP      = 0x800,    // y >  w * GuardBandY
+
+        CLIP_REJECT_MASK    = 0x03F,    // All vertices outside one of these, face is invisible
+        CLIP_CLIP_MASK      = 0xF10,    // Any vertex outside one of these, face must be clipped
+
+        CLIP_FORCE_32BIT    = 0x7FFFFFFF
+    };
+
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+	         CVertexCache();
+	virtual ~CVertexCache();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    void            SetViewport     ( float X, float Y, float Width, float Height );
+    void            SetGuardBand    ( float GuardBandX, float GuardBandY );
+    float           GetGuardBandX   ( ) const { return m_fGuardX; }
+    float           GetGuardBandY   ( ) const { return m_fGuardY; }
+    bool            SetPath         ( TRANSFORM_PATH Path );
+    bool            Transform       ( const CMesh * pMesh, const D3DXMATRIX & mtxWVP );
+    void            Release         ( );
+
+	//-------------------------------------------------------------------------
+	// Public Variables for This Class
+	//-------------------------------------------------------------------------
+    ULONG           m_nCount;           // Number of vertices currently cached
+    float          *m_pClipX;           // Clip space position (before the perspective divide)
+    float          *m_pClipY;
+    float          *m_pClipZ;
+    float          *m_pClipW;
+    float          *m_pScreenX;         // Screen space position (after divide & viewport)
+    float          *m_pScreenY;
+    float          *m_pScreenZ;
+    float          *m_pScreenW;         // Reciprocal of clip space W (for perspective correction)
+    UINT           *m_pClipCode;        // Combination of CLIP_CODE flags for each vertex
+
+	//-------------------------------------------------------------------------
+	// Public Inline Functions for This Class
+	//-------------------------------------------------------------------------
+    // Projects a clip space position to the screen (as the cache does)
+    void            ToScreen        ( float x, float y, float z, float w, float & sx, float & sy, float & sz, float & rhw ) const
+    {
+        rhw = 1.0f / w;
+        sx  = x * rhw * m_fScaleX + m_fOffsetX;
+        sy  = y * rhw * m_fScaleY + m_fOffsetY;
+        sz  = z * rhw;
+    }
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+    bool            Reserve         ( ULONG Count );
+    void            TransformScalar ( const CMesh * pMesh, const D3DXMATRIX & mtxWVP, ULONG Count );
+    void            TransformSSE    ( const CMesh * pMesh, const D3DXMATRIX & mtxWVP, ULONG Count );
+    void            TransformAVX    ( const CMesh * pMesh, const D3DXMATRIX & mtxWVP, ULONG Count );
+
+	//-------------------------------------------------------------------------
+	// Private Variables for This Class
+	//-------------------------------------------------------------------------
+    ULONG           m_nCapacity;        // Allocated size of each array
+    TRANSFORM_PATH  m_Path;             // Transform path in use
+    float           m_fScaleX;          // Viewport transform (x' = x * Scale + Offset)
+    float           m_fScaleY;
+    float           m_fOffsetX;
+    float           m_fOffsetY;
+    float           m_fGuardX;          // Guard band extents, as a multiple of the
+    float           m_fGuardY;          // viewport's half width / height.
+};
+
+#endif // _CVERTEXCACHE_H_
@@ -0,0 +1,361 @@
+//-----------------------------------------------------------------------------
+// File: Platform.h
+//
+// Desc: Portable stand-ins for the parts of the Win32 API, TCHAR routines and
+//       D3DX maths library used by the software pipeline. Included by Main.h
+//       in place of <windows.h> / <D3DX9.h> on platforms other than Windows,
+//       allowing the renderer to be built and run headless (e.g. on Linux).
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _PLATFORM_H_
+#define _PLATFORM_H_
+
+#ifndef _WIN32
+
+//-----------------------------------------------------------------------------
+// Platform Specific Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+// Standard C++ headers used by the pipeline must be seen before the min / max
+// macros below are defined (as is the case for <windows.h> with VC++ 6.0)
+#include <vector>
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// Win32 Types (sized as they are on Windows, ULONG pixels are 32 bit)
+//-----------------------------------------------------------------------------
+typedef unsigned int    ULONG;
+typedef int             LONG;
+typedef unsigned int    DWORD;
+typedef unsigned int    UINT;
+typedef unsigned short  USHORT;
+typedef unsigned char   UCHAR;
+typedef int             BOOL;
+typedef void          * HANDLE;
+typedef void          * HWND;
+typedef char            TCHAR;
+typedef char          * LPTSTR;
+typedef const char    * LPCTSTR;
+
+#ifndef TRUE
+#define TRUE            1
+#define FALSE           0
+#endif
+
+#ifndef __int64
+#define __int64         long long
+#endif
+
+#ifndef min
+#define min(a,b)        (((a) < (b)) ? (a) : (b))
+#define max(a,b)        (((a) > (b)) ? (a) : (b))
+#endif
+
+#define ZeroMemory( p, n )  memset( (void*)(p), 0, (n) )
+#define WINAPI
+
+//-----------------------------------------------------------------------------
+// TCHAR Routines (single byte characters only)
+//-----------------------------------------------------------------------------
+#define _T( x )         x
+#define _tcsstr         strstr
+#define _tcslen         strlen
+#define _tcstoul        strtoul
+#define _ttol           atol
+#define _tfopen         fopen
+#define _stprintf       sprintf
+#define _itot( Value, String, Radix ) ( sprintf( String, "%lu", (unsigned long)(Value) ), String )
+
+//-----------------------------------------------------------------------------
+// Win32 Timing Functions (implemented over the monotonic clock / nanosleep)
+//-----------------------------------------------------------------------------
+union LARGE_INTEGER { long long QuadPart; };
+
+inline BOOL QueryPerformanceFrequency( LARGE_INTEGER * pFrequency )
+{
+    pFrequency->QuadPart = 1000000000LL;
+    return TRUE;
+}
+
+inline BOOL QueryPerformanceCounter( LARGE_INTEGER * pCounter )
+{
+    timespec Time;
+    clock_gettime( CLOCK_MONOTONIC, &Time );
+    pCounter->QuadPart = (long long)Time.tv_sec * 1000000000LL + Time.tv_nsec;
+    return TRUE;
+}
+
+inline DWORD timeGetTime( )
+{
+    timespec Time;
+    clock_gettime( CLOCK_MONOTONIC, &Time );
+    return (DWORD)(Time.tv_sec * 1000 + Time.tv_nsec / 1000000);
+}
+
+#define TIMERR_NOERROR  0
+
+inline UINT timeBeginPeriod( UINT Period ) { return TIMERR_NOERROR; }
+inline UINT timeEndPeriod( UINT Period ) { return TIMERR_NOERROR; }
+
+inline void Sleep( DWORD Milliseconds )
+{
+    timespec Time;
+    Time.tv_sec  = Milliseconds / 1000;
+    Time.tv_nsec = (long)(Milliseconds % 1000) * 1000000L;
+    while ( nanosleep( &Time, &Time ) != 0 );
+}
+
+//-----------------------------------------------------------------------------
+// D3DX Maths (the subset used by the pipeline, same layout & conventions)
+//-----------------------------------------------------------------------------
+#define D3DX_PI                 3.141592654f
+#define D3DXToRadian( Degree )  ((Degree) * (D3DX_PI / 180.0f))
+#define D3DXToDegree( Radian )  ((Radian) * (180.0f / D3DX_PI))
+
+struct D3DXVECTOR2
+{
+    float x, y;
+
+    D3DXVECTOR2( ) {}
+    D3DXVECTOR2( float fx, float fy ) : x( fx ), y( fy ) {}
+};
+
+struct D3DXVECTOR3
+{
+    float x, y, z;
+
+    D3DXVECTOR3( ) {}
+    D3DXVECTOR3( float fx, float fy, float fz ) : x( fx ), y( fy ), z( fz ) {}
+
+    D3DXVECTOR3 & operator += ( const D3DXVECTOR3 & v ) { x += v.x; y += v.y; z += v.z; return *this; }
+    D3DXVECTOR3 & operator -= ( const D3DXVECTOR3 & v ) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+    D3DXVECTOR3 & operator *= ( float f ) { x *= f; y *= f; z *= f; return *this; }
+    D3DXVECTOR3 & operator /= ( float f ) { x /= f; y /= f; z /= f; return *this; }
+
+    D3DXVECTOR3 operator - ( ) const { return D3DXVECTOR3( -x, -y, -z ); }
+    D3DXVECTOR3 operator + ( const D3DXVECTOR3 & v ) const { return D3DXVECTOR3( x + v.x, y + v.y, z + v.z ); }
+    D3DXVECTOR3 operator - ( const D3DXVECTOR3 & v ) const { return D3DXVECTOR3( x - v.x, y - v.y, z - v.z ); }
+    D3DXVECTOR3 operator * ( float f ) const { return D3DXVECTOR3( x * f, y * f, z * f ); }
+    D3DXVECTOR3 operator / ( float f ) const { return D3DXVECTOR3( x / f, y / f, z / f ); }
+};
+
+struct D3DXVECTOR4
+{
+    float x, y, z, w;
+
+    D3DXVECTOR4( ) {}
+    D3DXVECTOR4( float fx, float fy, float fz, float fw ) : x( fx ), y( fy ), z( fz ), w( fw ) {}
+};
+
+struct D3DXPLANE
+{
+    float a, b, c, d;
+
+    D3DXPLANE( ) {}
+    D3DXPLANE( float fa, float fb, float fc, float fd ) : a( fa ), b( fb ), c( fc ), d( fd ) {}
+};
+
+struct D3DXMATRIX
+{
+    union
+    {
+        struct
+        {
+            float _11, _12, _13, _14;
+            float _21, _22, _23, _24;
+            float _31, _32, _33, _34;
+            float _41, _42, _43, _44;
+        };
+        float m[4][4];
+    };
+
+    D3DXMATRIX( ) {}
+
+    float & operator () ( UINT Row, UINT Col ) { return m[Row][Col]; }
+    float   operator () ( UINT Row, UINT Col ) const { return m[Row][Col]; }
+    D3DXMATRIX operator * ( const D3DXMATRIX & mtx ) const;
+    D3DXMATRIX & operator *= ( const D3DXMATRIX & mtx ) { *this = *this * mtx; return *this; }
+};
+
+inline D3DXMATRIX * D3DXMatrixIdentity( D3DXMATRIX * pOut )
+{
+    memset( (void*)pOut, 0, sizeof(D3DXMATRIX) );
+    pOut->_11 = pOut->_22 = pOut->_33 = pOut->_44 = 1.0f;
+    return pOut;
+}
+
+inline D3DXMATRIX * D3DXMatrixMultiply( D3DXMATRIX * pOut, const D3DXMATRIX * pM1, const D3DXMATRIX * pM2 )
+{
+    D3DXMATRIX Result;
+
+    for ( ULONG i = 0; i < 4; i++ )
+        for ( ULONG j = 0; j < 4; j++ )
+            Result.m[i][j] = pM1->m[i][0] * pM2->m[0][j] + pM1->m[i][1] * pM2->m[1][j] +
+                             pM1->m[i][2] * pM2->m[2][j] + pM1->m[i][3] * pM2->m[3][j];
+
+    *pOut = Result;
+    return pOut;
+}
+
+inline D3DXMATRIX D3DXMATRIX::operator * ( const D3DXMATRIX & mtx ) const
+{
+    D3DXMATRIX Result;
+    D3DXMatrixMultiply( &Result, this, &mtx );
+    return Result;
+}
+
+inline D3DXMATRIX * D3DXMatrixTranslation( D3DXMATRIX * pOut, float x, float y, float z )
+{
+    D3DXMatrixIdentity( pOut );
+    pOut->_41 = x; pOut->_42 = y; pOut->_43 = z;
+    return pOut;
+}
+
+inline D3DXMATRIX * D3DXMatrixRotationX( D3DXMATRIX * pOut, float Angle )
+{
+    D3DXMatrixIdentity( pOut );
+    pOut->_22 = cosf( Angle ); pOut->_23 = sinf( Angle );
+    pOut->_32 = -pOut->_23;    pOut->_33 = pOut->_22;
+    return pOut;
+}
+
+inline D3DXMATRIX * D3DXMatrixRotationY( D3DXMATRIX * pOut, float Angle )
+{
+    D3DXMatrixIdentity( pOut );
+    pOut->_11 = cosf( Angle ); pOut->_13 = -sinf( Angle );
+    pOut->_31 = -pOut->_13;    pOut->_33 = pOut->_11;
+    return pOut;
+}
+
+inline D3DXMATRIX * D3DXMatrixRotationZ( D3DXMATRIX * pOut, float Angle )
+{
+    D3DXMatrixIdentity( pOut );
+    pOut->_11 = cosf( Angle ); pOut->_12 = sinf( Angle );
+    pOut->_21 = -pOut->_12;    pOut->_22 = pOut->_11;
+    return pOut;
+}
+
+inline D3DXMATRIX * D3DXMatrixPerspectiveFovLH( D3DXMATRIX * pOut, float FovY, float Aspect, float zn, float zf )
+{
+    float yScale = 1.0f / tanf( FovY * 0.5f );
+
+    memset( (void*)pOut, 0, sizeof(D3DXMATRIX) );
+    pOut->_11 = yScale / Aspect;
+    pOut->_22 = yScale;
+    pOut->_33 = zf / (zf - zn);
+    pOut->_34 = 1.0f;
+    pOut->_43 = -zn * zf / (zf - zn);
+    return pOut;
+}
+
+inline D3DXMATRIX * D3DXMatrixInverse( D3DXMATRIX * pOut, float * pDeterminant, const D3DXMATRIX * pM )
+{
+    const float (*m)[4] = pM->m;
+    float   Cofactor[4][4], Det;
+    ULONG   i, j;
+
+    // Cofactors of the first column, used for the determinant
+    Cofactor[0][0] =  m[1][1] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) - m[1][2] * (m[2][1] * m[3][3] - m[2][3] * m[3][1]) + m[1][3] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]);
+    Cofactor[1][0] = -m[0][1] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) + m[0][2] * (m[2][1] * m[3][3] - m[2][3] * m[3][1]) - m[0][3] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]);
+    Cofactor[2][0] =  m[0][1] * (m[1][2] * m[3][3] - m[1][3] * m[3][2]) - m[0][2] * (m[1][1] * m[3][3] - m[1][3] * m[3][1]) + m[0][3] * (m[1][1] * m[3][2] - m[1][2] * m[3][1]);
+    Cofactor[3][0] = -m[0][1] * (m[1][2] * m[2][3] - m[1][3] * m[2][2]) + m[0][2] * (m[1][1] * m[2][3] - m[1][3] * m[2][1]) - m[0][3] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]);
+
+    Det = m[0][0] * Cofactor[0][0] + m[1][0] * Cofactor[1][0] + m[2][0] * Cofactor[2][0] + m[3][0] * Cofactor[3][0];
+    if ( pDeterminant ) *pDeterminant = Det;
+    if ( Det == 0.0f ) return NULL;
+
+    // Remaining cofactors
+    Cofactor[0][1] = -m[1][0] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) + m[1][2] * (m[2][0] * m[3][3] - m[2][3] * m[3][0]) - m[1][3] * (m[2][0] * m[3][2] - m[2][2] * m[3][0]);
+    Cofactor[1][1] =  m[0][0] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) - m[0][2] * (m[2][0] * m[3][3] - m[2][3] * m[3][0]) + m[0][3] * (m[2][0] * m[3][2] - m[2][2] * m[3][0]);
+    Cofactor[2][1] = -m[0][0] * (m[1][2] * m[3][3] - m[1][3] * m[3][2]) + m[0][2] * (m[1][0] * m[3][3] - m[1][3] * m[3][0]) - m[0][3] * (m[1][0] * m[3][2] - m[1][2] * m[3][0]);
+    Cofactor[3][1] =  m[0][0] * (m[1][2] * m[2][3] - m[1][3] * m[2][2]) - m[0][2] * (m[1][0] * m[2][3] - m[1][3] * m[2][0]) + m[0][3] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]);
+    Cofactor[0][2] =  m[1][0] * (m[2][1] * m[3][3] - m[2][3] * m[3][1]) - m[1][1] * (m[2][0] * m[3][3] - m[2][3] * m[3][0]) + m[1][3] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]);
+    Cofactor[1][2] = -m[0][0] * (m[2][1] * m[3][3] - m[2][3] * m[3][1]) + m[0][1] * (m[2][0] * m[3][3] - m[2][3] * m[3][0]) - m[0][3] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]);
+    Cofactor[2][2] =  m[0][0] * (m[1][1] * m[3][3] - m[1][3] * m[3][1]) - m[0][1] * (m[1][0] * m[3][3] - m[1][3] * m[3][0]) + m[0][3] * (m[1][0] * m[3][1] - m[1][1] * m[3][0]);
+    Cofactor[3][2] = -m[0][0] * (m[1][1] * m[2][3] - m[1][3] * m[2][1]) + m[0][1] * (m[1][0] * m[2][3] - m[1][3] * m[2][0]) - m[0][3] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    Cofactor[0][3] = -m[1][0] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]) + m[1][1] * (m[2][0] * m[3][2] - m[2][2] * m[3][0]) - m[1][2] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]);
+    Cofactor[1][3] =  m[0][0] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]) - m[0][1] * (m[2][0] * m[3][2] - m[2][2] * m[3][0]) + m[0][2] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]);
+    Cofactor[2][3] = -m[0][0] * (m[1][1] * m[3][2] - m[1][2] * m[3][1]) + m[0][1] * (m[1][0] * m[3][2] - m[1][2] * m[3][0]) - m[0][2] * (m[1][0] * m[3][1] - m[1][1] * m[3][0]);
+    Cofactor[3][3] =  m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+
+    // Inverse is the adjugate (the transposed cofactors) over the determinant
+    for ( i = 0; i < 4; i++ )
+        for ( j = 0; j < 4; j++ )
+            pOut->m[i][j] = Cofactor[j][i] / Det;
+
+    return pOut;
+}
+
+inline float D3DXVec3Dot( const D3DXVECTOR3 * pV1, const D3DXVECTOR3 * pV2 )
+{
+    return pV1->x * pV2->x + pV1->y * pV2->y + pV1->z * pV2->z;
+}
+
+inline float D3DXVec3Length( const D3DXVECTOR3 * pV )
+{
+    return sqrtf( D3DXVec3Dot( pV, pV ) );
+}
+
+inline D3DXVECTOR3 * D3DXVec3Cross( D3DXVECTOR3 * pOut, const D3DXVECTOR3 * pV1, const D3DXVECTOR3 * pV2 )
+{
+    *pOut = D3DXVECTOR3( pV1->y * pV2->z - pV1->z * pV2->y, pV1->z * pV2->x - pV1->x * pV2->z, pV1->x * pV2->y - pV1->y * pV2->x );
+    return pOut;
+}
+
+inline D3DXVECTOR3 * D3DXVec3Normalize( D3DXVECTOR3 * pOut, const D3DXVECTOR3 * pV )
+{
+    float Length = D3DXVec3Length( pV );
+    *pOut = ( Length > 0.0f ) ? *pV / Length : D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+    return pOut;
+}
+
+inline D3DXVECTOR3 * D3DXVec3TransformCoord( D3DXVECTOR3 * pOut, const D3DXVECTOR3 * pV, const D3DXMATRIX * pM )
+{
+    float x = pV->x, y = pV->y, z = pV->z;
+    float w = x * pM->_14 + y * pM->_24 + z * pM->_34 + pM->_44;
+
+    pOut->x = (x * pM->_11 + y * pM->_21 + z * pM->_31 + pM->_41) / w;
+    pOut->y = (x * pM->_12 + y * pM->_22 + z * pM->_32 + pM->_42) / w;
+    pOut->z = (x * pM->_13 + y * pM->_23 + z * pM->_33 + pM->_43) / w;
+    return pOut;
+}
+
+inline D3DXVECTOR3 * D3DXVec3TransformNormal( D3DXVECTOR3 * pOut, const D3DXVECTOR3 * pV, const D3DXMATRIX * pM )
+{
+    float x = pV->x, y = pV->y, z = pV->z;
+
+    pOut->x = x * pM->_11 + y * pM->_21 + z * pM->_31;
+    pOut->y = x * pM->_12 + y * pM->_22 + z * pM->_32;
+    pOut->z = x * pM->_13 + y * pM->_23 + z * pM->_33;
+    return pOut;
+}
+
+inline D3DXPLANE * D3DXPlaneNormalize( D3DXPLANE * pOut, const D3DXPLANE * pP )
+{
+    float Length = sqrtf( pP->a * pP->a + pP->b * pP->b + pP->c * pP->c );
+
+    if ( Length > 0.0f ) *pOut = D3DXPLANE( pP->a / Length, pP->b / Length, pP->c / Length, pP->d / Length );
+    else                 *pOut = D3DXPLANE( 0.0f, 0.0f, 0.0f, 0.0f );
+    return pOut;
+}
+
+inline float D3DXPlaneDotCoord( const D3DXPLANE * pP, const D3DXVECTOR3 * pV )
+{
+    return pP->a * pV->x + pP->b * pV->y + pP->c * pV->z + pP->d;
+}
+
+inline float D3DXPlaneDotNormal( const D3DXPLANE * pP, const D3DXVECTOR3 * pV )
+{
+    return pP->a * pV->x + pP->b * pV->y + pP->c * pV->z;
+}
+
+#endif // !_WIN32
+
+#endif // _PLATFORM_H_
@@ -1,20 +1,26 @@
-//{{NO_DEPENDENCIES}}
-// Microsoft Developer Studio generated include file.
-// Used by Software_Render.rc
-//
-#define IDR_MENU                        101
-#define IDI_ICON                        102
-#define ID_EXIT                         40006
-#define ID_ANIM_ROTATION1               40007
-#define ID_ANIM_ROTATION2               40008
-
-// Next default values for new objects
-// 
-#ifdef APSTUDIO_INVOKED
-#ifndef APSTUDIO_READONLY_SYMBOLS
-#define _APS_NEXT_RESOURCE_VALUE        103
-#define _APS_NEXT_COMMAND_VALUE         40009
-#define _APS_NEXT_CONTROL_VALUE         1000
-#define _APS_NEXT_SYMED_VALUE           101
-#endif
-#endif
+//{{NO_DEPENDENCIES}}
+// Microsoft Developer Studio generated include file.
+// Used by Software_Render.rc
+//
+#define IDR_MENU                        101
+#define IDI_ICON                        102
+#define ID_EXIT                         40006
+#define ID_ANIM_ROTATION1               40007
+#define ID_ANIM_ROTATION2               40008
+#define ID_RENDER_WIREFRAME             40009
+#define ID_RENDER_FLAT                  40010
+#define ID_RENDER_CULLBACK              40011
+#define ID_RENDER_TEXTURED              40012
+#define ID_RENDER_BILINEAR              40013
+#define ID_RENDER_OCCLUSION             40014
+
+// Next default values for new objects
+// 
+#ifdef APSTUDIO_INVOKED
+#ifndef APSTUDIO_READONLY_SYMBOLS
+#define _APS_NEXT_RESOURCE_VALUE        103
+#define _APS_NEXT_COMMAND_VALUE         40015
+#define _APS_NEXT_CONTROL_VALUE         1000
+#define _APS_NEXT_SYMED_VALUE           101
+#endif
+#endif
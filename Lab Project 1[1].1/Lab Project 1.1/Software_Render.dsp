@@ -1,155 +1,239 @@
-# Microsoft Developer Studio Project File - Name="Software_Render" - Package Owner=<4>
-# Microsoft Developer Studio Generated Build File, Format Version 6.00
-# ** DO NOT EDIT **
-
-# TARGTYPE "Win32 (x86) Application" 0x0101
-
-CFG=Software_Render - Win32 Debug
-!MESSAGE This is not a valid makefile. To build this project using NMAKE,
-!MESSAGE use the Export Makefile command and run
-!MESSAGE 
-!MESSAGE NMAKE /f "Software_Render.mak".
-!MESSAGE 
-!MESSAGE You can specify a configuration when running NMAKE
-!MESSAGE by defining the macro CFG on the command line. For example:
-!MESSAGE 
-!MESSAGE NMAKE /f "Software_Render.mak" CFG="Software_Render - Win32 Debug"
-!MESSAGE 
-!MESSAGE Possible choices for configuration are:
-!MESSAGE 
-!MESSAGE "Software_Render - Win32 Release" (based on "Win32 (x86) Application")
-!MESSAGE "Software_Render - Win32 Debug" (based on "Win32 (x86) Application")
-!MESSAGE 
-
-# Begin Project
-# PROP AllowPerConfigDependencies 0
-# PROP Scc_ProjName ""
-# PROP Scc_LocalPath ""
-CPP=cl.exe
-MTL=midl.exe
-RSC=rc.exe
-
-!IF  "$(CFG)" == "Software_Render - Win32 Release"
-
-# PROP BASE Use_MFC 0
-# PROP BASE Use_Debug_Libraries 0
-# PROP BASE Output_Dir "Release"
-# PROP BASE Intermediate_Dir "Release"
-# PROP BASE Target_Dir ""
-# PROP Use_MFC 0
-# PROP Use_Debug_Libraries 0
-# PROP Output_Dir "Compiled\Release"
-# PROP Intermediate_Dir "Compiled\Release"
-# PROP Ignore_Export_Lib 0
-# PROP Target_Dir ""
-# ADD BASE CPP /nologo /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /c
-# ADD CPP /nologo /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /c
-# ADD BASE MTL /nologo /D "NDEBUG" /mktyplib203 /win32
-# ADD MTL /nologo /D "NDEBUG" /mktyplib203 /win32
-# ADD BASE RSC /l 0x809 /d "NDEBUG"
-# ADD RSC /l 0x809 /d "NDEBUG"
-BSC32=bscmake.exe
-# ADD BASE BSC32 /nologo
-# ADD BSC32 /nologo
-LINK32=link.exe
-# ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:windows /machine:I386
-# ADD LINK32 user32.lib gdi32.lib advapi32.lib winmm.lib d3dx9.lib /nologo /subsystem:windows /machine:I386
-
-!ELSEIF  "$(CFG)" == "Software_Render - Win32 Debug"
-
-# PROP BASE Use_MFC 0
-# PROP BASE Use_Debug_Libraries 1
-# PROP BASE Output_Dir "Debug"
-# PROP BASE Intermediate_Dir "Debug"
-# PROP BASE Target_Dir ""
-# PROP Use_MFC 0
-# PROP Use_Debug_Libraries 1
-# PROP Output_Dir "Compiled\Debug"
-# PROP Intermediate_Dir "Compiled\Debug"
-# PROP Ignore_Export_Lib 0
-# PROP Target_Dir ""
-# ADD BASE CPP /nologo /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /GZ /c
-# ADD CPP /nologo /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /GZ /c
-# ADD BASE MTL /nologo /D "_DEBUG" /mktyplib203 /win32
-# ADD MTL /nologo /D "_DEBUG" /mktyplib203 /win32
-# ADD BASE RSC /l 0x809 /d "_DEBUG"
-# ADD RSC /l 0x809 /d "_DEBUG"
-BSC32=bscmake.exe
-# ADD BASE BSC32 /nologo
-# ADD BSC32 /nologo
-LINK32=link.exe
-# ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:windows /debug /machine:I386 /pdbtype:sept
-# ADD LINK32 user32.lib gdi32.lib advapi32.lib winmm.lib d3dx9.lib /nologo /subsystem:windows /debug /machine:I386 /pdbtype:sept
-
-!ENDIF 
-
-# Begin Target
-
-# Name "Software_Render - Win32 Release"
-# Name "Software_Render - Win32 Debug"
-# Begin Group "Source Files"
-
-# PROP Default_Filter "cpp;c;cxx;rc;def;r;odl;idl;hpj;bat"
-# Begin Source File
-
-SOURCE=.\Source\CGameApp.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\Source\CObject.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\Source\CTimer.cpp
-# End Source File
-# Begin Source File
-
-SOURCE=.\Source\Main.cpp
-# End Source File
-# End Group
-# Begin Group "Header Files"
-
-# PROP Default_Filter "h;hpp;hxx;hm;inl"
-# Begin Source File
-
-SOURCE=.\Includes\CGameApp.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\Includes\CObject.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\Includes\CTimer.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\Includes\Main.h
-# End Source File
-# End Group
-# Begin Group "Resource Files"
-
-# PROP Default_Filter "ico;cur;bmp;dlg;rc2;rct;bin;rgs;gif;jpg;jpeg;jpe"
-# Begin Source File
-
-SOURCE=.\Res\directx.ico
-# End Source File
-# Begin Source File
-
-SOURCE=.\Res\resource.h
-# End Source File
-# Begin Source File
-
-SOURCE=.\Res\Software_Render.rc
-# End Source File
-# End Group
-# Begin Group "Documents"
-
-# PROP Default_Filter ""
-# Begin Source File
-
-SOURCE=.\Docs\Readme.txt
-# End Source File
-# End Group
-# End Target
-# End Project
+# Microsoft Developer Studio Project File - Name="Software_Render" - Package Owner=<4>
+# Microsoft Developer Studio Generated Build File, Format Version 6.00
+# ** DO NOT EDIT **
+
+# TARGTYPE "Win32 (x86) Application" 0x0101
+
+CFG=Software_Render - Win32 Debug
+!MESSAGE This is not a valid makefile. To build this project using NMAKE,
+!MESSAGE use the Export Makefile command and run
+!MESSAGE 
+!MESSAGE NMAKE /f "Software_Render.mak".
+!MESSAGE 
+!MESSAGE You can specify a configuration when running NMAKE
+!MESSAGE by defining the macro CFG on the command line. For example:
+!MESSAGE 
+!MESSAGE NMAKE /f "Software_Render.mak" CFG="Software_Render - Win32 Debug"
+!MESSAGE 
+!MESSAGE Possible choices for configuration are:
+!MESSAGE 
+!MESSAGE "Software_Render - Win32 Release" (based on "Win32 (x86) Application")
+!MESSAGE "Software_Render - Win32 Debug" (based on "Win32 (x86) Application")
+!MESSAGE 
+
+# Begin Project
+# PROP AllowPerConfigDependencies 0
+# PROP Scc_ProjName ""
+# PROP Scc_LocalPath ""
+CPP=cl.exe
+MTL=midl.exe
+RSC=rc.exe
+
+!IF  "$(CFG)" == "Software_Render - Win32 Release"
+
+# PROP BASE Use_MFC 0
+# PROP BASE Use_Debug_Libraries 0
+# PROP BASE Output_Dir "Release"
+# PROP BASE Intermediate_Dir "Release"
+# PROP BASE Target_Dir ""
+# PROP Use_MFC 0
+# PROP Use_Debug_Libraries 0
+# PROP Output_Dir "Compiled\Release"
+# PROP Intermediate_Dir "Compiled\Release"
+# PROP Ignore_Export_Lib 0
+# PROP Target_Dir ""
+# ADD BASE CPP /nologo /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /c
+# ADD CPP /nologo /MT /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /c
+# ADD BASE MTL /nologo /D "NDEBUG" /mktyplib203 /win32
+# ADD MTL /nologo /D "NDEBUG" /mktyplib203 /win32
+# ADD BASE RSC /l 0x809 /d "NDEBUG"
+# ADD RSC /l 0x809 /d "NDEBUG"
+BSC32=bscmake.exe
+# ADD BASE BSC32 /nologo
+# ADD BSC32 /nologo
+LINK32=link.exe
+# ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:windows /machine:I386
+# ADD LINK32 user32.lib gdi32.lib advapi32.lib winmm.lib d3dx9.lib /nologo /subsystem:windows /machine:I386
+
+!ELSEIF  "$(CFG)" == "Software_Render - Win32 Debug"
+
+# PROP BASE Use_MFC 0
+# PROP BASE Use_Debug_Libraries 1
+# PROP BASE Output_Dir "Debug"
+# PROP BASE Intermediate_Dir "Debug"
+# PROP BASE Target_Dir ""
+# PROP Use_MFC 0
+# PROP Use_Debug_Libraries 1
+# PROP Output_Dir "Compiled\Debug"
+# PROP Intermediate_Dir "Compiled\Debug"
+# PROP Ignore_Export_Lib 0
+# PROP Target_Dir ""
+# ADD BASE CPP /nologo /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /GZ /c
+# ADD CPP /nologo /MTd /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /GZ /c
+# ADD BASE MTL /nologo /D "_DEBUG" /mktyplib203 /win32
+# ADD MTL /nologo /D "_DEBUG" /mktyplib203 /win32
+# ADD BASE RSC /l 0x809 /d "_DEBUG"
+# ADD RSC /l 0x809 /d "_DEBUG"
+BSC32=bscmake.exe
+# ADD BASE BSC32 /nologo
+# ADD BSC32 /nologo
+LINK32=link.exe
+# ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:windows /debug /machine:I386 /pdbtype:sept
+# ADD LINK32 user32.lib gdi32.lib advapi32.lib winmm.lib d3dx9.lib /nologo /subsystem:windows /debug /machine:I386 /pdbtype:sept
+
+!ENDIF 
+
+# Begin Target
+
+# Name "Software_Render - Win32 Release"
+# Name "Software_Render - Win32 Debug"
+# Begin Group "Source Files"
+
+# PROP Default_Filter "cpp;c;cxx;rc;def;r;odl;idl;hpj;bat"
+# Begin Source File
+
+SOURCE=.\Source\CBenchmark.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CClipper.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CCpuInfo.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CFrustum.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CGameApp.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CHiZBuffer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CObject.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CPresentQueue.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CRasterizer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CTexture.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CThreadPool.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CTimer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CVertexCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\Main.cpp
+# End Source File
+# End Group
+# Begin Group "Header Files"
+
+# PROP Default_Filter "h;hpp;hxx;hm;inl"
+# Begin Source File
+
+SOURCE=.\Includes\CBenchmark.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CClipper.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CCpuInfo.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CFrustum.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CGameApp.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CHiZBuffer.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CObject.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CPresentQueue.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CRasterizer.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CTexture.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CThreadPool.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CTimer.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CVertexCache.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\Main.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\Platform.h
+# End Source File
+# End Group
+# Begin Group "Resource Files"
+
+# PROP Default_Filter "ico;cur;bmp;dlg;rc2;rct;bin;rgs;gif;jpg;jpeg;jpe"
+# Begin Source File
+
+SOURCE=.\Res\directx.ico
+# End Source File
+# Begin Source File
+
+SOURCE=.\Res\resource.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Res\Software_Render.rc
+# End Source File
+# End Group
+# Begin Group "Documents"
+
+# PROP Default_Filter ""
+# Begin Source File
+
+SOURCE=.\Docs\Readme.txt
+# End Source File
+# End Group
+# End Target
+# End Project
@@ -0,0 +1,426 @@
+//-----------------------------------------------------------------------------
+// File: CBenchmark.cpp
+//
+// Desc: Micro-benchmarks for the software pipeline, run instead of the demo
+//       when the application is started with the '-bench' switch.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CBenchmark Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CBenchmark.h"
+#include "../Includes/CVertexCache.h"
+#include "../Includes/CRasterizer.h"
+#include "../Includes/CTexture.h"
+#include "../Includes/CHiZBuffer.h"
+#include "../Includes/CCpuInfo.h"
+#include <stdarg.h>
+#include <vector>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Name : Run () (Static)
+// Desc : Runs every benchmark, writing the results to the file specified.
+//-----------------------------------------------------------------------------
+bool CBenchmark::Run( LPCTSTR strFileName )
+{
+    FILE * pFile = _tfopen( strFileName, _T("w") );
+    if ( !pFile ) return false;
+
+    Report( pFile, "Software Render Benchmark\n" );
+    Report( pFile, "CPU : SSE2 %s, AVX %s, AVX2 %s\n\n", CCpuInfo::HasSSE2() ? "yes" : "no",
+            CCpuInfo::HasAVX() ? "yes" : "no", CCpuInfo::HasAVX2() ? "yes" : "no" );
+
+    // Run the individual benchmarks
+    BenchMeshBuild( pFile );
+    BenchTransform( pFile );
+    BenchTexture( pFile );
+    BenchHiZ( pFile );
+
+    fclose( pFile );
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetTime () (Static, Private)
+// Desc : Returns a high resolution time stamp in seconds.
+//-----------------------------------------------------------------------------
+double CBenchmark::GetTime( )
+{
+#ifdef _WIN32
+    static __int64 Frequency = 0;
+    __int64 Counter;
+
+    if ( !Frequency ) QueryPerformanceFrequency( (LARGE_INTEGER*)&Frequency );
+    QueryPerformanceCounter( (LARGE_INTEGER*)&Counter );
+    return (double)Counter / (double)Frequency;
+#else
+    timespec Time;
+    clock_gettime( CLOCK_MONOTONIC, &Time );
+    return (double)Time.tv_sec + (double)Time.tv_nsec * 1e-9;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Name : Report () (Static, Private)
+// Desc : printf style output to both the results file and stdout.
+//-----------------------------------------------------------------------------
+void CBenchmark::Report( FILE * pFile, const char * strFormat, ... )
+{
+    va_list Args;
+
+    va_start( Args, strFormat );
+    vfprintf( pFile, strFormat, Args );
+    va_end( Args );
+
+    va_start( Args, strFormat );
+    vprintf( strFormat, Args );
+    va_end( Args );
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildTestMesh () (Static, Private)
+// Desc : Builds a gently curved grid of quads through the bulk builder
+//        interface, each quad sharing its corners with its neighbours.
+//-----------------------------------------------------------------------------
+bool CBenchmark::BuildTestMesh( CMesh & Mesh, ULONG QuadsX, ULONG QuadsY )
+{
+    std::vector<CVertex> Vertices;
+    std::vector<ULONG>   Indices;
+    ULONG x, y, Row = QuadsX + 1;
+    float fx;
+
+    // Generate the grid points
+    Vertices.reserve( (QuadsX + 1) * (QuadsY + 1) );
+    for ( y = 0; y <= QuadsY; y++ )
+    {
+        for ( x = 0; x <= QuadsX; x++ )
+        {
+            fx = (float)x - QuadsX * 0.5f;
+            Vertices.push_back( CVertex( fx, (float)y - QuadsY * 0.5f, (fx * fx) * 0.001f ) );
+
+        } // Next Column
+
+    } // Next Row
+
+    // Generate the quads, wound the same way as the demo cube
+    Indices.reserve( QuadsX * QuadsY * 4 );
+    for ( y = 0; y < QuadsY; y++ )
+    {
+        for ( x = 0; x < QuadsX; x++ )
+        {
+            Indices.push_back( (y + 1) * Row + x );
+            Indices.push_back( (y + 1) * Row + x + 1 );
+            Indices.push_back( y * Row + x + 1 );
+            Indices.push_back( y * Row + x );
+
+        } // Next Column
+
+    } // Next Row
+
+    // Fill the mesh
+    Mesh.Release();
+    if ( !Mesh.Reserve( (ULONG)Vertices.size(), (ULONG)Indices.size(), QuadsX * QuadsY ) ) return false;
+    if ( Mesh.AddVertices( &Vertices[0], (ULONG)Vertices.size() ) < 0 ) return false;
+    if ( Mesh.AddFaces( &Indices[0], QuadsX * QuadsY, 4 ) < 0 ) return false;
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : BenchMeshBuild () (Static, Private)
+// Desc : Times building a large mesh one polygon at a time through the
+//        polygon staging interface (as BuildObjects does), and in bulk.
+//-----------------------------------------------------------------------------
+void CBenchmark::BenchMeshBuild( FILE * pFile )
+{
+    const ULONG QuadsX = 512, QuadsY = 512;
+    CMesh       Mesh;
+    ULONG       x, y;
+    long        Poly;
+    double      Start, Time;
+    float       fx, fy;
+
+    Report( pFile, "Mesh build : %lu quads\n", QuadsX * QuadsY );
+
+    // Polygon at a time, welded by Commit
+    Start = GetTime();
+    for ( y = 0; y < QuadsY; y++ )
+    {
+        for ( x = 0; x < QuadsX; x++ )
+        {
+            if ( (Poly = Mesh.AddPolygon( 1 )) < 0 ) break;
+            CPolygon * pPoly = Mesh.m_pPolygon[ Poly ];
+            if ( pPoly->AddVertex( 4 ) < 0 ) break;
+
+            fx = (float)x - QuadsX * 0.5f;
+            fy = (float)y - QuadsY * 0.5f;
+            pPoly->m_pVertex[0] = CVertex( fx,        fy + 1.0f, 0.0f );
+            pPoly->m_pVertex[1] = CVertex( fx + 1.0f, fy + 1.0f, 0.0f );
+            pPoly->m_pVertex[2] = CVertex( fx + 1.0f, fy,        0.0f );
+            pPoly->m_pVertex[3] = CVertex( fx,        fy,        0.0f );
+
+        } // Next Column
+
+    } // Next Row
+    Mesh.Commit();
+    Time = GetTime() - Start;
+    Report( pFile, "  %-16s : %9.3f ms (%lu vertices, %lu faces)\n", "AddPolygon",
+            Time * 1000.0, Mesh.m_nPositionCount, Mesh.m_nFaceCount );
+
+    // Bulk builder
+    Start = GetTime();
+    BuildTestMesh( Mesh, QuadsX, QuadsY );
+    Time = GetTime() - Start;
+    Report( pFile, "  %-16s : %9.3f ms (%lu vertices, %lu faces)\n\n", "Bulk",
+            Time * 1000.0, Mesh.m_nPositionCount, Mesh.m_nFaceCount );
+}
+
+//-----------------------------------------------------------------------------
+// Name : BenchTransform () (Static, Private)
+// Desc : Compares the original per polygon vertex D3DX transform (three
+//        D3DXVec3TransformCoord calls for every vertex of every polygon) with
+//        the batched single matrix transform of each unique position.
+//-----------------------------------------------------------------------------
+void CBenchmark::BenchTransform( FILE * pFile )
+{
+    const ULONG     Iterations = 20;
+    const float     Width = 640.0f, Height = 480.0f;
+    CMesh           Mesh;
+    CVertexCache    Cache;
+    D3DXMATRIX      mtxWorld, mtxView, mtxProj, mtxWVP;
+    D3DXVECTOR3     vtxCurrent;
+    double          Start, Scalar, Time, CheckSum = 0.0;
+    ULONG           i, f, v, Index;
+
+    static const CVertexCache::TRANSFORM_PATH Paths[] = { CVertexCache::PATH_SCALAR, CVertexCache::PATH_SSE, CVertexCache::PATH_AVX };
+    static const char * PathNames[] = { "SoA scalar", "SoA SSE", "SoA AVX" };
+
+    if ( !BuildTestMesh( Mesh, 256, 256 ) ) { Report( pFile, "Transform : failed to build test mesh.\n" ); return; }
+
+    // Set up the same style of matrices the demo uses
+    D3DXMatrixTranslation( &mtxWorld, 0.0f, 0.0f, 300.0f );
+    D3DXMatrixIdentity( &mtxView );
+    D3DXMatrixPerspectiveFovLH( &mtxProj, D3DXToRadian( 60.0f ), Width / Height, 1.01f, 1000.0f );
+    D3DXMatrixMultiply( &mtxWVP, &mtxWorld, &mtxView );
+    D3DXMatrixMultiply( &mtxWVP, &mtxWVP, &mtxProj );
+
+    Report( pFile, "Transform : %lu faces, %lu face vertices, %lu unique positions, %lu iterations\n",
+            Mesh.m_nFaceCount, Mesh.m_nIndexCount, Mesh.m_nPositionCount, Iterations );
+
+    // Original path, one vertex of one face at a time (including the
+    // repeated first vertex used to close the outline).
+    Start = GetTime();
+    for ( i = 0; i < Iterations; i++ )
+    {
+        for ( f = 0; f < Mesh.m_nFaceCount; f++ )
+        {
+            const MESHFACE & Face = Mesh.m_pFace[f];
+            for ( v = 0; v < Face.IndexCount + 1; v++ )
+            {
+                Index = Mesh.m_pIndex[ Face.FirstIndex + (v % Face.IndexCount) ];
+                vtxCurrent = D3DXVECTOR3( Mesh.m_pPositionX[Index], Mesh.m_pPositionY[Index], Mesh.m_pPositionZ[Index] );
+                D3DXVec3TransformCoord( &vtxCurrent, &vtxCurrent, &mtxWorld );
+                D3DXVec3TransformCoord( &vtxCurrent, &vtxCurrent, &mtxView );
+                D3DXVec3TransformCoord( &vtxCurrent, &vtxCurrent, &mtxProj );
+                CheckSum += vtxCurrent.x * Width / 2 + vtxCurrent.y * Height / 2;
+
+            } // Next Vertex
+
+        } // Next Face
+
+    } // Next Iteration
+    Scalar = GetTime() - Start;
+    Report( pFile, "  %-16s : %9.3f ms / iteration (checksum %g)\n", "D3DX per vertex",
+            Scalar * 1000.0 / Iterations, CheckSum );
+
+    // Batched paths
+    Cache.SetViewport( 0.0f, 0.0f, Width, Height );
+    for ( ULONG p = 0; p < 3; p++ )
+    {
+        if ( !Cache.SetPath( Paths[p] ) ) { Report( pFile, "  %-16s : not supported\n", PathNames[p] ); continue; }
+
+        // Warm up (allocates the cache arrays)
+        Cache.Transform( &Mesh, mtxWVP );
+
+        Start = GetTime();
+        for ( i = 0; i < Iterations; i++ ) Cache.Transform( &Mesh, mtxWVP );
+        Time = GetTime() - Start;
+
+        // Sum the results so the SIMD paths can be checked against the scalar one
+        CheckSum = 0.0;
+        for ( f = 0; f < Cache.m_nCount; f++ ) CheckSum += Cache.m_pScreenX[f] + Cache.m_pScreenY[f];
+
+        Report( pFile, "  %-16s : %9.3f ms / iteration, %6.2fx (checksum %g)\n", PathNames[p],
+                Time * 1000.0 / Iterations, (Time > 0.0) ? Scalar / Time : 0.0, CheckSum );
+
+    } // Next Path
+
+    Report( pFile, "\n" );
+}
+
+//-----------------------------------------------------------------------------
+// Name : BenchTexture () (Static, Private)
+// Desc : Measures textured fill rate, in megapixels per second, for each span
+//        kernel and filter mode at 640x480 and 1920x1080. Every frame covers
+//        the screen with several depth tested layers of a receding textured
+//        plane, drawn nearest last so that every layer is written.
+// Note : Uses a single thread so that the kernels themselves are compared.
+//-----------------------------------------------------------------------------
+void CBenchmark::BenchTexture( FILE * pFile )
+{
+    const ULONG     Frames = 10, Layers = 4;
+    const ULONG     Sizes[2][2] = { { 640, 480 }, { 1920, 1080 } };
+    CRasterizer     Rasterizer;
+    CTexture        Texture;
+    RASTERVERTEX    Quad[4];
+    float           BaseU[4];
+    double          Start, Time, CheckSum;
+    ULONG           s, p, f, i, l, x, y, Flags;
+
+    static const CRasterizer::SPAN_PATH Paths[] = { CRasterizer::SPAN_SCALAR, CRasterizer::SPAN_SSE2, CRasterizer::SPAN_AVX2 };
+    static const char * PathNames[] = { "Scalar", "SSE2", "AVX2" };
+
+    if ( !Texture.CreateChecker( 256, 16, 0x00FFA040, 0x00603010 ) ) { Report( pFile, "Texture : failed to build texture.\n" ); return; }
+
+    Report( pFile, "Texture : %lu layers, %lu frames, single thread\n", Layers, Frames );
+
+    for ( s = 0; s < 2; s++ )
+    {
+        ULONG Width = Sizes[s][0], Height = Sizes[s][1];
+        if ( !Rasterizer.SetBufferSize( Width, Height ) ) { Report( pFile, "  %lux%lu : failed to allocate buffers.\n", Width, Height ); continue; }
+
+        // Screen filling quad, the top edge four times further away than the bottom
+        Quad[0].x = 0.0f;         Quad[0].y = 0.0f;          Quad[0].rhw = 0.25f; Quad[0].u = 0.0f; Quad[0].v = 0.0f;
+        Quad[1].x = (float)Width; Quad[1].y = 0.0f;          Quad[1].rhw = 0.25f; Quad[1].u = 8.0f; Quad[1].v = 0.0f;
+        Quad[2].x = (float)Width; Quad[2].y = (float)Height; Quad[2].rhw = 1.0f;  Quad[2].u = 8.0f; Quad[2].v = 8.0f;
+        Quad[3].x = 0.0f;         Quad[3].y = (float)Height; Quad[3].rhw = 1.0f;  Quad[3].u = 0.0f; Quad[3].v = 8.0f;
+        for ( x = 0; x < 4; x++ ) BaseU[x] = Quad[x].u;
+
+        for ( f = 0; f < 2; f++ )
+        {
+            Flags = CRasterizer::RASTER_DEPTHTEST | CRasterizer::RASTER_DEPTHWRITE;
+            if ( f ) Flags |= CRasterizer::RASTER_BILINEAR;
+
+            for ( p = 0; p < 3; p++ )
+            {
+                if ( !Rasterizer.SetSpanPath( Paths[p] ) ) { Report( pFile, "  %4lux%-4lu %-8s %-6s : not supported\n", Width, Height, f ? "Bilinear" : "Nearest", PathNames[p] ); continue; }
+
+                Start = GetTime();
+                for ( i = 0; i < Frames; i++ )
+                {
+                    Rasterizer.BeginFrame( 0, 1.0f );
+                    for ( l = 0; l < Layers; l++ )
+                    {
+                        // Each layer is nearer than the last, and offset slightly
+                        for ( x = 0; x < 4; x++ ) { Quad[x].z = 0.9f - l * 0.1f; Quad[x].u = BaseU[x] + l * 0.25f; }
+                        Rasterizer.DrawTexturedTriangle( Quad[0], Quad[1], Quad[2], &Texture, Flags );
+                        Rasterizer.DrawTexturedTriangle( Quad[0], Quad[2], Quad[3], &Texture, Flags );
+
+                    } // Next Layer
+                    Rasterizer.EndFrame();
+
+                } // Next Frame
+                Time = GetTime() - Start;
+
+                // Sum the final image so the paths can be compared
+                CheckSum = 0.0;
+                for ( y = 0; y < Height; y++ )
+                {
+                    const ULONG * pRow = Rasterizer.GetColorBuffer() + y * Rasterizer.GetPitch();
+                    for ( x = 0; x < Width; x++ ) CheckSum += (pRow[x] & 0xFF) + ((pRow[x] >> 8) & 0xFF) + ((pRow[x] >> 16) & 0xFF);
+
+                } // Next Row
+
+                Report( pFile, "  %4lux%-4lu %-8s %-6s : %9.2f MPix/s (checksum %g)\n", Width, Height, f ? "Bilinear" : "Nearest",
+                        PathNames[p], (Time > 0.0) ? (double)Width * Height * Layers * Frames / (Time * 1e6) : 0.0, CheckSum );
+
+            } // Next Path
+
+        } // Next Filter
+
+    } // Next Size
+
+    Report( pFile, "\n" );
+}
+
+//-----------------------------------------------------------------------------
+// Name : BenchHiZ () (Static, Private)
+// Desc : Times building the depth pyramid at 640x480 and 1920x1080, and the
+//        cost of testing randomly placed rectangles against it. The depth
+//        buffer holds a receding floor with a near occluder covering its
+//        centre, roughly as the demo would produce.
+// Note : Uses a single thread so that the build itself is measured.
+//-----------------------------------------------------------------------------
+void CBenchmark::BenchHiZ( FILE * pFile )
+{
+    const ULONG     Builds = 100, Queries = 1000000;
+    const ULONG     Sizes[2][2] = { { 640, 480 }, { 1920, 1080 } };
+    CHiZBuffer      HiZBuffer;
+    std::vector<float> Depth, Rects;
+    double          Start, BuildTime, QueryTime;
+    ULONG           s, i, x, y, Pitch, Hidden;
+
+    Report( pFile, "HiZ : %lu builds, %lu queries, single thread\n", Builds, Queries );
+
+    for ( s = 0; s < 2; s++ )
+    {
+        ULONG Width = Sizes[s][0], Height = Sizes[s][1];
+
+        // Build the test depth buffer (padded rows, as the rasterizer's)
+        Pitch = (Width + 7) & ~7;
+        Depth.resize( Pitch * Height );
+        for ( y = 0; y < Height; y++ )
+        {
+            for ( x = 0; x < Width; x++ )
+            {
+                bool bOccluder = ( x > Width / 4 && x < Width * 3 / 4 && y > Height / 4 && y < Height * 3 / 4 );
+                Depth[ y * Pitch + x ] = bOccluder ? 0.2f : 1.0f - 0.5f * y / Height;
+
+            } // Next Column
+
+        } // Next Row
+
+        // Time the pyramid build
+        Start = GetTime();
+        for ( i = 0; i < Builds; i++ ) HiZBuffer.Build( &Depth[0], Width, Height, Pitch );
+        BuildTime = GetTime() - Start;
+
+        // Random rectangles of up to a quarter of the screen, at random depths
+        srand( 1 );
+        Rects.resize( Queries * 5 );
+        for ( i = 0; i < Queries; i++ )
+        {
+            float * pRect = &Rects[ i * 5 ];
+            pRect[0] = (float)(rand() % Width);
+            pRect[1] = (float)(rand() % Height);
+            pRect[2] = pRect[0] + (float)(rand() % (Width / 4));
+            pRect[3] = pRect[1] + (float)(rand() % (Height / 4));
+            pRect[4] = 0.25f + 0.75f * rand() / RAND_MAX;
+
+        } // Next Query
+
+        // Time the queries
+        Hidden = 0;
+        Start  = GetTime();
+        for ( i = 0; i < Queries; i++ )
+        {
+            const float * pRect = &Rects[ i * 5 ];
+            if ( !HiZBuffer.IsVisible( pRect[0], pRect[1], pRect[2], pRect[3], pRect[4] ) ) Hidden++;
+
+        } // Next Query
+        QueryTime = GetTime() - Start;
+
+        Report( pFile, "  %4lux%-4lu : build %8.3f ms, query %6.1f ns (%lu levels, %.1f%% hidden)\n", Width, Height,
+                BuildTime * 1e3 / Builds, QueryTime * 1e9 / Queries, HiZBuffer.GetLevelCount(), 100.0 * Hidden / Queries );
+
+    } // Next Size
+
+    Report( pFile, "\n" );
+}
@@ -0,0 +1,191 @@
+//-----------------------------------------------------------------------------
+// File: CClipper.cpp
+//
+// Desc: Homogeneous clip space polygon clipper. Faces are classified using
+//       the per vertex clip codes generated by the vertex cache, and only
+//       those crossing the near plane or the guard band are clipped (using
+//       Sutherland-Hodgman) before the perspective divide.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CClipper Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CClipper.h"
+
+//-----------------------------------------------------------------------------
+// Name : CClipper () (Constructor)
+// Desc : CClipper Class Constructor
+//-----------------------------------------------------------------------------
+CClipper::CClipper()
+{
+	// Reset / Clear all required values
+    ResetStats();
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CClipper () (Destructor)
+// Desc : CClipper Class Destructor
+//-----------------------------------------------------------------------------
+CClipper::~CClipper()
+{
+}
+
+//-----------------------------------------------------------------------------
+// Name : ResetStats ()
+// Desc : Resets the face classification counters.
+//-----------------------------------------------------------------------------
+void CClipper::ResetStats( )
+{
+    m_nAccepted = 0;
+    m_nRejected = 0;
+    m_nClipped  = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ClipPolygon ()
+// Desc : Builds the screen space outline of the face described by the
+//        vertex cache indices specified, and returns its vertex count (0 if
+//        nothing remains visible). The outline is valid until the next call.
+// Note : The optional texture coordinates are supplied per face corner (in
+//        the same order as the indices), and are interpolated by the clipper.
+//-----------------------------------------------------------------------------
+ULONG CClipper::ClipPolygon( const CVertexCache & Cache, const ULONG * pIndices, ULONG Count,
+                             RASTERVERTEX ** ppVertices, const D3DXVECTOR2 * pTexCoords )
+{
+    ULONG   i, Index, CodeOr = 0, CodeAnd = 0xFFFFFFFF;
+    float   gx = Cache.GetGuardBandX(), gy = Cache.GetGuardBandY();
+    int     Current = 0;
+
+    // Planes we clip against, matched to their clip code (ax + by + cz + dw >= 0 is inside)
+    const float Planes[5][4] = { { 0,  0, 1, 0  },      // Near
+                                 { 1,  0, 0, gx },      // Guard band left
+                                 {-1,  0, 0, gx },      // Guard band right
+                                 { 0,  1, 0, gy },      // Guard band bottom
+                                 { 0, -1, 0, gy } };    // Guard band top
+    const ULONG PlaneCodes[5] = { CVertexCache::CLIP_NEAR, CVertexCache::CLIP_GUARD_LEFT,
+                                  CVertexCache::CLIP_GUARD_RIGHT, CVertexCache::CLIP_GUARD_BOTTOM,
+                                  CVertexCache::CLIP_GUARD_TOP };
+
+    // Combine the vertex clip codes
+    for ( i = 0; i < Count; i++ )
+    {
+        CodeOr  |= Cache.m_pClipCode[ pIndices[i] ];
+        CodeAnd &= Cache.m_pClipCode[ pIndices[i] ];
+
+    } // Next Vertex
+
+    // Trivial reject, every vertex is outside the same view plane
+    if ( Count < 3 || (CodeAnd & CVertexCache::CLIP_REJECT_MASK) ) { m_nRejected++; return 0; }
+
+    // Make sure we have room for the worst case output
+    if ( m_Output.size() < Count + 5 ) m_Output.resize( Count + 5 );
+
+    // Trivial accept, use the cached screen space positions directly
+    if ( (CodeOr & CVertexCache::CLIP_CLIP_MASK) == 0 )
+    {
+        for ( i = 0; i < Count; i++ )
+        {
+            Index = pIndices[i];
+            m_Output[i].x = Cache.m_pScreenX[ Index ];
+            m_Output[i].y = Cache.m_pScreenY[ Index ];
+            m_Output[i].z   = Cache.m_pScreenZ[ Index ];
+            m_Output[i].rhw = Cache.m_pScreenW[ Index ];
+            m_Output[i].u   = (pTexCoords) ? pTexCoords[i].x : 0.0f;
+            m_Output[i].v   = (pTexCoords) ? pTexCoords[i].y : 0.0f;
+
+        } // Next Vertex
+
+        m_nAccepted++;
+        *ppVertices = &m_Output[0];
+        return Count;
+
+    } // End if trivially accepted
+
+    // Gather the clip space vertices
+    m_nClipped++;
+    m_Clip[0].resize( Count );
+    for ( i = 0; i < Count; i++ )
+    {
+        Index = pIndices[i];
+        m_Clip[0][i].x = Cache.m_pClipX[ Index ];
+        m_Clip[0][i].y = Cache.m_pClipY[ Index ];
+        m_Clip[0][i].z = Cache.m_pClipZ[ Index ];
+        m_Clip[0][i].w = Cache.m_pClipW[ Index ];
+        m_Clip[0][i].u = (pTexCoords) ? pTexCoords[i].x : 0.0f;
+        m_Clip[0][i].v = (pTexCoords) ? pTexCoords[i].y : 0.0f;
+
+    } // Next Vertex
+
+    // Clip against each plane that at least one vertex lies outside of
+    for ( i = 0; i < 5; i++ )
+    {
+        if ( !(CodeOr & PlaneCodes[i]) ) continue;
+
+        ClipToPlane( m_Clip[Current], m_Clip[Current ^ 1], Planes[i] );
+        Current ^= 1;
+        if ( m_Clip[Current].size() < 3 ) return 0;
+
+    } // Next Plane
+
+    // Perspective divide and viewport transform
+    Count = (ULONG)m_Clip[Current].size();
+    if ( m_Output.size() < Count ) m_Output.resize( Count );
+    for ( i = 0; i < Count; i++ )
+    {
+        const CLIPVERTEX & v = m_Clip[Current][i];
+        Cache.ToScreen( v.x, v.y, v.z, v.w, m_Output[i].x, m_Output[i].y, m_Output[i].z, m_Output[i].rhw );
+        m_Output[i].u = v.u;
+        m_Output[i].v = v.v;
+
+    } // Next Vertex
+
+    *ppVertices = &m_Output[0];
+    return Count;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ClipToPlane () (Private)
+// Desc : Sutherland-Hodgman clip of a polygon against a single plane.
+//-----------------------------------------------------------------------------
+void CClipper::ClipToPlane( const VectorClipVertex & In, VectorClipVertex & Out, const float Plane[4] )
+{
+    ULONG       i, Count = (ULONG)In.size();
+    float       d0, d1, t;
+    CLIPVERTEX  v;
+
+    Out.clear();
+    if ( Count == 0 ) return;
+
+    // Start with the edge running from the last vertex to the first
+    const CLIPVERTEX * p0 = &In[ Count - 1 ];
+    d0 = Plane[0] * p0->x + Plane[1] * p0->y + Plane[2] * p0->z + Plane[3] * p0->w;
+
+    for ( i = 0; i < Count; i++ )
+    {
+        const CLIPVERTEX * p1 = &In[i];
+        d1 = Plane[0] * p1->x + Plane[1] * p1->y + Plane[2] * p1->z + Plane[3] * p1->w;
+
+        // Does the edge cross the plane?
+        if ( (d0 >= 0.0f) != (d1 >= 0.0f) )
+        {
+            t   = d0 / (d0 - d1);
+            v.x = p0->x + (p1->x - p0->x) * t;
+            v.y = p0->y + (p1->y - p0->y) * t;
+            v.z = p0->z + (p1->z - p0->z) * t;
+            v.w = p0->w + (p1->w - p0->w) * t;
+            v.u = p0->u + (p1->u - p0->u) * t;
+            v.v = p0->v + (p1->v - p0->v) * t;
+            Out.push_back( v );
+
+        } // End if crossing
+
+        // Keep the end point if it is inside
+        if ( d1 >= 0.0f ) Out.push_back( *p1 );
+
+        p0 = p1;
+        d0 = d1;
+
+    } // Next Edge
+}
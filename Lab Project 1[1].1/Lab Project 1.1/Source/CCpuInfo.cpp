@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------------
+// File: CCpuInfo.cpp
+//
+// Desc: Processor feature detection, used to select between the scalar and
+//       SIMD (SSE / AVX) code paths at runtime.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CCpuInfo Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CCpuInfo.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Static Member Definitions
+//-----------------------------------------------------------------------------
+bool CCpuInfo::m_bDetected  = false;
+bool CCpuInfo::m_bSSE2      = false;
+bool CCpuInfo::m_bAVX       = false;
+bool CCpuInfo::m_bAVX2      = false;
+
+//-----------------------------------------------------------------------------
+// Name : HasSSE2 () (Static)
+// Desc : Returns true if SSE2 instructions may be used.
+//-----------------------------------------------------------------------------
+bool CCpuInfo::HasSSE2( )
+{
+    if ( !m_bDetected ) Detect();
+    return m_bSSE2;
+}
+
+//-----------------------------------------------------------------------------
+// Name : HasAVX () (Static)
+// Desc : Returns true if AVX instructions may be used.
+//-----------------------------------------------------------------------------
+bool CCpuInfo::HasAVX( )
+{
+    if ( !m_bDetected ) Detect();
+    return m_bAVX;
+}
+
+//-----------------------------------------------------------------------------
+// Name : HasAVX2 () (Static)
+// Desc : Returns true if AVX2 and FMA instructions may be used.
+//-----------------------------------------------------------------------------
+bool CCpuInfo::HasAVX2( )
+{
+    if ( !m_bDetected ) Detect();
+    return m_bAVX2;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Detect () (Static, Private)
+// Desc : Issues CPUID to determine the supported instruction sets. AVX also
+//        requires the OS to save the YMM registers, checked with XGETBV.
+//-----------------------------------------------------------------------------
+void CCpuInfo::Detect( )
+{
+    unsigned int Regs[4] = { 0, 0, 0, 0 }, MaxLeaf = 0;
+    unsigned __int64 XCR0 = 0;
+    bool bOSXSave, bFMA;
+
+    m_bDetected = true;
+
+#ifdef SIMD_AVX_SUPPORTED
+
+    // Retrieve the highest supported leaf, and the standard feature flags
+#if defined(_MSC_VER)
+    __cpuid( (int*)Regs, 0 ); MaxLeaf = Regs[0];
+    __cpuid( (int*)Regs, 1 );
+#else
+    MaxLeaf = __get_cpuid_max( 0, NULL );
+    __get_cpuid( 1, &Regs[0], &Regs[1], &Regs[2], &Regs[3] );
+#endif
+
+    m_bSSE2  = (Regs[3] & (1 << 26)) != 0;
+    bOSXSave = (Regs[2] & (1 << 27)) != 0;
+    bFMA     = (Regs[2] & (1 << 12)) != 0;
+    m_bAVX   = (Regs[2] & (1 << 28)) != 0;
+
+    // Make sure the OS saves the AVX register state
+    if ( m_bAVX && bOSXSave )
+    {
+#if defined(_MSC_VER)
+        XCR0 = _xgetbv( 0 );
+#else
+        unsigned int Low, High;
+        __asm__ __volatile__ ( "xgetbv" : "=a"(Low), "=d"(High) : "c"(0) );
+        XCR0 = ((unsigned __int64)High << 32) | Low;
+#endif
+    } // End if AVX
+
+    m_bAVX = m_bAVX && bOSXSave && ((XCR0 & 6) == 6);
+
+    // AVX2 lives in the extended feature flags
+    if ( m_bAVX && MaxLeaf >= 7 )
+    {
+#if defined(_MSC_VER)
+        __cpuidex( (int*)Regs, 7, 0 );
+#else
+        __cpuid_count( 7, 0, Regs[0], Regs[1], Regs[2], Regs[3] );
+#endif
+        m_bAVX2 = bFMA && (Regs[1] & (1 << 5)) != 0;
+
+    } // End if leaf 7 available
+
+#else
+
+    // Older compilers, SSE2 is the best we can do
+    m_bSSE2 = true;
+
+#endif
+}
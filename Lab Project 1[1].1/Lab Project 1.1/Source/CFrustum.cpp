@@ -0,0 +1,121 @@
+//-----------------------------------------------------------------------------
+// File: CFrustum.cpp
+//
+// Desc: View frustum class, used to cull bounding volumes that can not be
+//       seen before any of their geometry is processed.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CFrustum Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CFrustum.h"
+
+//-----------------------------------------------------------------------------
+// Name : CFrustum () (Constructor)
+// Desc : CFrustum Class Constructor
+//-----------------------------------------------------------------------------
+CFrustum::CFrustum()
+{
+	// Reset / Clear all required values
+    ZeroMemory( m_Planes, 6 * sizeof(D3DXPLANE) );
+}
+
+//-----------------------------------------------------------------------------
+// Name : CFrustum () (Alternate Constructor)
+// Desc : CFrustum Class Constructor, extracts the planes from the matrix
+//-----------------------------------------------------------------------------
+CFrustum::CFrustum( const D3DXMATRIX & mtx )
+{
+    CalcFrustumPlanes( mtx );
+}
+
+//-----------------------------------------------------------------------------
+// Name : CalcFrustumPlanes ()
+// Desc : Calculate the 6 frustum planes from the combined matrix specified.
+//-----------------------------------------------------------------------------
+void CFrustum::CalcFrustumPlanes( const D3DXMATRIX & m )
+{
+    // Left clipping plane
+    m_Planes[0].a = -(m._14 + m._11);
+    m_Planes[0].b = -(m._24 + m._21);
+    m_Planes[0].c = -(m._34 + m._31);
+    m_Planes[0].d = -(m._44 + m._41);
+
+    // Right clipping plane
+    m_Planes[1].a = -(m._14 - m._11);
+    m_Planes[1].b = -(m._24 - m._21);
+    m_Planes[1].c = -(m._34 - m._31);
+    m_Planes[1].d = -(m._44 - m._41);
+
+    // Top clipping plane
+    m_Planes[2].a = -(m._14 - m._12);
+    m_Planes[2].b = -(m._24 - m._22);
+    m_Planes[2].c = -(m._34 - m._32);
+    m_Planes[2].d = -(m._44 - m._42);
+
+    // Bottom clipping plane
+    m_Planes[3].a = -(m._14 + m._12);
+    m_Planes[3].b = -(m._24 + m._22);
+    m_Planes[3].c = -(m._34 + m._32);
+    m_Planes[3].d = -(m._44 + m._42);
+
+    // Near clipping plane
+    m_Planes[4].a = -(m._13);
+    m_Planes[4].b = -(m._23);
+    m_Planes[4].c = -(m._33);
+    m_Planes[4].d = -(m._43);
+
+    // Far clipping plane
+    m_Planes[5].a = -(m._14 - m._13);
+    m_Planes[5].b = -(m._24 - m._23);
+    m_Planes[5].c = -(m._34 - m._33);
+    m_Planes[5].d = -(m._44 - m._43);
+
+    // Normalize the planes so that sphere radii can be tested directly
+    for ( ULONG i = 0; i < 6; i++ ) D3DXPlaneNormalize( &m_Planes[i], &m_Planes[i] );
+}
+
+//-----------------------------------------------------------------------------
+// Name : SphereInFrustum ()
+// Desc : Determine whether or not the sphere passed is within the frustum.
+//-----------------------------------------------------------------------------
+bool CFrustum::SphereInFrustum( const D3DXVECTOR3 & Centre, float Radius ) const
+{
+    // Totally outside any one plane?
+    for ( ULONG i = 0; i < 6; i++ )
+    {
+        if ( D3DXPlaneDotCoord( &m_Planes[i], &Centre ) > Radius ) return false;
+
+    } // Next Plane
+
+    // Is (at least partially) within the frustum
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : BoundsInFrustum ()
+// Desc : Determine whether or not the box passed is within the frustum.
+//-----------------------------------------------------------------------------
+bool CFrustum::BoundsInFrustum( const D3DXVECTOR3 & Min, const D3DXVECTOR3 & Max ) const
+{
+    D3DXVECTOR3 NearPoint;
+
+    // Loop through all the planes
+    for ( ULONG i = 0; i < 6; i++ )
+    {
+        // Select the box corner furthest along the inward direction
+        NearPoint.x = (m_Planes[i].a > 0.0f) ? Min.x : Max.x;
+        NearPoint.y = (m_Planes[i].b > 0.0f) ? Min.y : Max.y;
+        NearPoint.z = (m_Planes[i].c > 0.0f) ? Min.z : Max.z;
+
+        // Near extreme point is outside, and thus the
+        // AABB is totally outside the frustum ?
+        if ( D3DXPlaneDotCoord( &m_Planes[i], &NearPoint ) > 0.0f ) return false;
+
+    } // Next Plane
+
+    // Is within the frustum
+    return true;
+}
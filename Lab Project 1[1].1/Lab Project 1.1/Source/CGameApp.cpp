@@ -9,7 +9,76 @@
 //-----------------------------------------------------------------------------
 // CGameApp Specific Includes
 //-----------------------------------------------------------------------------
-#include "..\\Includes\\CGameApp.h"
+#include "../Includes/CGameApp.h"
+
+//-----------------------------------------------------------------------------
+// Module Local Functions
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : RotateMatrix () (Private, Module Local)
+// Desc : Pre-multiplies the matrix by a yaw, then pitch, then roll rotation.
+//        Equivalent to building the three rotation matrices and multiplying
+//        them together and into the matrix, but the combined rotation is
+//        written out directly and only the upper 3x4 is touched.
+//-----------------------------------------------------------------------------
+static inline void RotateMatrix( D3DXMATRIX & mtx, float Yaw, float Pitch, float Roll )
+{
+    float sy = sinf( Yaw ),   cy = cosf( Yaw );
+    float sx = sinf( Pitch ), cx = cosf( Pitch );
+    float sz = sinf( Roll ),  cz = cosf( Roll );
+    float R[3][3], M[3][4];
+    ULONG i, j;
+
+    // Rotation Y * X * Z
+    R[0][0] = cy * cz - sy * sx * sz; R[0][1] = cy * sz + sy * sx * cz; R[0][2] = -sy * cx;
+    R[1][0] = -cx * sz;               R[1][1] = cx * cz;                R[1][2] = sx;
+    R[2][0] = sy * cz + cy * sx * sz; R[2][1] = sy * sz - cy * sx * cz; R[2][2] = cy * cx;
+
+    // Rotate the first three rows (the translation row is unaffected)
+    for ( i = 0; i < 3; i++ )
+        for ( j = 0; j < 4; j++ )
+            M[i][j] = R[i][0] * mtx.m[0][j] + R[i][1] * mtx.m[1][j] + R[i][2] * mtx.m[2][j];
+
+    for ( i = 0; i < 3; i++ )
+        for ( j = 0; j < 4; j++ )
+            mtx.m[i][j] = M[i][j];
+}
+
+//-----------------------------------------------------------------------------
+// Name : RandomFloat () (Private, Module Local)
+// Desc : Simple repeatable random number generator used to scatter the
+//        additional objects, returns a value in the range Min - Max.
+//-----------------------------------------------------------------------------
+static inline float RandomFloat( ULONG & Seed, float Min, float Max )
+{
+    Seed = Seed * 1664525UL + 1013904223UL;
+    return Min + (Max - Min) * ((Seed >> 8) & 0xFFFFFF) / (float)0xFFFFFF;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetSwitchValue () (Private, Module Local)
+// Desc : Retrieves the number following a '-name N' command line switch.
+//        Returns false, leaving 'Value' untouched, if it is not present.
+//-----------------------------------------------------------------------------
+static bool GetSwitchValue( LPCTSTR lpCmdLine, LPCTSTR strName, ULONG & Value )
+{
+    LPCTSTR strSwitch;
+
+    if ( !lpCmdLine || (strSwitch = _tcsstr( lpCmdLine, strName )) == NULL ) return false;
+    Value = (ULONG)_ttol( strSwitch + _tcslen( strName ) );
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Percentile () (Private, Module Local)
+// Desc : Returns the nearest rank percentile ('Fraction' of 0 - 1) of a
+//        sorted, non empty, list of values.
+//-----------------------------------------------------------------------------
+static inline double Percentile( const std::vector<double> & Sorted, double Fraction )
+{
+    ULONG Rank = (ULONG)ceil( Fraction * Sorted.size() );
+    return Sorted[ min( max( Rank, 1UL ), (ULONG)Sorted.size() ) - 1 ];
+}
 
 //-----------------------------------------------------------------------------
 // Name : CGameApp () (Constructor)
@@ -19,9 +88,29 @@ CGameApp::CGameApp()
 {
 	// Reset / Clear all required values
     m_hWnd              = NULL;
-    m_hdcFrameBuffer    = NULL;
-    m_hbmSelectOut      = NULL;
-    m_hbmFrameBuffer    = NULL;
+    m_LastFrameRate     = 0;
+    m_RenderMode        = RENDER_FLAT;
+    m_bCullBackFaces    = true;
+    m_bBilinear         = true;
+    m_bOcclusionCull    = true;
+    m_nOccludedCount    = 0;
+    m_nVisibleCount     = 0;
+    m_nObjectCount      = DEFAULT_OBJECT_COUNT;
+    m_pWorkers          = NULL;
+    m_nWorkerCount      = 0;
+    m_pDrawList         = NULL;
+    m_bTestOcclusion    = false;
+    m_nPresentLatency   = DEFAULT_PRESENT_LATENCY;
+    m_bHeadless         = false;
+    m_nFrameCount       = DEFAULT_HEADLESS_FRAMES;
+    m_nSeed             = 1;
+    m_nPresentFrame     = 0;
+    m_fTimeStep         = 0.0f;
+    m_bFrameStats       = false;
+    m_nViewX            = 0;
+    m_nViewY            = 0;
+    m_nViewWidth        = 0;
+    m_nViewHeight       = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -40,8 +129,77 @@ CGameApp::~CGameApp()
 //-----------------------------------------------------------------------------
 bool CGameApp::InitInstance( HANDLE hInstance, LPCTSTR lpCmdLine, int iCmdShow )
 {
-    // Create the primary display device
-    if (!CreateDisplay()) { ShutDown(); return false; }
+    LPCTSTR strSwitch;
+    LPTSTR  strEnd;
+    ULONG   Value;
+
+    // Number of objects to create ('-objects N'), used to measure throughput
+    if ( GetSwitchValue( lpCmdLine, _T("-objects"), m_nObjectCount ) )
+        m_nObjectCount = min( max( m_nObjectCount, DEFAULT_OBJECT_COUNT ), MAX_OBJECT_COUNT );
+
+    // Number of frames queued for presentation ('-latency N', 0 presents synchronously)
+    if ( GetSwitchValue( lpCmdLine, _T("-latency"), m_nPresentLatency ) )
+        m_nPresentLatency = min( m_nPresentLatency, MAX_PRESENT_LATENCY );
+
+    // Seed used to scatter the additional objects ('-seed N')
+    GetSwitchValue( lpCmdLine, _T("-seed"), m_nSeed );
+
+    // Write frame time statistics to 'FrameStats.txt' at shut down? ('-stats')
+    m_bFrameStats = ( lpCmdLine && _tcsstr( lpCmdLine, _T("-stats") ) );
+
+    // Render to memory only? (always, where there is no window support)
+#ifdef _WIN32
+    m_bHeadless = ( lpCmdLine && _tcsstr( lpCmdLine, _T("-headless") ) );
+#else
+    m_bHeadless = true;
+#endif
+
+    if ( m_bHeadless )
+    {
+        // Frame buffer size, number of frames and render mode of the scenario
+        m_nViewWidth  = DEFAULT_HEADLESS_WIDTH;
+        m_nViewHeight = DEFAULT_HEADLESS_HEIGHT;
+        GetSwitchValue( lpCmdLine, _T("-width"), m_nViewWidth );
+        GetSwitchValue( lpCmdLine, _T("-height"), m_nViewHeight );
+        GetSwitchValue( lpCmdLine, _T("-frames"), m_nFrameCount );
+        m_nFrameCount = max( m_nFrameCount, 1UL );
+
+        if ( GetSwitchValue( lpCmdLine, _T("-mode"), Value ) && Value >= RENDER_WIREFRAME && Value <= RENDER_TEXTURED )
+            m_RenderMode = (RENDER_MODE)Value;
+
+        // Frames to write out as images ('-dump 0,150,299')
+        if ( (strSwitch = _tcsstr( lpCmdLine, _T("-dump") )) != NULL )
+        {
+            for ( strSwitch += 5; ; strSwitch = strEnd + 1 )
+            {
+                Value = (ULONG)_tcstoul( strSwitch, &strEnd, 10 );
+                if ( strEnd == strSwitch ) break;
+                m_DumpFrames.push_back( Value );
+                if ( *strEnd != _T(',') ) break;
+
+            } // Next Frame
+
+            std::sort( m_DumpFrames.begin(), m_DumpFrames.end() );
+
+        } // End if dump specified
+
+    } // End if headless
+
+    // Spin up the worker threads (falls back to serial processing on failure)
+    m_ThreadPool.Create( );
+    m_Rasterizer.SetThreadPool( &m_ThreadPool );
+    m_HiZBuffer.SetThreadPool( &m_ThreadPool );
+
+    // Each pool thread transforms, clips and queues primitives independently
+    m_nWorkerCount = max( m_ThreadPool.GetThreadCount(), 1UL );
+    m_pWorkers     = new WorkerData[ m_nWorkerCount ];
+    if ( !m_pWorkers || !m_Rasterizer.SetQueueCount( m_nWorkerCount ) ) { ShutDown(); return false; }
+
+    // Create the primary display device (or just the frame buffer when headless)
+#ifdef _WIN32
+    if (!m_bHeadless && !CreateDisplay()) { ShutDown(); return false; }
+#endif
+    if (m_bHeadless && !CreateHeadless()) { ShutDown(); return false; }
 
     // Build Objects
     if (!BuildObjects()) { ShutDown(); return false; }
@@ -53,6 +211,7 @@ bool CGameApp::InitInstance( HANDLE hInstance, LPCTSTR lpCmdLine, int iCmdShow )
 	return true;
 }
 
+#ifdef _WIN32
 //-----------------------------------------------------------------------------
 // Name : CreateDisplay ()
 // Desc : Validate and set the current display device plugin, and create the
@@ -96,7 +255,7 @@ bool CGameApp::CreateDisplay()
     m_nViewHeight = rc.bottom - rc.top;
 
     // Build the frame buffer
-    if (!BuildFrameBuffer( Width, Height )) return false;
+    if (!BuildFrameBuffer( m_nViewWidth, m_nViewHeight )) return false;
     
 	// Show the window
 	ShowWindow(m_hWnd, SW_SHOW);
@@ -104,132 +263,137 @@ bool CGameApp::CreateDisplay()
     // Success!
     return true;
 }
+#endif // _WIN32
 
 //-----------------------------------------------------------------------------
-// Name : BuildFrameBuffer ()
-// Desc : Creates the frame buffer memory DC ready for use.
-// Note : Destroys the DC / Bitmap when needed, so can be re-used
+// Name : CreateHeadless ()
+// Desc : Headless counterpart to CreateDisplay, there is no window so only
+//        the in-memory frame buffer is created.
 //-----------------------------------------------------------------------------
-bool CGameApp::BuildFrameBuffer( ULONG Width, ULONG Height )
+bool CGameApp::CreateHeadless()
 {
-    // Obtain window's HDC.
-    HDC hDC = ::GetDC( m_hWnd );
-
-    // Create Frame Buffers Device Context if not already existant
-    if ( !m_hdcFrameBuffer ) m_hdcFrameBuffer = ::CreateCompatibleDC( hDC );
-    
-    // If an old FrameBuffer bitmap has already been generated then delete it
-    if ( m_hbmFrameBuffer ) 
-    {
-        // Select the frame buffer back out and destroy it
-        ::SelectObject( m_hdcFrameBuffer, m_hbmSelectOut );
-        ::DeleteObject( m_hbmFrameBuffer );
-        m_hbmFrameBuffer = NULL;
-        m_hbmSelectOut   = NULL;
+    // The whole frame buffer is used as the viewport
+    m_nViewX = 0;
+    m_nViewY = 0;
 
-    } // End if
-
-    // Create the frame buffer
-    m_hbmFrameBuffer = CreateCompatibleBitmap( hDC, Width, Height );    
-    if ( !m_hbmFrameBuffer ) return false;
-
-    // Select this bitmap into our Frame Buffer DC
-    m_hbmSelectOut = (HBITMAP)::SelectObject( m_hdcFrameBuffer, m_hbmFrameBuffer );
+    // Build the frame buffer
+    return BuildFrameBuffer( m_nViewWidth, m_nViewHeight );
+}
 
-    // Release windows HDC.
-    ::ReleaseDC( m_hWnd, hDC );
+//-----------------------------------------------------------------------------
+// Name : BuildFrameBuffer ()
+// Desc : Creates the in-memory color / depth buffers ready for use.
+// Note : Destroys any previous buffers when needed, so can be re-used
+//-----------------------------------------------------------------------------
+bool CGameApp::BuildFrameBuffer( ULONG Width, ULONG Height )
+{
+    // Finish presenting from the old buffers before they are destroyed
+    m_PresentQueue.Release();
+    m_Rasterizer.SetColorBuffer( NULL );
 
-    // Set up initial DC states
-    ::SetBkMode( m_hdcFrameBuffer, TRANSPARENT );
+    // The rasterizer owns the depth buffer (and a color buffer, used if the queue is unavailable)
+    if ( !m_Rasterizer.SetBufferSize( Width, Height ) ) return false;
 
-    // Success!!
-    return true;
+    // Frames are drawn into a ring of color buffers, presented on a separate thread
+    return m_PresentQueue.Create( Width, Height, m_Rasterizer.GetPitch(), m_nPresentLatency, StaticPresent, this );
 }
 
 //-----------------------------------------------------------------------------
 // Name : ClearFrameBuffer () (Private)
 // Desc : Clears the Frame Buffer (fills with the value passed)
+// Note : The clear is deferred, and is performed per tile by the rasterizer.
 //-----------------------------------------------------------------------------
 void CGameApp::ClearFrameBuffer( ULONG Color )
 {
+    // Draw into the next free buffer (waits if too many frames are still queued)
+    m_Rasterizer.SetColorBuffer( m_PresentQueue.AcquireBuffer() );
 
-    LOGBRUSH logBrush;
-    HBRUSH   hBrush = NULL, hOldBrush = NULL;
-    
-    // Set up the rendering brush
-    logBrush.lbStyle = BS_SOLID;
-    
-    // Set up the colour, converted to BGR & stripped of alpha
-    logBrush.lbColor = 0x00FFFFFF & RGB2BGR( Color );
-    
-    // Create the rendering brush
-    hBrush = ::CreateBrushIndirect( &logBrush );
-    if (!hBrush) return;
-
-    // Select into the frame buffer DC
-    hOldBrush = (HBRUSH)::SelectObject( m_hdcFrameBuffer, hBrush );
-
-    // Draw the rectangle
-    Rectangle( m_hdcFrameBuffer, m_nViewX, m_nViewY, m_nViewWidth, m_nViewHeight );
-    
-    // Destroy rendering brush
-    ::SelectObject( m_hdcFrameBuffer, hOldBrush );
-    ::DeleteObject( hBrush );
-
+    // Start the new frame, depth is reset to the far plane
+    m_Rasterizer.BeginFrame( Color, 1.0f );
 }
 
 //-----------------------------------------------------------------------------
 // Name : PresentFrameBuffer ()
-// Desc : We can now render the frame buffer to the final output device
+// Desc : Hands the finished frame over for presentation. With a latency of
+//        one or more frames the copy happens on the present thread, while
+//        the next frame is being drawn.
 //-----------------------------------------------------------------------------
 void CGameApp::PresentFrameBuffer( )
-{    
-    HDC hDC = NULL; 
-
-    // Retrieve the DC of the window
-    hDC = ::GetDC(m_hWnd);
+{
+    // Nothing to present?
+    if ( !m_Rasterizer.GetColorBuffer() ) return;
 
-    // Blit the frame buffer to the screen
-    ::BitBlt( hDC, m_nViewX, m_nViewY, m_nViewWidth, m_nViewHeight, m_hdcFrameBuffer,
-              m_nViewX, m_nViewY, SRCCOPY );
+    // Present the rasterizer's own buffer directly if the queue is unavailable
+    if ( m_PresentQueue.GetBufferCount() == 0 )
+    {
+        PresentBuffer( m_Rasterizer.GetColorBuffer(), m_Rasterizer.GetWidth(), m_Rasterizer.GetHeight(), m_Rasterizer.GetPitch() );
+        return;
 
-    // Clean up
-    ::ReleaseDC( m_hWnd, hDC );
+    } // End if no queue
 
+    m_PresentQueue.Submit();
 }
 
 //-----------------------------------------------------------------------------
-// Name : DrawLine () (Private)
-// Desc : Simple line drawing using GDI for clarity.
+// Name : StaticPresent () (Static Callback)
+// Desc : Present queue callback, routes through to the owning app object.
 //-----------------------------------------------------------------------------
-void CGameApp::DrawLine( const D3DXVECTOR3 & vtx1, const D3DXVECTOR3 & vtx2, ULONG Color )
+void CGameApp::StaticPresent( void * pContext, const ULONG * pBuffer, ULONG Width, ULONG Height, ULONG Pitch )
 {
-    LOGPEN logPen;
-    HPEN   hPen = NULL, hOldPen = NULL;
-    
-    // Set up the rendering pen
-    logPen.lopnStyle   = PS_SOLID;
-    logPen.lopnWidth.x = 1;
-    logPen.lopnWidth.y = 1;
+    ((CGameApp*)pContext)->PresentBuffer( pBuffer, Width, Height, Pitch );
+}
 
-    // Set up the colour, converted to BGR & stripped of alpha
-    logPen.lopnColor   = 0x00FFFFFF & RGB2BGR( Color ); 
-    
-    // Create the rendering pen
-    hPen = ::CreatePenIndirect( &logPen );
-    if (!hPen) return;
+//-----------------------------------------------------------------------------
+// Name : PresentBuffer () (Private)
+// Desc : We can now render the frame buffer to the final output device
+// Note : Called on the present thread, while the next frame is being drawn.
+//        When headless, any frames selected with '-dump' are written out
+//        as images instead.
+//-----------------------------------------------------------------------------
+void CGameApp::PresentBuffer( const ULONG * pBuffer, ULONG Width, ULONG Height, ULONG Pitch )
+{    
+    TCHAR       FileName[ 32 ];
+
+    if ( m_bHeadless )
+    {
+        // Write the frame out if it was selected
+        if ( std::binary_search( m_DumpFrames.begin(), m_DumpFrames.end(), m_nPresentFrame ) )
+        {
+            _stprintf( FileName, _T("Frame%05lu.ppm"), (unsigned long)m_nPresentFrame );
+            WriteFrame( FileName, pBuffer, Width, Height, Pitch );
 
-    // Select into the frame buffer DC
-    hOldPen = (HPEN)::SelectObject( m_hdcFrameBuffer, hPen );
+        } // End if dump frame
 
-    // Draw the line segment
-    MoveToEx( m_hdcFrameBuffer, (long)vtx1.x, (long)vtx1.y, NULL );
-    LineTo( m_hdcFrameBuffer, (long)vtx2.x, (long)vtx2.y );
+        m_nPresentFrame++;
+        return;
 
-    // Destroy rendering pen
-    ::SelectObject( m_hdcFrameBuffer, hOldPen );
-    ::DeleteObject( hPen );
-    
+    } // End if headless
+
+#ifdef _WIN32
+    HDC         hDC = NULL; 
+    BITMAPINFO  bmi;
+
+    // Describe the frame buffer memory (32bit, top down)
+    ZeroMemory( &bmi, sizeof(BITMAPINFO) );
+    bmi.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth       = (LONG)Pitch;
+    bmi.bmiHeader.biHeight      = -(LONG)Height;
+    bmi.bmiHeader.biPlanes      = 1;
+    bmi.bmiHeader.biBitCount    = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    // Retrieve the DC of the window
+    hDC = ::GetDC(m_hWnd);
+
+    // Blit the frame buffer to the screen
+    ::SetDIBitsToDevice( hDC, m_nViewX, m_nViewY, Width, Height, 0, 0, 0, Height,
+                         pBuffer, &bmi, DIB_RGB_COLORS );
+
+    // Clean up
+    ::ReleaseDC( m_hWnd, hDC );
+#endif
+
+    m_nPresentFrame++;
 }
 
 //-----------------------------------------------------------------------------
@@ -262,6 +426,10 @@ void CGameApp::SetupGameState()
 //-----------------------------------------------------------------------------
 int CGameApp::BeginGame()
 {
+    // Headless runs render a fixed number of frames, then exit
+    if ( m_bHeadless ) return RunHeadless();
+
+#ifdef _WIN32
     MSG		msg;
 
     // Start main loop
@@ -282,37 +450,151 @@ int CGameApp::BeginGame()
 		} // End If messages waiting
 	
     } // Until quit message is receieved
+#endif
 
     return 0;
 }
 
+//-----------------------------------------------------------------------------
+// Name : RunHeadless () (Private)
+// Desc : Renders the benchmark scenario given on the command line, timing
+//        each frame, and writes the frame time statistics to the file
+//        'Headless.json'. Returns the process exit code.
+// Note : Frames are advanced exactly as they are in the windowed loop, but
+//        animated by a fixed step so that the output is repeatable.
+//-----------------------------------------------------------------------------
+int CGameApp::RunHeadless()
+{
+    std::vector<double> FrameTimes( m_nFrameCount );
+    double              StartTime;
+
+    for ( ULONG i = 0; i < m_nFrameCount; i++ )
+    {
+        StartTime = CTimer::GetTime();
+        FrameAdvance();
+        FrameTimes[i] = (CTimer::GetTime() - StartTime) * 1000.0;
+
+    } // Next Frame
+
+    // Wait for the final frames to be presented (and written out)
+    m_PresentQueue.Flush();
+
+    // Write out the results
+    return WriteResults( _T("Headless.json"), FrameTimes ) ? 0 : 1;
+}
+
+//-----------------------------------------------------------------------------
+// Name : WriteResults () (Private)
+// Desc : Writes the scenario and the min / mean / p95 / p99 / max frame
+//        times (milliseconds) to the file specified, as JSON. A summary is
+//        also written to stdout.
+//-----------------------------------------------------------------------------
+bool CGameApp::WriteResults( LPCTSTR strFileName, const std::vector<double> & FrameTimes )
+{
+    static const char * ModeNames[] = { "", "wireframe", "flat", "textured" };
+    std::vector<double> Sorted( FrameTimes );
+    double              Mean = 0.0;
+    FILE              * pFile;
+
+    if ( Sorted.empty() ) return false;
+
+    // Calculate the statistics
+    std::sort( Sorted.begin(), Sorted.end() );
+    for ( ULONG i = 0; i < Sorted.size(); i++ ) Mean += Sorted[i];
+    Mean /= Sorted.size();
+
+    pFile = _tfopen( strFileName, _T("w") );
+    if ( !pFile ) return false;
+
+    fprintf( pFile, "{\n" );
+    fprintf( pFile, "    \"scenario\" : { \"objects\" : %lu, \"width\" : %lu, \"height\" : %lu, \"frames\" : %lu, \"seed\" : %lu,\n",
+             (unsigned long)m_Objects.size(), (unsigned long)m_nViewWidth, (unsigned long)m_nViewHeight,
+             (unsigned long)m_nFrameCount, (unsigned long)m_nSeed );
+    fprintf( pFile, "                   \"mode\" : \"%s\", \"occlusion\" : %s, \"threads\" : %lu, \"latency\" : %lu },\n",
+             ModeNames[ m_RenderMode ], m_bOcclusionCull ? "true" : "false", (unsigned long)m_nWorkerCount,
+             (unsigned long)m_PresentQueue.GetMaxLatency() );
+    fprintf( pFile, "    \"frame_ms\" : { \"min\" : %.4f, \"mean\" : %.4f, \"p95\" : %.4f, \"p99\" : %.4f, \"max\" : %.4f },\n",
+             Sorted.front(), Mean, Percentile( Sorted, 0.95 ), Percentile( Sorted, 0.99 ), Sorted.back() );
+    fprintf( pFile, "    \"last_frame\" : { \"visible\" : %lu, \"occluded\" : %lu }\n",
+             (unsigned long)m_nVisibleCount, (unsigned long)m_nOccludedCount );
+    fprintf( pFile, "}\n" );
+    fclose( pFile );
+
+    printf( "%lu frames : min %.3f ms, mean %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n", (unsigned long)Sorted.size(),
+            Sorted.front(), Mean, Percentile( Sorted, 0.95 ), Percentile( Sorted, 0.99 ), Sorted.back() );
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : WriteFrame () (Private)
+// Desc : Writes a frame buffer out as a binary (P6) PPM image.
+//-----------------------------------------------------------------------------
+bool CGameApp::WriteFrame( LPCTSTR strFileName, const ULONG * pBuffer, ULONG Width, ULONG Height, ULONG Pitch )
+{
+    std::vector<UCHAR> Row( Width * 3 );
+    FILE * pFile = _tfopen( strFileName, _T("wb") );
+    if ( !pFile ) return false;
+
+    fprintf( pFile, "P6\n%lu %lu\n255\n", (unsigned long)Width, (unsigned long)Height );
+    for ( ULONG y = 0; y < Height; y++ )
+    {
+        // Frame buffer pixels are 0x00RRGGBB
+        const ULONG * pSource = pBuffer + y * Pitch;
+        for ( ULONG x = 0; x < Width; x++ )
+        {
+            Row[ x * 3 + 0 ] = (UCHAR)(pSource[x] >> 16);
+            Row[ x * 3 + 1 ] = (UCHAR)(pSource[x] >> 8);
+            Row[ x * 3 + 2 ] = (UCHAR)(pSource[x]);
+
+        } // Next Pixel
+
+        fwrite( &Row[0], 1, Width * 3, pFile );
+
+    } // Next Row
+
+    fclose( pFile );
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 // Name : ShutDown ()
 // Desc : Shuts down the game engine, and frees up all resources.
 //-----------------------------------------------------------------------------
 bool CGameApp::ShutDown()
 {
-    // Destroy the frame buffer and associated DC's
-    if ( m_hdcFrameBuffer && m_hbmFrameBuffer )
-    {
-        ::SelectObject( m_hdcFrameBuffer, m_hbmSelectOut );
-        ::DeleteObject( m_hbmFrameBuffer );
-        ::DeleteDC( m_hdcFrameBuffer );
-
-    } // End if
+    // Write out the frame time statistics (once only)
+    if ( m_bFrameStats ) m_Timer.WriteFrameStats( _T("FrameStats.txt") );
+    m_bFrameStats = false;
+
+    // Present any outstanding frames, stop the worker threads and destroy the frame buffer
+    m_PresentQueue.Release();
+    m_ThreadPool.Release();
+    m_Rasterizer.Release();
+    m_Texture.Release();
+    m_HiZBuffer.Release();
+
+    // Release the objects and per thread data
+    if ( m_pWorkers ) delete []m_pWorkers;
+    m_pWorkers     = NULL;
+    m_nWorkerCount = 0;
+    m_Objects.clear();
+    m_VisibleObjects.clear();
 
     // Destroy the render window
+#ifdef _WIN32
     if ( m_hWnd ) DestroyWindow( m_hWnd );
+#endif
     
     // Clear all variables
     m_hWnd              = NULL;
-    m_hbmFrameBuffer    = NULL;
-    m_hdcFrameBuffer    = NULL;
     
     // Shutdown Success
     return true;
 }
 
+#ifdef _WIN32
 //-----------------------------------------------------------------------------
 // Name : StaticWndProc () (Static Callback)
 // Desc : This is the main messge pump for ALL display devices, it captures
@@ -407,6 +689,48 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
                                      MF_BYCOMMAND | (m_bRotation2) ? MF_CHECKED :  MF_UNCHECKED );
                     break;
 
+                case ID_RENDER_WIREFRAME:
+                    // Switch to wireframe output
+                    m_RenderMode = RENDER_WIREFRAME;
+                    ::CheckMenuRadioItem( ::GetMenu( m_hWnd ), ID_RENDER_WIREFRAME, ID_RENDER_TEXTURED,
+                                          ID_RENDER_WIREFRAME, MF_BYCOMMAND );
+                    break;
+
+                case ID_RENDER_FLAT:
+                    // Switch to flat shaded output
+                    m_RenderMode = RENDER_FLAT;
+                    ::CheckMenuRadioItem( ::GetMenu( m_hWnd ), ID_RENDER_WIREFRAME, ID_RENDER_TEXTURED,
+                                          ID_RENDER_FLAT, MF_BYCOMMAND );
+                    break;
+
+                case ID_RENDER_TEXTURED:
+                    // Switch to textured output
+                    m_RenderMode = RENDER_TEXTURED;
+                    ::CheckMenuRadioItem( ::GetMenu( m_hWnd ), ID_RENDER_WIREFRAME, ID_RENDER_TEXTURED,
+                                          ID_RENDER_TEXTURED, MF_BYCOMMAND );
+                    break;
+
+                case ID_RENDER_CULLBACK:
+                    // Disable / enable back face culling
+                    m_bCullBackFaces = !m_bCullBackFaces;
+                    ::CheckMenuItem( ::GetMenu( m_hWnd ), ID_RENDER_CULLBACK, 
+                                     MF_BYCOMMAND | ((m_bCullBackFaces) ? MF_CHECKED : MF_UNCHECKED) );
+                    break;
+
+                case ID_RENDER_BILINEAR:
+                    // Switch between bilinear and nearest texture filtering
+                    m_bBilinear = !m_bBilinear;
+                    ::CheckMenuItem( ::GetMenu( m_hWnd ), ID_RENDER_BILINEAR, 
+                                     MF_BYCOMMAND | ((m_bBilinear) ? MF_CHECKED : MF_UNCHECKED) );
+                    break;
+
+                case ID_RENDER_OCCLUSION:
+                    // Disable / enable hierarchical depth occlusion culling
+                    m_bOcclusionCull = !m_bOcclusionCull;
+                    ::CheckMenuItem( ::GetMenu( m_hWnd ), ID_RENDER_OCCLUSION, 
+                                     MF_BYCOMMAND | ((m_bOcclusionCull) ? MF_CHECKED : MF_UNCHECKED) );
+                    break;
+
                 case ID_EXIT:
                     // Recieved key/menu command to exit app
                     SendMessage( m_hWnd, WM_CLOSE, 0, 0 );
@@ -421,6 +745,7 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
     
     return 0;
 }
+#endif // _WIN32
 
 //-----------------------------------------------------------------------------
 // Name : BuildObjects ()
@@ -429,6 +754,8 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
 bool CGameApp::BuildObjects()
 {
     CPolygon * pPoly = NULL;
+    ULONG      Seed = m_nSeed;
+    float      fZ, fExtent;
 
     // Add 6 polygons to this mesh.
     if ( m_Mesh.AddPolygon( 6 ) < 0 ) return false;
@@ -437,63 +764,85 @@ bool CGameApp::BuildObjects()
     pPoly = m_Mesh.m_pPolygon[0];
     if ( pPoly->AddVertex( 4 ) < 0 ) return false;
 
-    pPoly->m_pVertex[0] = CVertex( -2,  2, -2 );
-    pPoly->m_pVertex[1] = CVertex(  2,  2, -2 );
-    pPoly->m_pVertex[2] = CVertex(  2, -2, -2 );
-    pPoly->m_pVertex[3] = CVertex( -2, -2, -2 );
+    pPoly->m_pVertex[0] = CVertex( -2,  2, -2, 0, 0 );
+    pPoly->m_pVertex[1] = CVertex(  2,  2, -2, 1, 0 );
+    pPoly->m_pVertex[2] = CVertex(  2, -2, -2, 1, 1 );
+    pPoly->m_pVertex[3] = CVertex( -2, -2, -2, 0, 1 );
     
     // Top Face
     pPoly = m_Mesh.m_pPolygon[1];
     if ( pPoly->AddVertex( 4 ) < 0 ) return false;
     
-    pPoly->m_pVertex[0] = CVertex( -2,  2,  2 );
-    pPoly->m_pVertex[1] = CVertex(  2,  2,  2 );
-    pPoly->m_pVertex[2] = CVertex(  2,  2, -2 );
-    pPoly->m_pVertex[3] = CVertex( -2,  2, -2 );
+    pPoly->m_pVertex[0] = CVertex( -2,  2,  2, 0, 0 );
+    pPoly->m_pVertex[1] = CVertex(  2,  2,  2, 1, 0 );
+    pPoly->m_pVertex[2] = CVertex(  2,  2, -2, 1, 1 );
+    pPoly->m_pVertex[3] = CVertex( -2,  2, -2, 0, 1 );
 
     // Back Face
     pPoly = m_Mesh.m_pPolygon[2];
     if ( pPoly->AddVertex( 4 ) < 0 ) return false;
 
-    pPoly->m_pVertex[0] = CVertex( -2, -2,  2 );
-    pPoly->m_pVertex[1] = CVertex(  2, -2,  2 );
-    pPoly->m_pVertex[2] = CVertex(  2,  2,  2 );
-    pPoly->m_pVertex[3] = CVertex( -2,  2,  2 ),
+    pPoly->m_pVertex[0] = CVertex( -2, -2,  2, 0, 0 );
+    pPoly->m_pVertex[1] = CVertex(  2, -2,  2, 1, 0 );
+    pPoly->m_pVertex[2] = CVertex(  2,  2,  2, 1, 1 );
+    pPoly->m_pVertex[3] = CVertex( -2,  2,  2, 0, 1 ),
 
     // Bottom Face
     pPoly = m_Mesh.m_pPolygon[3];
     if ( pPoly->AddVertex( 4 ) < 0 ) return false;
 
-    pPoly->m_pVertex[0] = CVertex( -2, -2, -2 );
-    pPoly->m_pVertex[1] = CVertex(  2, -2, -2 );
-    pPoly->m_pVertex[2] = CVertex(  2, -2,  2 );
-    pPoly->m_pVertex[3] = CVertex( -2, -2,  2 );
+    pPoly->m_pVertex[0] = CVertex( -2, -2, -2, 0, 0 );
+    pPoly->m_pVertex[1] = CVertex(  2, -2, -2, 1, 0 );
+    pPoly->m_pVertex[2] = CVertex(  2, -2,  2, 1, 1 );
+    pPoly->m_pVertex[3] = CVertex( -2, -2,  2, 0, 1 );
 
     // Left Face
     pPoly = m_Mesh.m_pPolygon[4];
     if ( pPoly->AddVertex( 4 ) < 0 ) return false;
 
-    pPoly->m_pVertex[0] = CVertex( -2,  2,  2 );
-    pPoly->m_pVertex[1] = CVertex( -2,  2, -2 );
-    pPoly->m_pVertex[2] = CVertex( -2, -2, -2 );
-    pPoly->m_pVertex[3] = CVertex( -2, -2,  2 );
+    pPoly->m_pVertex[0] = CVertex( -2,  2,  2, 0, 0 );
+    pPoly->m_pVertex[1] = CVertex( -2,  2, -2, 1, 0 );
+    pPoly->m_pVertex[2] = CVertex( -2, -2, -2, 1, 1 );
+    pPoly->m_pVertex[3] = CVertex( -2, -2,  2, 0, 1 );
 
     // Right Face
     pPoly = m_Mesh.m_pPolygon[5];
     if ( pPoly->AddVertex( 4 ) < 0 ) return false;
 
-    pPoly->m_pVertex[0] = CVertex(  2,  2, -2 );
-    pPoly->m_pVertex[1] = CVertex(  2,  2,  2 ); 
-    pPoly->m_pVertex[2] = CVertex(  2, -2,  2 );
-    pPoly->m_pVertex[3] = CVertex(  2, -2, -2 );
+    pPoly->m_pVertex[0] = CVertex(  2,  2, -2, 0, 0 );
+    pPoly->m_pVertex[1] = CVertex(  2,  2,  2, 1, 0 ); 
+    pPoly->m_pVertex[2] = CVertex(  2, -2,  2, 1, 1 );
+    pPoly->m_pVertex[3] = CVertex(  2, -2, -2, 0, 1 );
+
+    // All of our objects should reference this mesh
+    m_Objects.resize( m_nObjectCount, CObject( &m_Mesh ) );
+    m_VisibleObjects.resize( m_nObjectCount );
 
-    // Our two objects should reference this mesh
-    m_pObject[ 0 ].m_pMesh = &m_Mesh;
-    m_pObject[ 1 ].m_pMesh = &m_Mesh;
+    // Set the first two objects matrices so that they are offset slightly
+    D3DXMatrixTranslation( &m_Objects[ 0 ].m_mtxWorld, -3.5f,  2.0f, 14.0f );
+    D3DXMatrixTranslation( &m_Objects[ 1 ].m_mtxWorld,  3.5f, -2.0f, 14.0f );
+    m_Objects[ 0 ].m_vecSpin = D3DXVECTOR3(  75.0f, 50.0f,  25.0f );
+    m_Objects[ 1 ].m_vecSpin = D3DXVECTOR3( -25.0f, 50.0f, -75.0f );
 
-    // Set both objects matrices so that they are offset slightly
-    D3DXMatrixTranslation( &m_pObject[ 0 ].m_mtxWorld, -3.5f,  2.0f, 14.0f );
-    D3DXMatrixTranslation( &m_pObject[ 1 ].m_mtxWorld,  3.5f, -2.0f, 14.0f );
+    // Scatter any others through the volume behind them, within the initial view
+    for ( ULONG i = 2; i < m_nObjectCount; i++ )
+    {
+        CObject & Object = m_Objects[ i ];
+
+        fZ      = RandomFloat( Seed, 20.0f, 400.0f );
+        fExtent = fZ * 0.7f;
+        D3DXMatrixTranslation( &Object.m_mtxWorld, RandomFloat( Seed, -fExtent, fExtent ),
+                               RandomFloat( Seed, -fExtent * 0.6f, fExtent * 0.6f ), fZ );
+        Object.m_vecSpin = D3DXVECTOR3( RandomFloat( Seed, -90.0f, 90.0f ), RandomFloat( Seed, -90.0f, 90.0f ),
+                                        RandomFloat( Seed, -90.0f, 90.0f ) );
+
+    } // Next Object
+
+    // Move the polygons into the mesh's indexed storage
+    if ( !m_Mesh.Commit() ) return false;
+
+    // Build the texture used for textured output
+    if ( !m_Texture.CreateChecker( 64, 8, 0x00FFA040, 0x00603010 ) ) return false;
     
     // Success!
     return true;
@@ -505,37 +854,97 @@ bool CGameApp::BuildObjects()
 //-----------------------------------------------------------------------------
 void CGameApp::FrameAdvance()
 {
-    CMesh      *pMesh = NULL;
-    TCHAR       lpszFPS[30];
+    D3DXMATRIX  mtxWVP;
+    float       fGuardX, fGuardY;
+    ULONG       i, BatchCount;
+#ifdef _WIN32
+    static TCHAR FrameRate[ 50 ];
+    static TCHAR TitleBuffer[ 255 ];
+#endif
+
+    // Advance the timer (headless runs are not locked to the display rate)
+    m_Timer.Tick( m_bHeadless ? 0.0f : 60.0f );
+
+#ifdef _WIN32
+    // Get / Display the framerate
+    if ( m_hWnd && m_LastFrameRate != m_Timer.GetFrameRate() )
+    {
+        m_LastFrameRate = m_Timer.GetFrameRate( FrameRate );
+        _stprintf( TitleBuffer, _T("Software Render : %s (%lu of %lu objects drawn)"), FrameRate,
+                   m_nVisibleCount - m_nOccludedCount, (ULONG)m_Objects.size() );
+        SetWindowText( m_hWnd, TitleBuffer );
 
-    // Advance the timer
-    m_Timer.Tick( 60.0f );
+    } // End if Frame Rate Altered
+#endif
     
-    // Animate the two objects
+    // Animate all objects (by a fixed step when headless)
+    m_fTimeStep = m_bHeadless ? HEADLESS_TIME_STEP : m_Timer.GetTimeElapsed();
     AnimateObjects();
 
     // Clear the frame buffer ready for drawing
     ClearFrameBuffer( 0x00FFFFFF );
-    
-    // Loop through each object
-    for ( ULONG i = 0; i < 2; i++ )
+
+    // Faces inside the guard band are scissored by the rasterizer rather than clipped,
+    // but the band must stay within the coordinate range the rasterizer accepts.
+    fGuardX = (2.0f * (RASTER_MAX_COORD - m_nViewX) - m_nViewWidth)  / max( m_nViewWidth,  1UL );
+    fGuardY = (2.0f * (RASTER_MAX_COORD - m_nViewY) - m_nViewHeight) / max( m_nViewHeight, 1UL );
+
+    // Set the viewport used by each thread to generate screen space positions
+    for ( i = 0; i < m_nWorkerCount; i++ )
     {
-        // Store mesh for easy access
-        pMesh = m_pObject[i].m_pMesh;
+        m_pWorkers[i].VertexCache.SetViewport( (float)m_nViewX, (float)m_nViewY, (float)m_nViewWidth, (float)m_nViewHeight );
+        m_pWorkers[i].VertexCache.SetGuardBand( min( GUARD_BAND, fGuardX ), min( GUARD_BAND, fGuardY ) );
+        m_pWorkers[i].nOccluded = 0;
 
-        // Loop through each polygon
-        for ( ULONG f = 0; f < pMesh->m_nPolygonCount; f++ )
-        {
-            // Render the primitive
-            DrawPrimitive( pMesh->m_pPolygon[f], &m_pObject[i].m_mtxWorld );
-    
-        } // Next Polygon
+    } // Next Worker
+
+    // Extract the world space view frustum
+    D3DXMatrixMultiply( &mtxWVP, &m_mtxView, &m_mtxProjection );
+    m_Frustum.CalcFrustumPlanes( mtxWVP );
     
+    // Test every object against the frustum, in parallel
+    BatchCount = (m_Objects.size() + OBJECT_BATCH_SIZE - 1) / OBJECT_BATCH_SIZE;
+    m_ThreadPool.Execute( CullJob, this, BatchCount );
+
+    // Sort the visible objects into occluders and everything else
+    m_Occluders.clear();
+    m_DrawList.clear();
+    for ( i = 0; i < m_VisibleObjects.size(); i++ )
+    {
+        VisibleObject & Visible = m_VisibleObjects[i];
+        if ( !Visible.bVisible ) continue;
+
+        if ( m_bOcclusionCull && Visible.bOccluder )
+            m_Occluders.push_back( &Visible );
+        else
+            m_DrawList.push_back( &Visible );
+
     } // Next Object
+    m_nVisibleCount = m_Occluders.size() + m_DrawList.size();
+
+    if ( m_bOcclusionCull )
+    {
+        // Draw the occluders front to back, then build the depth pyramid from the result
+        std::sort( m_Occluders.begin(), m_Occluders.end(), CompareNearZ );
+        m_pDrawList      = &m_Occluders;
+        m_bTestOcclusion = false;
+        m_ThreadPool.Execute( DrawJob, this, (m_Occluders.size() + OBJECT_BATCH_SIZE - 1) / OBJECT_BATCH_SIZE );
+
+        m_Rasterizer.Flush();
+        m_HiZBuffer.Build( m_Rasterizer.GetDepthBuffer(), m_Rasterizer.GetWidth(), m_Rasterizer.GetHeight(), m_Rasterizer.GetPitch() );
+
+    } // End if occlusion culling
 
-    // Display Frame Rate
-    m_Timer.GetFrameRate( lpszFPS );
-    TextOut( m_hdcFrameBuffer, 5, 5, lpszFPS, strlen( lpszFPS ) ); 
+    // Draw everything else (tested against the pyramid before being transformed)
+    m_pDrawList      = &m_DrawList;
+    m_bTestOcclusion = m_bOcclusionCull;
+    m_ThreadPool.Execute( DrawJob, this, (m_DrawList.size() + OBJECT_BATCH_SIZE - 1) / OBJECT_BATCH_SIZE );
+
+    // Total up the objects rejected by each thread
+    for ( m_nOccludedCount = 0, i = 0; i < m_nWorkerCount; i++ ) m_nOccludedCount += m_pWorkers[i].nOccluded;
+
+    // Rasterize everything that was binned this frame
+    m_Rasterizer.EndFrame();
     
     // Present the buffer
     PresentFrameBuffer();
@@ -543,100 +952,313 @@ void CGameApp::FrameAdvance()
 }
 
 //-----------------------------------------------------------------------------
-// Name : DrawPrimitive () (Private)
-// Desc : This function renders an individual polygon.
+// Name : CullBatch () (Private)
+// Desc : Tests a batch of objects against the view frustum, and calculates
+//        the matrices and screen space bounds of those that may be visible.
+// Note : Called from the thread pool, writes only to the batch's own entries
+//        in m_VisibleObjects.
+//-----------------------------------------------------------------------------
+void CGameApp::CullBatch( ULONG Batch, ULONG ThreadIndex )
+{
+    ULONG First = Batch * OBJECT_BATCH_SIZE;
+    ULONG Last  = min( First + OBJECT_BATCH_SIZE, (ULONG)m_Objects.size() );
+    float fArea;
+
+    for ( ULONG i = First; i < Last; i++ )
+    {
+        CObject       & Object  = m_Objects[i];
+        VisibleObject & Visible = m_VisibleObjects[i];
+        CMesh         * pMesh   = Object.m_pMesh;
+
+        // Skip the object if its bounding sphere is outside the frustum
+        Visible.bVisible = false;
+        if ( !ObjectInFrustum( &Object ) ) continue;
+
+        // Combine the world, view and projection matrices once per object
+        Visible.pObject = &Object;
+        D3DXMatrixMultiply( &Visible.mtxWV, &Object.m_mtxWorld, &m_mtxView );
+        D3DXMatrixMultiply( &Visible.mtxWVP, &Visible.mtxWV, &m_mtxProjection );
+
+        // Refine using the object space bounding box (planes from the WVP matrix are in object space)
+        if ( !CFrustum( Visible.mtxWVP ).BoundsInFrustum( pMesh->m_BoundsMin, pMesh->m_BoundsMax ) ) continue;
+        Visible.bVisible = true;
+
+        // Objects crossing the near plane can't be tested, so always draw them first
+        Visible.bOccluder = true;
+        if ( GetScreenBounds( pMesh, Visible.mtxWVP, Visible.MinX, Visible.MinY, Visible.MaxX, Visible.MaxY, Visible.NearZ, ThreadIndex ) )
+        {
+            fArea = (Visible.MaxX - Visible.MinX) * (Visible.MaxY - Visible.MinY);
+            Visible.bOccluder = ( fArea >= OCCLUDER_MIN_AREA * m_nViewWidth * m_nViewHeight );
+
+        } // End if bounds available
+        else Visible.NearZ = 0.0f;
+
+    } // Next Object
+}
+
+//-----------------------------------------------------------------------------
+// Name : DrawBatch () (Private)
+// Desc : Draws a batch of objects from the current draw list, optionally
+//        testing each against the occlusion buffer first.
+// Note : Called from the thread pool. Primitives are queued on the calling
+//        thread's own rasterizer queue.
 //-----------------------------------------------------------------------------
-void CGameApp::DrawPrimitive( CPolygon * pPoly, D3DXMATRIX * pmtxWorld )
+void CGameApp::DrawBatch( ULONG Batch, ULONG ThreadIndex )
 {
-    D3DXVECTOR3 vtxPrevious, vtxCurrent;
+    ULONG First = Batch * OBJECT_BATCH_SIZE;
+    ULONG Last  = min( First + OBJECT_BATCH_SIZE, (ULONG)m_pDrawList->size() );
 
-    // Loop round each vertex transforming as we go
-    for ( USHORT v = 0; v < pPoly->m_nVertexCount + 1; v++ ) 
+    for ( ULONG i = First; i < Last; i++ )
     {
-        // Store the current vertex
-        vtxCurrent = (D3DXVECTOR3&)pPoly->m_pVertex[ v % pPoly->m_nVertexCount ];
+        const VisibleObject & Visible = *(*m_pDrawList)[i];
 
-        // Multiply the vertex position by the World / object matrix
-        D3DXVec3TransformCoord( &vtxCurrent, &vtxCurrent, pmtxWorld );
+        // Skip objects hidden behind the occluders
+        if ( m_bTestOcclusion && !m_HiZBuffer.IsVisible( Visible.MinX, Visible.MinY, Visible.MaxX, Visible.MaxY, Visible.NearZ ) )
+        {
+            m_pWorkers[ ThreadIndex ].nOccluded++;
+            continue;
 
-        // Multiply by View matrix
-        D3DXVec3TransformCoord( &vtxCurrent, &vtxCurrent, &m_mtxView );
+        } // End if hidden
 
-        // Multiply by Projection matrix
-        D3DXVec3TransformCoord( &vtxCurrent, &vtxCurrent, &m_mtxProjection );
+        DrawObject( Visible.pObject, Visible.mtxWV, Visible.mtxWVP, ThreadIndex );
 
-        // Convert to screen space coordinates
-        vtxCurrent.x =   vtxCurrent.x * m_nViewWidth  / 2 + m_nViewX + m_nViewWidth  / 2;
-        vtxCurrent.y =  -vtxCurrent.y * m_nViewHeight / 2 + m_nViewY + m_nViewHeight / 2;
+    } // Next Object
+}
 
-        // If this is the first vertex, continue. This is the first point of our first line.
-        if ( v == 0 ) { vtxPrevious = vtxCurrent; continue; }
+//-----------------------------------------------------------------------------
+// Name : ObjectInFrustum () (Private)
+// Desc : Tests the object's world space bounding sphere against the frustum.
+//-----------------------------------------------------------------------------
+bool CGameApp::ObjectInFrustum( const CObject * pObject )
+{
+    const D3DXMATRIX & mtx = pObject->m_mtxWorld;
+    D3DXVECTOR3 vecCentre, vecAxis;
+    float       fScale, fAxis;
 
-        // Draw the line
-        DrawLine( vtxPrevious, vtxCurrent, 0 );
+    // Transform the sphere centre into world space
+    D3DXVec3TransformCoord( &vecCentre, &pObject->m_pMesh->m_BoundsCentre, &mtx );
 
-        // Store this as new line's first point
-        vtxPrevious = vtxCurrent; 
+    // Scale the radius by the largest axis scale in the world matrix
+    vecAxis = D3DXVECTOR3( mtx._11, mtx._12, mtx._13 ); fScale = D3DXVec3Length( &vecAxis );
+    vecAxis = D3DXVECTOR3( mtx._21, mtx._22, mtx._23 ); fAxis  = D3DXVec3Length( &vecAxis ); if ( fAxis > fScale ) fScale = fAxis;
+    vecAxis = D3DXVECTOR3( mtx._31, mtx._32, mtx._33 ); fAxis  = D3DXVec3Length( &vecAxis ); if ( fAxis > fScale ) fScale = fAxis;
 
-    } // Next Vertex
+    return m_Frustum.SphereInFrustum( vecCentre, pObject->m_pMesh->m_fBoundsRadius * fScale );
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetScreenBounds () (Private)
+// Desc : Projects the mesh's object space bounding box to find the screen
+//        space rectangle it covers, along with its nearest depth value.
+// Note : Returns false if the box crosses the near plane, in which case the
+//        rectangle is meaningless and the object should be assumed visible.
+//-----------------------------------------------------------------------------
+bool CGameApp::GetScreenBounds( const CMesh * pMesh, const D3DXMATRIX & mtxWVP, float & MinX, float & MinY,
+                                float & MaxX, float & MaxY, float & NearZ, ULONG ThreadIndex )
+{
+    const D3DXVECTOR3 & Min = pMesh->m_BoundsMin, & Max = pMesh->m_BoundsMax;
+    float x, y, z, w, sx, sy, sz, rhw;
+
+    MinX = MinY = NearZ = 1e30f;
+    MaxX = MaxY = -1e30f;
+
+    // Project each of the eight corners
+    for ( ULONG i = 0; i < 8; i++ )
+    {
+        D3DXVECTOR3 vecCorner( (i & 1) ? Max.x : Min.x, (i & 2) ? Max.y : Min.y, (i & 4) ? Max.z : Min.z );
+
+        // Transform into clip space
+        x = vecCorner.x * mtxWVP._11 + vecCorner.y * mtxWVP._21 + vecCorner.z * mtxWVP._31 + mtxWVP._41;
+        y = vecCorner.x * mtxWVP._12 + vecCorner.y * mtxWVP._22 + vecCorner.z * mtxWVP._32 + mtxWVP._42;
+        z = vecCorner.x * mtxWVP._13 + vecCorner.y * mtxWVP._23 + vecCorner.z * mtxWVP._33 + mtxWVP._43;
+        w = vecCorner.x * mtxWVP._14 + vecCorner.y * mtxWVP._24 + vecCorner.z * mtxWVP._34 + mtxWVP._44;
+
+        // Behind (or on) the near plane?
+        if ( w <= 0.0f || z < 0.0f ) return false;
+
+        m_pWorkers[ ThreadIndex ].VertexCache.ToScreen( x, y, z, w, sx, sy, sz, rhw );
+        if ( sx < MinX ) MinX = sx;
+        if ( sx > MaxX ) MaxX = sx;
+        if ( sy < MinY ) MinY = sy;
+        if ( sy > MaxY ) MaxY = sy;
+        if ( sz < NearZ ) NearZ = sz;
+
+    } // Next Corner
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : DrawObject () (Private)
+// Desc : Transforms the object's mesh and queues each of its front facing
+//        polygons with the rasterizer.
+//-----------------------------------------------------------------------------
+void CGameApp::DrawObject( CObject * pObject, const D3DXMATRIX & mtxWV, const D3DXMATRIX & mtxWVP, ULONG ThreadIndex )
+{
+    CMesh      *pMesh = pObject->m_pMesh;
+    D3DXMATRIX  mtxInverse;
+    D3DXVECTOR3 vecEye;
+    bool        bCullBackFaces;
+
+    // Find the camera position in object space for back face culling
+    bCullBackFaces = m_bCullBackFaces && D3DXMatrixInverse( &mtxInverse, NULL, &mtxWV ) != NULL;
+    if ( bCullBackFaces ) vecEye = D3DXVECTOR3( mtxInverse._41, mtxInverse._42, mtxInverse._43 );
+
+    // Transform every unique vertex in the mesh in one batch
+    if ( !m_pWorkers[ ThreadIndex ].VertexCache.Transform( pMesh, mtxWVP ) ) return;
+
+    // Loop through each face
+    for ( ULONG f = 0; f < pMesh->m_nFaceCount; f++ )
+    {
+        const MESHFACE & Face = pMesh->m_pFace[f];
+
+        // Skip faces pointing away from the camera
+        if ( bCullBackFaces && D3DXVec3Dot( &Face.Normal, &vecEye ) + Face.Distance <= 0.0f ) continue;
+
+        // Render the primitive
+        DrawPrimitive( pMesh, f, &pObject->m_mtxWorld, ThreadIndex );
+
+    } // Next Face
+}
+
+//-----------------------------------------------------------------------------
+// Name : DrawPrimitive () (Private)
+// Desc : This function renders an individual face of the mesh.
+// Note : The thread's vertex cache must already contain the transformed
+//        positions of the mesh specified.
+//-----------------------------------------------------------------------------
+void CGameApp::DrawPrimitive( CMesh * pMesh, ULONG Face, D3DXMATRIX * pmtxWorld, ULONG ThreadIndex )
+{
+    WorkerData & Worker = m_pWorkers[ ThreadIndex ];
+    const ULONG * pIndex = &pMesh->m_pIndex[ pMesh->m_pFace[ Face ].FirstIndex ];
+    const D3DXVECTOR2 * pTexCoord = &pMesh->m_pTexCoord[ pMesh->m_pFace[ Face ].FirstIndex ];
+    ULONG       VertexCount = pMesh->m_pFace[ Face ].IndexCount;
+    ULONG       Flags;
+    RASTERVERTEX *pVertices = NULL;
+    D3DXVECTOR3 vecNormal;
+    D3DXVECTOR3 vecLight( -0.4f, 0.6f, -1.0f );
+    ULONG       Color = 0;
+    float       fShade;
+
+    // Degenerate polygons can not be rendered
+    if ( VertexCount < 3 ) return;
+
+    // Retrieve the screen space outline, clipped if necessary
+    VertexCount = Worker.Clipper.ClipPolygon( Worker.VertexCache, pIndex, VertexCount, &pVertices, pTexCoord );
+    if ( VertexCount < 3 ) return;
+
+    // Draw the textured polygon as a triangle fan
+    if ( m_RenderMode == RENDER_TEXTURED )
+    {
+        Flags = CRasterizer::RASTER_DEPTHTEST | CRasterizer::RASTER_DEPTHWRITE;
+        if ( m_bBilinear ) Flags |= CRasterizer::RASTER_BILINEAR;
+
+        for ( ULONG v = 2; v < VertexCount; v++ )
+        {
+            m_Rasterizer.DrawTexturedTriangle( pVertices[0], pVertices[v - 1], pVertices[v], &m_Texture, Flags, ThreadIndex );
+
+        } // Next Triangle
+        return;
+
+    } // End if textured
+
+    // Calculate the polygon's lighting for flat shaded output
+    if ( m_RenderMode == RENDER_FLAT )
+    {
+        // Generate the world space face normal
+        D3DXVec3TransformNormal( &vecNormal, &pMesh->m_pFace[ Face ].Normal, pmtxWorld );
+        D3DXVec3Normalize( &vecNormal, &vecNormal );
+        D3DXVec3Normalize( &vecLight, &vecLight );
+
+        // Simple ambient + diffuse term applied to the base color
+        fShade = D3DXVec3Dot( &vecNormal, &vecLight );
+        fShade = 0.3f + 0.7f * ((fShade > 0.0f) ? fShade : 0.0f);
+        Color  = ((ULONG)(255 * fShade) << 16) | ((ULONG)(160 * fShade) << 8) | (ULONG)(64 * fShade);
+
+        // Draw the polygon as a triangle fan
+        for ( ULONG v = 2; v < VertexCount; v++ )
+        {
+            m_Rasterizer.DrawTriangle( pVertices[0], pVertices[v - 1], pVertices[v], Color, ThreadIndex );
+
+        } // Next Triangle
+
+    } // End if flat shaded
+    else
+    {
+        // Draw the outline, closing back to the first vertex
+        for ( ULONG v = 0; v < VertexCount; v++ )
+        {
+            m_Rasterizer.DrawLine( pVertices[v], pVertices[ (v + 1) % VertexCount ], 0, ThreadIndex );
+
+        } // Next Line
+
+    } // End if wireframe
 }
 
 //-----------------------------------------------------------------------------
 // Name : AnimateObjects () (Private)
-// Desc : Animates the objects we currently have loaded.
+// Desc : Animates the objects we currently have loaded, in parallel.
 //-----------------------------------------------------------------------------
 void CGameApp::AnimateObjects()
 {
-    // Note : Expanded for the purposes of this example only.
-    D3DXMATRIX mtxYaw, mtxPitch, mtxRoll, mtxRotate;
-    float RotationYaw, RotationPitch, RotationRoll;
+    ULONG BatchCount = (m_Objects.size() + OBJECT_BATCH_SIZE - 1) / OBJECT_BATCH_SIZE;
 
-    // Rotate Object 1 by small amount
-    if ( m_bRotation1 )
-    {
-        // Calculate rotation values for object 0
-        RotationYaw   = D3DXToRadian( 75.0f * m_Timer.GetTimeElapsed() );
-        RotationPitch = D3DXToRadian( 50.0f * m_Timer.GetTimeElapsed() );
-        RotationRoll  = D3DXToRadian( 25.0f * m_Timer.GetTimeElapsed() );
-
-        // Build rotation matrices 
-        D3DXMatrixIdentity( &mtxRotate );
-        D3DXMatrixRotationY( &mtxYaw, RotationYaw);
-        D3DXMatrixRotationX( &mtxPitch,RotationPitch);
-        D3DXMatrixRotationZ( &mtxRoll, RotationRoll);
-        
-        // Concatenate the rotation matrices
-        D3DXMatrixMultiply( &mtxRotate, &mtxRotate, &mtxYaw );
-        D3DXMatrixMultiply( &mtxRotate, &mtxRotate, &mtxPitch );
-        D3DXMatrixMultiply( &mtxRotate, &mtxRotate, &mtxRoll );
-            
-        // Apply the rotation to our object's matrix
-        D3DXMatrixMultiply( &m_pObject[ 0 ].m_mtxWorld, &mtxRotate, &m_pObject[ 0 ].m_mtxWorld );
+    // Nothing to do if all rotation is disabled
+    if ( !m_bRotation1 && !m_bRotation2 ) return;
+
+    m_ThreadPool.Execute( AnimateJob, this, BatchCount );
+}
 
-    } // End if Rotation Enabled
+//-----------------------------------------------------------------------------
+// Name : AnimateBatch () (Private)
+// Desc : Rotates each object in the batch by a small amount. The 'Object 1'
+//        rotation setting applies to the first object and every other object
+//        after it, the 'Object 2' setting to the remainder.
+//-----------------------------------------------------------------------------
+void CGameApp::AnimateBatch( ULONG Batch )
+{
+    ULONG First    = Batch * OBJECT_BATCH_SIZE;
+    ULONG Last     = min( First + OBJECT_BATCH_SIZE, (ULONG)m_Objects.size() );
+    float fElapsed = m_fTimeStep;
 
-    // Rotate Object 2 by small amount
-    if ( m_bRotation2 )
+    for ( ULONG i = First; i < Last; i++ )
     {
-        // Calculate rotation values for object 1
-        RotationYaw   = D3DXToRadian( -25.0f * m_Timer.GetTimeElapsed() );
-        RotationPitch = D3DXToRadian(  50.0f * m_Timer.GetTimeElapsed() );
-        RotationRoll  = D3DXToRadian( -75.0f * m_Timer.GetTimeElapsed() );
-
-        // Build rotation matrices 
-        D3DXMatrixIdentity( &mtxRotate );
-        D3DXMatrixRotationY( &mtxYaw, RotationYaw);
-        D3DXMatrixRotationX( &mtxPitch,RotationPitch);
-        D3DXMatrixRotationZ( &mtxRoll, RotationRoll);
-        
-        // Concatenate the rotation matrices
-        D3DXMatrixMultiply( &mtxRotate, &mtxRotate, &mtxYaw );
-        D3DXMatrixMultiply( &mtxRotate, &mtxRotate, &mtxPitch );
-        D3DXMatrixMultiply( &mtxRotate, &mtxRotate, &mtxRoll );
-            
+        CObject & Object = m_Objects[i];
+
+        // Rotation enabled for this object?
+        if ( !((i & 1) ? m_bRotation2 : m_bRotation1) ) continue;
+
         // Apply the rotation to our object's matrix
-        D3DXMatrixMultiply( &m_pObject[ 1 ].m_mtxWorld, &mtxRotate, &m_pObject[ 1 ].m_mtxWorld );
+        RotateMatrix( Object.m_mtxWorld, D3DXToRadian( Object.m_vecSpin.x * fElapsed ),
+                      D3DXToRadian( Object.m_vecSpin.y * fElapsed ), D3DXToRadian( Object.m_vecSpin.z * fElapsed ) );
 
-    } // End if rotation enabled
+    } // Next Object
+}
+
+//-----------------------------------------------------------------------------
+// Name : AnimateJob () (Static, Private)
+// Desc : Thread pool job callback, animates a single batch of objects.
+//-----------------------------------------------------------------------------
+void CGameApp::AnimateJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex )
+{
+    ((CGameApp*)pContext)->AnimateBatch( JobIndex );
+}
+
+//-----------------------------------------------------------------------------
+// Name : CullJob () (Static, Private)
+// Desc : Thread pool job callback, frustum tests a single batch of objects.
+//-----------------------------------------------------------------------------
+void CGameApp::CullJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex )
+{
+    ((CGameApp*)pContext)->CullBatch( JobIndex, ThreadIndex );
+}
 
-}
\ No newline at end of file
+//-----------------------------------------------------------------------------
+// Name : DrawJob () (Static, Private)
+// Desc : Thread pool job callback, draws a single batch of the draw list.
+//-----------------------------------------------------------------------------
+void CGameApp::DrawJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex )
+{
+    ((CGameApp*)pContext)->DrawBatch( JobIndex, ThreadIndex );
+}
@@ -0,0 +1,284 @@
+//-----------------------------------------------------------------------------
+// File: CHiZBuffer.cpp
+//
+// Desc: Hierarchical depth buffer used for occlusion culling. A pyramid of
+//       minimum / maximum depth values is built from the rasterizer's depth
+//       buffer, and screen space rectangles can then be tested against it
+//       using only a handful of reads.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CHiZBuffer Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CHiZBuffer.h"
+#include <xmmintrin.h>
+
+//-----------------------------------------------------------------------------
+// Name : CHiZBuffer () (Constructor)
+// Desc : CHiZBuffer Class Constructor
+//-----------------------------------------------------------------------------
+CHiZBuffer::CHiZBuffer()
+{
+	// Reset / Clear all required values
+    m_nWidth        = 0;
+    m_nHeight       = 0;
+    m_pSource       = NULL;
+    m_nSourcePitch  = 0;
+    m_pThreadPool   = NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CHiZBuffer () (Destructor)
+// Desc : CHiZBuffer Class Destructor
+//-----------------------------------------------------------------------------
+CHiZBuffer::~CHiZBuffer()
+{
+    // Release the pyramid
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Releases every level of the pyramid.
+//-----------------------------------------------------------------------------
+void CHiZBuffer::Release( )
+{
+    for ( ULONG i = 0; i < m_Levels.size(); i++ )
+    {
+        if ( m_Levels[i].pMin ) delete []m_Levels[i].pMin;
+        if ( m_Levels[i].pMax ) delete []m_Levels[i].pMax;
+
+    } // Next Level
+
+    // Clear variables
+    m_Levels.clear();
+    m_nWidth  = 0;
+    m_nHeight = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Allocate () (Private)
+// Desc : (Re)allocates the pyramid levels for a depth buffer of the size
+//        specified, down to a single cell.
+//-----------------------------------------------------------------------------
+bool CHiZBuffer::Allocate( ULONG Width, ULONG Height )
+{
+    Level NewLevel;
+
+    // Nothing to do if the size is unchanged
+    if ( Width == m_nWidth && Height == m_nHeight && !m_Levels.empty() ) return true;
+
+    // Release the old pyramid
+    Release();
+
+    // Level 0 cell counts
+    NewLevel.Width  = (Width  + HIZ_CELL_SIZE - 1) / HIZ_CELL_SIZE;
+    NewLevel.Height = (Height + HIZ_CELL_SIZE - 1) / HIZ_CELL_SIZE;
+
+    for ( ;; )
+    {
+        // Allocate this level
+        NewLevel.pMin = new float[ NewLevel.Width * NewLevel.Height ];
+        NewLevel.pMax = new float[ NewLevel.Width * NewLevel.Height ];
+        m_Levels.push_back( NewLevel );
+        if ( !NewLevel.pMin || !NewLevel.pMax ) { Release(); return false; }
+
+        // Stop once a single cell covers everything
+        if ( NewLevel.Width == 1 && NewLevel.Height == 1 ) break;
+        NewLevel.Width  = (NewLevel.Width  + 1) / 2;
+        NewLevel.Height = (NewLevel.Height + 1) / 2;
+
+    } // Next Level
+
+    // Store the new size
+    m_nWidth  = Width;
+    m_nHeight = Height;
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Build ()
+// Desc : Builds the pyramid from the depth buffer specified. Level 0 is built
+//        a row of cells at a time (in parallel where a thread pool is
+//        available), each level above is then reduced from the one below.
+// Note : 'Pitch' is the distance between depth buffer rows, in pixels.
+//-----------------------------------------------------------------------------
+bool CHiZBuffer::Build( const float * pDepth, ULONG Width, ULONG Height, ULONG Pitch )
+{
+    ULONG L, x, y, x0, y0, x1, y1;
+    float Min, Max;
+
+    // Nothing to build from?
+    if ( !pDepth || Width == 0 || Height == 0 ) { Release(); return false; }
+    if ( !Allocate( Width, Height ) ) return false;
+
+    // Build level 0 directly from the depth buffer
+    m_pSource      = pDepth;
+    m_nSourcePitch = Pitch;
+    if ( m_pThreadPool )
+        m_pThreadPool->Execute( BuildJob, this, m_Levels[0].Height );
+    else
+        for ( y = 0; y < m_Levels[0].Height; y++ ) BuildRow( y );
+    m_pSource = NULL;
+
+    // Reduce each level from the one below
+    for ( L = 1; L < m_Levels.size(); L++ )
+    {
+        const Level & Src = m_Levels[L - 1];
+        const Level & Dst = m_Levels[L];
+
+        for ( y = 0; y < Dst.Height; y++ )
+        {
+            for ( x = 0; x < Dst.Width; x++ )
+            {
+                // 2x2 source cells (clamped at odd sized edges)
+                x0 = x * 2; x1 = min( x0 + 1, Src.Width  - 1 );
+                y0 = y * 2; y1 = min( y0 + 1, Src.Height - 1 );
+
+                Min = min( min( Src.pMin[ y0 * Src.Width + x0 ], Src.pMin[ y0 * Src.Width + x1 ] ),
+                           min( Src.pMin[ y1 * Src.Width + x0 ], Src.pMin[ y1 * Src.Width + x1 ] ) );
+                Max = max( max( Src.pMax[ y0 * Src.Width + x0 ], Src.pMax[ y0 * Src.Width + x1 ] ),
+                           max( Src.pMax[ y1 * Src.Width + x0 ], Src.pMax[ y1 * Src.Width + x1 ] ) );
+                Dst.pMin[ y * Dst.Width + x ] = Min;
+                Dst.pMax[ y * Dst.Width + x ] = Max;
+
+            } // Next Cell
+
+        } // Next Row
+
+    } // Next Level
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildJob () (Static, Private)
+// Desc : Thread pool job callback, builds a single row of level 0 cells.
+//-----------------------------------------------------------------------------
+void CHiZBuffer::BuildJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex )
+{
+    ((CHiZBuffer*)pContext)->BuildRow( JobIndex );
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildRow () (Private)
+// Desc : Calculates the minimum and maximum depth of each level 0 cell in the
+//        row specified. Cells lying wholly within the buffer are reduced four
+//        pixels at a time using SSE.
+//-----------------------------------------------------------------------------
+void CHiZBuffer::BuildRow( ULONG Row )
+{
+    const Level & L0 = m_Levels[0];
+    ULONG   Cell, x, y, x0, y0, x1, y1;
+    float   Min, Max, Result[4];
+    __m128  vMin, vMax, a, b;
+
+    // Pixel rows covered by this row of cells
+    y0 = Row * HIZ_CELL_SIZE;
+    y1 = min( y0 + HIZ_CELL_SIZE, m_nHeight );
+
+    for ( Cell = 0; Cell < L0.Width; Cell++ )
+    {
+        x0 = Cell * HIZ_CELL_SIZE;
+        x1 = min( x0 + HIZ_CELL_SIZE, m_nWidth );
+
+        if ( x1 - x0 == HIZ_CELL_SIZE )
+        {
+            // Full width cell, two groups of four pixels per row
+            vMin = _mm_set1_ps(  1e30f );
+            vMax = _mm_set1_ps( -1e30f );
+            for ( y = y0; y < y1; y++ )
+            {
+                const float * pRow = m_pSource + y * m_nSourcePitch + x0;
+                a    = _mm_loadu_ps( pRow );
+                b    = _mm_loadu_ps( pRow + 4 );
+                vMin = _mm_min_ps( vMin, _mm_min_ps( a, b ) );
+                vMax = _mm_max_ps( vMax, _mm_max_ps( a, b ) );
+
+            } // Next Row
+
+            _mm_storeu_ps( Result, vMin );
+            Min = min( min( Result[0], Result[1] ), min( Result[2], Result[3] ) );
+            _mm_storeu_ps( Result, vMax );
+            Max = max( max( Result[0], Result[1] ), max( Result[2], Result[3] ) );
+        }
+        else
+        {
+            // Partial cell at the right hand edge of the buffer
+            Min =  1e30f;
+            Max = -1e30f;
+            for ( y = y0; y < y1; y++ )
+            {
+                const float * pRow = m_pSource + y * m_nSourcePitch;
+                for ( x = x0; x < x1; x++ )
+                {
+                    if ( pRow[x] < Min ) Min = pRow[x];
+                    if ( pRow[x] > Max ) Max = pRow[x];
+
+                } // Next Pixel
+
+            } // Next Row
+
+        } // End if partial cell
+
+        L0.pMin[ Row * L0.Width + Cell ] = Min;
+        L0.pMax[ Row * L0.Width + Cell ] = Max;
+
+    } // Next Cell
+}
+
+//-----------------------------------------------------------------------------
+// Name : IsVisible ()
+// Desc : Determines whether anything at or beyond depth 'NearZ' within the
+//        screen space rectangle specified could be visible. Returns false
+//        only when every pixel of the rectangle is already nearer.
+// Note : The rectangle is tested at the finest level where it covers no more
+//        than 2x2 cells, so the test costs at most four reads.
+//-----------------------------------------------------------------------------
+bool CHiZBuffer::IsVisible( float MinX, float MinY, float MaxX, float MaxY, float NearZ ) const
+{
+    long  x0, y0, x1, y1, x, y;
+    ULONG L;
+
+    // No pyramid, assume visible
+    if ( m_Levels.empty() ) return true;
+
+    // Entirely off screen?
+    if ( MaxX < 0.0f || MaxY < 0.0f || MinX >= (float)m_nWidth || MinY >= (float)m_nHeight ) return false;
+
+    // Quick accept, nearer than anything in the buffer
+    if ( NearZ < m_Levels.back().pMin[0] ) return true;
+
+    // Calculate the level 0 cells overlapped by the (clamped) rectangle
+    x0 = (long)max( MinX, 0.0f ) / (long)HIZ_CELL_SIZE;
+    y0 = (long)max( MinY, 0.0f ) / (long)HIZ_CELL_SIZE;
+    x1 = (long)min( MaxX, (float)(m_nWidth  - 1) ) / (long)HIZ_CELL_SIZE;
+    y1 = (long)min( MaxY, (float)(m_nHeight - 1) ) / (long)HIZ_CELL_SIZE;
+
+    // Climb the pyramid until the rectangle covers at most 2x2 cells
+    for ( L = 0; L + 1 < m_Levels.size() && (x1 - x0 > 1 || y1 - y0 > 1); L++ )
+    {
+        x0 >>= 1; y0 >>= 1; x1 >>= 1; y1 >>= 1;
+
+    } // Next Level
+
+    // Visible if any cell has something at least as far away as the object
+    const Level & Lvl = m_Levels[L];
+    for ( y = y0; y <= y1; y++ )
+    {
+        for ( x = x0; x <= x1; x++ )
+        {
+            if ( NearZ <= Lvl.pMax[ y * Lvl.Width + x ] ) return true;
+
+        } // Next Cell
+
+    } // Next Row
+
+    // Completely hidden
+    return false;
+}
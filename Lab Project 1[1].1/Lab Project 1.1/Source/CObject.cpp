@@ -1,204 +1,716 @@
-//-----------------------------------------------------------------------------
-// File: CObject.cpp
-//
-// Desc: This file houses the various object / mesh related classes.
-//
-// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
-//-----------------------------------------------------------------------------
-
-//-----------------------------------------------------------------------------
-// CObject Specific Includes
-//-----------------------------------------------------------------------------
-#include "..\\Includes\\CObject.h"
-
-//-----------------------------------------------------------------------------
-// Name : CObject () (Constructor)
-// Desc : CObject Class Constructor
-//-----------------------------------------------------------------------------
-CObject::CObject()
-{
-	// Reset / Clear all required values
-    m_pMesh = NULL;
-    D3DXMatrixIdentity( &m_mtxWorld );
-}
-
-//-----------------------------------------------------------------------------
-// Name : CObject () (Alternate Constructor)
-// Desc : CObject Class Constructor, sets the internal mesh object
-//-----------------------------------------------------------------------------
-CObject::CObject( CMesh * pMesh )
-{
-	// Reset / Clear all required values
-    D3DXMatrixIdentity( &m_mtxWorld );
-
-    // Set Mesh
-    m_pMesh = pMesh;
-}
-
-//-----------------------------------------------------------------------------
-// Name : CMesh () (Constructor)
-// Desc : CMesh Class Constructor
-//-----------------------------------------------------------------------------
-CMesh::CMesh()
-{
-	// Reset / Clear all required values
-    m_nPolygonCount = 0;
-    m_pPolygon      = NULL;
-
-}
-
-//-----------------------------------------------------------------------------
-// Name : CMesh () (Alternate Constructor)
-// Desc : CMesh Class Constructor, adds specified number of polygons
-//-----------------------------------------------------------------------------
-CMesh::CMesh( ULONG Count )
-{
-	// Reset / Clear all required values
-    m_nPolygonCount = 0;
-    m_pPolygon      = NULL;
-
-    // Add Polygons
-    AddPolygon( Count );
-}
-
-//-----------------------------------------------------------------------------
-// Name : ~CMesh () (Destructor)
-// Desc : CMesh Class Destructor
-//-----------------------------------------------------------------------------
-CMesh::~CMesh()
-{
-	// Release our mesh components
-    if ( m_pPolygon ) 
-    {
-        // Delete all individual polygons in the array.
-        for ( ULONG i = 0; i < m_nPolygonCount; i++ )
-        {
-            if ( m_pPolygon[i] ) delete m_pPolygon[i];
-        
-        } // Next Polygon
-
-        // Free up the array itself
-        delete []m_pPolygon;
-    
-    } // End if
-
-    // Clear variables
-    m_pPolygon      = NULL;
-    m_nPolygonCount = 0;
-}
-
-//-----------------------------------------------------------------------------
-// Name : AddPolygon()
-// Desc : Adds a polygon, or multiple polygons, to this mesh.
-// Note : Returns the index for the first polygon added, or -1 on failure.
-//-----------------------------------------------------------------------------
-long CMesh::AddPolygon( ULONG Count )
-{
-
-    CPolygon ** pPolyBuffer = NULL;
-    
-    // Allocate new resized array
-    if (!( pPolyBuffer = new CPolygon*[ m_nPolygonCount + Count ] )) return -1;
-
-    // Clear out slack pointers
-    ZeroMemory( &pPolyBuffer[ m_nPolygonCount ], Count * sizeof( CPolygon* ) );
-
-    // Existing Data?
-    if ( m_pPolygon )
-    {
-        // Copy old data into new buffer
-        memcpy( pPolyBuffer, m_pPolygon, m_nPolygonCount * sizeof( CPolygon* ) );
-
-        // Release old buffer
-        delete []m_pPolygon;
-
-    } // End if
-    
-    // Store pointer for new buffer
-    m_pPolygon = pPolyBuffer;
-
-    // Allocate new polygon pointers
-    for ( UINT i = 0; i < Count; i++ )
-    {
-        // Allocate new poly
-        if (!( m_pPolygon[ m_nPolygonCount ] = new CPolygon() )) return -1;
-
-        // Increase overall poly count
-        m_nPolygonCount++;
-
-    } // Next Polygon
-    
-    // Return first polygon
-    return m_nPolygonCount - Count;
-}
-
-//-----------------------------------------------------------------------------
-// Name : CPolygon () (Constructor)
-// Desc : CPolygon Class Constructor
-//-----------------------------------------------------------------------------
-CPolygon::CPolygon()
-{
-	// Reset / Clear all required values
-    m_nVertexCount  = 0;
-    m_pVertex       = NULL;
-
-}
-
-//-----------------------------------------------------------------------------
-// Name : CPolygon () (Alternate Constructor)
-// Desc : CPolygon Class Constructor, adds specified number of vertices
-//-----------------------------------------------------------------------------
-CPolygon::CPolygon( USHORT Count )
-{
-	// Reset / Clear all required values
-    m_nVertexCount  = 0;
-    m_pVertex       = NULL;
-
-    // Add vertices
-    AddVertex( Count );
-}
-
-//-----------------------------------------------------------------------------
-// Name : ~CPolygon () (Destructor)
-// Desc : CPolygon Class Destructor
-//-----------------------------------------------------------------------------
-CPolygon::~CPolygon()
-{
-	// Release our vertices
-    if ( m_pVertex ) delete []m_pVertex;
-    
-    // Clear variables
-    m_pVertex       = NULL;
-    m_nVertexCount  = 0;
-}
-
-//-----------------------------------------------------------------------------
-// Name : AddVertex()
-// Desc : Adds a vertex, or multiple vertices, to this polygon.
-// Note : Returns the index for the first vertex added, or -1 on failure.
-//-----------------------------------------------------------------------------
-long CPolygon::AddVertex( USHORT Count )
-{
-    CVertex * pVertexBuffer = NULL;
-    
-    // Allocate new resized array
-    if (!( pVertexBuffer = new CVertex[ m_nVertexCount + Count ] )) return -1;
-
-    // Existing Data?
-    if ( m_pVertex )
-    {
-        // Copy old data into new buffer
-        memcpy( pVertexBuffer, m_pVertex, m_nVertexCount * sizeof(CVertex) );
-
-        // Release old buffer
-        delete []m_pVertex;
-
-    } // End if
-
-    // Store pointer for new buffer
-    m_pVertex = pVertexBuffer;
-    m_nVertexCount += Count;
-
-    // Return first vertex
-    return m_nVertexCount - Count;
+//-----------------------------------------------------------------------------
+// File: CObject.cpp
+//
+// Desc: This file houses the various object / mesh related classes.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CObject Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CObject.h"
+#include <xmmintrin.h>
+#include <vector>
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// Module Local Structures
+//-----------------------------------------------------------------------------
+// Used when welding polygon vertices into the unique position list
+struct WeldVertex
+{
+    float       x, y, z;                // Vertex position
+    ULONG       Polygon;                // Polygon the vertex belongs to
+    USHORT      Vertex;                 // Index of the vertex in that polygon
+};
+
+//-----------------------------------------------------------------------------
+// Name : WeldVertexLess () (Module Local)
+// Desc : Sort predicate used to group identical positions together.
+//-----------------------------------------------------------------------------
+static bool WeldVertexLess( const WeldVertex & a, const WeldVertex & b )
+{
+    if ( a.x != b.x ) return a.x < b.x;
+    if ( a.y != b.y ) return a.y < b.y;
+    return a.z < b.z;
+}
+
+//-----------------------------------------------------------------------------
+// Name : CObject () (Constructor)
+// Desc : CObject Class Constructor
+//-----------------------------------------------------------------------------
+CObject::CObject()
+{
+	// Reset / Clear all required values
+    m_pMesh   = NULL;
+    m_vecSpin = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+    D3DXMatrixIdentity( &m_mtxWorld );
+}
+
+//-----------------------------------------------------------------------------
+// Name : CObject () (Alternate Constructor)
+// Desc : CObject Class Constructor, sets the internal mesh object
+//-----------------------------------------------------------------------------
+CObject::CObject( CMesh * pMesh )
+{
+	// Reset / Clear all required values
+    m_vecSpin = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+    D3DXMatrixIdentity( &m_mtxWorld );
+
+    // Set Mesh
+    m_pMesh = pMesh;
+}
+
+//-----------------------------------------------------------------------------
+// Name : CMesh () (Constructor)
+// Desc : CMesh Class Constructor
+//-----------------------------------------------------------------------------
+CMesh::CMesh()
+{
+	// Reset / Clear all required values
+    m_nPositionCount    = 0;
+    m_pPositionX        = NULL;
+    m_pPositionY        = NULL;
+    m_pPositionZ        = NULL;
+    m_nIndexCount       = 0;
+    m_pIndex            = NULL;
+    m_pTexCoord         = NULL;
+    m_nFaceCount        = 0;
+    m_pFace             = NULL;
+    m_nPolygonCount     = 0;
+    m_pPolygon          = NULL;
+    m_nPositionCapacity = 0;
+    m_nIndexCapacity    = 0;
+    m_nFaceCapacity     = 0;
+    m_nPolygonCapacity  = 0;
+    ResetBounds();
+
+}
+
+//-----------------------------------------------------------------------------
+// Name : CMesh () (Alternate Constructor)
+// Desc : CMesh Class Constructor, adds specified number of polygons
+//-----------------------------------------------------------------------------
+CMesh::CMesh( ULONG Count )
+{
+	// Reset / Clear all required values
+    m_nPositionCount    = 0;
+    m_pPositionX        = NULL;
+    m_pPositionY        = NULL;
+    m_pPositionZ        = NULL;
+    m_nIndexCount       = 0;
+    m_pIndex            = NULL;
+    m_pTexCoord         = NULL;
+    m_nFaceCount        = 0;
+    m_pFace             = NULL;
+    m_nPolygonCount     = 0;
+    m_pPolygon          = NULL;
+    m_nPositionCapacity = 0;
+    m_nIndexCapacity    = 0;
+    m_nFaceCapacity     = 0;
+    m_nPolygonCapacity  = 0;
+    ResetBounds();
+
+    // Add Polygons
+    AddPolygon( Count );
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CMesh () (Destructor)
+// Desc : CMesh Class Destructor
+//-----------------------------------------------------------------------------
+CMesh::~CMesh()
+{
+	// Release our mesh components
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Releases all of the mesh data, including any staged polygons.
+//-----------------------------------------------------------------------------
+void CMesh::Release( )
+{
+    // Release the vertex pool, index buffer and face table
+    if ( m_pPositionX ) _mm_free( m_pPositionX );
+    if ( m_pPositionY ) _mm_free( m_pPositionY );
+    if ( m_pPositionZ ) _mm_free( m_pPositionZ );
+    if ( m_pIndex     ) delete []m_pIndex;
+    if ( m_pTexCoord  ) delete []m_pTexCoord;
+    if ( m_pFace      ) delete []m_pFace;
+
+    // Release any staged polygons
+    ReleasePolygons();
+
+    // Clear variables
+    m_nPositionCount    = 0;
+    m_pPositionX        = NULL;
+    m_pPositionY        = NULL;
+    m_pPositionZ        = NULL;
+    m_nIndexCount       = 0;
+    m_pIndex            = NULL;
+    m_pTexCoord         = NULL;
+    m_nFaceCount        = 0;
+    m_pFace             = NULL;
+    m_nPositionCapacity = 0;
+    m_nIndexCapacity    = 0;
+    m_nFaceCapacity     = 0;
+    ResetBounds();
+}
+
+//-----------------------------------------------------------------------------
+// Name : ReleasePolygons () (Private)
+// Desc : Releases the staged polygon array.
+//-----------------------------------------------------------------------------
+void CMesh::ReleasePolygons( )
+{
+    if ( m_pPolygon ) 
+    {
+        // Delete all individual polygons in the array.
+        for ( ULONG i = 0; i < m_nPolygonCount; i++ )
+        {
+            if ( m_pPolygon[i] ) delete m_pPolygon[i];
+        
+        } // Next Polygon
+
+        // Free up the array itself
+        delete []m_pPolygon;
+    
+    } // End if
+
+    // Clear variables
+    m_pPolygon         = NULL;
+    m_nPolygonCount    = 0;
+    m_nPolygonCapacity = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Reserve ()
+// Desc : Pre-sizes the vertex pool, index buffer and face table so that the
+//        specified totals can be added without any further allocation.
+//-----------------------------------------------------------------------------
+bool CMesh::Reserve( ULONG VertexCount, ULONG IndexCount, ULONG FaceCount )
+{
+    if ( !ReservePositions( VertexCount ) ) return false;
+    if ( !ReserveIndices( IndexCount ) ) return false;
+    if ( !ReserveFaces( FaceCount ) ) return false;
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ReservePositions () (Private)
+// Desc : Ensures the vertex pool can hold at least 'Count' vertices. The
+//        arrays are kept padded with zeros to a multiple of 8 entries.
+//-----------------------------------------------------------------------------
+bool CMesh::ReservePositions( ULONG Count )
+{
+    float * pNewX = NULL, * pNewY = NULL, * pNewZ = NULL;
+    ULONG   Capacity = (Count + 7) & ~7;
+
+    // Already large enough?
+    if ( Capacity <= m_nPositionCapacity ) return true;
+
+    // Allocate new resized arrays
+    pNewX = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    pNewY = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    pNewZ = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    if ( !pNewX || !pNewY || !pNewZ )
+    {
+        if ( pNewX ) _mm_free( pNewX );
+        if ( pNewY ) _mm_free( pNewY );
+        if ( pNewZ ) _mm_free( pNewZ );
+        return false;
+
+    } // End if failed
+
+    // Copy old data, and clear the remainder
+    if ( m_nPositionCount )
+    {
+        memcpy( pNewX, m_pPositionX, m_nPositionCount * sizeof(float) );
+        memcpy( pNewY, m_pPositionY, m_nPositionCount * sizeof(float) );
+        memcpy( pNewZ, m_pPositionZ, m_nPositionCount * sizeof(float) );
+    
+    } // End if existing data
+    ZeroMemory( pNewX + m_nPositionCount, (Capacity - m_nPositionCount) * sizeof(float) );
+    ZeroMemory( pNewY + m_nPositionCount, (Capacity - m_nPositionCount) * sizeof(float) );
+    ZeroMemory( pNewZ + m_nPositionCount, (Capacity - m_nPositionCount) * sizeof(float) );
+
+    // Release old arrays and store the new ones
+    if ( m_pPositionX ) _mm_free( m_pPositionX );
+    if ( m_pPositionY ) _mm_free( m_pPositionY );
+    if ( m_pPositionZ ) _mm_free( m_pPositionZ );
+    m_pPositionX        = pNewX;
+    m_pPositionY        = pNewY;
+    m_pPositionZ        = pNewZ;
+    m_nPositionCapacity = Capacity;
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ReserveIndices () (Private)
+// Desc : Ensures the index buffer (and the texture coordinates stored
+//        alongside it) can hold at least 'Count' indices.
+//-----------------------------------------------------------------------------
+bool CMesh::ReserveIndices( ULONG Count )
+{
+    ULONG       * pBuffer   = NULL;
+    D3DXVECTOR2 * pTexCoord = NULL;
+
+    // Already large enough?
+    if ( Count <= m_nIndexCapacity ) return true;
+
+    // Allocate new resized arrays
+    if (!( pBuffer = new ULONG[ Count ] )) return false;
+    if (!( pTexCoord = new D3DXVECTOR2[ Count ] )) { delete []pBuffer; return false; }
+
+    // Existing Data?
+    if ( m_pIndex )
+    {
+        memcpy( pBuffer, m_pIndex, m_nIndexCount * sizeof(ULONG) );
+        memcpy( pTexCoord, m_pTexCoord, m_nIndexCount * sizeof(D3DXVECTOR2) );
+        delete []m_pIndex;
+        delete []m_pTexCoord;
+
+    } // End if
+
+    // Store pointers for new buffers
+    m_pIndex         = pBuffer;
+    m_pTexCoord      = pTexCoord;
+    m_nIndexCapacity = Count;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ReserveFaces () (Private)
+// Desc : Ensures the face table can hold at least 'Count' faces.
+//-----------------------------------------------------------------------------
+bool CMesh::ReserveFaces( ULONG Count )
+{
+    MESHFACE * pBuffer = NULL;
+
+    // Already large enough?
+    if ( Count <= m_nFaceCapacity ) return true;
+
+    // Allocate new resized array
+    if (!( pBuffer = new MESHFACE[ Count ] )) return false;
+
+    // Existing Data?
+    if ( m_pFace )
+    {
+        memcpy( pBuffer, m_pFace, m_nFaceCount * sizeof(MESHFACE) );
+        delete []m_pFace;
+
+    } // End if
+
+    // Store pointer for new buffer
+    m_pFace         = pBuffer;
+    m_nFaceCapacity = Count;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : AddVertices ()
+// Desc : Appends vertices to the vertex pool.
+// Note : Returns the index of the first vertex added, or -1 on failure.
+//-----------------------------------------------------------------------------
+long CMesh::AddVertices( const CVertex * pVertices, ULONG Count )
+{
+    ULONG i, Needed = m_nPositionCount + Count;
+
+    // Grow geometrically so repeated calls remain linear overall
+    if ( Needed > m_nPositionCapacity )
+    {
+        if ( !ReservePositions( max( Needed, m_nPositionCapacity * 2 ) ) ) return -1;
+    
+    } // End if grow
+
+    // Copy the vertices into the pool
+    for ( i = 0; i < Count; i++ )
+    {
+        m_pPositionX[ m_nPositionCount + i ] = pVertices[i].x;
+        m_pPositionY[ m_nPositionCount + i ] = pVertices[i].y;
+        m_pPositionZ[ m_nPositionCount + i ] = pVertices[i].z;
+
+    } // Next Vertex
+
+    // Return first vertex
+    m_nPositionCount = Needed;
+    UpdateBounds( Needed - Count, Count );
+    return Needed - Count;
+}
+
+//-----------------------------------------------------------------------------
+// Name : AddFace ()
+// Desc : Appends a single face, built from the vertex pool indices specified.
+// Note : Returns the index of the face added, or -1 on failure.
+//-----------------------------------------------------------------------------
+long CMesh::AddFace( const ULONG * pIndices, ULONG Count, const D3DXVECTOR2 * pTexCoords )
+{
+    return AddFaces( pIndices, 1, Count, pTexCoords );
+}
+
+//-----------------------------------------------------------------------------
+// Name : AddFaces ()
+// Desc : Appends multiple faces, each with the same number of vertices. The
+//        index array holds 'FaceCount * VerticesPerFace' entries, as does the
+//        (optional) texture coordinate array. Corners are given a texture
+//        coordinate of ( 0, 0 ) when none are supplied.
+// Note : Returns the index of the first face added, or -1 on failure.
+//-----------------------------------------------------------------------------
+long CMesh::AddFaces( const ULONG * pIndices, ULONG FaceCount, ULONG VerticesPerFace, const D3DXVECTOR2 * pTexCoords )
+{
+    ULONG i, NeededIndices = m_nIndexCount + FaceCount * VerticesPerFace;
+    ULONG NeededFaces = m_nFaceCount + FaceCount;
+
+    // Grow geometrically so repeated calls remain linear overall
+    if ( NeededIndices > m_nIndexCapacity )
+    {
+        if ( !ReserveIndices( max( NeededIndices, m_nIndexCapacity * 2 ) ) ) return -1;
+    
+    } // End if grow indices
+    if ( NeededFaces > m_nFaceCapacity )
+    {
+        if ( !ReserveFaces( max( NeededFaces, m_nFaceCapacity * 2 ) ) ) return -1;
+    
+    } // End if grow faces
+
+    // Copy the indices, and describe each face
+    memcpy( &m_pIndex[ m_nIndexCount ], pIndices, FaceCount * VerticesPerFace * sizeof(ULONG) );
+    if ( pTexCoords )
+        memcpy( &m_pTexCoord[ m_nIndexCount ], pTexCoords, FaceCount * VerticesPerFace * sizeof(D3DXVECTOR2) );
+    else
+        ZeroMemory( &m_pTexCoord[ m_nIndexCount ], FaceCount * VerticesPerFace * sizeof(D3DXVECTOR2) );
+    for ( i = 0; i < FaceCount; i++ )
+    {
+        m_pFace[ m_nFaceCount + i ].FirstIndex = m_nIndexCount + i * VerticesPerFace;
+        m_pFace[ m_nFaceCount + i ].IndexCount = VerticesPerFace;
+
+    } // Next Face
+
+    // Return first face
+    m_nIndexCount = NeededIndices;
+    m_nFaceCount  = NeededFaces;
+    CalcFacePlanes( NeededFaces - FaceCount, FaceCount );
+    return NeededFaces - FaceCount;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ResetBounds () (Private)
+// Desc : Resets the bounding volumes ready to be grown by UpdateBounds.
+//-----------------------------------------------------------------------------
+void CMesh::ResetBounds( )
+{
+    m_BoundsMin     = D3DXVECTOR3(  999999.0f,  999999.0f,  999999.0f );
+    m_BoundsMax     = D3DXVECTOR3( -999999.0f, -999999.0f, -999999.0f );
+    m_BoundsCentre  = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+    m_fBoundsRadius = 0.0f;
+}
+
+//-----------------------------------------------------------------------------
+// Name : UpdateBounds () (Private)
+// Desc : Grows the bounding box to include the vertices specified, and
+//        rebuilds the bounding sphere around the resulting box.
+//-----------------------------------------------------------------------------
+void CMesh::UpdateBounds( ULONG FirstVertex, ULONG Count )
+{
+    D3DXVECTOR3 vecExtents;
+
+    // Grow the bounding box
+    for ( ULONG i = FirstVertex; i < FirstVertex + Count; i++ )
+    {
+        if ( m_pPositionX[i] < m_BoundsMin.x ) m_BoundsMin.x = m_pPositionX[i];
+        if ( m_pPositionY[i] < m_BoundsMin.y ) m_BoundsMin.y = m_pPositionY[i];
+        if ( m_pPositionZ[i] < m_BoundsMin.z ) m_BoundsMin.z = m_pPositionZ[i];
+        if ( m_pPositionX[i] > m_BoundsMax.x ) m_BoundsMax.x = m_pPositionX[i];
+        if ( m_pPositionY[i] > m_BoundsMax.y ) m_BoundsMax.y = m_pPositionY[i];
+        if ( m_pPositionZ[i] > m_BoundsMax.z ) m_BoundsMax.z = m_pPositionZ[i];
+
+    } // Next Vertex
+
+    // The sphere encloses the box
+    if ( m_nPositionCount == 0 ) return;
+    m_BoundsCentre  = (m_BoundsMin + m_BoundsMax) * 0.5f;
+    vecExtents      = m_BoundsMax - m_BoundsCentre;
+    m_fBoundsRadius = D3DXVec3Length( &vecExtents );
+}
+
+//-----------------------------------------------------------------------------
+// Name : CalcFacePlanes () (Private)
+// Desc : Calculates the plane of each face specified. Newell's method is used
+//        so that polygons with collinear leading vertices are still handled.
+//        Faces are wound clockwise when viewed from their front side (in this
+//        left handed system).
+//-----------------------------------------------------------------------------
+void CMesh::CalcFacePlanes( ULONG FirstFace, ULONG Count )
+{
+    D3DXVECTOR3 vecNormal, vecCentre, vecCurrent, vecNext;
+    ULONG       f, v;
+
+    for ( f = FirstFace; f < FirstFace + Count; f++ )
+    {
+        MESHFACE    & Face   = m_pFace[f];
+        const ULONG * pIndex = &m_pIndex[ Face.FirstIndex ];
+
+        vecNormal = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+        vecCentre = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+        for ( v = 0; v < Face.IndexCount; v++ )
+        {
+            ULONG i0 = pIndex[ v ], i1 = pIndex[ (v + 1) % Face.IndexCount ];
+            vecCurrent = D3DXVECTOR3( m_pPositionX[i0], m_pPositionY[i0], m_pPositionZ[i0] );
+            vecNext    = D3DXVECTOR3( m_pPositionX[i1], m_pPositionY[i1], m_pPositionZ[i1] );
+
+            // Accumulate (matches Cross( v1 - v0, v2 - v0 ) for a triangle)
+            vecNormal.x += (vecCurrent.y - vecNext.y) * (vecCurrent.z + vecNext.z);
+            vecNormal.y += (vecCurrent.z - vecNext.z) * (vecCurrent.x + vecNext.x);
+            vecNormal.z += (vecCurrent.x - vecNext.x) * (vecCurrent.y + vecNext.y);
+            vecCentre   = vecCentre + vecCurrent;
+
+        } // Next Vertex
+
+        // Store the plane
+        D3DXVec3Normalize( &Face.Normal, &vecNormal );
+        if ( Face.IndexCount ) vecCentre = vecCentre * (1.0f / Face.IndexCount);
+        Face.Distance = -D3DXVec3Dot( &Face.Normal, &vecCentre );
+
+    } // Next Face
+}
+
+//-----------------------------------------------------------------------------
+// Name : AddPolygon()
+// Desc : Stages a polygon, or multiple polygons, for addition to this mesh.
+// Note : Returns the index for the first polygon added, or -1 on failure.
+//        The polygons are not renderable until Commit() has been called.
+//-----------------------------------------------------------------------------
+long CMesh::AddPolygon( ULONG Count )
+{
+
+    CPolygon ** pPolyBuffer = NULL;
+    ULONG       Capacity;
+    
+    // Resize the array (geometrically) if required
+    if ( m_nPolygonCount + Count > m_nPolygonCapacity )
+    {
+        // Allocate new resized array
+        Capacity = max( m_nPolygonCount + Count, m_nPolygonCapacity * 2 );
+        if (!( pPolyBuffer = new CPolygon*[ Capacity ] )) return -1;
+
+        // Existing Data?
+        if ( m_pPolygon )
+        {
+            // Copy old data into new buffer
+            memcpy( pPolyBuffer, m_pPolygon, m_nPolygonCount * sizeof( CPolygon* ) );
+
+            // Release old buffer
+            delete []m_pPolygon;
+
+        } // End if
+    
+        // Store pointer for new buffer
+        m_pPolygon         = pPolyBuffer;
+        m_nPolygonCapacity = Capacity;
+
+    } // End if grow
+
+    // Allocate new polygon pointers
+    for ( UINT i = 0; i < Count; i++ )
+    {
+        // Allocate new poly
+        if (!( m_pPolygon[ m_nPolygonCount ] = new CPolygon() )) return -1;
+
+        // Increase overall poly count
+        m_nPolygonCount++;
+
+    } // Next Polygon
+    
+    // Return first polygon
+    return m_nPolygonCount - Count;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Commit()
+// Desc : Moves all staged polygons into the indexed mesh storage, welding
+//        identical vertex positions so that shared corners are stored (and
+//        therefore transformed) only once. The staged polygons are released.
+//-----------------------------------------------------------------------------
+bool CMesh::Commit( )
+{
+    std::vector<WeldVertex> Weld;
+    std::vector<ULONG>      PolyFirstIndex;
+    WeldVertex  Entry;
+    ULONG       i, Count, IndexCount, FirstIndex, FirstVertex, FaceCount;
+    USHORT      v;
+
+    // Count the staged vertices and usable faces
+    for ( IndexCount = 0, FaceCount = 0, i = 0; i < m_nPolygonCount; i++ )
+    {
+        if ( m_pPolygon[i]->m_nVertexCount == 0 ) continue;
+        IndexCount += m_pPolygon[i]->m_nVertexCount;
+        FaceCount++;
+
+    } // Next Polygon
+
+    // Gather every vertex
+    Weld.reserve( IndexCount );
+    for ( i = 0; i < m_nPolygonCount; i++ )
+    {
+        CPolygon * pPoly = m_pPolygon[i];
+        for ( v = 0; v < pPoly->m_nVertexCount; v++ )
+        {
+            Entry.x       = pPoly->m_pVertex[v].x;
+            Entry.y       = pPoly->m_pVertex[v].y;
+            Entry.z       = pPoly->m_pVertex[v].z;
+            Entry.Polygon = i;
+            Entry.Vertex  = v;
+            Weld.push_back( Entry );
+
+        } // Next Vertex
+
+    } // Next Polygon
+
+    // Sort so that identical positions are adjacent
+    std::sort( Weld.begin(), Weld.end(), WeldVertexLess );
+
+    // Count the unique positions
+    for ( Count = 0, i = 0; i < Weld.size(); i++ )
+    {
+        if ( i == 0 || WeldVertexLess( Weld[i - 1], Weld[i] ) ) Count++;
+    
+    } // Next Vertex
+
+    // Make room for everything up front
+    if ( !Reserve( m_nPositionCount + Count, m_nIndexCount + IndexCount, m_nFaceCount + FaceCount ) ) return false;
+
+    // Lay out the face table, each polygon's indices are stored contiguously
+    PolyFirstIndex.resize( m_nPolygonCount );
+    FirstIndex = m_nIndexCount;
+    for ( i = 0; i < m_nPolygonCount; i++ )
+    {
+        CPolygon * pPoly = m_pPolygon[i];
+        PolyFirstIndex[i] = FirstIndex;
+        if ( pPoly->m_nVertexCount == 0 ) continue;
+
+        m_pFace[ m_nFaceCount ].FirstIndex = FirstIndex;
+        m_pFace[ m_nFaceCount ].IndexCount = pPoly->m_nVertexCount;
+        m_nFaceCount++;
+        FirstIndex += pPoly->m_nVertexCount;
+
+    } // Next Polygon
+
+    // Store unique positions and each polygon vertex's index
+    FirstVertex = m_nPositionCount;
+    for ( i = 0; i < Weld.size(); i++ )
+    {
+        const WeldVertex & Vtx = Weld[i];
+        if ( i == 0 || WeldVertexLess( Weld[i - 1], Vtx ) )
+        {
+            m_pPositionX[ m_nPositionCount ] = Vtx.x;
+            m_pPositionY[ m_nPositionCount ] = Vtx.y;
+            m_pPositionZ[ m_nPositionCount ] = Vtx.z;
+            m_nPositionCount++;
+
+        } // End if new position
+
+        // The texture coordinate stays with the polygon's corner
+        const CVertex & Source = m_pPolygon[ Vtx.Polygon ]->m_pVertex[ Vtx.Vertex ];
+        m_pIndex[ PolyFirstIndex[ Vtx.Polygon ] + Vtx.Vertex ]    = m_nPositionCount - 1;
+        m_pTexCoord[ PolyFirstIndex[ Vtx.Polygon ] + Vtx.Vertex ] = D3DXVECTOR2( Source.tu, Source.tv );
+
+    } // Next Vertex
+
+    // Success!
+    m_nIndexCount += IndexCount;
+    UpdateBounds( FirstVertex, m_nPositionCount - FirstVertex );
+    CalcFacePlanes( m_nFaceCount - FaceCount, FaceCount );
+    ReleasePolygons();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : CPolygon () (Constructor)
+// Desc : CPolygon Class Constructor
+//-----------------------------------------------------------------------------
+CPolygon::CPolygon()
+{
+	// Reset / Clear all required values
+    m_nVertexCount    = 0;
+    m_nVertexCapacity = 0;
+    m_pVertex         = NULL;
+
+}
+
+//-----------------------------------------------------------------------------
+// Name : CPolygon () (Alternate Constructor)
+// Desc : CPolygon Class Constructor, adds specified number of vertices
+//-----------------------------------------------------------------------------
+CPolygon::CPolygon( USHORT Count )
+{
+	// Reset / Clear all required values
+    m_nVertexCount    = 0;
+    m_nVertexCapacity = 0;
+    m_pVertex         = NULL;
+
+    // Add vertices
+    AddVertex( Count );
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CPolygon () (Destructor)
+// Desc : CPolygon Class Destructor
+//-----------------------------------------------------------------------------
+CPolygon::~CPolygon()
+{
+	// Release our vertices
+    if ( m_pVertex ) delete []m_pVertex;
+    
+    // Clear variables
+    m_pVertex         = NULL;
+    m_nVertexCount    = 0;
+    m_nVertexCapacity = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : AddVertex()
+// Desc : Adds a vertex, or multiple vertices, to this polygon.
+// Note : Returns the index for the first vertex added, or -1 on failure.
+//-----------------------------------------------------------------------------
+long CPolygon::AddVertex( USHORT Count )
+{
+    CVertex * pVertexBuffer = NULL;
+    ULONG     Capacity;
+    
+    // Resize the array (geometrically) if required
+    if ( m_nVertexCount + Count > m_nVertexCapacity )
+    {
+        // Allocate new resized array
+        Capacity = max( (ULONG)(m_nVertexCount + Count), (ULONG)m_nVertexCapacity * 2 );
+        if ( Capacity > 0xFFFF ) Capacity = 0xFFFF;
+        if ( m_nVertexCount + Count > Capacity ) return -1;
+        if (!( pVertexBuffer = new CVertex[ Capacity ] )) return -1;
+
+        // Existing Data?
+        if ( m_pVertex )
+        {
+            // Copy old data into new buffer
+            memcpy( pVertexBuffer, m_pVertex, m_nVertexCount * sizeof(CVertex) );
+
+            // Release old buffer
+            delete []m_pVertex;
+
+        } // End if
+
+        // Store pointer for new buffer
+        m_pVertex         = pVertexBuffer;
+        m_nVertexCapacity = (USHORT)Capacity;
+
+    } // End if grow
+
+    m_nVertexCount += Count;
+
+    // Return first vertex
+    return m_nVertexCount - Count;
 }
\ No newline at end of file
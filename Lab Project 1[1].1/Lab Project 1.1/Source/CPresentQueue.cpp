@@ -0,0 +1,321 @@
+//-----------------------------------------------------------------------------
+// File: CPresentQueue.cpp
+//
+// Desc: Multiple buffered frame presentation. Finished frames are handed to
+//       a dedicated present thread, so that the next frame can be drawn
+//       while the previous one is still being copied to the window.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CPresentQueue Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CPresentQueue.h"
+#include <xmmintrin.h>
+
+#ifdef _WIN32
+#include <process.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Name : CPresentQueue () (Constructor)
+// Desc : CPresentQueue Class Constructor
+//-----------------------------------------------------------------------------
+CPresentQueue::CPresentQueue()
+{
+	// Reset / Clear all required values
+    m_nWidth        = 0;
+    m_nHeight       = 0;
+    m_nPitch        = 0;
+    m_nBufferCount  = 0;
+    m_nAcquireIndex = 0;
+    m_nPresentIndex = 0;
+    m_bAcquired     = false;
+    m_nPresentCount = 0;
+    m_pFunction     = NULL;
+    m_pContext      = NULL;
+    m_bThread       = false;
+    m_bQuit         = false;
+
+    for ( ULONG i = 0; i <= MAX_PRESENT_LATENCY; i++ ) m_pBuffers[i] = NULL;
+
+#ifdef _WIN32
+    m_hThread       = NULL;
+    m_hFree         = NULL;
+    m_hReady        = NULL;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CPresentQueue () (Destructor)
+// Desc : CPresentQueue Class Destructor
+//-----------------------------------------------------------------------------
+CPresentQueue::~CPresentQueue()
+{
+    // Stop the present thread and free the buffers
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Create ()
+// Desc : Allocates MaxLatency + 1 buffers of the size specified and starts
+//        the present thread. Falls back to presenting on the submitting
+//        thread (a single buffer) if the thread can not be started.
+//-----------------------------------------------------------------------------
+bool CPresentQueue::Create( ULONG Width, ULONG Height, ULONG Pitch, ULONG MaxLatency,
+                            PRESENTFUNC pFunction, void * pContext )
+{
+    ULONG i;
+
+    // Release any previous queue
+    Release();
+
+    // Validate
+    if ( !pFunction || Width == 0 || Height == 0 || Pitch < Width ) return false;
+    if ( MaxLatency > MAX_PRESENT_LATENCY ) MaxLatency = MAX_PRESENT_LATENCY;
+
+    // Allocate the buffer ring
+    for ( i = 0; i <= MaxLatency; i++ )
+    {
+        m_pBuffers[i] = (ULONG*)_mm_malloc( Pitch * Height * sizeof(ULONG), 32 );
+        if ( !m_pBuffers[i] ) { Release(); return false; }
+        m_nBufferCount++;
+
+    } // Next Buffer
+
+    // Store details
+    m_nWidth        = Width;
+    m_nHeight       = Height;
+    m_nPitch        = Pitch;
+    m_pFunction     = pFunction;
+    m_pContext      = pContext;
+    m_nAcquireIndex = 0;
+    m_nPresentIndex = 0;
+    m_nPresentCount = 0;
+    m_bAcquired     = false;
+    m_bQuit         = false;
+
+    // Nothing more to do if presenting synchronously
+    if ( m_nBufferCount == 1 ) return true;
+
+#ifdef _WIN32
+    // Create the synchronisation objects and start the thread
+    m_hFree  = ::CreateSemaphore( NULL, m_nBufferCount, m_nBufferCount, NULL );
+    m_hReady = ::CreateSemaphore( NULL, 0, m_nBufferCount, NULL );
+    if ( m_hFree && m_hReady ) m_hThread = (HANDLE)_beginthreadex( NULL, 0, StaticPresentProc, this, 0, NULL );
+    m_bThread = ( m_hThread != NULL );
+    if ( !m_bThread )
+    {
+        if ( m_hFree  ) ::CloseHandle( m_hFree );
+        if ( m_hReady ) ::CloseHandle( m_hReady );
+        m_hFree  = NULL;
+        m_hReady = NULL;
+
+    } // End if failed
+#else
+    // Create the synchronisation objects and start the thread
+    if ( sem_init( &m_hFree, 0, m_nBufferCount ) == 0 )
+    {
+        if ( sem_init( &m_hReady, 0, 0 ) == 0 )
+        {
+            m_bThread = ( pthread_create( &m_hThread, NULL, StaticPresentProc, this ) == 0 );
+            if ( !m_bThread ) sem_destroy( &m_hReady );
+
+        } // End if ready semaphore created
+        if ( !m_bThread ) sem_destroy( &m_hFree );
+
+    } // End if free semaphore created
+#endif
+
+    // Fall back to a single synchronously presented buffer
+    if ( !m_bThread )
+    {
+        for ( i = 1; i < m_nBufferCount; i++ ) { _mm_free( m_pBuffers[i] ); m_pBuffers[i] = NULL; }
+        m_nBufferCount = 1;
+
+    } // End if no thread
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Presents any outstanding frames, stops the present thread and
+//        frees the buffers.
+//-----------------------------------------------------------------------------
+void CPresentQueue::Release( )
+{
+    ULONG i;
+
+    if ( m_bThread )
+    {
+        // Finish presenting anything already submitted
+        Flush();
+
+        // Wake the thread with the quit flag set, and wait for it to exit
+        m_bQuit = true;
+#ifdef _WIN32
+        ::ReleaseSemaphore( m_hReady, 1, NULL );
+        ::WaitForSingleObject( m_hThread, INFINITE );
+        ::CloseHandle( m_hThread );
+        ::CloseHandle( m_hFree );
+        ::CloseHandle( m_hReady );
+        m_hThread = NULL;
+        m_hFree   = NULL;
+        m_hReady  = NULL;
+#else
+        sem_post( &m_hReady );
+        pthread_join( m_hThread, NULL );
+        sem_destroy( &m_hFree );
+        sem_destroy( &m_hReady );
+#endif
+
+    } // End if thread running
+
+    // Free the buffers
+    for ( i = 0; i <= MAX_PRESENT_LATENCY; i++ )
+    {
+        if ( m_pBuffers[i] ) _mm_free( m_pBuffers[i] );
+        m_pBuffers[i] = NULL;
+
+    } // Next Buffer
+
+    // Clear variables
+    m_nBufferCount  = 0;
+    m_bAcquired     = false;
+    m_bThread       = false;
+    m_bQuit         = false;
+}
+
+//-----------------------------------------------------------------------------
+// Name : AcquireBuffer ()
+// Desc : Returns the buffer into which the next frame should be drawn,
+//        waiting for the present thread to release one if necessary.
+// Note : Calling again before Submit() returns the same buffer.
+//-----------------------------------------------------------------------------
+ULONG * CPresentQueue::AcquireBuffer( )
+{
+    // Nothing to hand out?
+    if ( m_nBufferCount == 0 ) return NULL;
+
+    // Wait for the oldest buffer to be presented (if required)
+    if ( !m_bAcquired && m_bThread )
+    {
+#ifdef _WIN32
+        ::WaitForSingleObject( m_hFree, INFINITE );
+#else
+        while ( sem_wait( &m_hFree ) != 0 );
+#endif
+    } // End if wait
+
+    m_bAcquired = true;
+    return m_pBuffers[ m_nAcquireIndex ];
+}
+
+//-----------------------------------------------------------------------------
+// Name : Submit ()
+// Desc : Hands the acquired buffer over for presentation.
+//-----------------------------------------------------------------------------
+void CPresentQueue::Submit( )
+{
+    // Nothing acquired?
+    if ( !m_bAcquired ) return;
+    m_bAcquired = false;
+
+    // Present directly if there is no present thread
+    if ( !m_bThread )
+    {
+        m_pFunction( m_pContext, m_pBuffers[ m_nAcquireIndex ], m_nWidth, m_nHeight, m_nPitch );
+        m_nPresentCount++;
+        return;
+
+    } // End if synchronous
+
+    // Buffers are presented in the order they are handed out
+    m_nAcquireIndex = (m_nAcquireIndex + 1) % m_nBufferCount;
+
+    // Wake the present thread
+#ifdef _WIN32
+    ::ReleaseSemaphore( m_hReady, 1, NULL );
+#else
+    sem_post( &m_hReady );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Name : Flush ()
+// Desc : Waits until every submitted frame has been presented.
+//-----------------------------------------------------------------------------
+void CPresentQueue::Flush( )
+{
+    ULONG i, Count;
+
+    if ( !m_bThread ) return;
+
+    // Claim every buffer not held by the renderer, then hand them back
+    Count = m_nBufferCount - (m_bAcquired ? 1 : 0);
+    for ( i = 0; i < Count; i++ )
+    {
+#ifdef _WIN32
+        ::WaitForSingleObject( m_hFree, INFINITE );
+#else
+        while ( sem_wait( &m_hFree ) != 0 );
+#endif
+    } // Next Buffer
+
+#ifdef _WIN32
+    ::ReleaseSemaphore( m_hFree, Count, NULL );
+#else
+    for ( i = 0; i < Count; i++ ) sem_post( &m_hFree );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Name : PresentProc () (Private)
+// Desc : Present thread main loop, presents each frame as it is submitted.
+//-----------------------------------------------------------------------------
+void CPresentQueue::PresentProc( )
+{
+    for ( ; ; )
+    {
+        // Wait for a frame (or a quit request)
+#ifdef _WIN32
+        ::WaitForSingleObject( m_hReady, INFINITE );
+#else
+        while ( sem_wait( &m_hReady ) != 0 );
+#endif
+        if ( m_bQuit ) break;
+
+        // Present it, and return the buffer to the ring
+        m_pFunction( m_pContext, m_pBuffers[ m_nPresentIndex ], m_nWidth, m_nHeight, m_nPitch );
+        m_nPresentIndex = (m_nPresentIndex + 1) % m_nBufferCount;
+        m_nPresentCount++;
+
+#ifdef _WIN32
+        ::ReleaseSemaphore( m_hFree, 1, NULL );
+#else
+        sem_post( &m_hFree );
+#endif
+
+    } // Until quit
+}
+
+//-----------------------------------------------------------------------------
+// Name : StaticPresentProc () (Static Callback)
+// Desc : Thread entry point, routes through to the owning queue object.
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+unsigned __stdcall CPresentQueue::StaticPresentProc( void * pParam )
+{
+    ((CPresentQueue*)pParam)->PresentProc();
+    return 0;
+}
+#else
+void * CPresentQueue::StaticPresentProc( void * pParam )
+{
+    ((CPresentQueue*)pParam)->PresentProc();
+    return NULL;
+}
+#endif
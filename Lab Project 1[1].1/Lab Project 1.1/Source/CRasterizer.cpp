@@ -0,0 +1,1148 @@
+//-----------------------------------------------------------------------------
+// File: CRasterizer.cpp
+//
+// Desc: Tile based software rasterizer. Screen space primitives are binned
+//       into fixed size tiles, and each tile is then rasterized into the
+//       in-memory color and depth buffers independently of the others so
+//       that the work may be spread over a pool of worker threads.
+//       Textured triangles are filled by span kernels which process 4 (SSE2)
+//       or 8 (AVX2) horizontally adjacent pixels at once.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CRasterizer Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CRasterizer.h"
+#include "../Includes/CCpuInfo.h"
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+// Module Local Functions
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : LerpColor () (Module Local)
+// Desc : Blends two XRGB colors, 'Weight' (0 - 255) being the amount of 'b'.
+//        The two pairs of alternate channels are each blended in one multiply.
+//-----------------------------------------------------------------------------
+static inline ULONG LerpColor( ULONG a, ULONG b, ULONG Weight )
+{
+    ULONG rb = ((((a & 0x00FF00FF) * (256 - Weight)) + ((b & 0x00FF00FF) * Weight)) >> 8) & 0x00FF00FF;
+    ULONG ga = ((((a >> 8) & 0x00FF00FF) * (256 - Weight)) + (((b >> 8) & 0x00FF00FF) * Weight)) & 0xFF00FF00;
+    return rb | ga;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SampleTexture () (Module Local)
+// Desc : Samples the texture at the texel space coordinates specified, using
+//        either nearest or bilinear filtering (texel centres lie at +0.5).
+//-----------------------------------------------------------------------------
+static inline ULONG SampleTexture( const CTexture * pTexture, float u, float v, bool bBilinear )
+{
+    float fu, fv;
+    long  iu, iv;
+    ULONG wu, wv, Top, Bottom;
+
+    // Nearest texel
+    if ( !bBilinear ) return pTexture->GetTexel( (ULONG)(long)floorf( u ), (ULONG)(long)floorf( v ) );
+
+    // Find the top left texel of the 2x2 footprint, and the blend weights
+    u -= 0.5f; fu = floorf( u ); iu = (long)fu; wu = (ULONG)((u - fu) * 256.0f);
+    v -= 0.5f; fv = floorf( v ); iv = (long)fv; wv = (ULONG)((v - fv) * 256.0f);
+
+    Top    = LerpColor( pTexture->GetTexel( iu, iv ),     pTexture->GetTexel( iu + 1, iv ),     wu );
+    Bottom = LerpColor( pTexture->GetTexel( iu, iv + 1 ), pTexture->GetTexel( iu + 1, iv + 1 ), wu );
+    return LerpColor( Top, Bottom, wv );
+}
+
+//-----------------------------------------------------------------------------
+// Name : FloorSSE2 () (Module Local)
+// Desc : Rounds towards negative infinity (SSE4.1 has an instruction for this).
+//-----------------------------------------------------------------------------
+static inline __m128 FloorSSE2( __m128 x )
+{
+    __m128 f = _mm_cvtepi32_ps( _mm_cvttps_epi32( x ) );
+    return _mm_sub_ps( f, _mm_and_ps( _mm_cmpgt_ps( f, x ), _mm_set1_ps( 1.0f ) ) );
+}
+
+//-----------------------------------------------------------------------------
+// Name : TexelOffsetSSE2 () (Module Local)
+// Desc : SSE2 version of CTexture::GetTexelOffset, for wrapped coordinates.
+//-----------------------------------------------------------------------------
+static inline __m128i TexelOffsetSSE2( __m128i iu, __m128i iv, __m128i WidthShift )
+{
+    __m128i Three = _mm_set1_epi32( 3 ), Tile = _mm_set1_epi32( ~3 );
+    __m128i Row   = _mm_or_si128( _mm_sll_epi32( _mm_and_si128( iv, Tile ), WidthShift ), _mm_slli_epi32( _mm_and_si128( iv, Three ), 2 ) );
+    __m128i Col   = _mm_or_si128( _mm_slli_epi32( _mm_and_si128( iu, Tile ), 2 ), _mm_and_si128( iu, Three ) );
+    return _mm_or_si128( Row, Col );
+}
+
+//-----------------------------------------------------------------------------
+// Name : GatherSSE2 () (Module Local)
+// Desc : Fetches four texels (SSE2 has no gather instruction).
+//-----------------------------------------------------------------------------
+static inline __m128i GatherSSE2( const UINT * pTexels, __m128i Offset )
+{
+    UINT Index[4];
+    _mm_storeu_si128( (__m128i*)Index, Offset );
+    return _mm_setr_epi32( pTexels[ Index[0] ], pTexels[ Index[1] ], pTexels[ Index[2] ], pTexels[ Index[3] ] );
+}
+
+//-----------------------------------------------------------------------------
+// Name : LerpColorSSE2 () (Module Local)
+// Desc : SSE2 version of LerpColor, using 16 bit multiplies.
+//-----------------------------------------------------------------------------
+static inline __m128i LerpColorSSE2( __m128i a, __m128i b, __m128i Weight )
+{
+    __m128i Mask = _mm_set1_epi32( 0x00FF00FF );
+    __m128i wb   = _mm_or_si128( Weight, _mm_slli_epi32( Weight, 16 ) );
+    __m128i wa   = _mm_sub_epi16( _mm_set1_epi16( 256 ), wb );
+    __m128i rb   = _mm_add_epi16( _mm_mullo_epi16( _mm_and_si128( a, Mask ), wa ), _mm_mullo_epi16( _mm_and_si128( b, Mask ), wb ) );
+    __m128i ga   = _mm_add_epi16( _mm_mullo_epi16( _mm_srli_epi16( a, 8 ), wa ), _mm_mullo_epi16( _mm_srli_epi16( b, 8 ), wb ) );
+    return _mm_or_si128( _mm_srli_epi16( rb, 8 ), _mm_andnot_si128( Mask, ga ) );
+}
+
+#ifdef SIMD_AVX_SUPPORTED
+//-----------------------------------------------------------------------------
+// Name : TexelOffsetAVX2 () (Module Local)
+// Desc : AVX2 version of CTexture::GetTexelOffset, for wrapped coordinates.
+//-----------------------------------------------------------------------------
+SIMD_TARGET_AVX2 static inline __m256i TexelOffsetAVX2( __m256i iu, __m256i iv, __m128i WidthShift )
+{
+    __m256i Three = _mm256_set1_epi32( 3 ), Tile = _mm256_set1_epi32( ~3 );
+    __m256i Row   = _mm256_or_si256( _mm256_sll_epi32( _mm256_and_si256( iv, Tile ), WidthShift ), _mm256_slli_epi32( _mm256_and_si256( iv, Three ), 2 ) );
+    __m256i Col   = _mm256_or_si256( _mm256_slli_epi32( _mm256_and_si256( iu, Tile ), 2 ), _mm256_and_si256( iu, Three ) );
+    return _mm256_or_si256( Row, Col );
+}
+
+//-----------------------------------------------------------------------------
+// Name : LerpColorAVX2 () (Module Local)
+// Desc : AVX2 version of LerpColor, using 16 bit multiplies.
+//-----------------------------------------------------------------------------
+SIMD_TARGET_AVX2 static inline __m256i LerpColorAVX2( __m256i a, __m256i b, __m256i Weight )
+{
+    __m256i Mask = _mm256_set1_epi32( 0x00FF00FF );
+    __m256i wb   = _mm256_or_si256( Weight, _mm256_slli_epi32( Weight, 16 ) );
+    __m256i wa   = _mm256_sub_epi16( _mm256_set1_epi16( 256 ), wb );
+    __m256i rb   = _mm256_add_epi16( _mm256_mullo_epi16( _mm256_and_si256( a, Mask ), wa ), _mm256_mullo_epi16( _mm256_and_si256( b, Mask ), wb ) );
+    __m256i ga   = _mm256_add_epi16( _mm256_mullo_epi16( _mm256_srli_epi16( a, 8 ), wa ), _mm256_mullo_epi16( _mm256_srli_epi16( b, 8 ), wb ) );
+    return _mm256_or_si256( _mm256_srli_epi16( rb, 8 ), _mm256_andnot_si256( Mask, ga ) );
+}
+#endif // SIMD_AVX_SUPPORTED
+
+//-----------------------------------------------------------------------------
+// Name : CRasterizer () (Constructor)
+// Desc : CRasterizer Class Constructor
+//-----------------------------------------------------------------------------
+CRasterizer::CRasterizer()
+{
+	// Reset / Clear all required values
+    m_nWidth        = 0;
+    m_nHeight       = 0;
+    m_nPitch        = 0;
+    m_pColorBuffer  = NULL;
+    m_pOwnColorBuffer = NULL;
+    m_pDepthBuffer  = NULL;
+    m_nTilesX       = 0;
+    m_nTilesY       = 0;
+    m_nQueueCount   = 1;
+    m_pTileBins     = NULL;
+    m_pPrimitives   = NULL;
+    m_ClearColor    = 0;
+    m_ClearDepth    = 1.0f;
+    m_bClearPending = false;
+    m_pThreadPool   = NULL;
+
+    // Select the fastest span kernel available
+    SetSpanPath( SPAN_AUTO );
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CRasterizer () (Destructor)
+// Desc : CRasterizer Class Destructor
+//-----------------------------------------------------------------------------
+CRasterizer::~CRasterizer()
+{
+    // Release our buffers
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Releases the frame buffers and tile bins.
+//-----------------------------------------------------------------------------
+void CRasterizer::Release( )
+{
+    // Release buffers
+    if ( m_pOwnColorBuffer ) _mm_free( m_pOwnColorBuffer );
+    if ( m_pDepthBuffer ) _mm_free( m_pDepthBuffer );
+    if ( m_pTileBins    ) delete []m_pTileBins;
+    if ( m_pPrimitives  ) delete []m_pPrimitives;
+
+    // Clear variables
+    m_pColorBuffer  = NULL;
+    m_pOwnColorBuffer = NULL;
+    m_pDepthBuffer  = NULL;
+    m_pTileBins     = NULL;
+    m_pPrimitives   = NULL;
+    m_nWidth        = 0;
+    m_nHeight       = 0;
+    m_nPitch        = 0;
+    m_nTilesX       = 0;
+    m_nTilesY       = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetSpanPath ()
+// Desc : Selects the textured span kernel. Returns false (and leaves the path
+//        unaltered) if the processor does not support the requested path.
+//-----------------------------------------------------------------------------
+bool CRasterizer::SetSpanPath( SPAN_PATH Path )
+{
+    // Pick the best path automatically?
+    if ( Path == SPAN_AUTO )
+    {
+        if      ( CCpuInfo::HasAVX2() ) Path = SPAN_AVX2;
+        else if ( CCpuInfo::HasSSE2() ) Path = SPAN_SSE2;
+        else                            Path = SPAN_SCALAR;
+
+    } // End if automatic
+
+    // Validate
+#ifndef SIMD_AVX_SUPPORTED
+    if ( Path == SPAN_AVX2 ) return false;
+#endif
+    if ( Path == SPAN_AVX2 && !CCpuInfo::HasAVX2() ) return false;
+    if ( Path == SPAN_SSE2 && !CCpuInfo::HasSSE2() ) return false;
+
+    // Store
+    m_SpanPath = Path;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetQueueCount ()
+// Desc : Sets the number of primitive queues, typically one per thread that
+//        will be submitting primitives. Anything already queued is discarded.
+//-----------------------------------------------------------------------------
+bool CRasterizer::SetQueueCount( ULONG Count )
+{
+    // Validate
+    if ( Count == 0 ) return false;
+    if ( Count == m_nQueueCount ) return true;
+
+    // Store, and rebuild the bins if the buffers already exist
+    m_nQueueCount = Count;
+    if ( m_pColorBuffer && !AllocateBins() ) { Release(); return false; }
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : AllocateBins () (Private)
+// Desc : (Re)allocates the primitive lists and tile bins for each queue.
+//-----------------------------------------------------------------------------
+bool CRasterizer::AllocateBins( )
+{
+    // Release the old bins
+    if ( m_pTileBins   ) delete []m_pTileBins;
+    if ( m_pPrimitives ) delete []m_pPrimitives;
+
+    // Allocate one primitive list per queue, and one bin per queue per tile
+    m_pPrimitives = new VectorPrimitive[ m_nQueueCount ];
+    m_pTileBins   = new VectorULONG[ m_nQueueCount * m_nTilesX * m_nTilesY ];
+    return ( m_pPrimitives && m_pTileBins );
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetBufferSize ()
+// Desc : (Re)allocates the color / depth buffers and the tile bins.
+// Note : Rows are padded to a multiple of 8 pixels, and the buffers are 32
+//        byte aligned, so that the span kernels only ever touch whole aligned
+//        groups of pixels which never straddle two tiles.
+//-----------------------------------------------------------------------------
+bool CRasterizer::SetBufferSize( ULONG Width, ULONG Height )
+{
+    ULONG Pitch = (Width + 7) & ~7;
+
+    // Nothing to do if the size is unchanged
+    if ( Width == m_nWidth && Height == m_nHeight && m_pColorBuffer ) return true;
+
+    // Release old buffers
+    Release();
+
+    // A zero sized buffer is valid (i.e. minimized window), we just draw nothing
+    if ( Width == 0 || Height == 0 ) return true;
+
+    // Allocate the new buffers
+    m_pOwnColorBuffer = (ULONG*)_mm_malloc( Pitch * Height * sizeof(ULONG), 32 );
+    m_pColorBuffer = m_pOwnColorBuffer;
+    m_pDepthBuffer = (float*)_mm_malloc( Pitch * Height * sizeof(float), 32 );
+    if ( !m_pColorBuffer || !m_pDepthBuffer ) { Release(); return false; }
+
+    // Allocate tile bins
+    m_nTilesX   = (Width  + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    m_nTilesY   = (Height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    if ( !AllocateBins() ) { Release(); return false; }
+
+    // Store the new size
+    m_nWidth  = Width;
+    m_nHeight = Height;
+    m_nPitch  = Pitch;
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetColorBuffer ()
+// Desc : Redirects rendering into an external color buffer, such as one of
+//        a ring of buffers being presented on another thread. Passing NULL
+//        restores the rasterizer's own buffer.
+// Note : The buffer must match the current size and pitch, and be 32 byte
+//        aligned. Only change buffers between EndFrame() and BeginFrame().
+//-----------------------------------------------------------------------------
+void CRasterizer::SetColorBuffer( ULONG * pBuffer )
+{
+    // Nothing to redirect without buffers of our own
+    if ( !m_pOwnColorBuffer ) return;
+
+    m_pColorBuffer = (pBuffer) ? pBuffer : m_pOwnColorBuffer;
+}
+
+//-----------------------------------------------------------------------------
+// Name : BeginFrame ()
+// Desc : Starts a new frame. The clear itself is deferred until each tile is
+//        rasterized so that the buffers are only touched once per frame.
+//-----------------------------------------------------------------------------
+void CRasterizer::BeginFrame( ULONG ClearColor, float ClearDepth )
+{
+    // Store clear values
+    m_ClearColor = ClearColor;
+    m_ClearDepth = ClearDepth;
+    m_bClearPending = true;
+
+    // Nothing allocated (i.e. zero sized buffers) ?
+    if ( !m_pPrimitives ) return;
+
+    // Discard anything left from a previous frame
+    for ( ULONG i = 0; i < m_nQueueCount; i++ ) m_pPrimitives[i].clear();
+    for ( ULONG i = 0; i < m_nQueueCount * m_nTilesX * m_nTilesY; i++ ) m_pTileBins[i].clear();
+}
+
+//-----------------------------------------------------------------------------
+// Name : DrawTriangle ()
+// Desc : Sets up a flat colored screen space triangle and adds it to the tile
+//        bins. Either winding order is accepted.
+//-----------------------------------------------------------------------------
+void CRasterizer::DrawTriangle( const RASTERVERTEX & v0, const RASTERVERTEX & v1, const RASTERVERTEX & v2, ULONG Color, ULONG Queue )
+{
+    const RASTERVERTEX * pVertex[3] = { &v0, &v1, &v2 };
+    Primitive   Prim;
+    float       fX[3], fY[3];
+
+    // Nothing to do without a buffer
+    if ( !m_pColorBuffer || !m_pPrimitives || Queue >= m_nQueueCount ) return;
+
+    // Build the edge functions and depth plane
+    Prim.Type  = PRIMITIVE_TRIANGLE;
+    Prim.Color = Color;
+    if ( !SetupTriangle( Prim, pVertex, fX, fY ) ) return;
+
+    // Queue it up
+    m_pPrimitives[ Queue ].push_back( Prim );
+    BinPrimitive( Queue, m_pPrimitives[ Queue ].size() - 1 );
+}
+
+//-----------------------------------------------------------------------------
+// Name : DrawTexturedTriangle ()
+// Desc : Sets up a perspective correct textured triangle and adds it to the
+//        tile bins. Either winding order is accepted.
+// Note : The texture must remain valid until EndFrame() has been called.
+//-----------------------------------------------------------------------------
+void CRasterizer::DrawTexturedTriangle( const RASTERVERTEX & v0, const RASTERVERTEX & v1, const RASTERVERTEX & v2,
+                                        const CTexture * pTexture, ULONG Flags, ULONG Queue )
+{
+    const RASTERVERTEX * pVertex[3] = { &v0, &v1, &v2 };
+    Primitive   Prim;
+    float       fX[3], fY[3], Value[3];
+    ULONG       i;
+
+    // Nothing to do without a buffer or texture
+    if ( !m_pColorBuffer || !m_pPrimitives || Queue >= m_nQueueCount || !pTexture || !pTexture->GetTexels() ) return;
+
+    // Build the edge functions and depth plane
+    Prim.Type     = PRIMITIVE_TEXTURED;
+    Prim.Color    = 0;
+    Prim.pTexture = pTexture;
+    Prim.Flags    = Flags;
+    if ( !SetupTriangle( Prim, pVertex, fX, fY ) ) return;
+
+    // 1/w, u/w and v/w are linear in screen space, u and v are scaled to texels here
+    for ( i = 0; i < 3; i++ ) Value[i] = pVertex[i]->rhw;
+    SetupPlane( fX, fY, Value, Prim.W0, Prim.DWDX, Prim.DWDY );
+    for ( i = 0; i < 3; i++ ) Value[i] = pVertex[i]->u * pTexture->GetWidth() * pVertex[i]->rhw;
+    SetupPlane( fX, fY, Value, Prim.U0, Prim.DUDX, Prim.DUDY );
+    for ( i = 0; i < 3; i++ ) Value[i] = pVertex[i]->v * pTexture->GetHeight() * pVertex[i]->rhw;
+    SetupPlane( fX, fY, Value, Prim.V0, Prim.DVDX, Prim.DVDY );
+
+    // Queue it up
+    m_pPrimitives[ Queue ].push_back( Prim );
+    BinPrimitive( Queue, m_pPrimitives[ Queue ].size() - 1 );
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetupTriangle () (Private)
+// Desc : Snaps the triangle to the sub-pixel grid, and builds its bounding
+//        box, edge functions and depth plane. Returns false if the triangle
+//        is degenerate, or lies outside of the buffer.
+// Note : The vertex pointers are reordered (if required) to a consistent
+//        winding, and the snapped positions are returned for any further
+//        plane equations the caller needs.
+//-----------------------------------------------------------------------------
+bool CRasterizer::SetupTriangle( Primitive & Prim, const RASTERVERTEX * pVertex[3], float fX[3], float fY[3] )
+{
+    const RASTERVERTEX * pSwap;
+    long        X[3], Y[3], Temp;
+    __int64     Area;
+    float       Value[3];
+    ULONG       i, j;
+
+    // Reject anything outside of the representable range
+    for ( i = 0; i < 3; i++ )
+    {
+        if ( fabsf( pVertex[i]->x ) > RASTER_MAX_COORD ) return false;
+        if ( fabsf( pVertex[i]->y ) > RASTER_MAX_COORD ) return false;
+
+    } // Next Vertex
+
+    // Snap to 28.4 fixed point
+    for ( i = 0; i < 3; i++ )
+    {
+        X[i] = (long)floorf( pVertex[i]->x * RASTER_SUBPIXEL + 0.5f );
+        Y[i] = (long)floorf( pVertex[i]->y * RASTER_SUBPIXEL + 0.5f );
+
+    } // Next Vertex
+
+    // Calculate twice the signed area, discarding degenerate triangles
+    Area = (__int64)(X[1] - X[0]) * (Y[2] - Y[0]) - (__int64)(Y[1] - Y[0]) * (X[2] - X[0]);
+    if ( Area == 0 ) return false;
+
+    // Enforce a consistent winding for the edge functions
+    if ( Area < 0 )
+    {
+        pSwap = pVertex[1]; pVertex[1] = pVertex[2]; pVertex[2] = pSwap;
+        Temp  = X[1]; X[1] = X[2]; X[2] = Temp;
+        Temp  = Y[1]; Y[1] = Y[2]; Y[2] = Temp;
+
+    } // End if swap
+
+    // Calculate the pixel bounding box, clipped to the buffer
+    Prim.MinX  = min( X[0], min( X[1], X[2] ) ) >> 4;
+    Prim.MinY  = min( Y[0], min( Y[1], Y[2] ) ) >> 4;
+    Prim.MaxX  = max( X[0], max( X[1], X[2] ) ) >> 4;
+    Prim.MaxY  = max( Y[0], max( Y[1], Y[2] ) ) >> 4;
+    if ( Prim.MinX < 0 ) Prim.MinX = 0;
+    if ( Prim.MinY < 0 ) Prim.MinY = 0;
+    if ( Prim.MaxX > (long)m_nWidth  - 1 ) Prim.MaxX = (long)m_nWidth  - 1;
+    if ( Prim.MaxY > (long)m_nHeight - 1 ) Prim.MaxY = (long)m_nHeight - 1;
+    if ( Prim.MinX > Prim.MaxX || Prim.MinY > Prim.MaxY ) return false;
+
+    // Build the edge functions
+    for ( i = 0; i < 3; i++ )
+    {
+        j = (i + 1) % 3;
+        Prim.A[i] = Y[i] - Y[j];
+        Prim.B[i] = X[j] - X[i];
+        Prim.C[i] = -((__int64)Prim.A[i] * X[i] + (__int64)Prim.B[i] * Y[i]);
+
+        // Top-left fill convention, pixels exactly on other edges are excluded
+        if ( !(Prim.A[i] > 0 || (Prim.A[i] == 0 && Prim.B[i] > 0)) ) Prim.C[i] -= 1;
+
+    } // Next Edge
+
+    // Build the depth plane equation from the snapped positions
+    for ( i = 0; i < 3; i++ )
+    {
+        fX[i]    = X[i] / (float)RASTER_SUBPIXEL;
+        fY[i]    = Y[i] / (float)RASTER_SUBPIXEL;
+        Value[i] = pVertex[i]->z;
+
+    } // Next Vertex
+    SetupPlane( fX, fY, Value, Prim.Z0, Prim.DZDX, Prim.DZDY );
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetupPlane () (Static, Private)
+// Desc : Calculates the screen space plane equation of a value interpolated
+//        across the triangle. 'Origin' is the value at the centre of pixel
+//        ( 0, 0 ), so pixel ( x, y ) has the value Origin + DX * x + DY * y.
+//-----------------------------------------------------------------------------
+void CRasterizer::SetupPlane( const float fX[3], const float fY[3], const float Value[3],
+                              float & Origin, float & DX, float & DY )
+{
+    float Det = (fX[1] - fX[0]) * (fY[2] - fY[0]) - (fX[2] - fX[0]) * (fY[1] - fY[0]);
+
+    DX     = ((Value[1] - Value[0]) * (fY[2] - fY[0]) - (Value[2] - Value[0]) * (fY[1] - fY[0])) / Det;
+    DY     = ((fX[1] - fX[0]) * (Value[2] - Value[0]) - (fX[2] - fX[0]) * (Value[1] - Value[0])) / Det;
+    Origin = Value[0] + DX * (0.5f - fX[0]) + DY * (0.5f - fY[0]);
+}
+
+//-----------------------------------------------------------------------------
+// Name : DrawLine ()
+// Desc : Adds a single pixel wide line to the tile bins. As with GDI's
+//        LineTo, the final pixel of the line is not drawn. Lines are not
+//        depth tested.
+//-----------------------------------------------------------------------------
+void CRasterizer::DrawLine( const RASTERVERTEX & v0, const RASTERVERTEX & v1, ULONG Color, ULONG Queue )
+{
+    Primitive Prim;
+
+    // Nothing to do without a buffer
+    if ( !m_pColorBuffer || !m_pPrimitives || Queue >= m_nQueueCount ) return;
+
+    // Reject anything outside of the representable range
+    if ( fabsf( v0.x ) > RASTER_MAX_COORD || fabsf( v0.y ) > RASTER_MAX_COORD ) return;
+    if ( fabsf( v1.x ) > RASTER_MAX_COORD || fabsf( v1.y ) > RASTER_MAX_COORD ) return;
+
+    // Store line details
+    Prim.Type  = PRIMITIVE_LINE;
+    Prim.Color = Color;
+    Prim.X0    = v0.x; Prim.Y0 = v0.y;
+    Prim.X1    = v1.x; Prim.Y1 = v1.y;
+
+    // Calculate the pixel bounding box, clipped to the buffer
+    Prim.MinX  = (long)floorf( min( v0.x, v1.x ) );
+    Prim.MinY  = (long)floorf( min( v0.y, v1.y ) );
+    Prim.MaxX  = (long)floorf( max( v0.x, v1.x ) );
+    Prim.MaxY  = (long)floorf( max( v0.y, v1.y ) );
+    if ( Prim.MinX < 0 ) Prim.MinX = 0;
+    if ( Prim.MinY < 0 ) Prim.MinY = 0;
+    if ( Prim.MaxX > (long)m_nWidth  - 1 ) Prim.MaxX = (long)m_nWidth  - 1;
+    if ( Prim.MaxY > (long)m_nHeight - 1 ) Prim.MaxY = (long)m_nHeight - 1;
+    if ( Prim.MinX > Prim.MaxX || Prim.MinY > Prim.MaxY ) return;
+
+    // Queue it up
+    m_pPrimitives[ Queue ].push_back( Prim );
+    BinPrimitive( Queue, m_pPrimitives[ Queue ].size() - 1 );
+}
+
+//-----------------------------------------------------------------------------
+// Name : BinPrimitive () (Private)
+// Desc : Adds the primitive to the queue's bin of every tile that it may
+//        touch.
+//-----------------------------------------------------------------------------
+void CRasterizer::BinPrimitive( ULONG Queue, ULONG PrimitiveIndex )
+{
+    const Primitive & Prim = m_pPrimitives[ Queue ][ PrimitiveIndex ];
+    VectorULONG     * pBins = m_pTileBins + Queue * m_nTilesX * m_nTilesY;
+    long  TileX0, TileY0, TileX1, TileY1, tx, ty, X0, Y0, X1, Y1, i;
+    bool  bTestEdges;
+
+    // Calculate the range of tiles covered by the bounding box
+    TileX0 = Prim.MinX / RASTER_TILE_SIZE;
+    TileY0 = Prim.MinY / RASTER_TILE_SIZE;
+    TileX1 = Prim.MaxX / RASTER_TILE_SIZE;
+    TileY1 = Prim.MaxY / RASTER_TILE_SIZE;
+
+    // Only bother testing tiles against the edges of larger triangles
+    bTestEdges = (Prim.Type != PRIMITIVE_LINE) && (TileX0 != TileX1 || TileY0 != TileY1);
+
+    for ( ty = TileY0; ty <= TileY1; ty++ )
+    {
+        for ( tx = TileX0; tx <= TileX1; tx++ )
+        {
+            if ( bTestEdges )
+            {
+                // Calculate the region of the tile overlapped by the bounding box
+                X0 = max( Prim.MinX, tx * (long)RASTER_TILE_SIZE );
+                Y0 = max( Prim.MinY, ty * (long)RASTER_TILE_SIZE );
+                X1 = min( Prim.MaxX, (tx + 1) * (long)RASTER_TILE_SIZE - 1 );
+                Y1 = min( Prim.MaxY, (ty + 1) * (long)RASTER_TILE_SIZE - 1 );
+
+                // Test the most inside corner against each edge
+                for ( i = 0; i < 3; i++ )
+                {
+                    __int64 PX = (__int64)((Prim.A[i] > 0) ? X1 : X0) * RASTER_SUBPIXEL + RASTER_SUBPIXEL / 2;
+                    __int64 PY = (__int64)((Prim.B[i] > 0) ? Y1 : Y0) * RASTER_SUBPIXEL + RASTER_SUBPIXEL / 2;
+                    if ( Prim.A[i] * PX + Prim.B[i] * PY + Prim.C[i] < 0 ) break;
+
+                } // Next Edge
+
+                // Tile is entirely outside one of the edges?
+                if ( i < 3 ) continue;
+
+            } // End if test edges
+
+            // Add to the bin
+            pBins[ ty * m_nTilesX + tx ].push_back( PrimitiveIndex );
+
+        } // Next Tile Column
+
+    } // Next Tile Row
+}
+
+//-----------------------------------------------------------------------------
+// Name : Flush ()
+// Desc : Rasterizes every primitive queued so far (in parallel where a thread
+//        pool is available) and empties the bins. The buffers may then be
+//        read, for instance to build an occlusion buffer, before the rest of
+//        the frame is drawn.
+// Note : Tiles are only cleared by the first flush following BeginFrame().
+//-----------------------------------------------------------------------------
+void CRasterizer::Flush( )
+{
+    ULONG TileCount = m_nTilesX * m_nTilesY, i;
+
+    // Nothing allocated (i.e. zero sized buffers) ?
+    if ( !m_pPrimitives ) return;
+
+    // Nothing to clear or draw?
+    for ( i = 0; i < m_nQueueCount && m_pPrimitives[i].empty(); i++ );
+    if ( !m_bClearPending && i == m_nQueueCount ) return;
+
+    // Rasterize all tiles
+    if ( m_pThreadPool )
+        m_pThreadPool->Execute( TileJob, this, TileCount );
+    else
+        for ( i = 0; i < TileCount; i++ ) RasterizeTile( i );
+
+    // Release the primitives (bins keep their capacity)
+    m_bClearPending = false;
+    for ( i = 0; i < m_nQueueCount; i++ ) m_pPrimitives[i].clear();
+    for ( i = 0; i < m_nQueueCount * TileCount; i++ ) m_pTileBins[i].clear();
+}
+
+//-----------------------------------------------------------------------------
+// Name : EndFrame ()
+// Desc : Rasterizes any remaining primitives, writing the final image into
+//        the color buffer.
+//-----------------------------------------------------------------------------
+void CRasterizer::EndFrame( )
+{
+    Flush();
+}
+
+//-----------------------------------------------------------------------------
+// Name : TileJob () (Static, Private)
+// Desc : Thread pool job callback, rasterizes a single tile.
+//-----------------------------------------------------------------------------
+void CRasterizer::TileJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex )
+{
+    ((CRasterizer*)pContext)->RasterizeTile( JobIndex );
+}
+
+//-----------------------------------------------------------------------------
+// Name : RasterizeTile () (Private)
+// Desc : Clears the tile (if required) and then rasterizes each primitive
+//        binned to it, one queue after another.
+// Note : Only ever touches pixels within the tile, so tiles may be processed
+//        concurrently without any locking.
+//-----------------------------------------------------------------------------
+void CRasterizer::RasterizeTile( ULONG TileIndex )
+{
+    long  TileX0, TileY0, TileX1, TileY1, X0, Y0, X1, Y1, x, y;
+    ULONG i, q;
+
+    // Calculate the tile's pixel rectangle (inclusive)
+    TileX0 = (TileIndex % m_nTilesX) * RASTER_TILE_SIZE;
+    TileY0 = (TileIndex / m_nTilesX) * RASTER_TILE_SIZE;
+    TileX1 = min( TileX0 + (long)RASTER_TILE_SIZE, (long)m_nWidth  ) - 1;
+    TileY1 = min( TileY0 + (long)RASTER_TILE_SIZE, (long)m_nHeight ) - 1;
+
+    // Clear the tile (first flush of the frame only)
+    for ( y = TileY0; m_bClearPending && y <= TileY1; y++ )
+    {
+        ULONG * pColor = m_pColorBuffer + y * m_nPitch;
+        float * pDepth = m_pDepthBuffer + y * m_nPitch;
+        for ( x = TileX0; x <= TileX1; x++ ) { pColor[x] = m_ClearColor; pDepth[x] = m_ClearDepth; }
+
+    } // Next Row
+
+    // Rasterize each queue's primitives, in submission order
+    for ( q = 0; q < m_nQueueCount; q++ )
+    {
+        const VectorPrimitive & Primitives = m_pPrimitives[ q ];
+        const VectorULONG     & Bin        = m_pTileBins[ q * m_nTilesX * m_nTilesY + TileIndex ];
+
+        for ( i = 0; i < Bin.size(); i++ )
+        {
+            const Primitive & Prim = Primitives[ Bin[i] ];
+
+            // Clip the bounding box to the tile
+            X0 = max( Prim.MinX, TileX0 ); Y0 = max( Prim.MinY, TileY0 );
+            X1 = min( Prim.MaxX, TileX1 ); Y1 = min( Prim.MaxY, TileY1 );
+            if ( X0 > X1 || Y0 > Y1 ) continue;
+
+            switch ( Prim.Type )
+            {
+                case PRIMITIVE_TRIANGLE:
+                    RasterTriangle( Prim, X0, Y0, X1, Y1 );
+                    break;
+
+                case PRIMITIVE_TEXTURED:
+                    // Hand off to the selected span kernel
+                    switch ( m_SpanPath )
+                    {
+    #ifdef SIMD_AVX_SUPPORTED
+                        case SPAN_AVX2: RasterTexturedAVX2( Prim, X0, Y0, X1, Y1 ); break;
+    #endif
+                        case SPAN_SSE2: RasterTexturedSSE2( Prim, X0, Y0, X1, Y1 ); break;
+                        default:        RasterTexturedScalar( Prim, X0, Y0, X1, Y1 ); break;
+
+                    } // End Switch
+                    break;
+
+                default:
+                    RasterLine( Prim, X0, Y0, X1, Y1 );
+                    break;
+
+            } // End Switch
+
+        } // Next Primitive
+
+    } // Next Queue
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetupEdges () (Static, Private)
+// Desc : Calculates the edge function values at the centre of pixel
+//        ( X0, Y0 ) and their per pixel steps, for use within the specified
+//        pixel rectangle. Returns false if the rectangle is entirely outside
+//        of the triangle.
+//-----------------------------------------------------------------------------
+bool CRasterizer::SetupEdges( const Primitive & Prim, long X0, long Y0, long X1, long Y1,
+                              long E[3], long StepX[3], long StepY[3] )
+{
+    __int64 SX, SY, Corner, DX, DY, EMin, EMax;
+    long    i;
+
+    // Sample position of the first pixel centre
+    SX = (__int64)X0 * RASTER_SUBPIXEL + RASTER_SUBPIXEL / 2;
+    SY = (__int64)Y0 * RASTER_SUBPIXEL + RASTER_SUBPIXEL / 2;
+
+    // Classify each edge against the rectangle. Edges that pass for every pixel
+    // are dropped, which also keeps the remaining values within 32 bits.
+    for ( i = 0; i < 3; i++ )
+    {
+        Corner = Prim.A[i] * SX + Prim.B[i] * SY + Prim.C[i];
+        DX     = (__int64)Prim.A[i] * (X1 - X0) * RASTER_SUBPIXEL;
+        DY     = (__int64)Prim.B[i] * (Y1 - Y0) * RASTER_SUBPIXEL;
+        EMin   = Corner + min( DX, (__int64)0 ) + min( DY, (__int64)0 );
+        EMax   = Corner + max( DX, (__int64)0 ) + max( DY, (__int64)0 );
+
+        // Entirely outside this edge?
+        if ( EMax < 0 ) return false;
+
+        if ( EMin >= 0 )
+        {
+            // Entirely inside this edge
+            E[i] = 0; StepX[i] = 0; StepY[i] = 0;
+        }
+        else
+        {
+            E[i]     = (long)Corner;
+            StepX[i] = Prim.A[i] * (long)RASTER_SUBPIXEL;
+            StepY[i] = Prim.B[i] * (long)RASTER_SUBPIXEL;
+
+        } // End if partially covered
+
+    } // Next Edge
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : RasterTriangle () (Private)
+// Desc : Rasterizes the triangle within the specified pixel rectangle using
+//        incremental edge functions, with a less-than depth test.
+//-----------------------------------------------------------------------------
+void CRasterizer::RasterTriangle( const Primitive & Prim, long X0, long Y0, long X1, long Y1 )
+{
+    long    E[3], StepX[3], StepY[3], e0, e1, e2, x, y;
+    float   zRow, z;
+
+    // Calculate the edge functions at the first pixel
+    if ( !SetupEdges( Prim, X0, Y0, X1, Y1, E, StepX, StepY ) ) return;
+
+    // Starting depth value
+    zRow = Prim.Z0 + Prim.DZDX * X0 + Prim.DZDY * Y0;
+
+    // Walk the rectangle
+    for ( y = Y0; y <= Y1; y++ )
+    {
+        ULONG * pColor = m_pColorBuffer + y * m_nPitch;
+        float * pDepth = m_pDepthBuffer + y * m_nPitch;
+
+        e0 = E[0]; e1 = E[1]; e2 = E[2]; z = zRow;
+        for ( x = X0; x <= X1; x++ )
+        {
+            // Inside all three edges, and passes the depth test?
+            if ( (e0 | e1 | e2) >= 0 && z < pDepth[x] )
+            {
+                pDepth[x] = z;
+                pColor[x] = Prim.Color;
+
+            } // End if visible
+
+            e0 += StepX[0]; e1 += StepX[1]; e2 += StepX[2];
+            z  += Prim.DZDX;
+
+        } // Next Pixel
+
+        E[0] += StepY[0]; E[1] += StepY[1]; E[2] += StepY[2];
+        zRow += Prim.DZDY;
+
+    } // Next Row
+}
+
+//-----------------------------------------------------------------------------
+// Name : RasterLine () (Private)
+// Desc : Rasterizes the portion of a line within the pixel rectangle. Each
+//        pixel is derived from its position on the major axis alone, so the
+//        same line split over several tiles is drawn without gaps or overlap.
+//-----------------------------------------------------------------------------
+void CRasterizer::RasterLine( const Primitive & Prim, long X0, long Y0, long X1, long Y1 )
+{
+    float DX = Prim.X1 - Prim.X0, DY = Prim.Y1 - Prim.Y0, Slope;
+    long  Start, End, Low, High, i, Minor;
+
+    if ( fabsf( DX ) >= fabsf( DY ) )
+    {
+        // X major, calculate the pixel column range (excluding the last pixel)
+        Start = (long)floorf( Prim.X0 );
+        End   = (long)floorf( Prim.X1 );
+        if ( Start == End ) return;
+        if ( Start < End ) { Low = Start; High = End - 1; } else { Low = End + 1; High = Start; }
+
+        // Clip to the rectangle
+        if ( Low  < X0 ) Low  = X0;
+        if ( High > X1 ) High = X1;
+
+        Slope = DY / DX;
+        for ( i = Low; i <= High; i++ )
+        {
+            Minor = (long)floorf( Prim.Y0 + ((i + 0.5f) - Prim.X0) * Slope );
+            if ( Minor >= Y0 && Minor <= Y1 ) m_pColorBuffer[ Minor * m_nPitch + i ] = Prim.Color;
+
+        } // Next Pixel
+    }
+    else
+    {
+        // Y major, calculate the pixel row range (excluding the last pixel)
+        Start = (long)floorf( Prim.Y0 );
+        End   = (long)floorf( Prim.Y1 );
+        if ( Start == End ) return;
+        if ( Start < End ) { Low = Start; High = End - 1; } else { Low = End + 1; High = Start; }
+
+        // Clip to the rectangle
+        if ( Low  < Y0 ) Low  = Y0;
+        if ( High > Y1 ) High = Y1;
+
+        Slope = DX / DY;
+        for ( i = Low; i <= High; i++ )
+        {
+            Minor = (long)floorf( Prim.X0 + ((i + 0.5f) - Prim.Y0) * Slope );
+            if ( Minor >= X0 && Minor <= X1 ) m_pColorBuffer[ i * m_nPitch + Minor ] = Prim.Color;
+
+        } // Next Pixel
+
+    } // End if Y major
+}
+
+//-----------------------------------------------------------------------------
+// Name : RasterTexturedScalar () (Private)
+// Desc : Reference textured span kernel, one pixel at a time. 1/w, u/w and
+//        v/w are interpolated linearly, and divided through at each pixel to
+//        recover the perspective correct texture coordinates.
+//-----------------------------------------------------------------------------
+void CRasterizer::RasterTexturedScalar( const Primitive & Prim, long X0, long Y0, long X1, long Y1 )
+{
+    long    E[3], StepX[3], StepY[3], e0, e1, e2, x, y;
+    float   z, w, u, v;
+    bool    bDepthTest  = (Prim.Flags & RASTER_DEPTHTEST ) != 0;
+    bool    bDepthWrite = (Prim.Flags & RASTER_DEPTHWRITE) != 0;
+    bool    bBilinear   = (Prim.Flags & RASTER_BILINEAR  ) != 0;
+
+    // Calculate the edge functions at the first pixel
+    if ( !SetupEdges( Prim, X0, Y0, X1, Y1, E, StepX, StepY ) ) return;
+
+    // Walk the rectangle
+    for ( y = Y0; y <= Y1; y++ )
+    {
+        ULONG * pColor = m_pColorBuffer + y * m_nPitch;
+        float * pDepth = m_pDepthBuffer + y * m_nPitch;
+
+        e0 = E[0]; e1 = E[1]; e2 = E[2];
+        for ( x = X0; x <= X1; x++ )
+        {
+            // Inside all three edges?
+            if ( (e0 | e1 | e2) >= 0 )
+            {
+                z = Prim.Z0 + Prim.DZDX * x + Prim.DZDY * y;
+                if ( !bDepthTest || z < pDepth[x] )
+                {
+                    // Recover the texture coordinates
+                    w = 1.0f / (Prim.W0 + Prim.DWDX * x + Prim.DWDY * y);
+                    u = (Prim.U0 + Prim.DUDX * x + Prim.DUDY * y) * w;
+                    v = (Prim.V0 + Prim.DVDX * x + Prim.DVDY * y) * w;
+
+                    if ( bDepthWrite ) pDepth[x] = z;
+                    pColor[x] = SampleTexture( Prim.pTexture, u, v, bBilinear );
+
+                } // End if passed depth test
+
+            } // End if inside
+
+            e0 += StepX[0]; e1 += StepX[1]; e2 += StepX[2];
+
+        } // Next Pixel
+
+        E[0] += StepY[0]; E[1] += StepY[1]; E[2] += StepY[2];
+
+    } // Next Row
+}
+
+//-----------------------------------------------------------------------------
+// Name : RasterTexturedSSE2 () (Private)
+// Desc : Textured span kernel processing four pixels per iteration.
+// Note : Each row is walked in aligned groups of four pixels starting at or
+//        before X0. Pixels of the group outside of X0 - X1 are masked out,
+//        and since tiles are a multiple of 8 pixels wide (and rows padded to
+//        match) a group never reaches into a neighbouring tile.
+//-----------------------------------------------------------------------------
+void CRasterizer::RasterTexturedSSE2( const Primitive & Prim, long X0, long Y0, long X1, long Y1 )
+{
+    const UINT * pTexels = Prim.pTexture->GetTexels();
+    long    E[3], StepX[3], StepY[3], XStart, x, y, i;
+    bool    bDepthTest  = (Prim.Flags & RASTER_DEPTHTEST ) != 0;
+    bool    bDepthWrite = (Prim.Flags & RASTER_DEPTHWRITE) != 0;
+    bool    bBilinear   = (Prim.Flags & RASTER_BILINEAR  ) != 0;
+
+    __m128i Lane       = _mm_setr_epi32( 0, 1, 2, 3 );
+    __m128  LaneF      = _mm_cvtepi32_ps( Lane );
+    __m128i MinX       = _mm_set1_epi32( X0 - 1 ), MaxX = _mm_set1_epi32( X1 + 1 );
+    __m128i WrapU      = _mm_set1_epi32( Prim.pTexture->GetWidth()  - 1 );
+    __m128i WrapV      = _mm_set1_epi32( Prim.pTexture->GetHeight() - 1 );
+    __m128i WidthShift = _mm_cvtsi32_si128( Prim.pTexture->GetWidthShift() );
+    __m128i MinusOne   = _mm_set1_epi32( -1 ), OneI = _mm_set1_epi32( 1 );
+    __m128  DZDX = _mm_set1_ps( Prim.DZDX ), DWDX = _mm_set1_ps( Prim.DWDX );
+    __m128  DUDX = _mm_set1_ps( Prim.DUDX ), DVDX = _mm_set1_ps( Prim.DVDX );
+    __m128  Half = _mm_set1_ps( 0.5f ), Two = _mm_set1_ps( 2.0f ), Scale = _mm_set1_ps( 256.0f );
+    __m128i e0, e1, e2, Step0, Step1, Step2, xs, Mask, Color, iu, iv, iu1, iv1, wu, wv;
+    __m128  zRow, wRow, uRow, vRow, xf, z, rhw, w, u, v, fu, fv, Depth;
+
+    // Calculate the edge functions at the first pixel
+    if ( !SetupEdges( Prim, X0, Y0, X1, Y1, E, StepX, StepY ) ) return;
+
+    // Start each row on a 4 pixel boundary
+    XStart = X0 & ~3;
+    for ( i = 0; i < 3; i++ ) E[i] -= (X0 - XStart) * StepX[i];
+    Step0 = _mm_set1_epi32( StepX[0] * 4 );
+    Step1 = _mm_set1_epi32( StepX[1] * 4 );
+    Step2 = _mm_set1_epi32( StepX[2] * 4 );
+
+    // Walk the rectangle
+    for ( y = Y0; y <= Y1; y++ )
+    {
+        ULONG * pColor = m_pColorBuffer + y * m_nPitch;
+        float * pDepth = m_pDepthBuffer + y * m_nPitch;
+
+        // Edge values for the first group, and the attribute planes for this row
+        e0   = _mm_setr_epi32( E[0], E[0] + StepX[0], E[0] + StepX[0] * 2, E[0] + StepX[0] * 3 );
+        e1   = _mm_setr_epi32( E[1], E[1] + StepX[1], E[1] + StepX[1] * 2, E[1] + StepX[1] * 3 );
+        e2   = _mm_setr_epi32( E[2], E[2] + StepX[2], E[2] + StepX[2] * 2, E[2] + StepX[2] * 3 );
+        zRow = _mm_set1_ps( Prim.Z0 + Prim.DZDY * y );
+        wRow = _mm_set1_ps( Prim.W0 + Prim.DWDY * y );
+        uRow = _mm_set1_ps( Prim.U0 + Prim.DUDY * y );
+        vRow = _mm_set1_ps( Prim.V0 + Prim.DVDY * y );
+
+        for ( x = XStart; x <= X1; x += 4 )
+        {
+            // Coverage, inside all three edges and within X0 - X1
+            xs   = _mm_add_epi32( _mm_set1_epi32( x ), Lane );
+            Mask = _mm_cmpgt_epi32( _mm_or_si128( _mm_or_si128( e0, e1 ), e2 ), MinusOne );
+            Mask = _mm_and_si128( Mask, _mm_and_si128( _mm_cmpgt_epi32( xs, MinX ), _mm_cmplt_epi32( xs, MaxX ) ) );
+            e0   = _mm_add_epi32( e0, Step0 );
+            e1   = _mm_add_epi32( e1, Step1 );
+            e2   = _mm_add_epi32( e2, Step2 );
+            if ( !_mm_movemask_ps( _mm_castsi128_ps( Mask ) ) ) continue;
+
+            // Depth test
+            xf    = _mm_add_ps( _mm_set1_ps( (float)x ), LaneF );
+            z     = _mm_add_ps( zRow, _mm_mul_ps( xf, DZDX ) );
+            Depth = _mm_load_ps( pDepth + x );
+            if ( bDepthTest ) Mask = _mm_and_si128( Mask, _mm_castps_si128( _mm_cmplt_ps( z, Depth ) ) );
+            if ( !_mm_movemask_ps( _mm_castsi128_ps( Mask ) ) ) continue;
+
+            // Recover the texture coordinates (reciprocal refined with one Newton-Raphson step)
+            rhw = _mm_add_ps( wRow, _mm_mul_ps( xf, DWDX ) );
+            w   = _mm_rcp_ps( rhw );
+            w   = _mm_mul_ps( w, _mm_sub_ps( Two, _mm_mul_ps( rhw, w ) ) );
+            u   = _mm_mul_ps( _mm_add_ps( uRow, _mm_mul_ps( xf, DUDX ) ), w );
+            v   = _mm_mul_ps( _mm_add_ps( vRow, _mm_mul_ps( xf, DVDX ) ), w );
+
+            if ( bBilinear )
+            {
+                // Top left texel of each 2x2 footprint, and the blend weights
+                u   = _mm_sub_ps( u, Half ); fu = FloorSSE2( u );
+                v   = _mm_sub_ps( v, Half ); fv = FloorSSE2( v );
+                wu  = _mm_cvttps_epi32( _mm_mul_ps( _mm_sub_ps( u, fu ), Scale ) );
+                wv  = _mm_cvttps_epi32( _mm_mul_ps( _mm_sub_ps( v, fv ), Scale ) );
+                iu  = _mm_and_si128( _mm_cvttps_epi32( fu ), WrapU );
+                iv  = _mm_and_si128( _mm_cvttps_epi32( fv ), WrapV );
+                iu1 = _mm_and_si128( _mm_add_epi32( iu, OneI ), WrapU );
+                iv1 = _mm_and_si128( _mm_add_epi32( iv, OneI ), WrapV );
+
+                Color = LerpColorSSE2( LerpColorSSE2( GatherSSE2( pTexels, TexelOffsetSSE2( iu,  iv,  WidthShift ) ),
+                                                      GatherSSE2( pTexels, TexelOffsetSSE2( iu1, iv,  WidthShift ) ), wu ),
+                                       LerpColorSSE2( GatherSSE2( pTexels, TexelOffsetSSE2( iu,  iv1, WidthShift ) ),
+                                                      GatherSSE2( pTexels, TexelOffsetSSE2( iu1, iv1, WidthShift ) ), wu ), wv );
+            }
+            else
+            {
+                // Nearest texel
+                iu    = _mm_and_si128( _mm_cvttps_epi32( FloorSSE2( u ) ), WrapU );
+                iv    = _mm_and_si128( _mm_cvttps_epi32( FloorSSE2( v ) ), WrapV );
+                Color = GatherSSE2( pTexels, TexelOffsetSSE2( iu, iv, WidthShift ) );
+
+            } // End if nearest
+
+            // Write the covered pixels
+            if ( bDepthWrite ) _mm_store_ps( pDepth + x, _mm_or_ps( _mm_and_ps( _mm_castsi128_ps( Mask ), z ),
+                                                                    _mm_andnot_ps( _mm_castsi128_ps( Mask ), Depth ) ) );
+            _mm_store_si128( (__m128i*)(pColor + x), _mm_or_si128( _mm_and_si128( Mask, Color ),
+                                                                   _mm_andnot_si128( Mask, _mm_load_si128( (__m128i*)(pColor + x) ) ) ) );
+
+        } // Next 4 Pixels
+
+        E[0] += StepY[0]; E[1] += StepY[1]; E[2] += StepY[2];
+
+    } // Next Row
+}
+
+//-----------------------------------------------------------------------------
+// Name : RasterTexturedAVX2 () (Private)
+// Desc : Textured span kernel processing eight pixels per iteration, using
+//        the AVX2 gather instruction to fetch the texels.
+// Note : Rows are walked in aligned groups of eight pixels, as described for
+//        RasterTexturedSSE2.
+//-----------------------------------------------------------------------------
+#ifdef SIMD_AVX_SUPPORTED
+SIMD_TARGET_AVX2 void CRasterizer::RasterTexturedAVX2( const Primitive & Prim, long X0, long Y0, long X1, long Y1 )
+{
+    const int * pTexels = (const int*)Prim.pTexture->GetTexels();
+    long    E[3], StepX[3], StepY[3], XStart, x, y, i;
+    bool    bDepthTest  = (Prim.Flags & RASTER_DEPTHTEST ) != 0;
+    bool    bDepthWrite = (Prim.Flags & RASTER_DEPTHWRITE) != 0;
+    bool    bBilinear   = (Prim.Flags & RASTER_BILINEAR  ) != 0;
+
+    __m256i Lane       = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+    __m256  LaneF      = _mm256_cvtepi32_ps( Lane );
+    __m256i MinX       = _mm256_set1_epi32( X0 - 1 ), MaxX = _mm256_set1_epi32( X1 + 1 );
+    __m256i WrapU      = _mm256_set1_epi32( Prim.pTexture->GetWidth()  - 1 );
+    __m256i WrapV      = _mm256_set1_epi32( Prim.pTexture->GetHeight() - 1 );
+    __m128i WidthShift = _mm_cvtsi32_si128( Prim.pTexture->GetWidthShift() );
+    __m256i MinusOne   = _mm256_set1_epi32( -1 ), OneI = _mm256_set1_epi32( 1 );
+    __m256  DZDX = _mm256_set1_ps( Prim.DZDX ), DWDX = _mm256_set1_ps( Prim.DWDX );
+    __m256  DUDX = _mm256_set1_ps( Prim.DUDX ), DVDX = _mm256_set1_ps( Prim.DVDX );
+    __m256  Half = _mm256_set1_ps( 0.5f ), Two = _mm256_set1_ps( 2.0f ), Scale = _mm256_set1_ps( 256.0f );
+    __m256i e0, e1, e2, Step0, Step1, Step2, xs, Mask, Color, iu, iv, iu1, iv1, wu, wv;
+    __m256  zRow, wRow, uRow, vRow, xf, z, rhw, w, u, v, fu, fv, Depth;
+
+    // Calculate the edge functions at the first pixel
+    if ( !SetupEdges( Prim, X0, Y0, X1, Y1, E, StepX, StepY ) ) return;
+
+    // Start each row on an 8 pixel boundary
+    XStart = X0 & ~7;
+    for ( i = 0; i < 3; i++ ) E[i] -= (X0 - XStart) * StepX[i];
+    Step0 = _mm256_set1_epi32( StepX[0] * 8 );
+    Step1 = _mm256_set1_epi32( StepX[1] * 8 );
+    Step2 = _mm256_set1_epi32( StepX[2] * 8 );
+
+    // Walk the rectangle
+    for ( y = Y0; y <= Y1; y++ )
+    {
+        ULONG * pColor = m_pColorBuffer + y * m_nPitch;
+        float * pDepth = m_pDepthBuffer + y * m_nPitch;
+
+        // Edge values for the first group, and the attribute planes for this row
+        e0   = _mm256_add_epi32( _mm256_set1_epi32( E[0] ), _mm256_mullo_epi32( Lane, _mm256_set1_epi32( StepX[0] ) ) );
+        e1   = _mm256_add_epi32( _mm256_set1_epi32( E[1] ), _mm256_mullo_epi32( Lane, _mm256_set1_epi32( StepX[1] ) ) );
+        e2   = _mm256_add_epi32( _mm256_set1_epi32( E[2] ), _mm256_mullo_epi32( Lane, _mm256_set1_epi32( StepX[2] ) ) );
+        zRow = _mm256_set1_ps( Prim.Z0 + Prim.DZDY * y );
+        wRow = _mm256_set1_ps( Prim.W0 + Prim.DWDY * y );
+        uRow = _mm256_set1_ps( Prim.U0 + Prim.DUDY * y );
+        vRow = _mm256_set1_ps( Prim.V0 + Prim.DVDY * y );
+
+        for ( x = XStart; x <= X1; x += 8 )
+        {
+            // Coverage, inside all three edges and within X0 - X1
+            xs   = _mm256_add_epi32( _mm256_set1_epi32( x ), Lane );
+            Mask = _mm256_cmpgt_epi32( _mm256_or_si256( _mm256_or_si256( e0, e1 ), e2 ), MinusOne );
+            Mask = _mm256_and_si256( Mask, _mm256_and_si256( _mm256_cmpgt_epi32( xs, MinX ), _mm256_cmpgt_epi32( MaxX, xs ) ) );
+            e0   = _mm256_add_epi32( e0, Step0 );
+            e1   = _mm256_add_epi32( e1, Step1 );
+            e2   = _mm256_add_epi32( e2, Step2 );
+            if ( _mm256_testz_si256( Mask, Mask ) ) continue;
+
+            // Depth test
+            xf    = _mm256_add_ps( _mm256_set1_ps( (float)x ), LaneF );
+            z     = _mm256_fmadd_ps( xf, DZDX, zRow );
+            Depth = _mm256_load_ps( pDepth + x );
+            if ( bDepthTest ) Mask = _mm256_and_si256( Mask, _mm256_castps_si256( _mm256_cmp_ps( z, Depth, _CMP_LT_OQ ) ) );
+            if ( _mm256_testz_si256( Mask, Mask ) ) continue;
+
+            // Recover the texture coordinates (reciprocal refined with one Newton-Raphson step)
+            rhw = _mm256_fmadd_ps( xf, DWDX, wRow );
+            w   = _mm256_rcp_ps( rhw );
+            w   = _mm256_mul_ps( w, _mm256_fnmadd_ps( rhw, w, Two ) );
+            u   = _mm256_mul_ps( _mm256_fmadd_ps( xf, DUDX, uRow ), w );
+            v   = _mm256_mul_ps( _mm256_fmadd_ps( xf, DVDX, vRow ), w );
+
+            if ( bBilinear )
+            {
+                // Top left texel of each 2x2 footprint, and the blend weights
+                u   = _mm256_sub_ps( u, Half ); fu = _mm256_floor_ps( u );
+                v   = _mm256_sub_ps( v, Half ); fv = _mm256_floor_ps( v );
+                wu  = _mm256_cvttps_epi32( _mm256_mul_ps( _mm256_sub_ps( u, fu ), Scale ) );
+                wv  = _mm256_cvttps_epi32( _mm256_mul_ps( _mm256_sub_ps( v, fv ), Scale ) );
+                iu  = _mm256_and_si256( _mm256_cvttps_epi32( fu ), WrapU );
+                iv  = _mm256_and_si256( _mm256_cvttps_epi32( fv ), WrapV );
+                iu1 = _mm256_and_si256( _mm256_add_epi32( iu, OneI ), WrapU );
+                iv1 = _mm256_and_si256( _mm256_add_epi32( iv, OneI ), WrapV );
+
+                Color = LerpColorAVX2( LerpColorAVX2( _mm256_i32gather_epi32( pTexels, TexelOffsetAVX2( iu,  iv,  WidthShift ), 4 ),
+                                                      _mm256_i32gather_epi32( pTexels, TexelOffsetAVX2( iu1, iv,  WidthShift ), 4 ), wu ),
+                                       LerpColorAVX2( _mm256_i32gather_epi32( pTexels, TexelOffsetAVX2( iu,  iv1, WidthShift ), 4 ),
+                                                      _mm256_i32gather_epi32( pTexels, TexelOffsetAVX2( iu1, iv1, WidthShift ), 4 ), wu ), wv );
+            }
+            else
+            {
+                // Nearest texel
+                iu    = _mm256_and_si256( _mm256_cvttps_epi32( _mm256_floor_ps( u ) ), WrapU );
+                iv    = _mm256_and_si256( _mm256_cvttps_epi32( _mm256_floor_ps( v ) ), WrapV );
+                Color = _mm256_i32gather_epi32( pTexels, TexelOffsetAVX2( iu, iv, WidthShift ), 4 );
+
+            } // End if nearest
+
+            // Write the covered pixels
+            if ( bDepthWrite ) _mm256_store_ps( pDepth + x, _mm256_blendv_ps( Depth, z, _mm256_castsi256_ps( Mask ) ) );
+            _mm256_store_si256( (__m256i*)(pColor + x), _mm256_blendv_epi8( _mm256_load_si256( (__m256i*)(pColor + x) ), Color, Mask ) );
+
+        } // Next 8 Pixels
+
+        E[0] += StepY[0]; E[1] += StepY[1]; E[2] += StepY[2];
+
+    } // Next Row
+
+    // Avoid AVX -> SSE transition penalties in the caller
+    _mm256_zeroupper();
+}
+#endif // SIMD_AVX_SUPPORTED
@@ -0,0 +1,132 @@
+//-----------------------------------------------------------------------------
+// File: CTexture.cpp
+//
+// Desc: Texture storage for the software rasterizer. Texels are stored in
+//       4x4 tiles (one 64 byte cache line each) so that the texels sampled
+//       by neighbouring pixels, on either axis, are likely to share a line.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CTexture Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CTexture.h"
+#include <xmmintrin.h>
+
+//-----------------------------------------------------------------------------
+// Name : CTexture () (Constructor)
+// Desc : CTexture Class Constructor
+//-----------------------------------------------------------------------------
+CTexture::CTexture()
+{
+	// Reset / Clear all required values
+    m_nWidth      = 0;
+    m_nHeight     = 0;
+    m_nWidthShift = 0;
+    m_pTexels     = NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CTexture () (Destructor)
+// Desc : CTexture Class Destructor
+//-----------------------------------------------------------------------------
+CTexture::~CTexture()
+{
+    // Release our texels
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Releases the texel data.
+//-----------------------------------------------------------------------------
+void CTexture::Release( )
+{
+    if ( m_pTexels ) _mm_free( m_pTexels );
+
+    // Clear variables
+    m_pTexels     = NULL;
+    m_nWidth      = 0;
+    m_nHeight     = 0;
+    m_nWidthShift = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Create ()
+// Desc : Allocates an (uninitialized) texture of the size specified.
+// Note : Fails unless both dimensions are powers of two no smaller than a
+//        single tile.
+//-----------------------------------------------------------------------------
+bool CTexture::Create( ULONG Width, ULONG Height )
+{
+    ULONG Shift;
+
+    // Validate the dimensions
+    if ( Width  < TEXTURE_TILE_SIZE || (Width  & (Width  - 1)) ) return false;
+    if ( Height < TEXTURE_TILE_SIZE || (Height & (Height - 1)) ) return false;
+
+    // Release any previous texture
+    Release();
+
+    // Allocate the texels
+    m_pTexels = (UINT*)_mm_malloc( Width * Height * sizeof(UINT), 32 );
+    if ( !m_pTexels ) return false;
+
+    // Store the new size
+    for ( Shift = 0; (1UL << Shift) < Width; Shift++ );
+    m_nWidth      = Width;
+    m_nHeight     = Height;
+    m_nWidthShift = Shift;
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetTexels ()
+// Desc : Fills the texture from a linear (row by row) source image of the
+//        same dimensions, rearranging the texels into tiled order.
+// Note : 'Pitch' is the distance between source rows, in texels.
+//-----------------------------------------------------------------------------
+void CTexture::SetTexels( const ULONG * pSource, ULONG Pitch )
+{
+    ULONG x, y;
+
+    for ( y = 0; y < m_nHeight; y++ )
+    {
+        for ( x = 0; x < m_nWidth; x++ )
+        {
+            m_pTexels[ GetTexelOffset( x, y ) ] = (UINT)pSource[ y * Pitch + x ];
+
+        } // Next Column
+
+    } // Next Row
+}
+
+//-----------------------------------------------------------------------------
+// Name : CreateChecker ()
+// Desc : Builds a square checker board texture, used by the demo in place of
+//        a texture loaded from disk.
+//-----------------------------------------------------------------------------
+bool CTexture::CreateChecker( ULONG Size, ULONG CheckSize, ULONG Color1, ULONG Color2 )
+{
+    ULONG x, y;
+
+    // Create the texture itself
+    if ( CheckSize == 0 || !Create( Size, Size ) ) return false;
+
+    // Fill in the checks (written directly in tiled order)
+    for ( y = 0; y < Size; y++ )
+    {
+        for ( x = 0; x < Size; x++ )
+        {
+            m_pTexels[ GetTexelOffset( x, y ) ] = (UINT)((((x / CheckSize) + (y / CheckSize)) & 1) ? Color2 : Color1);
+
+        } // Next Column
+
+    } // Next Row
+
+    // Success!
+    return true;
+}
@@ -0,0 +1,313 @@
+//-----------------------------------------------------------------------------
+// File: CThreadPool.cpp
+//
+// Desc: Simple worker thread pool used to split per-frame processing (such as
+//       tile rasterization) across all of the available processor cores.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CThreadPool Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CThreadPool.h"
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Name : CThreadPool () (Constructor)
+// Desc : CThreadPool Class Constructor
+//-----------------------------------------------------------------------------
+CThreadPool::CThreadPool()
+{
+	// Reset / Clear all required values
+    m_nThreadCount  = 0;
+    m_nNextJob      = 0;
+    m_nJobCount     = 0;
+    m_pFunction     = NULL;
+    m_pContext      = NULL;
+    m_bQuit         = false;
+
+#ifdef _WIN32
+    m_hStart        = NULL;
+    m_hDone         = NULL;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CThreadPool () (Destructor)
+// Desc : CThreadPool Class Destructor
+//-----------------------------------------------------------------------------
+CThreadPool::~CThreadPool()
+{
+    // Shut down any running workers
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetProcessorCount () (Static)
+// Desc : Returns the number of logical processors available to the process.
+//-----------------------------------------------------------------------------
+ULONG CThreadPool::GetProcessorCount( )
+{
+    long Count = 1;
+
+#ifdef _WIN32
+    SYSTEM_INFO Info;
+    ::GetSystemInfo( &Info );
+    Count = (long)Info.dwNumberOfProcessors;
+#else
+    Count = sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+
+    // Always report at least one
+    return (Count < 1) ? 1 : (ULONG)Count;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Create ()
+// Desc : Spawns the worker threads. A thread count of 0 creates one thread
+//        per logical processor. The calling thread counts as one of these.
+//-----------------------------------------------------------------------------
+bool CThreadPool::Create( ULONG ThreadCount )
+{
+    ULONG i;
+
+    // Release any previous threads
+    Release();
+
+    // Select and clamp the thread count
+    if ( ThreadCount == 0 ) ThreadCount = GetProcessorCount();
+    if ( ThreadCount > MAX_POOL_THREADS ) ThreadCount = MAX_POOL_THREADS;
+
+    // Set up the batch state
+    m_bQuit     = false;
+    m_nNextJob  = 0;
+    m_nJobCount = 0;
+
+    // The calling thread always takes slot 0
+    m_nThreadCount = 1;
+    if ( ThreadCount == 1 ) return true;
+
+#ifdef _WIN32
+    // Create the synchronisation objects
+    m_hStart = ::CreateSemaphore( NULL, 0, MAX_POOL_THREADS, NULL );
+    m_hDone  = ::CreateSemaphore( NULL, 0, MAX_POOL_THREADS, NULL );
+    if ( !m_hStart || !m_hDone ) { Release(); return false; }
+#else
+    // Create the synchronisation objects
+    if ( sem_init( &m_hStart, 0, 0 ) != 0 ) return false;
+    if ( sem_init( &m_hDone, 0, 0 ) != 0 ) { sem_destroy( &m_hStart ); return false; }
+#endif
+
+    // Spawn the worker threads
+    for ( i = 1; i < ThreadCount; i++ )
+    {
+        m_Params[i].pPool = this;
+        m_Params[i].Index = i;
+
+#ifdef _WIN32
+        m_hThreads[i] = (HANDLE)_beginthreadex( NULL, 0, StaticWorkerProc, &m_Params[i], 0, NULL );
+        if ( !m_hThreads[i] ) break;
+#else
+        if ( pthread_create( &m_hThreads[i], NULL, StaticWorkerProc, &m_Params[i] ) != 0 ) break;
+#endif
+
+        // Thread is now running
+        m_nThreadCount++;
+
+    } // Next Thread
+
+    // Success if we managed to spawn at least one worker
+    if ( m_nThreadCount == 1 )
+    {
+#ifndef _WIN32
+        sem_destroy( &m_hStart );
+        sem_destroy( &m_hDone );
+#endif
+        Release();
+        return false;
+
+    } // End if no workers
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Signals all worker threads to exit and waits for them to finish.
+//-----------------------------------------------------------------------------
+void CThreadPool::Release( )
+{
+    ULONG i;
+
+    // Any workers running?
+    if ( m_nThreadCount > 1 )
+    {
+        // Wake each worker with the quit flag set
+        m_bQuit = true;
+
+#ifdef _WIN32
+        ::ReleaseSemaphore( m_hStart, m_nThreadCount - 1, NULL );
+
+        // Wait for, and close, each thread
+        for ( i = 1; i < m_nThreadCount; i++ )
+        {
+            ::WaitForSingleObject( m_hThreads[i], INFINITE );
+            ::CloseHandle( m_hThreads[i] );
+
+        } // Next Thread
+#else
+        for ( i = 1; i < m_nThreadCount; i++ ) sem_post( &m_hStart );
+
+        // Wait for each thread
+        for ( i = 1; i < m_nThreadCount; i++ ) pthread_join( m_hThreads[i], NULL );
+
+        sem_destroy( &m_hStart );
+        sem_destroy( &m_hDone );
+#endif
+
+    } // End if workers running
+
+#ifdef _WIN32
+    // Destroy synchronisation objects
+    if ( m_hStart ) ::CloseHandle( m_hStart );
+    if ( m_hDone  ) ::CloseHandle( m_hDone );
+    m_hStart = NULL;
+    m_hDone  = NULL;
+#endif
+
+    // Clear variables
+    m_nThreadCount = 0;
+    m_bQuit        = false;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Execute ()
+// Desc : Runs pFunction once for every job index in the range [0, JobCount)
+//        spread over all pool threads, and returns once they have completed.
+// Note : Jobs are claimed dynamically, so uneven jobs still balance well.
+//-----------------------------------------------------------------------------
+void CThreadPool::Execute( THREADJOBFUNC pFunction, void * pContext, ULONG JobCount )
+{
+    ULONG i, WorkerCount;
+
+    if ( JobCount == 0 || !pFunction ) return;
+
+    // Run inline if there are no workers, or only a single job
+    if ( m_nThreadCount <= 1 || JobCount == 1 )
+    {
+        for ( i = 0; i < JobCount; i++ ) pFunction( pContext, i, 0 );
+        return;
+
+    } // End if serial
+
+    // Store batch details
+    m_pFunction = pFunction;
+    m_pContext  = pContext;
+    m_nJobCount = JobCount;
+    m_nNextJob  = 0;
+
+    // Don't wake more workers than there are jobs to do
+    WorkerCount = m_nThreadCount - 1;
+    if ( WorkerCount > JobCount - 1 ) WorkerCount = JobCount - 1;
+
+    // Wake the workers
+#ifdef _WIN32
+    ::ReleaseSemaphore( m_hStart, WorkerCount, NULL );
+#else
+    for ( i = 0; i < WorkerCount; i++ ) sem_post( &m_hStart );
+#endif
+
+    // The calling thread takes part too
+    ProcessJobs( 0 );
+
+    // Wait until every woken worker has checked back in
+    for ( i = 0; i < WorkerCount; i++ )
+    {
+#ifdef _WIN32
+        ::WaitForSingleObject( m_hDone, INFINITE );
+#else
+        while ( sem_wait( &m_hDone ) != 0 );
+#endif
+    } // Next Worker
+
+    // Clear batch details
+    m_pFunction = NULL;
+    m_pContext  = NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ProcessJobs () (Private)
+// Desc : Claims and executes jobs from the current batch until none remain.
+//-----------------------------------------------------------------------------
+void CThreadPool::ProcessJobs( ULONG ThreadIndex )
+{
+    LONG Job;
+
+    for ( ; ; )
+    {
+        // Claim the next job index
+#ifdef _WIN32
+        Job = ::InterlockedIncrement( &m_nNextJob ) - 1;
+#else
+        Job = __sync_fetch_and_add( &m_nNextJob, 1 );
+#endif
+        if ( Job >= (LONG)m_nJobCount ) break;
+
+        // Execute
+        m_pFunction( m_pContext, (ULONG)Job, ThreadIndex );
+
+    } // Next Job
+}
+
+//-----------------------------------------------------------------------------
+// Name : WorkerProc () (Private)
+// Desc : Worker thread main loop, sleeps until woken for a batch.
+//-----------------------------------------------------------------------------
+void CThreadPool::WorkerProc( ULONG ThreadIndex )
+{
+    for ( ; ; )
+    {
+        // Wait for a batch (or a quit request)
+#ifdef _WIN32
+        ::WaitForSingleObject( m_hStart, INFINITE );
+#else
+        while ( sem_wait( &m_hStart ) != 0 );
+#endif
+        if ( m_bQuit ) break;
+
+        // Process jobs until the batch is exhausted
+        ProcessJobs( ThreadIndex );
+
+        // Signal completion
+#ifdef _WIN32
+        ::ReleaseSemaphore( m_hDone, 1, NULL );
+#else
+        sem_post( &m_hDone );
+#endif
+
+    } // Until quit
+}
+
+//-----------------------------------------------------------------------------
+// Name : StaticWorkerProc () (Static Callback)
+// Desc : Thread entry point, routes through to the owning pool object.
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+unsigned __stdcall CThreadPool::StaticWorkerProc( void * pParam )
+#else
+void * CThreadPool::StaticWorkerProc( void * pParam )
+#endif
+{
+    WorkerParam * pWorker = (WorkerParam*)pParam;
+
+    // Run the worker loop
+    pWorker->pPool->WorkerProc( pWorker->Index );
+
+    return 0;
+}
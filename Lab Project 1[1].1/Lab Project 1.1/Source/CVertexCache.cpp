@@ -0,0 +1,397 @@
+//-----------------------------------------------------------------------------
+// File: CVertexCache.cpp
+//
+// Desc: Post-transform vertex cache. Transforms a mesh's unique positions
+//       by a single combined world / view / projection matrix, four or eight
+//       at a time, and stores the results for the polygon drawing to index.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CVertexCache Specific Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/CVertexCache.h"
+#include "../Includes/CCpuInfo.h"
+
+//-----------------------------------------------------------------------------
+// Name : CVertexCache () (Constructor)
+// Desc : CVertexCache Class Constructor
+//-----------------------------------------------------------------------------
+CVertexCache::CVertexCache()
+{
+	// Reset / Clear all required values
+    m_nCount    = 0;
+    m_nCapacity = 0;
+    m_pClipX    = NULL;
+    m_pClipY    = NULL;
+    m_pClipZ    = NULL;
+    m_pClipW    = NULL;
+    m_pScreenX  = NULL;
+    m_pScreenY  = NULL;
+    m_pScreenZ  = NULL;
+    m_pScreenW  = NULL;
+    m_pClipCode = NULL;
+    m_fScaleX   = 1.0f;
+    m_fScaleY   = 1.0f;
+    m_fOffsetX  = 0.0f;
+    m_fOffsetY  = 0.0f;
+    m_fGuardX   = 1.0f;
+    m_fGuardY   = 1.0f;
+
+    // Select the best available path
+    SetPath( PATH_AUTO );
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CVertexCache () (Destructor)
+// Desc : CVertexCache Class Destructor
+//-----------------------------------------------------------------------------
+CVertexCache::~CVertexCache()
+{
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Releases the cache arrays.
+//-----------------------------------------------------------------------------
+void CVertexCache::Release( )
+{
+    // Release arrays
+    if ( m_pClipX   ) _mm_free( m_pClipX );
+    if ( m_pClipY   ) _mm_free( m_pClipY );
+    if ( m_pClipZ   ) _mm_free( m_pClipZ );
+    if ( m_pClipW   ) _mm_free( m_pClipW );
+    if ( m_pScreenX ) _mm_free( m_pScreenX );
+    if ( m_pScreenY ) _mm_free( m_pScreenY );
+    if ( m_pScreenZ ) _mm_free( m_pScreenZ );
+    if ( m_pScreenW ) _mm_free( m_pScreenW );
+    if ( m_pClipCode) _mm_free( m_pClipCode );
+
+    // Clear variables
+    m_pClipX    = NULL;
+    m_pClipY    = NULL;
+    m_pClipZ    = NULL;
+    m_pClipW    = NULL;
+    m_pScreenX  = NULL;
+    m_pScreenY  = NULL;
+    m_pScreenZ  = NULL;
+    m_pScreenW  = NULL;
+    m_pClipCode = NULL;
+    m_nCount    = 0;
+    m_nCapacity = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetViewport ()
+// Desc : Sets the viewport used to generate the screen space positions.
+//-----------------------------------------------------------------------------
+void CVertexCache::SetViewport( float X, float Y, float Width, float Height )
+{
+    m_fScaleX  =  Width  / 2.0f;
+    m_fScaleY  = -Height / 2.0f;
+    m_fOffsetX =  X + Width  / 2.0f;
+    m_fOffsetY =  Y + Height / 2.0f;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetGuardBand ()
+// Desc : Sets the guard band extents, as a multiple of the viewport's half
+//        width / height (1.0 = no guard band). Faces that fit within the
+//        guard band are left for the rasterizer to scissor, rather than being
+//        clipped against the viewport edges.
+//-----------------------------------------------------------------------------
+void CVertexCache::SetGuardBand( float GuardBandX, float GuardBandY )
+{
+    m_fGuardX = (GuardBandX < 1.0f) ? 1.0f : GuardBandX;
+    m_fGuardY = (GuardBandY < 1.0f) ? 1.0f : GuardBandY;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetPath ()
+// Desc : Selects the transform code path. Returns false (and leaves the path
+//        unaltered) if the processor does not support the requested path.
+//-----------------------------------------------------------------------------
+bool CVertexCache::SetPath( TRANSFORM_PATH Path )
+{
+    // Pick the best path automatically?
+    if ( Path == PATH_AUTO )
+    {
+        if      ( CCpuInfo::HasAVX()  ) Path = PATH_AVX;
+        else if ( CCpuInfo::HasSSE2() ) Path = PATH_SSE;
+        else                            Path = PATH_SCALAR;
+
+    } // End if automatic
+
+    // Validate
+    if ( Path == PATH_AVX && !CCpuInfo::HasAVX() ) return false;
+    if ( Path == PATH_SSE && !CCpuInfo::HasSSE2() ) return false;
+
+    // Store
+    m_Path = Path;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Reserve () (Private)
+// Desc : Ensures there is room for the specified number of vertices (plus
+//        padding to a multiple of 8). Grows geometrically.
+//-----------------------------------------------------------------------------
+bool CVertexCache::Reserve( ULONG Count )
+{
+    ULONG Capacity;
+
+    // Round up to the SIMD width
+    Count = (Count + 7) & ~7;
+    if ( Count <= m_nCapacity ) return true;
+
+    // Grow
+    Capacity = max( Count, m_nCapacity * 2 );
+    Release();
+
+    m_pClipX   = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    m_pClipY   = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    m_pClipZ   = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    m_pClipW   = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    m_pScreenX = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    m_pScreenY = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    m_pScreenZ = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    m_pScreenW = (float*)_mm_malloc( Capacity * sizeof(float), 32 );
+    m_pClipCode= (UINT*)_mm_malloc( Capacity * sizeof(UINT), 32 );
+    if ( !m_pClipX || !m_pClipY || !m_pClipZ || !m_pClipW ||
+         !m_pScreenX || !m_pScreenY || !m_pScreenZ || !m_pScreenW || !m_pClipCode ) { Release(); return false; }
+
+    m_nCapacity = Capacity;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Transform ()
+// Desc : Transforms all of the vertices in the mesh's vertex pool by the
+//        combined world / view / projection matrix specified, and generates
+//        each vertex's clip codes.
+//-----------------------------------------------------------------------------
+bool CVertexCache::Transform( const CMesh * pMesh, const D3DXMATRIX & mtxWVP )
+{
+    // Make room
+    m_nCount = 0;
+    if ( !Reserve( pMesh->m_nPositionCount ) ) return false;
+
+    // Transform using the selected path. The source and destination arrays
+    // are both padded to a multiple of 8, so SIMD paths need no remainder loop.
+    switch ( m_Path )
+    {
+#ifdef SIMD_AVX_SUPPORTED
+        case PATH_AVX:
+            TransformAVX( pMesh, mtxWVP, (pMesh->m_nPositionCount + 7) & ~7 );
+            break;
+#endif
+        case PATH_SSE:
+            TransformSSE( pMesh, mtxWVP, (pMesh->m_nPositionCount + 3) & ~3 );
+            break;
+
+        default:
+            TransformScalar( pMesh, mtxWVP, pMesh->m_nPositionCount );
+            break;
+
+    } // End Switch
+
+    m_nCount = pMesh->m_nPositionCount;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : TransformScalar () (Private)
+// Desc : Reference implementation, transforms one vertex at a time.
+//-----------------------------------------------------------------------------
+void CVertexCache::TransformScalar( const CMesh * pMesh, const D3DXMATRIX & m, ULONG Count )
+{
+    float x, y, z, cx, cy, cz, cw, rw, gx, gy;
+    UINT  Code;
+
+    for ( ULONG i = 0; i < Count; i++ )
+    {
+        x = pMesh->m_pPositionX[i];
+        y = pMesh->m_pPositionY[i];
+        z = pMesh->m_pPositionZ[i];
+
+        // Transform to clip space
+        cx = x * m._11 + y * m._21 + z * m._31 + m._41;
+        cy = x * m._12 + y * m._22 + z * m._32 + m._42;
+        cz = x * m._13 + y * m._23 + z * m._33 + m._43;
+        cw = x * m._14 + y * m._24 + z * m._34 + m._44;
+        m_pClipX[i] = cx; m_pClipY[i] = cy; m_pClipZ[i] = cz; m_pClipW[i] = cw;
+
+        // Generate clip codes
+        gx   = cw * m_fGuardX;
+        gy   = cw * m_fGuardY;
+        Code = 0;
+        if ( cx < -cw ) Code |= CLIP_LEFT;
+        if ( cx >  cw ) Code |= CLIP_RIGHT;
+        if ( cy < -cw ) Code |= CLIP_BOTTOM;
+        if ( cy >  cw ) Code |= CLIP_TOP;
+        if ( cz < 0.0f) Code |= CLIP_NEAR;
+        if ( cz >  cw ) Code |= CLIP_FAR;
+        if ( cx < -gx ) Code |= CLIP_GUARD_LEFT;
+        if ( cx >  gx ) Code |= CLIP_GUARD_RIGHT;
+        if ( cy < -gy ) Code |= CLIP_GUARD_BOTTOM;
+        if ( cy >  gy ) Code |= CLIP_GUARD_TOP;
+        m_pClipCode[i] = Code;
+
+        // Perspective divide and viewport
+        rw = 1.0f / cw;
+        m_pScreenX[i] = cx * rw * m_fScaleX + m_fOffsetX;
+        m_pScreenY[i] = cy * rw * m_fScaleY + m_fOffsetY;
+        m_pScreenZ[i] = cz * rw;
+        m_pScreenW[i] = rw;
+
+    } // Next Vertex
+}
+
+//-----------------------------------------------------------------------------
+// Name : TransformSSE () (Private)
+// Desc : Transforms four vertices per iteration using SSE.
+//-----------------------------------------------------------------------------
+void CVertexCache::TransformSSE( const CMesh * pMesh, const D3DXMATRIX & m, ULONG Count )
+{
+    __m128 m11 = _mm_set1_ps( m._11 ), m21 = _mm_set1_ps( m._21 ), m31 = _mm_set1_ps( m._31 ), m41 = _mm_set1_ps( m._41 );
+    __m128 m12 = _mm_set1_ps( m._12 ), m22 = _mm_set1_ps( m._22 ), m32 = _mm_set1_ps( m._32 ), m42 = _mm_set1_ps( m._42 );
+    __m128 m13 = _mm_set1_ps( m._13 ), m23 = _mm_set1_ps( m._23 ), m33 = _mm_set1_ps( m._33 ), m43 = _mm_set1_ps( m._43 );
+    __m128 m14 = _mm_set1_ps( m._14 ), m24 = _mm_set1_ps( m._24 ), m34 = _mm_set1_ps( m._34 ), m44 = _mm_set1_ps( m._44 );
+    __m128 ScaleX  = _mm_set1_ps( m_fScaleX ),  ScaleY  = _mm_set1_ps( m_fScaleY );
+    __m128 OffsetX = _mm_set1_ps( m_fOffsetX ), OffsetY = _mm_set1_ps( m_fOffsetY );
+    __m128 One     = _mm_set1_ps( 1.0f ), Zero = _mm_setzero_ps();
+    __m128 GuardX  = _mm_set1_ps( m_fGuardX ), GuardY = _mm_set1_ps( m_fGuardY );
+    __m128 Bit[10], Code;
+    __m128 x, y, z, cx, cy, cz, cw, nw, gx, gy, rw;
+
+    // Clip code bits, in the same order as the comparisons below
+    Bit[0] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_LEFT ) );
+    Bit[1] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_RIGHT ) );
+    Bit[2] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_BOTTOM ) );
+    Bit[3] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_TOP ) );
+    Bit[4] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_NEAR ) );
+    Bit[5] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_FAR ) );
+    Bit[6] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_GUARD_LEFT ) );
+    Bit[7] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_GUARD_RIGHT ) );
+    Bit[8] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_GUARD_BOTTOM ) );
+    Bit[9] = _mm_castsi128_ps( _mm_set1_epi32( CLIP_GUARD_TOP ) );
+
+    for ( ULONG i = 0; i < Count; i += 4 )
+    {
+        x  = _mm_load_ps( pMesh->m_pPositionX + i );
+        y  = _mm_load_ps( pMesh->m_pPositionY + i );
+        z  = _mm_load_ps( pMesh->m_pPositionZ + i );
+
+        // Transform to clip space
+        cx = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m11 ), _mm_mul_ps( y, m21 ) ), _mm_add_ps( _mm_mul_ps( z, m31 ), m41 ) );
+        cy = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m12 ), _mm_mul_ps( y, m22 ) ), _mm_add_ps( _mm_mul_ps( z, m32 ), m42 ) );
+        cz = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m13 ), _mm_mul_ps( y, m23 ) ), _mm_add_ps( _mm_mul_ps( z, m33 ), m43 ) );
+        cw = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m14 ), _mm_mul_ps( y, m24 ) ), _mm_add_ps( _mm_mul_ps( z, m34 ), m44 ) );
+        _mm_store_ps( m_pClipX + i, cx );
+        _mm_store_ps( m_pClipY + i, cy );
+        _mm_store_ps( m_pClipZ + i, cz );
+        _mm_store_ps( m_pClipW + i, cw );
+
+        // Generate clip codes
+        nw   = _mm_sub_ps( Zero, cw );
+        gx   = _mm_mul_ps( cw, GuardX );
+        gy   = _mm_mul_ps( cw, GuardY );
+        Code =                   _mm_and_ps( _mm_cmplt_ps( cx, nw ), Bit[0] );
+        Code = _mm_or_ps( Code,  _mm_and_ps( _mm_cmpgt_ps( cx, cw ), Bit[1] ) );
+        Code = _mm_or_ps( Code,  _mm_and_ps( _mm_cmplt_ps( cy, nw ), Bit[2] ) );
+        Code = _mm_or_ps( Code,  _mm_and_ps( _mm_cmpgt_ps( cy, cw ), Bit[3] ) );
+        Code = _mm_or_ps( Code,  _mm_and_ps( _mm_cmplt_ps( cz, Zero ), Bit[4] ) );
+        Code = _mm_or_ps( Code,  _mm_and_ps( _mm_cmpgt_ps( cz, cw ), Bit[5] ) );
+        Code = _mm_or_ps( Code,  _mm_and_ps( _mm_cmplt_ps( cx, _mm_sub_ps( Zero, gx ) ), Bit[6] ) );
+        Code = _mm_or_ps( Code,  _mm_and_ps( _mm_cmpgt_ps( cx, gx ), Bit[7] ) );
+        Code = _mm_or_ps( Code,  _mm_and_ps( _mm_cmplt_ps( cy, _mm_sub_ps( Zero, gy ) ), Bit[8] ) );
+        Code = _mm_or_ps( Code,  _mm_and_ps( _mm_cmpgt_ps( cy, gy ), Bit[9] ) );
+        _mm_store_ps( (float*)(m_pClipCode + i), Code );
+
+        // Perspective divide and viewport
+        rw = _mm_div_ps( One, cw );
+        _mm_store_ps( m_pScreenX + i, _mm_add_ps( _mm_mul_ps( _mm_mul_ps( cx, rw ), ScaleX ), OffsetX ) );
+        _mm_store_ps( m_pScreenY + i, _mm_add_ps( _mm_mul_ps( _mm_mul_ps( cy, rw ), ScaleY ), OffsetY ) );
+        _mm_store_ps( m_pScreenZ + i, _mm_mul_ps( cz, rw ) );
+        _mm_store_ps( m_pScreenW + i, rw );
+
+    } // Next 4 Vertices
+}
+
+//-----------------------------------------------------------------------------
+// Name : TransformAVX () (Private)
+// Desc : Transforms eight vertices per iteration using AVX.
+//-----------------------------------------------------------------------------
+#ifdef SIMD_AVX_SUPPORTED
+SIMD_TARGET_AVX void CVertexCache::TransformAVX( const CMesh * pMesh, const D3DXMATRIX & m, ULONG Count )
+{
+    __m256 m11 = _mm256_set1_ps( m._11 ), m21 = _mm256_set1_ps( m._21 ), m31 = _mm256_set1_ps( m._31 ), m41 = _mm256_set1_ps( m._41 );
+    __m256 m12 = _mm256_set1_ps( m._12 ), m22 = _mm256_set1_ps( m._22 ), m32 = _mm256_set1_ps( m._32 ), m42 = _mm256_set1_ps( m._42 );
+    __m256 m13 = _mm256_set1_ps( m._13 ), m23 = _mm256_set1_ps( m._23 ), m33 = _mm256_set1_ps( m._33 ), m43 = _mm256_set1_ps( m._43 );
+    __m256 m14 = _mm256_set1_ps( m._14 ), m24 = _mm256_set1_ps( m._24 ), m34 = _mm256_set1_ps( m._34 ), m44 = _mm256_set1_ps( m._44 );
+    __m256 ScaleX  = _mm256_set1_ps( m_fScaleX ),  ScaleY  = _mm256_set1_ps( m_fScaleY );
+    __m256 OffsetX = _mm256_set1_ps( m_fOffsetX ), OffsetY = _mm256_set1_ps( m_fOffsetY );
+    __m256 One     = _mm256_set1_ps( 1.0f ), Zero = _mm256_setzero_ps();
+    __m256 GuardX  = _mm256_set1_ps( m_fGuardX ), GuardY = _mm256_set1_ps( m_fGuardY );
+    __m256 Bit[10], Code;
+    __m256 x, y, z, cx, cy, cz, cw, nw, gx, gy, rw;
+
+    // Clip code bits, in the same order as the comparisons below
+    Bit[0] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_LEFT ) );
+    Bit[1] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_RIGHT ) );
+    Bit[2] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_BOTTOM ) );
+    Bit[3] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_TOP ) );
+    Bit[4] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_NEAR ) );
+    Bit[5] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_FAR ) );
+    Bit[6] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_GUARD_LEFT ) );
+    Bit[7] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_GUARD_RIGHT ) );
+    Bit[8] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_GUARD_BOTTOM ) );
+    Bit[9] = _mm256_castsi256_ps( _mm256_set1_epi32( CLIP_GUARD_TOP ) );
+
+    for ( ULONG i = 0; i < Count; i += 8 )
+    {
+        x  = _mm256_load_ps( pMesh->m_pPositionX + i );
+        y  = _mm256_load_ps( pMesh->m_pPositionY + i );
+        z  = _mm256_load_ps( pMesh->m_pPositionZ + i );
+
+        // Transform to clip space
+        cx = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, m11 ), _mm256_mul_ps( y, m21 ) ), _mm256_add_ps( _mm256_mul_ps( z, m31 ), m41 ) );
+        cy = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, m12 ), _mm256_mul_ps( y, m22 ) ), _mm256_add_ps( _mm256_mul_ps( z, m32 ), m42 ) );
+        cz = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, m13 ), _mm256_mul_ps( y, m23 ) ), _mm256_add_ps( _mm256_mul_ps( z, m33 ), m43 ) );
+        cw = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, m14 ), _mm256_mul_ps( y, m24 ) ), _mm256_add_ps( _mm256_mul_ps( z, m34 ), m44 ) );
+        _mm256_store_ps( m_pClipX + i, cx );
+        _mm256_store_ps( m_pClipY + i, cy );
+        _mm256_store_ps( m_pClipZ + i, cz );
+        _mm256_store_ps( m_pClipW + i, cw );
+
+        // Generate clip codes
+        nw   = _mm256_sub_ps( Zero, cw );
+        gx   = _mm256_mul_ps( cw, GuardX );
+        gy   = _mm256_mul_ps( cw, GuardY );
+        Code =                     _mm256_and_ps( _mm256_cmp_ps( cx, nw, _CMP_LT_OQ ), Bit[0] );
+        Code = _mm256_or_ps( Code, _mm256_and_ps( _mm256_cmp_ps( cx, cw, _CMP_GT_OQ ), Bit[1] ) );
+        Code = _mm256_or_ps( Code, _mm256_and_ps( _mm256_cmp_ps( cy, nw, _CMP_LT_OQ ), Bit[2] ) );
+        Code = _mm256_or_ps( Code, _mm256_and_ps( _mm256_cmp_ps( cy, cw, _CMP_GT_OQ ), Bit[3] ) );
+        Code = _mm256_or_ps( Code, _mm256_and_ps( _mm256_cmp_ps( cz, Zero, _CMP_LT_OQ ), Bit[4] ) );
+        Code = _mm256_or_ps( Code, _mm256_and_ps( _mm256_cmp_ps( cz, cw, _CMP_GT_OQ ), Bit[5] ) );
+        Code = _mm256_or_ps( Code, _mm256_and_ps( _mm256_cmp_ps( cx, _mm256_sub_ps( Zero, gx ), _CMP_LT_OQ ), Bit[6] ) );
+        Code = _mm256_or_ps( Code, _mm256_and_ps( _mm256_cmp_ps( cx, gx, _CMP_GT_OQ ), Bit[7] ) );
+        Code = _mm256_or_ps( Code, _mm256_and_ps( _mm256_cmp_ps( cy, _mm256_sub_ps( Zero, gy ), _CMP_LT_OQ ), Bit[8] ) );
+        Code = _mm256_or_ps( Code, _mm256_and_ps( _mm256_cmp_ps( cy, gy, _CMP_GT_OQ ), Bit[9] ) );
+        _mm256_store_ps( (float*)(m_pClipCode + i), Code );
+
+        // Perspective divide and viewport
+        rw = _mm256_div_ps( One, cw );
+        _mm256_store_ps( m_pScreenX + i, _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( cx, rw ), ScaleX ), OffsetX ) );
+        _mm256_store_ps( m_pScreenY + i, _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( cy, rw ), ScaleY ), OffsetY ) );
+        _mm256_store_ps( m_pScreenZ + i, _mm256_mul_ps( cz, rw ) );
+        _mm256_store_ps( m_pScreenW + i, rw );
+
+    } // Next 8 Vertices
+
+    // Avoid AVX -> SSE transition penalties in the caller
+    _mm256_zeroupper();
+}
+#endif // SIMD_AVX_SUPPORTED
@@ -1,40 +1,92 @@
-//-----------------------------------------------------------------------------
-// File: Main.cpp
-//
-// Desc: Main application entry & handling source file.
-//
-// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
-//-----------------------------------------------------------------------------
-
-//-----------------------------------------------------------------------------
-// Main Module Includes
-//-----------------------------------------------------------------------------
-#include "..\\Includes\\Main.h"
-#include "..\\Includes\\CGameApp.h"
-
-//-----------------------------------------------------------------------------
-// Global Variable Definitions
-//-----------------------------------------------------------------------------
-CGameApp    g_App;      // Core game application processing engine
-
-//-----------------------------------------------------------------------------
-// Name : WinMain() (Application Entry Point)
-// Desc : Entry point for program, App flow starts here.
-//-----------------------------------------------------------------------------
-int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpCmdLine, int iCmdShow )
-{
-    int retCode;
-
-	// Initialise the engine.
-	if (!g_App.InitInstance( hInstance, lpCmdLine, iCmdShow )) return 0;
-    
-    // Begin the gameplay process. Will return when app due to exit.
-    retCode = g_App.BeginGame();
-
-    // Shut down the engine, just to be polite, before exiting.
-    if ( !g_App.ShutDown() )  MessageBox( 0, _T("Failed to shut system down correctly, please check file named 'debug.txt'.\r\n\r\nIf the problem persists, please contact technical support."), _T("Non-Fatal Error"), MB_OK | MB_ICONEXCLAMATION );
-
-    // Return the correct exit code.
-    return retCode;
-
-}
\ No newline at end of file
+//-----------------------------------------------------------------------------
+// File: Main.cpp
+//
+// Desc: Main application entry & handling source file.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Main Module Includes
+//-----------------------------------------------------------------------------
+#include "../Includes/Main.h"
+#include "../Includes/CGameApp.h"
+#include "../Includes/CBenchmark.h"
+
+//-----------------------------------------------------------------------------
+// Global Variable Definitions
+//-----------------------------------------------------------------------------
+CGameApp    g_App;      // Core game application processing engine
+
+#ifdef _WIN32
+//-----------------------------------------------------------------------------
+// Name : WinMain() (Application Entry Point)
+// Desc : Entry point for program, App flow starts here.
+//-----------------------------------------------------------------------------
+int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpCmdLine, int iCmdShow )
+{
+    int retCode;
+
+    // Run the benchmarks instead of the demo if requested
+    if ( lpCmdLine && _tcsstr( lpCmdLine, _T("-bench") ) )
+    {
+        if ( !CBenchmark::Run( _T("Benchmark.txt") ) ) return 1;
+        return 0;
+
+    } // End if benchmark
+
+	// Initialise the engine.
+	if (!g_App.InitInstance( hInstance, lpCmdLine, iCmdShow )) return 0;
+    
+    // Begin the gameplay process. Will return when app due to exit.
+    retCode = g_App.BeginGame();
+
+    // Shut down the engine, just to be polite, before exiting.
+    if ( !g_App.ShutDown() )  MessageBox( 0, _T("Failed to shut system down correctly, please check file named 'debug.txt'.\r\n\r\nIf the problem persists, please contact technical support."), _T("Non-Fatal Error"), MB_OK | MB_ICONEXCLAMATION );
+
+    // Return the correct exit code.
+    return retCode;
+
+}
+#else
+
+//-----------------------------------------------------------------------------
+// Name : main() (Application Entry Point)
+// Desc : Entry point for platforms without window support, the arguments are
+//        joined back into a single command line and the engine always runs
+//        headless (see CGameApp::RunHeadless).
+//-----------------------------------------------------------------------------
+int main( int argc, char * argv[] )
+{
+    static TCHAR CmdLine[ 1024 ];
+    int          i, retCode;
+
+    // Rebuild the command line
+    for ( i = 1; i < argc; i++ )
+    {
+        if ( _tcslen( CmdLine ) + _tcslen( argv[i] ) + 2 > sizeof(CmdLine) ) break;
+        if ( i > 1 ) strcat( CmdLine, _T(" ") );
+        strcat( CmdLine, argv[i] );
+
+    } // Next Argument
+
+    // Run the benchmarks instead of the scenario if requested
+    if ( _tcsstr( CmdLine, _T("-bench") ) )
+    {
+        if ( !CBenchmark::Run( _T("Benchmark.txt") ) ) return 1;
+        return 0;
+
+    } // End if benchmark
+
+    // Initialise the engine.
+    if (!g_App.InitInstance( NULL, CmdLine, 0 )) return 1;
+
+    // Render the scenario, then shut down the engine.
+    retCode = g_App.BeginGame();
+    g_App.ShutDown();
+
+    // Return the correct exit code.
+    return retCode;
+}
+
+#endif // _WIN32
@@ -16,6 +16,16 @@
 //-----------------------------------------------------------------------------
 #include "Main.h"
 
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const float DEFAULT_SPIN_MARGIN = 0.001f; // Frame limiter time spun rather than slept (Seconds)
+const ULONG FRAME_STAT_WINDOW = 1024;     // Frames covered by the frame time histogram
+const ULONG FRAME_STAT_BUCKETS = 128;     // Number of (logarithmic) histogram buckets
+const ULONG FRAME_STAT_OCTAVE = 8;        // Histogram buckets per doubling of frame time
+const float FRAME_STAT_MIN_TIME = 0.0001f; // Upper limit of the first histogram bucket (Seconds)
+const float DEFAULT_SPIKE_FACTOR = 2.0f;  // Frames this many times the window average are spikes
+
 //-----------------------------------------------------------------------------
 // Main Class Declarations
 //-----------------------------------------------------------------------------
@@ -40,6 +50,15 @@ public:
 	void	        Tick( float fLockFPS = 0.0f );
     unsigned long   GetFrameRate( LPTSTR lpszString = NULL ) const;
     float           GetTimeElapsed() const;
+    void            SetSpinMargin( float fMargin );
+    float           GetSpinMargin() const;
+    float           GetSleepOvershoot( LPTSTR lpszString = NULL ) const;
+    void            SetSpikeFactor( float fFactor );
+    ULONG           GetSpikeCount() const;
+    float           GetFrameTimePercentile( float fPercentile ) const;
+    float           GetFrameTimeMax() const;
+    void            GetFrameStats( LPTSTR lpszString ) const;
+    bool            WriteFrameStats( LPCTSTR lpszFileName ) const;
 
 private:
 	//------------------------------------------------------------
@@ -55,10 +74,32 @@ private:
     unsigned long   m_FrameRate;                // Stores current framerate
 	unsigned long   m_FPSFrameCount;            // Elapsed frames in any given second
 	float           m_FPSTimeElapsed;           // How much time has passed during FPS sample
+
+    bool            m_bTimerPeriod;             // System timer resolution raised for accurate sleeps
+    float           m_fSpinMargin;              // Frame limiter time spun rather than slept (Seconds)
+    float           m_fLastOvershoot;           // How far the last limiter sleep ran past its request
+    float           m_fMaxOvershoot;            // Largest limiter sleep overshoot so far
+    double          m_fTotalOvershoot;          // Sum of all limiter sleep overshoots
+    ULONG           m_nSleepCount;              // Number of limiter sleeps
+
+    float           m_fStatTime[FRAME_STAT_WINDOW];     // Sliding window of raw frame times
+    ULONG           m_nStatHistogram[FRAME_STAT_BUCKETS]; // Window frame counts per bucket
+    ULONG           m_nStatIndex;               // Window slot to be written next
+    ULONG           m_nStatCount;               // Number of frames in the window
+    double          m_fStatSum;                 // Running sum of the frame times in the window
+    ULONG           m_nTickCount;               // Number of calls to Tick
+    ULONG           m_nFrameCount;              // Frames recorded since construction
+    double          m_fTotalTime;               // Sum of every recorded frame time
+    float           m_fMaxTime;                 // Longest frame recorded
+    float           m_fSpikeFactor;             // Frames this many times the average are spikes
+    ULONG           m_nSpikeCount;              // Number of spikes recorded
 	
 	//------------------------------------------------------------
 	// Private Functions For This Class
 	//------------------------------------------------------------
+    __int64         GetCounter() const;
+    void            LimiterSleep( float fSeconds );
+    void            RecordFrame( float fTimeElapsed );
 };
 
 #endif // _CTIMER_H_
\ No newline at end of file
@@ -13,6 +13,29 @@
 //-----------------------------------------------------------------------------
 #include "..\\Includes\\CTimer.h"
 
+//-----------------------------------------------------------------------------
+// Name : FrameTimeBucket () (Module Local)
+// Desc : Returns the frame time histogram bucket for the time specified.
+//        Bucket 'n' holds times up to FRAME_STAT_MIN_TIME * 2^(n / OCTAVE).
+//-----------------------------------------------------------------------------
+static inline ULONG FrameTimeBucket( float fTime )
+{
+    double Bucket;
+
+    if ( fTime <= FRAME_STAT_MIN_TIME ) return 0;
+    Bucket = ceil( log( fTime / FRAME_STAT_MIN_TIME ) * (FRAME_STAT_OCTAVE / 0.69314718056) );
+    return ( Bucket < FRAME_STAT_BUCKETS - 1 ) ? (ULONG)Bucket : FRAME_STAT_BUCKETS - 1;
+}
+
+//-----------------------------------------------------------------------------
+// Name : FrameTimeBucketLimit () (Module Local)
+// Desc : Returns the longest frame time held by the bucket specified.
+//-----------------------------------------------------------------------------
+static inline float FrameTimeBucketLimit( ULONG Bucket )
+{
+    return FRAME_STAT_MIN_TIME * (float)pow( 2.0, (double)Bucket / FRAME_STAT_OCTAVE );
+}
+
 //-----------------------------------------------------------------------------
 // Name : CTimer () (Constructor)
 // Desc : CTimer Class Constructor
@@ -40,6 +63,29 @@ CTimer::CTimer()
 	m_FrameRate			= 0;
 	m_FPSFrameCount		= 0;
 	m_FPSTimeElapsed	= 0.0f;
+
+    // Raise the system timer resolution, so that frame limiter sleeps are
+    // accurate to around a millisecond
+    m_bTimerPeriod      = ( timeBeginPeriod( 1 ) == TIMERR_NOERROR );
+    m_fSpinMargin       = DEFAULT_SPIN_MARGIN;
+    m_fLastOvershoot    = 0.0f;
+    m_fMaxOvershoot     = 0.0f;
+    m_fTotalOvershoot   = 0.0;
+    m_nSleepCount       = 0;
+
+    // Clear the frame statistics
+    m_SampleIndex       = 0;
+    m_SampleSum         = 0.0;
+    m_nStatIndex        = 0;
+    m_nStatCount        = 0;
+    m_fStatSum          = 0.0;
+    m_nTickCount        = 0;
+    m_nFrameCount       = 0;
+    m_fTotalTime        = 0.0;
+    m_fMaxTime          = 0.0f;
+    m_fSpikeFactor      = DEFAULT_SPIKE_FACTOR;
+    m_nSpikeCount       = 0;
+    memset( m_nStatHistogram, 0, sizeof(m_nStatHistogram) );
 }
 
 //-----------------------------------------------------------------------------
@@ -48,13 +94,16 @@ CTimer::CTimer()
 //-----------------------------------------------------------------------------
 CTimer::~CTimer()
 {
+    // Restore the system timer resolution
+    if ( m_bTimerPeriod ) timeEndPeriod( 1 );
 }
 
 //-----------------------------------------------------------------------------
 // Name : Tick () 
 // Desc : Function which signals that frame has advanced
 // Note : You can specify a number of frames per second to lock the frame rate
-//        to. This will simply soak up the remaining time to hit that target.
+//        to. Most of the remaining time is slept, and only the last part of
+//        it (the spin margin) is soaked up in a loop to hit that target.
 //-----------------------------------------------------------------------------
 void CTimer::Tick( float fLockFPS )
 {
@@ -82,6 +131,9 @@ void CTimer::Tick( float fLockFPS )
     // Should we lock the frame rate ?
     if ( fLockFPS > 0.0f )
     {
+        // Sleep through all but the spin margin, the loop below takes up the rest
+        LimiterSleep( (1.0f / fLockFPS) - fTimeElapsed - m_fSpinMargin );
+
         while ( fTimeElapsed < (1.0f / fLockFPS))
         {
             // Is performance hardware available?
@@ -106,13 +158,18 @@ void CTimer::Tick( float fLockFPS )
 	// Save current frame time
 	m_LastTime = m_CurrentTime;
 
+    // Record the frame statistics (the first tick measures start up, not a frame)
+    if ( m_nTickCount++ > 0 ) RecordFrame( fTimeElapsed );
+
     // Filter out values wildly different from current average
     if ( fabsf(fTimeElapsed - m_TimeElapsed) < 1.0f  )
     {
-        // Wrap FIFO frame time buffer.
-        memmove( &m_FrameTime[1], m_FrameTime, (MAX_SAMPLE_COUNT - 1) * sizeof(float) );
-        m_FrameTime[ 0 ] = fTimeElapsed;
-        if ( m_SampleCount < MAX_SAMPLE_COUNT ) m_SampleCount++;
+        // Replace the oldest sample in the ring, keeping the running sum up to date
+        if ( m_SampleCount == MAX_SAMPLE_COUNT ) m_SampleSum -= m_FrameTime[ m_SampleIndex ];
+        else m_SampleCount++;
+        m_FrameTime[ m_SampleIndex ] = fTimeElapsed;
+        m_SampleSum  += fTimeElapsed;
+        m_SampleIndex = (m_SampleIndex + 1) % MAX_SAMPLE_COUNT;
 
     } // End if
     
@@ -127,10 +184,8 @@ void CTimer::Tick( float fLockFPS )
 		m_FPSTimeElapsed	= 0.0f;
 	} // End If Second Elapsed
 
-    // Count up the new average elapsed time
-    m_TimeElapsed = 0.0f;
-    for ( ULONG i = 0; i < m_SampleCount; i++ ) m_TimeElapsed += m_FrameTime[ i ];
-    if ( m_SampleCount > 0 ) m_TimeElapsed /= m_SampleCount;
+    // The new average elapsed time
+    m_TimeElapsed = ( m_SampleCount > 0 ) ? (float)(m_SampleSum / m_SampleCount) : 0.0f;
 
 }
 
@@ -163,3 +218,237 @@ float CTimer::GetTimeElapsed() const
     return m_TimeElapsed;
 
 }
+
+//-----------------------------------------------------------------------------
+// Name : SetSpinMargin () 
+// Desc : Sets how much of each locked frame's remaining time is soaked up in
+//        a loop rather than slept (Seconds). Should be a little larger than
+//        the overshoot typically reported by GetSleepOvershoot.
+//-----------------------------------------------------------------------------
+void CTimer::SetSpinMargin( float fMargin )
+{
+    m_fSpinMargin = max( fMargin, 0.0f );
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetSpinMargin () 
+// Desc : Returns the frame limiter spin margin (Seconds)
+//-----------------------------------------------------------------------------
+float CTimer::GetSpinMargin() const
+{
+    return m_fSpinMargin;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetSleepOvershoot () 
+// Desc : Returns the average amount by which the frame limiter's sleeps ran
+//        past the time requested (Seconds), optionally building a string
+//        reporting the last, average and maximum overshoot.
+//-----------------------------------------------------------------------------
+float CTimer::GetSleepOvershoot( LPTSTR lpszString ) const
+{
+    float fAverage = ( m_nSleepCount > 0 ) ? (float)(m_fTotalOvershoot / m_nSleepCount) : 0.0f;
+
+    // Fill string buffer ?
+    if ( lpszString )
+    {
+        _stprintf( lpszString, _T("Sleep overshoot %.2fms (avg %.2fms, max %.2fms)"),
+                   m_fLastOvershoot * 1000.0f, fAverage * 1000.0f, m_fMaxOvershoot * 1000.0f );
+
+    } // End if build overshoot string
+
+    return fAverage;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetSpikeFactor () 
+// Desc : Sets how many times longer than the window average a frame must take
+//        before it is counted as a spike.
+//-----------------------------------------------------------------------------
+void CTimer::SetSpikeFactor( float fFactor )
+{
+    m_fSpikeFactor = max( fFactor, 1.0f );
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetSpikeCount () 
+// Desc : Returns the number of spikes recorded since construction
+//-----------------------------------------------------------------------------
+ULONG CTimer::GetSpikeCount() const
+{
+    return m_nSpikeCount;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetFrameTimePercentile () 
+// Desc : Returns the frame time (Seconds) which the percentage of frames
+//        specified, within the sliding window, took no longer than.
+// Note : Resolved to the upper limit of a histogram bucket, so the result is
+//        within around 9% of the exact value (and never above the maximum).
+//-----------------------------------------------------------------------------
+float CTimer::GetFrameTimePercentile( float fPercentile ) const
+{
+    ULONG Target, Count = 0, i;
+
+    if ( m_nStatCount == 0 ) return 0.0f;
+
+    // Number of frames which must lie at or below the result
+    Target = (ULONG)ceil( m_nStatCount * min( max( fPercentile, 0.0f ), 100.0f ) / 100.0f );
+    if ( Target == 0 ) Target = 1;
+
+    // Walk the buckets until enough frames are covered
+    for ( i = 0; i < FRAME_STAT_BUCKETS - 1; i++ )
+    {
+        Count += m_nStatHistogram[i];
+        if ( Count >= Target ) break;
+
+    } // Next Bucket
+
+    return min( FrameTimeBucketLimit( i ), GetFrameTimeMax() );
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetFrameTimeMax () 
+// Desc : Returns the longest frame time within the sliding window (Seconds)
+//-----------------------------------------------------------------------------
+float CTimer::GetFrameTimeMax() const
+{
+    float fMax = 0.0f;
+
+    for ( ULONG i = 0; i < m_nStatCount; i++ ) fMax = max( fMax, m_fStatTime[i] );
+    return fMax;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetFrameStats () 
+// Desc : Builds a string reporting the frame time percentiles and maximum
+//        over the sliding window, along with the spike count.
+//-----------------------------------------------------------------------------
+void CTimer::GetFrameStats( LPTSTR lpszString ) const
+{
+    if ( !lpszString ) return;
+
+    _stprintf( lpszString, _T("p50 %.2fms p90 %.2fms p99 %.2fms max %.2fms, %lu spikes"),
+               GetFrameTimePercentile( 50.0f ) * 1000.0f, GetFrameTimePercentile( 90.0f ) * 1000.0f,
+               GetFrameTimePercentile( 99.0f ) * 1000.0f, GetFrameTimeMax() * 1000.0f, (unsigned long)m_nSpikeCount );
+}
+
+//-----------------------------------------------------------------------------
+// Name : WriteFrameStats () 
+// Desc : Writes the frame statistics, and the window's frame time histogram,
+//        to the text file specified. Intended to be called at shut down.
+//-----------------------------------------------------------------------------
+bool CTimer::WriteFrameStats( LPCTSTR lpszFileName ) const
+{
+    FILE  * pFile;
+    float   fAverage = ( m_nFrameCount > 0 ) ? (float)(m_fTotalTime / m_nFrameCount) : 0.0f;
+    ULONG   i;
+
+    // Open the file
+    pFile = _tfopen( lpszFileName, _T("w") );
+    if ( !pFile ) return false;
+
+    // Totals since construction
+    fprintf( pFile, "Frames           : %lu\n", (unsigned long)m_nFrameCount );
+    fprintf( pFile, "Average          : %.3fms (%.1f FPS)\n", fAverage * 1000.0f, fAverage > 0.0f ? 1.0f / fAverage : 0.0f );
+    fprintf( pFile, "Maximum          : %.3fms\n", m_fMaxTime * 1000.0f );
+    fprintf( pFile, "Spikes           : %lu (over %.1fx the window average)\n", (unsigned long)m_nSpikeCount, m_fSpikeFactor );
+    if ( m_nSleepCount > 0 )
+        fprintf( pFile, "Sleep overshoot  : avg %.3fms, max %.3fms\n",
+                 (float)(m_fTotalOvershoot / m_nSleepCount) * 1000.0f, m_fMaxOvershoot * 1000.0f );
+
+    // Sliding window percentiles
+    fprintf( pFile, "\nLast %lu frames\n", (unsigned long)m_nStatCount );
+    fprintf( pFile, "p50              : %.3fms\n", GetFrameTimePercentile( 50.0f ) * 1000.0f );
+    fprintf( pFile, "p90              : %.3fms\n", GetFrameTimePercentile( 90.0f ) * 1000.0f );
+    fprintf( pFile, "p99              : %.3fms\n", GetFrameTimePercentile( 99.0f ) * 1000.0f );
+    fprintf( pFile, "Maximum          : %.3fms\n", GetFrameTimeMax() * 1000.0f );
+
+    // Non empty histogram buckets
+    fprintf( pFile, "\nHistogram\n" );
+    for ( i = 0; i < FRAME_STAT_BUCKETS; i++ )
+    {
+        if ( m_nStatHistogram[i] == 0 ) continue;
+        if ( i < FRAME_STAT_BUCKETS - 1 )
+            fprintf( pFile, "<= %9.3fms     : %lu\n", FrameTimeBucketLimit( i ) * 1000.0f, (unsigned long)m_nStatHistogram[i] );
+        else
+            fprintf( pFile, " > %9.3fms     : %lu\n", FrameTimeBucketLimit( i - 1 ) * 1000.0f, (unsigned long)m_nStatHistogram[i] );
+
+    } // Next Bucket
+
+    // Success!
+    fclose( pFile );
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetCounter () (Private)
+// Desc : Reads the current performance counter (or millisecond) time.
+//-----------------------------------------------------------------------------
+__int64 CTimer::GetCounter() const
+{
+    __int64 Counter;
+
+    // Is performance hardware available?
+    if ( m_PerfHardware )
+        QueryPerformanceCounter( (LARGE_INTEGER*)&Counter );
+    else
+        Counter = timeGetTime();
+
+    return Counter;
+}
+
+//-----------------------------------------------------------------------------
+// Name : LimiterSleep () (Private)
+// Desc : Sleeps for the whole number of milliseconds within the time given,
+//        and records how far past the requested time the sleep actually ran.
+//-----------------------------------------------------------------------------
+void CTimer::LimiterSleep( float fSeconds )
+{
+    __int64 StartTime;
+    DWORD   Milliseconds;
+
+    // Anything under a millisecond is left to be spun out
+    if ( fSeconds < 0.001f ) return;
+    Milliseconds = (DWORD)(fSeconds * 1000.0f);
+
+    StartTime = GetCounter();
+    ::Sleep( Milliseconds );
+
+    // Record the overshoot
+    m_fLastOvershoot   = (GetCounter() - StartTime) * m_TimeScale - Milliseconds * 0.001f;
+    m_fMaxOvershoot    = max( m_fMaxOvershoot, m_fLastOvershoot );
+    m_fTotalOvershoot += m_fLastOvershoot;
+    m_nSleepCount++;
+}
+
+//-----------------------------------------------------------------------------
+// Name : RecordFrame () (Private)
+// Desc : Adds a raw (unfiltered) frame time to the statistics. The oldest
+//        frame in the window is swapped out of the histogram and running sum
+//        so that the cost per frame is constant.
+//-----------------------------------------------------------------------------
+void CTimer::RecordFrame( float fTimeElapsed )
+{
+    // Count it as a spike if it took much longer than the window average
+    if ( m_nStatCount > 0 && fTimeElapsed > (float)(m_fStatSum / m_nStatCount) * m_fSpikeFactor ) m_nSpikeCount++;
+
+    // Replace the oldest frame in the window
+    if ( m_nStatCount == FRAME_STAT_WINDOW )
+    {
+        m_nStatHistogram[ FrameTimeBucket( m_fStatTime[ m_nStatIndex ] ) ]--;
+        m_fStatSum -= m_fStatTime[ m_nStatIndex ];
+    }
+    else
+        m_nStatCount++;
+
+    m_fStatTime[ m_nStatIndex ] = fTimeElapsed;
+    m_nStatHistogram[ FrameTimeBucket( fTimeElapsed ) ]++;
+    m_fStatSum  += fTimeElapsed;
+    m_nStatIndex = (m_nStatIndex + 1) % FRAME_STAT_WINDOW;
+
+    // Totals since construction
+    m_nFrameCount++;
+    m_fTotalTime += fTimeElapsed;
+    m_fMaxTime    = max( m_fMaxTime, fTimeElapsed );
+}
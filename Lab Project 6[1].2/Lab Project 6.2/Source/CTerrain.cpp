@@ -138,8 +138,13 @@ bool CTerrain::LoadHeightMap( LPCTSTR FileName, ULONG Width, ULONG Height )
     pFile = _tfopen( FileName, _T("rb") );
     if (!pFile) return false;
 
-    // Read the heightmap data (grayscale)
-    fread( m_pHeightMap, Width * Height, 1, pFile );
+    // Validate the file size against the dimensions specified
+    fseek( pFile, 0, SEEK_END );
+    if ( (ULONG)ftell( pFile ) != Width * Height ) { fclose( pFile ); return false; }
+    fseek( pFile, 0, SEEK_SET );
+
+    // Read the heightmap data (grayscale) in a single block
+    if ( fread( m_pHeightMap, Width * Height, 1, pFile ) != 1 ) { fclose( pFile ); return false; }
     
     // Finish up
     fclose( pFile );
@@ -70,6 +70,11 @@ public:
     const D3DXVECTOR3&  GetUp            ( ) const { return m_vecUp;    }
     const D3DXVECTOR3&  GetRight         ( ) const { return m_vecRight; }
     const D3DXMATRIX&   GetViewMatrix    ( );
+
+    D3DXVECTOR3         GetRenderPosition( ) const { return m_vecPrevPos + (m_vecPos - m_vecPrevPos) * m_fInterpolation; }
+    void                StoreState       ( )                             { m_vecPrevPos = m_vecPos; }
+    void                OffsetState      ( const D3DXVECTOR3& vecShift ) { m_vecPrevPos += vecShift; m_bViewDirty = true; m_bFrustumDirty = true; }
+    void                SetInterpolation ( float Alpha )                 { m_fInterpolation = Alpha; m_bViewDirty = true; m_bFrustumDirty = true; }
     
     void                SetVolumeInfo    ( const VOLUME_INFO& Volume );
     const VOLUME_INFO&  GetVolumeInfo    ( ) const;
@@ -90,6 +95,7 @@ public:
     virtual CAMERA_MODE GetCameraMode    ( ) const = 0;
 
     bool                BoundsInFrustum  ( const D3DXVECTOR3 & Min, const D3DXVECTOR3 & Max );
+    bool                BoundsInFrustum  ( const D3DXVECTOR3 & Min, const D3DXVECTOR3 & Max, ULONG & PlaneMask );
 
 protected:
     //-------------------------------------------------------------------------
@@ -122,6 +128,10 @@ protected:
     D3DXVECTOR3     m_vecLook;              // Camera Look Vector
     D3DXVECTOR3     m_vecRight;             // Camera Right Vector
 
+    // Render interpolation between simulation steps
+    D3DXVECTOR3     m_vecPrevPos;           // Camera Position at the start of the latest simulation step
+    float           m_fInterpolation;       // Fraction of the way from the previous to the current position to render
+
 };
 
 //-----------------------------------------------------------------------------
@@ -24,6 +24,12 @@
 //-----------------------------------------------------------------------------
 class CCamera;
 
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const float SIMULATION_STEP      = 1.0f / 60.0f;    // Fixed simulation time step (in seconds)
+const ULONG SIMULATION_MAX_STEPS = 8;               // Most simulation steps run in a single frame
+
 //-----------------------------------------------------------------------------
 // Main Class Declarations
 //-----------------------------------------------------------------------------
@@ -67,6 +73,7 @@ private:
     void        SetupRenderStates ( );
     void        AnimateObjects    ( );
     void        ProcessInput      ( );
+    void        AdvanceSimulation ( float TimeElapsed );
     bool        TestDeviceCaps    ( );
     void        SelectMenuItems   ( );
 
@@ -90,6 +97,8 @@ private:
     
     CTimer                  m_Timer;            // Game timer
     ULONG                   m_LastFrameRate;    // Used for making sure we update only when fps changes.
+    float                   m_fSimAccumulator;  // Elapsed time not yet consumed by the simulation
+    ULONG                   m_nMoveDirection;   // Movement keys held at the last input poll
     
     HWND                    m_hWnd;             // Main window HWND
     HICON                   m_hIcon;            // Window Icon
@@ -80,6 +80,8 @@ public:
     //-------------------------------------------------------------------------
     bool                SetCameraMode      ( ULONG Mode );
     void                Update             ( float TimeScale );
+    void                StoreState         ( );
+    void                SetInterpolation   ( float Alpha );
     
     void                AddPlayerCallback    ( UPDATEPLAYER pFunc, LPVOID pContext );
     void                AddCameraCallback    ( UPDATECAMERA pFunc, LPVOID pContext );
@@ -105,6 +107,7 @@ public:
     const D3DXVECTOR3 & GetLook            ( ) const { return m_vecLook; }
     const D3DXVECTOR3 & GetUp              ( ) const { return m_vecUp; }
     const D3DXVECTOR3 & GetRight           ( ) const { return m_vecRight; }
+    D3DXVECTOR3         GetRenderPosition  ( ) const { return m_vecPrevPos + (m_vecPos - m_vecPrevPos) * m_fInterpolation; }
     
     float               GetYaw             ( ) const { return m_fYaw; }
     float               GetPitch           ( ) const { return m_fPitch; }
@@ -136,6 +139,10 @@ private:
     float           m_fPitch;               // Player pitch
     float           m_fRoll;                // Player roll
     float           m_fYaw;                 // Player yaw
+
+    // Render interpolation between simulation steps
+    D3DXVECTOR3     m_vecPrevPos;           // Player Position at the start of the latest simulation step
+    float           m_fInterpolation;       // Fraction of the way from the previous to the current position to render
     
     // Force / Player Update Variables
     D3DXVECTOR3     m_vecVelocity;          // Movement velocity vector
@@ -0,0 +1,138 @@
+//-----------------------------------------------------------------------------
+// File: CProfiler.h
+//
+// Desc: Lightweight scoped profiler. Zones placed with PROFILE_ZONE are timed
+//       into per-thread event buffers, averaged over recent frames, and can be
+//       written out as a Chrome 'about:tracing' / Perfetto JSON trace.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CPROFILER_H_
+#define _CPROFILER_H_
+
+//-----------------------------------------------------------------------------
+// CProfiler Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+// The profiler is built into debug builds, and any build which defines PROFILE.
+// Elsewhere the macros below compile away to nothing.
+#if defined(_DEBUG) || defined(PROFILE)
+#define PROFILER_ENABLED
+#endif
+
+#ifdef PROFILER_ENABLED
+
+const ULONG PROFILE_MAX_ZONES   = 64;       // Maximum number of distinct zones
+const ULONG PROFILE_MAX_THREADS = 32;       // Maximum number of threads which may record zones
+const ULONG PROFILE_EVENT_COUNT = 65536;    // Most recent zone events kept per thread (power of two)
+const ULONG PROFILE_HISTORY     = 64;       // Frames covered by the per zone rolling averages
+const LONG  PROFILE_ZONE_UNSET  = PROFILE_MAX_ZONES + 1; // Zone index not yet looked up
+
+// Times the remainder of the enclosing scope (one zone per scope). The zone
+// index is cached in a constant initialized static, so there is no compiler
+// generated guard for threads to race past (see CProfiler::GetZone).
+#define PROFILE_ZONE( Name ) \
+    static volatile LONG _ProfileZone = PROFILE_ZONE_UNSET; \
+    CProfileScope _ProfileScope( CProfiler::GetZone( &_ProfileZone, Name ) )
+
+#define PROFILE_END_FRAME()             CProfiler::EndFrame()
+#define PROFILE_WRITE_TRACE( FileName ) CProfiler::WriteTrace( FileName )
+
+#else // PROFILER_ENABLED
+
+#define PROFILE_ZONE( Name )
+#define PROFILE_END_FRAME()
+#define PROFILE_WRITE_TRACE( FileName )
+
+#endif // !PROFILER_ENABLED
+
+#ifdef PROFILER_ENABLED
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CProfiler (Class)
+// Desc : Static zone registry and event store. Each thread appends the zones
+//        it completes to its own buffer, so recording never takes a lock.
+// Note : EndFrame and WriteTrace read every thread's buffer, and should be
+//        called from the main thread only.
+//-----------------------------------------------------------------------------
+class CProfiler
+{
+public:
+	//-------------------------------------------------------------------------
+	// Public Static Functions For This Class
+	//-------------------------------------------------------------------------
+    static ULONG        RegisterZone    ( const char * strName );
+    static void         RecordZone      ( ULONG Zone, __int64 Start, __int64 End );
+    static void         EndFrame        ( );
+    static bool         WriteTrace      ( LPCTSTR strFileName );
+
+    static ULONG        GetZoneCount    ( );
+    static const char * GetZoneName     ( ULONG Zone );
+    static float        GetZoneAverage  ( ULONG Zone );
+    static float        GetZoneCalls    ( ULONG Zone );
+
+    //-------------------------------------------------------------------------
+    // Name : GetZone () (Static)
+    // Desc : Returns the zone index cached in the variable specified, looking
+    //        it up and storing it on first use.
+    // Note : Threads racing on first use each call RegisterZone, which returns
+    //        the same index to all of them, so the cached value never changes
+    //        once it has been stored.
+    //-------------------------------------------------------------------------
+    static ULONG GetZone( volatile LONG * pZone, const char * strName )
+    {
+        LONG Zone = *pZone;
+        if ( Zone == PROFILE_ZONE_UNSET )
+        {
+            Zone = (LONG)RegisterZone( strName );
+            InterlockedExchange( (LONG*)pZone, Zone );
+
+        } // End if not yet looked up
+        return (ULONG)Zone;
+    }
+
+    //-------------------------------------------------------------------------
+    // Name : GetCounter () (Static)
+    // Desc : Reads the performance counter used to time each zone.
+    //-------------------------------------------------------------------------
+    static __int64 GetCounter( )
+    {
+        __int64 Counter;
+        QueryPerformanceCounter( (LARGE_INTEGER*)&Counter );
+        return Counter;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Name : CProfileScope (Class)
+// Desc : Records the time between its construction and destruction against
+//        the zone specified. Created by the PROFILE_ZONE macro.
+//-----------------------------------------------------------------------------
+class CProfileScope
+{
+public:
+    //-------------------------------------------------------------------------
+    // Constructors & Destructors for This Class
+    //-------------------------------------------------------------------------
+     CProfileScope( ULONG Zone ) { m_nZone = Zone; m_Start = CProfiler::GetCounter(); }
+    ~CProfileScope( )            { CProfiler::RecordZone( m_nZone, m_Start, CProfiler::GetCounter() ); }
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Variables For This Class
+	//-------------------------------------------------------------------------
+    ULONG           m_nZone;                    // Zone being timed
+    __int64         m_Start;                    // Counter value on entry to the scope
+};
+
+#endif // PROFILER_ENABLED
+
+#endif // _CPROFILER_H_
@@ -15,6 +15,15 @@
 //-----------------------------------------------------------------------------
 #include "Main.h"
 #include "CObject.h"
+#include "CThreadPool.h"
+#include "CTerrainPager.h"
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const USHORT TERRAIN_MAX_LOD     = 8;   // Maximum number of detail levels for each block
+const USHORT TERRAIN_LOD_EDGES   = 16;  // Number of edge stitching combinations per level
+const USHORT TERRAIN_BLEND_CHANNELS = 4; // Layer blend maps packed into each blend texture
 
 //-----------------------------------------------------------------------------
 // Forward Declarations
@@ -25,6 +34,33 @@ class CTerrainBlock;
 class CTerrainSplat;
 class CTerrainLayer;
 
+//-----------------------------------------------------------------------------
+// Main Structure Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : BLOCK_SOURCE (Struct)
+// Desc : Describes where a terrain block reads the data it is built from.
+//        Each pointer addresses the block's first sample, so the same layout
+//        serves both the full heightmap and a paged tile.
+//-----------------------------------------------------------------------------
+struct BLOCK_SOURCE
+{
+    const float   * pHeights;       // Heights, starting at the block's first sample
+    ULONG           HeightPitch;    // Samples between rows of heights
+    const float   * pNormalX;       // Normal field X components, starting at the block's first sample
+    const float   * pNormalY;       // Normal field Y components
+    const float   * pNormalZ;       // Normal field Z components
+    ULONG           NormalPitch;    // Normals between rows
+    ULONG           NormalWidth;    // Columns of normals available from the block's first sample
+    ULONG           NormalHeight;   // Rows of normals available from the block's first sample
+    const UCHAR  ** ppBlendMaps;    // Blend map for each layer
+    ULONG           BlendOffset;    // Index of the block's first texel in each blend map
+    ULONG           BlendPitch;     // Texels between rows of each blend map
+    const UCHAR  ** ppCoverage;     // Coverage map for each layer (see CTerrainLayer::BuildCoverage)
+    ULONG           CoverageOffset; // Index of the block's first quad in each coverage map
+    ULONG           CoveragePitch;  // Quads between rows of each coverage map
+};
+
 //-----------------------------------------------------------------------------
 // Main Class Declarations
 //-----------------------------------------------------------------------------
@@ -37,6 +73,18 @@ class CTerrainLayer;
 class CTerrain
 {
 public:
+    //-------------------------------------------------------------------------
+    // Enumerators
+    //-------------------------------------------------------------------------
+    enum HEIGHTMAP_FORMAT {
+        HEIGHTMAP_8BIT        = 1,      // Unsigned 8 bit samples
+        HEIGHTMAP_16BIT       = 2,      // Unsigned 16 bit samples, little endian
+        HEIGHTMAP_16BIT_BE    = 3,      // Unsigned 16 bit samples, big endian
+        HEIGHTMAP_FLOAT       = 4,      // 32 bit floating point samples
+
+        HEIGHTMAP_FORCE_32BIT = 0x7FFFFFFF
+    };
+
     //-------------------------------------------------------------------------
     // Constructors & Destructors for This Class
     //-------------------------------------------------------------------------
@@ -53,7 +101,10 @@ public:
     void                Render          ( CCamera * pCamera = NULL );
     void                Release         ( );
     float              *GetHeightMap    ( ) const { return m_pHeightMap; }
-    D3DXVECTOR3         GetHeightMapNormal  ( ULONG x, ULONG z );
+    D3DXVECTOR3         GetHeightMapNormal  ( ULONG x, ULONG z ) const;
+    const float        *GetNormalsX     ( ) const { return m_pNormalX; }
+    const float        *GetNormalsY     ( ) const { return m_pNormalY; }
+    const float        *GetNormalsZ     ( ) const { return m_pNormalZ; }
     ULONG               GetTerrainWidth ( ) const { return m_nHeightMapWidth; }
     ULONG               GetTerrainHeight( ) const { return m_nHeightMapHeight; }
     const D3DXVECTOR3&  GetScale        ( ) const { return m_vecScale; }
@@ -62,6 +113,22 @@ public:
     USHORT              GetLayerCount   ( ) const { return m_nLayerCount; }
     CTerrainLayer      *GetLayer        ( USHORT Index ) { return m_pLayer[Index]; }
     USHORT              GetBlendTexRatio( ) const { return m_nBlendTexRatio; }
+    USHORT              GetBlendGroupCount( ) const { return (m_nLayerCount + TERRAIN_BLEND_CHANNELS - 2) / TERRAIN_BLEND_CHANNELS; }
+    void                GetBlendAtlasPlacement( ULONG StartX, ULONG StartZ, ULONG & Page, RECT & Rect ) const;
+    ULONG               GetBlendAtlasWidth ( ) const { return m_nAtlasWidth; }
+    ULONG               GetBlendAtlasHeight( ) const { return m_nAtlasHeight; }
+    LPDIRECT3DTEXTURE9  GetBlendAtlas   ( ULONG Page, USHORT Group ) const { return m_pBlendAtlas ? m_pBlendAtlas[ Page * GetBlendGroupCount() + Group ] : NULL; }
+    USHORT              GetLODCount     ( ) const { return m_nLODCount; }
+    ULONG               GetBlockCount   ( ) const { return m_nBlockCount; }
+    CTerrainBlock      *GetBlock        ( ULONG Index ) { return m_pBlock[Index]; }
+    USHORT              GetBlocksWide   ( ) const { return m_nBlocksWide; }
+    USHORT              GetBlocksHigh   ( ) const { return m_nBlocksHigh; }
+    ULONG               GetBlockWidth   ( ) const { return m_nBlockWidth; }
+    ULONG               GetBlockHeight  ( ) const { return m_nBlockHeight; }
+    void                GetBlockSource  ( ULONG StartX, ULONG StartZ, BLOCK_SOURCE & Source, const UCHAR ** ppBlendMaps, const UCHAR ** ppCoverage );
+    LPDIRECT3DINDEXBUFFER9 GetLODIndexBuffer( ) const { return m_pLODIndexBuffer; }
+    ULONG               GetLODStart     ( USHORT Level, USHORT Edges ) const { return m_nLODStart[Level][Edges]; }
+    ULONG               GetLODPrimitives( USHORT Level, USHORT Edges ) const { return m_nLODPrimitives[Level][Edges]; }
 
     //-------------------------------------------------------------------------
 	// Public Static Functions For This Class
@@ -70,6 +137,19 @@ public:
     static void     UpdateCamera  ( LPVOID pContext, CCamera * pCamera, float TimeScale );
 
 private:
+    //-------------------------------------------------------------------------
+	// Private Structures For This Class
+	//-------------------------------------------------------------------------
+    struct QuadNode
+    {
+        D3DXVECTOR3     BoundsMin;          // Bounds of every block beneath this node
+        D3DXVECTOR3     BoundsMax;
+        ULONG           FirstChild;         // Index of the first child node (children are stored together)
+        ULONG           ChildCount;         // Number of child nodes, zero for a leaf
+        ULONG           FirstBlock;         // First entry in m_pQuadBlocks beneath this node
+        ULONG           BlockCount;         // Number of blocks beneath this node
+    };
+
 	//-------------------------------------------------------------------------
 	// Private Variables For This Class
 	//-------------------------------------------------------------------------
@@ -77,6 +157,9 @@ private:
     float              *m_pHeightMap;       // The physical heightmap data loaded
     ULONG               m_nHeightMapWidth;  // Width of the 2D heightmap data
     ULONG               m_nHeightMapHeight; // Height of the 2D heightmap data
+    float              *m_pNormalX;         // Heightmap normal field, X components (one per sample)
+    float              *m_pNormalY;         // Heightmap normal field, Y components
+    float              *m_pNormalZ;         // Heightmap normal field, Z components
 
     ULONG               m_nBlockWidth;      // Width of an individual terrain block
     ULONG               m_nBlockHeight;     // Height of an individual terrain block
@@ -86,10 +169,29 @@ private:
     USHORT              m_nBlocksHigh;      // Number of blocks high
     
     USHORT              m_nBlendTexRatio;   // Number of blend map texels to map to each terrain quad
+
+    ULONG               m_nAtlasMaxSize;    // Largest blend atlas page, in texels along each side
+    ULONG               m_nAtlasBlocksWide; // Blocks across each blend atlas page
+    ULONG               m_nAtlasBlocksHigh; // Blocks down each blend atlas page
+    ULONG               m_nAtlasPagesWide;  // Blend atlas pages across the terrain
+    ULONG               m_nAtlasPageCount;  // Number of blend atlas pages
+    ULONG               m_nAtlasWidth;      // Width of each blend atlas page, in texels
+    ULONG               m_nAtlasHeight;     // Height of each blend atlas page, in texels
+    LPDIRECT3DTEXTURE9* m_pBlendAtlas;      // Blend atlas textures, one for each layer group on each page
     
     CTerrainBlock     **m_pBlock;           // Simple array of terrain block pointers
     ULONG               m_nBlockCount;      // Number of terrain blocks stored here
     CTerrainLayer     **m_pLayer;           // Simple array of layer pointers
+    QuadNode           *m_pQuadNodes;       // Quadtree built over the block grid (node 0 is the root)
+    ULONG               m_nQuadNodeCount;   // Number of quadtree nodes in use
+    CTerrainBlock     **m_pQuadBlocks;      // Blocks in quadtree order, each node covers a contiguous run
+    ULONG               m_nQuadBlockCount;  // Number of blocks placed in quadtree order
+    CTerrainBlock     **m_pVisibleBlocks;   // Blocks found to be within the frustum this frame
+    ULONG               m_nVisibleCount;    // Number of visible blocks this frame
+    CTerrainBlock     **m_pLODBlocks;       // Visible blocks and their neighbours, whose level is selected this frame
+    ULONG               m_nLODBlockCount;   // Number of blocks in the LOD list
+    CTerrainBlock     **m_pLODQueue;        // Blocks whose neighbours are still to be checked against their level
+    ULONG               m_nLODFrame;        // Incremented each time the LOD list is built
     USHORT              m_nLayerCount;      // Number of layers stored here
 
     LPDIRECT3DDEVICE9   m_pD3DDevice;       // D3D Device to use for creation / rendering.
@@ -100,15 +202,57 @@ private:
     LPDIRECT3DTEXTURE9* m_pTexture;         // Array of textures loaded for this terrain
     USHORT              m_nTextureCount;    // Number of textures loaded.
 
+    CThreadPool         m_ThreadPool;       // Worker threads used to process terrain data
+    float              *m_pFilterScratch;   // Intermediate heightmap used by the filter passes
+    ULONG               m_nFilterScratchSize; // Number of floats allocated in the scratch buffer
+    volatile LONG       m_nBlockFailures;   // Number of blocks which failed to build on the thread pool
+
+    USHORT              m_nLODCount;        // Number of detail levels available to each block
+    float               m_fLODMaxError;     // Largest screen space error (in pixels) allowed when selecting a level
+    LPDIRECT3DINDEXBUFFER9 m_pLODIndexBuffer; // Index lists for every level / edge combination, shared by all blocks
+    ULONG               m_nLODStart[TERRAIN_MAX_LOD][TERRAIN_LOD_EDGES];      // First index of each list
+    ULONG               m_nLODPrimitives[TERRAIN_MAX_LOD][TERRAIN_LOD_EDGES]; // Triangle count of each list
+
+    CTerrainPager       m_Pager;            // Streams blocks from the page file (when paging)
+    float               m_fPageRadius;      // Distance from the camera within which blocks are paged in
+    ULONG               m_nPageUploads;     // Most paged blocks uploaded to the device each frame
+
+    const UCHAR        *m_pCookedData;      // Mapped view of the cooked terrain file (while loading only)
+    ULONG               m_nCookedSize;      // Size of the mapped view, in bytes
+
 
 	//-------------------------------------------------------------------------
 	// Private Functions For This Class
 	//-------------------------------------------------------------------------
     long            AddTerrainBlock         ( ULONG Count = 1 );
     long            AddTerrainLayer         ( USHORT Count = 1 );
-    bool            GenerateLayers          ( LPCTSTR DefFile );
-    bool            GenerateTerrainBlocks   ( );
-    void            FilterHeightMap         ( );
+    bool            GenerateLayers          ( LPCTSTR DefFile, bool LoadBlendMaps = true, ULONG FirstRow = 0 );
+    bool            GenerateTerrainBlocks   ( LPCTSTR CookedFile = NULL, unsigned __int64 CookedHash = 0 );
+    bool            CreateBlendAtlas        ( );
+    void            SetBlendChannel         ( USHORT LayerIndex );
+    bool            OpenCookedTerrain       ( LPCTSTR FileName, unsigned __int64 Hash );
+    void            CloseCookedTerrain      ( );
+    bool            LoadCookedBlocks        ( );
+    bool            WriteCookedTerrain      ( LPCTSTR FileName, unsigned __int64 Hash );
+    bool            BuildPageFile           ( LPCTSTR FileName, LPCTSTR DefFile, LPCTSTR HeightMapFile, HEIGHTMAP_FORMAT Format,
+                                              ULONG FilterRadius, ULONG FilterIterations, bool FilterGaussian, unsigned __int64 Hash );
+    bool            LoadHeightMap           ( LPCTSTR FileName, HEIGHTMAP_FORMAT Format, ULONG FirstRow = 0, ULONG FileRows = 0 );
+    void            FilterHeightMap         ( ULONG Radius = 1, ULONG Iterations = 1, bool Gaussian = false );
+    bool            GenerateNormals         ( );
+    void            GenerateNormalRow       ( ULONG z );
+    bool            GenerateLODIndices      ( );
+    void            UpdateLOD               ( CCamera * pCamera );
+    bool            BuildQuadTree           ( );
+    void            BuildQuadNode           ( ULONG Node, ULONG X0, ULONG Z0, ULONG X1, ULONG Z1 );
+    void            CullQuadNode            ( ULONG Node, ULONG PlaneMask, CCamera * pCamera );
+    void            CollectVisibleBlocks    ( CCamera * pCamera );
+
+    //-------------------------------------------------------------------------
+	// Private Static Functions For This Class
+	//-------------------------------------------------------------------------
+    static void     GenerateNormalsJob      ( void * pContext, ULONG JobIndex, ULONG ThreadIndex );
+    static CTerrain *LoadPageBand           ( void * pContext, ULONG FirstRow, ULONG RowCount, ULONG & BandRow );
+    static void     BuildBlockJob           ( void * pContext, ULONG JobIndex, ULONG ThreadIndex );
     
 };
 
@@ -119,6 +263,18 @@ private:
 class CTerrainBlock
 {
 public:
+    //-------------------------------------------------------------------------
+    // Enumerators
+    //-------------------------------------------------------------------------
+    enum PAGE_STATE {
+        PAGE_UNLOADED       = 0,        // No data held (paged terrains only)
+        PAGE_QUEUED         = 1,        // Waiting for, or being built by, a loader thread
+        PAGE_BUILT          = 2,        // Built, waiting for its device resources
+        PAGE_RESIDENT       = 3,        // Ready to render
+
+        PAGE_FORCE_32BIT    = 0x7FFFFFFF
+    };
+
     //-------------------------------------------------------------------------
     // Constructors & Destructors for This Class
     //-------------------------------------------------------------------------
@@ -128,8 +284,14 @@ public:
 	//-------------------------------------------------------------------------
 	// Public Functions For This Class
 	//-------------------------------------------------------------------------
-    bool    GenerateBlock ( CTerrain * pParent, ULONG StartX, ULONG StartZ, ULONG BlockWidth, ULONG BlockHeight );
-    void    Render        ( LPDIRECT3DDEVICE9 pD3DDevice, USHORT LayerIndex );
+    bool    GenerateBlock   ( CTerrain * pParent, ULONG StartX, ULONG StartZ, ULONG BlockWidth, ULONG BlockHeight );
+    bool    BuildBlock      ( CTerrain * pParent, const BLOCK_SOURCE & Source, ULONG StartX, ULONG StartZ, ULONG BlockWidth, ULONG BlockHeight );
+    bool    CreateResources ( bool FreeStaging = true );
+    bool    ReadCooked      ( CTerrain * pParent, ULONG StartX, ULONG StartZ, const UCHAR *& pData, const UCHAR * pEnd );
+    bool    WriteCooked     ( HANDLE hFile ) const;
+    void    ReleaseResources( );
+    void    Render          ( LPDIRECT3DDEVICE9 pD3DDevice, USHORT LayerIndex );
+    void    CalculateLODErrors( const BLOCK_SOURCE & Source );
 
 	//-------------------------------------------------------------------------
 	// Public Variables For This Class
@@ -146,20 +308,35 @@ public:
     USHORT                  m_nSplatCount;      // Number of splat levels stored
     CTerrainSplat        ** m_pSplatLevel;      // Actual splat levels stored
     LPDIRECT3DVERTEXBUFFER9 m_pVertexBuffer;    // Terrain blocks vertex buffer
+    CVertex               * m_pVertices;        // Built vertex data, awaiting CreateResources
+    LPDIRECT3DTEXTURE9    * m_pBlendTexture;    // Blend texture of each layer group (may be a shared atlas page)
+    ULONG                 * m_pBlendData;       // Built blend texels (packed A8R8G8B8) of each layer group, awaiting upload
 
     D3DXVECTOR3             m_BoundsMin;        // Bounding box minimum extents
     D3DXVECTOR3             m_BoundsMax;        // Bounding box maximum extents
 
+    float                   m_fLODError[TERRAIN_MAX_LOD]; // Largest world space height error at each level
+    USHORT                  m_nLOD;             // Level selected for the current frame
+    USHORT                  m_nLODEdges;        // Edges to stitch to a coarser neighbour this frame
+    ULONG                   m_nLODFrame;        // Last LOD list (see CTerrain::UpdateLOD) which included this block
+    bool                    m_bLODQueued;       // Block is waiting in the LOD queue
+
+    volatile LONG           m_nPageState;       // PAGE_STATE of this block
+    float                 * m_pHeights;         // Block heights kept while resident (paged terrains only)
+    ULONG                   m_nPageFrame;       // Last frame on which the block was within the paging radius
+    CTerrainBlock         * m_pPagePrev;        // Previous (more recently used) resident block
+    CTerrainBlock         * m_pPageNext;        // Next (less recently used) resident block
+
 private:
     
     //-------------------------------------------------------------------------
 	// Private Functions For This Class
 	//-------------------------------------------------------------------------
-    bool    CountLayerUsage     ( );
-    bool    GenerateSplats      ( );
-    bool    GenerateSplatLevel  ( USHORT TerrainLayer );
+    bool    CountLayerUsage     ( const BLOCK_SOURCE & Source );
+    bool    GenerateSplats      ( const BLOCK_SOURCE & Source );
+    bool    GenerateSplatLevel  ( const BLOCK_SOURCE & Source, USHORT TerrainLayer );
     long    AddSplatLevel       ( USHORT Count );
-    bool    GenerateBlendMaps   ( );
+    bool    GenerateBlendMaps   ( const BLOCK_SOURCE & Source );
     
 };
 
@@ -183,7 +360,7 @@ public:
     ULONG                   m_nIndexCount;      // Pre-Calculated Number of indices for rendering 
     ULONG                   m_nPrimitiveCount;  // Pre-calculated number of primitives for rendering
     USHORT                  m_nLayerIndex;      // Layer index used for this splat level
-    LPDIRECT3DTEXTURE9      m_pBlendTexture;    // Generated blend texture.
+    USHORT                * m_pIndices;         // Built index data, awaiting upload
        
 };
 
@@ -204,12 +381,20 @@ public:
 	// Public Functions for This Class
 	//-------------------------------------------------------------------------
     UCHAR   GetFilteredAlpha( ULONG x, ULONG z );
+    bool    BuildCoverage   ( ULONG BlendTexRatio );
+
+    //-------------------------------------------------------------------------
+	// Public Static Functions for This Class
+	//-------------------------------------------------------------------------
+    static void BuildCoverage( UCHAR * pDest, ULONG DestPitch, const UCHAR * pSrc, ULONG SrcPitch,
+                               ULONG QuadsWide, ULONG QuadsHigh, ULONG BlendTexRatio );
 	
     //-------------------------------------------------------------------------
 	// Public Variables For This Class
 	//-------------------------------------------------------------------------
     D3DXMATRIX          m_mtxTexture;       // The texture matrix applied to this layer
     UCHAR              *m_pBlendMap;        // The blend map data for this layer
+    UCHAR              *m_pCoverage;        // Largest blend map value under each terrain quad
     ULONG               m_nLayerWidth;      // Width of the layer alpha map
     ULONG               m_nLayerHeight;     // Height of the layer alpha map
     short               m_nTextureIndex;    // Index of the texture to use
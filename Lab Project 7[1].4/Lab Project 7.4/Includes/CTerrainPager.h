@@ -0,0 +1,129 @@
+//-----------------------------------------------------------------------------
+// File: CTerrainPager.h
+//
+// Desc: Streams terrain blocks in and out of memory from a page file, so that
+//       terrains far larger than available memory can be rendered. Blocks
+//       around the viewer are read and built on background threads, uploaded
+//       a few at a time on the main thread, and evicted least recently used
+//       first once no longer required.
+//
+// Copyright (c) 1997-2002 Daedalus Developments. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CTERRAINPAGER_H_
+#define _CTERRAINPAGER_H_
+
+//-----------------------------------------------------------------------------
+// CTerrainPager Specific Includes
+//-----------------------------------------------------------------------------
+#include "Main.h"
+
+//-----------------------------------------------------------------------------
+// Forward Declarations
+//-----------------------------------------------------------------------------
+class CTerrain;
+class CTerrainBlock;
+
+//-----------------------------------------------------------------------------
+// Definitions, Macros & Constants
+//-----------------------------------------------------------------------------
+const ULONG PAGE_MAX_LOADERS = 8;       // Maximum number of background loader threads
+const ULONG PAGE_MAX_PENDING = 64;      // Most blocks which may be queued, loading or awaiting upload
+
+//-----------------------------------------------------------------------------
+// Callback Function Types
+//-----------------------------------------------------------------------------
+// Provides the source data for the heightmap rows [FirstRow, FirstRow + RowCount)
+// while the page file is written, returning a terrain holding those rows (and
+// any others) along with the heightmap row at which its data begins
+typedef CTerrain * (*PAGEBANDFUNC)( void * pContext, ULONG FirstRow, ULONG RowCount, ULONG & BandRow );
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CTerrainPager (Class)
+// Desc : Owns the page file and the background loader threads. The block grid
+//        of the terrain always exists, along with each block's bounds and
+//        level of detail errors, but only blocks near the viewer hold their
+//        vertex, splat and height data.
+// Note : Page file layout (all values little endian);
+//          PageFileHeader
+//          float Overview[(BlocksWide + 1) * (BlocksHigh + 1)]  - Height at each block corner
+//          PageFileTile  Tiles[BlocksWide * BlocksHigh]          - Bounds and errors of each block
+//          Tile data, TileSize bytes for each block, containing;
+//              float Heights[BlockWidth * BlockHeight]
+//              float NormalX/Y/Z[(BlockWidth + 1) * (BlockHeight + 1)] (each)
+//              UCHAR BlendMap[LayerCount][BlendWidth * BlendHeight]
+//        The header records a hash of the files the page file was built from,
+//        so Open can reject a page file that is out of date.
+//-----------------------------------------------------------------------------
+class CTerrainPager
+{
+public:
+    //-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+	         CTerrainPager();
+	virtual ~CTerrainPager();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+    bool            Open            ( CTerrain * pTerrain, LPCTSTR FileName, unsigned __int64 Hash, ULONG MaxResident, ULONG LoaderCount );
+    bool            InitBlocks      ( );
+    void            Close           ( );
+    void            Update          ( const D3DXVECTOR3 & Position, float Radius, ULONG MaxUploads );
+    float           GetOverviewHeight( float x, float z ) const;
+    bool            IsOpen          ( ) const { return m_hFile != INVALID_HANDLE_VALUE; }
+    ULONG           GetResidentCount( ) const { return m_nResidentCount; }
+
+    static bool     WritePageFile   ( CTerrain * pTerrain, LPCTSTR FileName, unsigned __int64 Hash, PAGEBANDFUNC pLoadBand, void * pContext );
+
+private:
+    //-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+    void            LoaderProc      ( );
+    bool            LoadBlock       ( ULONG Block, UCHAR * pTile, const UCHAR ** ppBlendMaps, UCHAR * pCoverage, const UCHAR ** ppCoverage );
+    void            RequestBlock    ( ULONG Block );
+    void            TouchBlock      ( CTerrainBlock * pBlock );
+    void            UnlinkBlock     ( CTerrainBlock * pBlock );
+
+    //-------------------------------------------------------------------------
+	// Private Static Functions For This Class
+	//-------------------------------------------------------------------------
+    static unsigned __stdcall StaticLoaderProc( void * pParam );
+
+    //-------------------------------------------------------------------------
+	// Private Variables for This Class
+	//-------------------------------------------------------------------------
+    CTerrain      * m_pTerrain;         // Terrain whose blocks are being paged
+    HANDLE          m_hFile;            // The open page file
+    ULONG           m_nTileSize;        // Size of each block's tile data, in bytes
+    __int64         m_nTileStart;       // File offset of the first tile
+    float         * m_pOverview;        // Height at every block corner (always resident)
+    ULONG           m_nOverviewWidth;   // Overview samples in each row
+    ULONG           m_nOverviewHeight;  // Overview rows
+    ULONG           m_nMaxResident;     // Most blocks which are kept resident
+
+    ULONG           m_nFrame;           // Incremented on each Update
+    ULONG           m_nResidentCount;   // Number of resident blocks
+    ULONG           m_nPendingCount;    // Blocks queued, loading or awaiting upload
+    CTerrainBlock * m_pLRUHead;         // Most recently used resident block
+    CTerrainBlock * m_pLRUTail;         // Least recently used resident block
+
+    HANDLE          m_hLoaders[PAGE_MAX_LOADERS]; // Loader thread handles
+    ULONG           m_nLoaderCount;     // Number of loader threads running
+    HANDLE          m_hRequest;         // Semaphore signalled once per queued block
+    CRITICAL_SECTION m_Lock;            // Guards the two queues below
+    ULONG           m_Requests[PAGE_MAX_PENDING]; // Blocks waiting to be loaded (ring buffer)
+    ULONG           m_nRequestHead;     // Next request to be taken by a loader
+    ULONG           m_nRequestCount;    // Number of requests waiting
+    ULONG           m_Completed[PAGE_MAX_PENDING]; // Blocks built and waiting for upload (ring buffer)
+    ULONG           m_nCompletedHead;   // Next block to be uploaded
+    ULONG           m_nCompletedCount;  // Number of blocks waiting for upload
+    volatile bool   m_bQuit;            // Loader threads should exit when woken
+};
+
+#endif // _CTERRAINPAGER_H_
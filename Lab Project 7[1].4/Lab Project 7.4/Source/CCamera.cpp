@@ -29,6 +29,8 @@ CCamera::CCamera()
     m_vecUp           = D3DXVECTOR3( 0.0f, 1.0f, 0.0f );
     m_vecLook         = D3DXVECTOR3( 0.0f, 0.0f, 1.0f );
     m_vecPos          = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+    m_vecPrevPos      = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+    m_fInterpolation  = 1.0f;
 
     m_fFOV            = 60.0f;
     m_fNearClip       = 1.0f;
@@ -63,6 +65,8 @@ CCamera::CCamera( const CCamera * pCamera )
     m_vecUp          = D3DXVECTOR3( 0.0f, 1.0f, 0.0f );
     m_vecLook        = D3DXVECTOR3( 0.0f, 0.0f, 1.0f );
     m_vecPos         = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+    m_vecPrevPos     = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+    m_fInterpolation = 1.0f;
 
     m_fFOV            = 60.0f;
     m_fNearClip       = 1.0f;
@@ -164,12 +168,16 @@ const D3DXMATRIX& CCamera::GetProjMatrix()
 //-----------------------------------------------------------------------------
 // Name : GetViewMatrix ()
 // Desc : Return the current view matrix.
+// Note : The view is built from the render position, interpolated between the
+//        last two simulation steps (see SetInterpolation).
 //-----------------------------------------------------------------------------
 const D3DXMATRIX& CCamera::GetViewMatrix()
 {
     // Only update matrix if something has changed
     if ( m_bViewDirty ) 
     {
+        D3DXVECTOR3 vecPos = GetRenderPosition();
+
         // Because many rotations will cause floating point errors, the axis will eventually become
         // non-perpendicular to one other causing all hell to break loose. Therefore, we must
         // perform base vector regeneration to ensure that all vectors remain unit length and
@@ -185,9 +193,9 @@ const D3DXMATRIX& CCamera::GetViewMatrix()
         m_mtxView._11 = m_vecRight.x; m_mtxView._12 = m_vecUp.x; m_mtxView._13 = m_vecLook.x;
 	    m_mtxView._21 = m_vecRight.y; m_mtxView._22 = m_vecUp.y; m_mtxView._23 = m_vecLook.y;
 	    m_mtxView._31 = m_vecRight.z; m_mtxView._32 = m_vecUp.z; m_mtxView._33 = m_vecLook.z;
-	    m_mtxView._41 =- D3DXVec3Dot( &m_vecPos, &m_vecRight );
-	    m_mtxView._42 =- D3DXVec3Dot( &m_vecPos, &m_vecUp    );
-	    m_mtxView._43 =- D3DXVec3Dot( &m_vecPos, &m_vecLook  );
+	    m_mtxView._41 =- D3DXVec3Dot( &vecPos, &m_vecRight );
+	    m_mtxView._42 =- D3DXVec3Dot( &vecPos, &m_vecUp    );
+	    m_mtxView._43 =- D3DXVec3Dot( &vecPos, &m_vecLook  );
 
         // View Matrix has been updated
         m_bViewDirty = false;
@@ -279,6 +287,49 @@ void CCamera::CalcFrustumPlanes()
     m_bFrustumDirty = false;
 }
 
+//-----------------------------------------------------------------------------
+// Name : BoundsInFrustum () (Overload)
+// Desc : Determine whether or not the box passed is within the frustum,
+//        testing only the planes whose bits are set in 'PlaneMask'. On return
+//        the bit for each plane which the box lies entirely inside has been
+//        cleared, so a mask of zero means the box is wholly within the
+//        frustum. Boxes contained by this one need only test the planes left.
+//-----------------------------------------------------------------------------
+bool CCamera::BoundsInFrustum( const D3DXVECTOR3 & Min, const D3DXVECTOR3 & Max, ULONG & PlaneMask )
+{
+    ULONG       i;
+    float       Distance, Radius;
+    D3DXVECTOR3 Centre, Extents;
+
+    // First calculate the frustum planes
+    CalcFrustumPlanes();
+
+    // Box centre and half size
+    Centre  = (Min + Max) * 0.5f;
+    Extents = (Max - Min) * 0.5f;
+
+    // Loop through the planes still to be tested
+    for ( i = 0; i < 6; i++ )
+    {
+        if ( !(PlaneMask & (1 << i)) ) continue;
+
+        // Signed distance from the centre, and the box's projected radius
+        const D3DXPLANE & Plane = m_Frustum[i];
+        Distance = Plane.a * Centre.x + Plane.b * Centre.y + Plane.c * Centre.z + Plane.d;
+        Radius   = fabsf( Plane.a ) * Extents.x + fabsf( Plane.b ) * Extents.y + fabsf( Plane.c ) * Extents.z;
+
+        // Wholly outside this plane ?
+        if ( Distance - Radius > 0.0f ) return false;
+
+        // Wholly inside, no need to test this plane again
+        if ( Distance + Radius <= 0.0f ) PlaneMask &= ~(1 << i);
+
+    } // Next Plane
+
+    // Is (at least partially) within the frustum
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 // Name : BoundsInFrustum ()
 // Desc : Determine whether or not the box passed is within the frustum.
@@ -11,6 +11,7 @@
 //-----------------------------------------------------------------------------
 #include "..\\Includes\\CGameApp.h"
 #include "..\\Includes\\CCamera.h"
+#include "..\\Includes\\CProfiler.h"
 
 //-----------------------------------------------------------------------------
 // CGameApp Member Functions
@@ -29,6 +30,8 @@ CGameApp::CGameApp()
     m_hMenu         = NULL;
     m_bLostDevice   = false;
     m_LastFrameRate = 0;
+    m_fSimAccumulator = 0.0f;
+    m_nMoveDirection  = 0;
     
     // Set up initial states (these will be adjusted later if not supported)
     m_FillMode      = D3DFILL_SOLID;
@@ -209,6 +212,10 @@ void CGameApp::SetupGameState()
     // Lets give a small initial rotation and set initial position
     m_Player.SetPosition( D3DXVECTOR3( 5433.0f, 400.0f, 8067.0f) );
     m_Player.Rotate( -10, 135, 0 );
+
+    // Start the simulation from here (nothing to interpolate from yet)
+    m_Player.StoreState();
+    m_fSimAccumulator = 0.0f;
 }
 
 //-----------------------------------------------------------------------------
@@ -571,11 +578,15 @@ int CGameApp::BeginGame()
         {
 			// Advance Game Frame.
 			FrameAdvance();
+            PROFILE_END_FRAME();
 
 		} // End If messages waiting
 	
     } // Until quit message is receieved
 
+    // Write out the profile trace (profiling builds only)
+    PROFILE_WRITE_TRACE( _T("Profile.json") );
+
     return 0;
 }
 
@@ -1110,7 +1121,8 @@ void CGameApp::ReleaseObjects( )
 void CGameApp::FrameAdvance()
 {
     static TCHAR FrameRate[ 50 ];
-    static TCHAR TitleBuffer[ 255 ];
+    static TCHAR TitleBuffer[ 1024 ];
+    PROFILE_ZONE( "CGameApp::FrameAdvance" );
 
     // Advance the timer
     m_Timer.Tick( );
@@ -1123,6 +1135,17 @@ void CGameApp::FrameAdvance()
     {
         m_LastFrameRate = m_Timer.GetFrameRate( FrameRate );
         _stprintf( TitleBuffer, _T("Terrain Alpha : %s"), FrameRate );
+
+#ifdef PROFILER_ENABLED
+        // Append the average time spent in each zone per frame
+        for ( ULONG i = 0; i < CProfiler::GetZoneCount() && _tcslen( TitleBuffer ) < 900; i++ )
+        {
+            _stprintf( TitleBuffer + _tcslen( TitleBuffer ), _T(" | %hs %.2fms"),
+                       CProfiler::GetZoneName( i ), CProfiler::GetZoneAverage( i ) );
+
+        } // Next Zone
+#endif
+
         SetWindowText( m_hWnd, TitleBuffer );
 
     } // End if Frame Rate Altered
@@ -1152,6 +1175,13 @@ void CGameApp::FrameAdvance()
     // Poll & Process input devices
     ProcessInput();
 
+    // Step the simulation to catch up with the real time elapsed (the averaged
+    // value would lose or invent time whenever the frame rate changed)
+    AdvanceSimulation( m_Timer.GetRawTimeElapsed() );
+
+    // Update the device matrix
+    m_pCamera->UpdateRenderView( m_pD3DDevice );
+
     // Animate the game objects
     AnimateObjects();
 
@@ -1177,13 +1207,18 @@ void CGameApp::FrameAdvance()
     m_pD3DDevice->EndScene();
     
     // Present the buffer
-    if ( FAILED(m_pD3DDevice->Present( NULL, NULL, NULL, NULL )) ) m_bLostDevice = true;
+    {
+        PROFILE_ZONE( "Present" );
+        if ( FAILED(m_pD3DDevice->Present( NULL, NULL, NULL, NULL )) ) m_bLostDevice = true;
+    }
 
 }
 
 //-----------------------------------------------------------------------------
 // Name : ProcessInput () (Private)
 // Desc : Simply polls the input devices and performs basic input operations
+// Note : Rotation is applied immediately, movement is stored for the next
+//        simulation steps (see AdvanceSimulation).
 //-----------------------------------------------------------------------------
 void CGameApp::ProcessInput( )
 {
@@ -1191,6 +1226,7 @@ void CGameApp::ProcessInput( )
     ULONG        Direction = 0;
     POINT        CursorPos;
     float        X = 0.0f, Y = 0.0f;
+    PROFILE_ZONE( "CGameApp::ProcessInput" );
 
     // Retrieve keyboard state
     if ( !GetKeyboardState( pKeyBuffer ) ) return;
@@ -1221,36 +1257,58 @@ void CGameApp::ProcessInput( )
 
     } // End if Captured
 
-    // Update if we have moved
-    if ( Direction > 0 || X != 0.0f || Y != 0.0f )
+    // Rotate our camera
+    if ( X || Y ) 
     {
-        // Rotate our camera
-        if ( X || Y ) 
-        {
-            // Are they holding the right mouse button ?
-            if ( pKeyBuffer[ VK_RBUTTON ] & 0xF0 )
-                m_Player.Rotate( Y, 0.0f, -X );
-            else
-                m_Player.Rotate( Y, X, 0.0f );
-        
-        } // End if any rotation
+        // Are they holding the right mouse button ?
+        if ( pKeyBuffer[ VK_RBUTTON ] & 0xF0 )
+            m_Player.Rotate( Y, 0.0f, -X );
+        else
+            m_Player.Rotate( Y, X, 0.0f );
+    
+    } // End if any rotation
 
-        // Any Movement ?
-        if ( Direction ) 
-        {
-            // Move our player (Force applied must be greater than total friction)
-            m_Player.Move( Direction, 500.0f * m_Timer.GetTimeElapsed(), true );
+    // Store the movement for the simulation
+    m_nMoveDirection = Direction;
 
-        } // End if any movement
+}
 
-    } // End if camera moved
+//-----------------------------------------------------------------------------
+// Name : AdvanceSimulation () (Private)
+// Desc : Runs as many fixed length simulation steps as the time elapsed (plus
+//        any left over from previous frames) allows, then tells the player
+//        how far between the last two steps it should be rendered.
+// Note : The number of steps per frame is capped, so a long stall (a window
+//        drag for instance) drops time rather than spiralling.
+//-----------------------------------------------------------------------------
+void CGameApp::AdvanceSimulation( float TimeElapsed )
+{
+    ULONG Steps = 0;
+    PROFILE_ZONE( "CGameApp::AdvanceSimulation" );
 
-    // Update our camera (updates velocity etc)
-    m_Player.Update( m_Timer.GetTimeElapsed() );
+    // Accumulate the time elapsed
+    m_fSimAccumulator += TimeElapsed;
+    if ( m_fSimAccumulator > SIMULATION_STEP * SIMULATION_MAX_STEPS ) m_fSimAccumulator = SIMULATION_STEP * SIMULATION_MAX_STEPS;
 
-    // Update the device matrix
-    m_pCamera->UpdateRenderView( m_pD3DDevice );
+    // Consume it a step at a time
+    while ( m_fSimAccumulator >= SIMULATION_STEP && Steps < SIMULATION_MAX_STEPS )
+    {
+        // The state we are leaving becomes the one to interpolate from
+        m_Player.StoreState();
+
+        // Move our player (Force applied must be greater than total friction)
+        if ( m_nMoveDirection ) m_Player.Move( m_nMoveDirection, 500.0f * SIMULATION_STEP, true );
+
+        // Update our player (updates velocity etc)
+        m_Player.Update( SIMULATION_STEP );
+
+        m_fSimAccumulator -= SIMULATION_STEP;
+        Steps++;
 
+    } // Next Step
+
+    // Render the remaining fraction of the way towards the latest step
+    m_Player.SetInterpolation( m_fSimAccumulator / SIMULATION_STEP );
 }
 
 //-----------------------------------------------------------------------------
@@ -1259,6 +1317,8 @@ void CGameApp::ProcessInput( )
 //-----------------------------------------------------------------------------
 void CGameApp::AnimateObjects()
 {
+    PROFILE_ZONE( "CGameApp::AnimateObjects" );
+
     // No objects to animate in this demonstration
 }
 
@@ -1356,6 +1416,7 @@ bool CGameApp::BuildSkyBox()
 //-----------------------------------------------------------------------------
 void CGameApp::RenderSkyBox( )
 {
+    PROFILE_ZONE( "CGameApp::RenderSkyBox" );
     D3DXMATRIX mtxWorld;
     D3DXMatrixIdentity( &mtxWorld );
 
@@ -1363,7 +1424,7 @@ void CGameApp::RenderSkyBox( )
     if ( !m_pCamera || !m_pD3DDevice ) return;
     
     // Generate our sky box rendering origin and set as world matrix
-    D3DXVECTOR3 CamPos = m_pCamera->GetPosition();
+    D3DXVECTOR3 CamPos = m_pCamera->GetRenderPosition();
     D3DXMatrixTranslation( &mtxWorld, CamPos.x, CamPos.y + 1.3f, CamPos.z );
     m_pD3DDevice->SetTransform( D3DTS_WORLD, &mtxWorld );
 
@@ -1431,6 +1492,9 @@ bool CMyD3DInit::ValidateDevice( const D3DDEVTYPE &Type, const D3DCAPS9 &Caps )
     // Must support 'SelectArg1' texture op.
     if ( !(Caps.TextureOpCaps & D3DTEXOPCAPS_SELECTARG1 ) ) return false;
 
+    // Must support 'DotProduct3' texture op (selects the terrain blend map channels).
+    if ( !(Caps.TextureOpCaps & D3DTEXOPCAPS_DOTPRODUCT3 ) ) return false;
+
     // Supported
     return true;
 }
@@ -13,6 +13,7 @@
 #include "..\\Includes\\CPlayer.h"
 #include "..\\Includes\\CCamera.h"
 #include "..\\Includes\\CObject.h"
+#include "..\\Includes\\CProfiler.h"
 
 //-----------------------------------------------------------------------------
 // Name : CPlayer () (Constructor)
@@ -32,6 +33,8 @@ CPlayer::CPlayer()
     m_vecRight           = D3DXVECTOR3( 1.0f, 0.0f, 0.0f );
     m_vecUp              = D3DXVECTOR3( 0.0f, 1.0f, 0.0f );
     m_vecLook            = D3DXVECTOR3( 0.0f, 0.0f, 1.0f );
+    m_vecPrevPos         = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+    m_fInterpolation     = 1.0f;
 
     // Camera offset values (from the players origin)
     m_vecCamOffset       = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
@@ -129,6 +132,7 @@ void CPlayer::SetCamOffset( const D3DXVECTOR3& Offset )
 void CPlayer::Update( float TimeScale )
 {
     ULONG i;
+    PROFILE_ZONE( "CPlayer::Update" );
 
     // Add on our gravity vector
     m_vecVelocity += m_vecGravity * TimeScale;
@@ -209,6 +213,31 @@ void CPlayer::Update( float TimeScale )
 
 }
 
+//-----------------------------------------------------------------------------
+// Name : StoreState ()
+// Desc : Store the current player (and camera) position as the previous
+//        state. Called prior to each fixed simulation step so that rendering
+//        can later interpolate between the last two steps.
+//-----------------------------------------------------------------------------
+void CPlayer::StoreState( )
+{
+    m_vecPrevPos = m_vecPos;
+    if ( m_pCamera ) m_pCamera->StoreState();
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetInterpolation ()
+// Desc : Set how far between the previous and current simulation steps the
+//        player and camera should be rendered (0 = previous, 1 = current).
+// Note : Only positions are interpolated, orientation is driven directly by
+//        input each frame and is always rendered as is.
+//-----------------------------------------------------------------------------
+void CPlayer::SetInterpolation( float Alpha )
+{
+    m_fInterpolation = Alpha;
+    if ( m_pCamera ) m_pCamera->SetInterpolation( Alpha );
+}
+
 //-----------------------------------------------------------------------------
 // Name : SetCameraMode ()
 // Desc : Sets the camera type we are using to view the player.
@@ -278,6 +307,10 @@ bool CPlayer::SetCameraMode( ULONG Mode )
     // Attach the new camera to 'this' player object
     pNewCamera->AttachToPlayer( this );
 
+    // Don't interpolate from wherever the old camera happened to be
+    pNewCamera->StoreState();
+    pNewCamera->SetInterpolation( m_fInterpolation );
+
     // Destroy our old camera and replace with our new one
     if ( m_pCamera ) delete m_pCamera;
     m_pCamera = pNewCamera;
@@ -293,10 +326,15 @@ bool CPlayer::SetCameraMode( ULONG Mode )
 void CPlayer::Rotate( float x, float y, float z )
 {
     D3DXMATRIX mtxRotate;
+    D3DXVECTOR3 vecCamPos;
 
     // Validate requirements
     if (!m_pCamera) return;
 
+    // Rotations may swing the camera about the player, record its position so
+    // that we can apply the same shift to the state we are interpolating from
+    vecCamPos = m_pCamera->GetPosition();
+
     // Are we in FPS mode ?
     if ( m_CameraMode == CCamera::MODE_FPS || m_CameraMode == CCamera::MODE_THIRDPERSON )
     {
@@ -392,6 +430,9 @@ void CPlayer::Rotate( float x, float y, float z )
     D3DXVec3Cross( &m_vecUp, &m_vecLook, &m_vecRight );
     D3DXVec3Normalize( &m_vecUp, &m_vecUp );
 
+    // Shift the previous camera state by the same amount
+    m_pCamera->OffsetState( m_pCamera->GetPosition() - vecCamPos );
+
 }
 
 //-----------------------------------------------------------------------------
@@ -505,6 +546,7 @@ void CPlayer::RemoveCameraCallback( UPDATECAMERA pFunc, LPVOID pContext )
 void CPlayer::Render( LPDIRECT3DDEVICE9 pDevice )
 {
     CObject * pObject = NULL;
+    PROFILE_ZONE( "CPlayer::Render" );
 
     // Validate Parameters
     if (!pDevice) return;
@@ -531,9 +573,10 @@ void CPlayer::Render( LPDIRECT3DDEVICE9 pDevice )
 	pMatrix->_12 = m_vecRight.y; pMatrix->_22 = m_vecUp.y; pMatrix->_32 = m_vecLook.y;
 	pMatrix->_13 = m_vecRight.z; pMatrix->_23 = m_vecUp.z; pMatrix->_33 = m_vecLook.z;
 
-    pMatrix->_41 = m_vecPos.x;
-    pMatrix->_42 = m_vecPos.y - 10.0f;
-    pMatrix->_43 = m_vecPos.z;
+    D3DXVECTOR3 vecPos = GetRenderPosition();
+    pMatrix->_41 = vecPos.x;
+    pMatrix->_42 = vecPos.y - 10.0f;
+    pMatrix->_43 = vecPos.z;
 
     // Render our player mesh object
     CMesh * pMesh = pObject->m_pMesh;
@@ -0,0 +1,334 @@
+//-----------------------------------------------------------------------------
+// File: CProfiler.cpp
+//
+// Desc: Lightweight scoped profiler. Zones placed with PROFILE_ZONE are timed
+//       into per-thread event buffers, averaged over recent frames, and can be
+//       written out as a Chrome 'about:tracing' / Perfetto JSON trace.
+//
+// Copyright (c) 1997-2002 Adam Hoult & Gary Simmons. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CProfiler Specific Includes
+//-----------------------------------------------------------------------------
+#include "..\\Includes\\CProfiler.h"
+
+#ifdef PROFILER_ENABLED
+
+//-----------------------------------------------------------------------------
+// Module Local Structures
+//-----------------------------------------------------------------------------
+namespace
+{
+    // A single completed zone
+    struct ProfileEvent
+    {
+        ULONG           Zone;                   // Zone index
+        __int64         Start;                  // Counter value on entry
+        __int64         End;                    // Counter value on exit
+    };
+
+    // Everything recorded by one thread. Only the owning thread writes the
+    // event ring and zone totals, the 'Last' arrays belong to EndFrame.
+    struct ThreadBuffer
+    {
+        DWORD           ThreadID;                       // Thread which owns this buffer
+        ProfileEvent  * pEvents;                        // Ring of the most recent events
+        volatile ULONG  EventCount;                     // Total events written (wraps)
+        volatile ULONG  ZoneTicks[PROFILE_MAX_ZONES];   // Running counter ticks per zone (wraps)
+        volatile ULONG  ZoneCalls[PROFILE_MAX_ZONES];   // Running call count per zone (wraps)
+        ULONG           LastTicks[PROFILE_MAX_ZONES];   // Totals seen by the previous EndFrame
+        ULONG           LastCalls[PROFILE_MAX_ZONES];
+    };
+
+    // Registered zone details, and its recent per frame history
+    struct ZoneData
+    {
+        const char    * strName;                        // Name shown in reports and traces
+        float           Time[PROFILE_HISTORY];          // Milliseconds spent in the zone per frame
+        ULONG           Calls[PROFILE_HISTORY];         // Calls made per frame
+        double          TimeSum;                        // Running sums of the above
+        ULONG           CallSum;
+    };
+
+    ThreadBuffer      * g_pThreads[PROFILE_MAX_THREADS];    // Buffers of every recording thread
+    LONG                g_nThreadCount  = 0;                // Number of slots claimed in the above
+    ZoneData            g_Zones[PROFILE_MAX_ZONES];         // Registered zones
+    volatile LONG       g_nZoneCount    = 0;                // Number of registered zones
+    LONG                g_ZoneLock      = 0;                // Guards zone registration
+    ULONG               g_nHistoryIndex = 0;                // Frame history slot to be written next
+    ULONG               g_nHistoryCount = 0;                // Number of frames in the history
+    __int64             g_BaseTime      = 0;                // Counter value trace times are relative to
+    double              g_fTickScale    = 0.0;              // Milliseconds per counter tick
+    DWORD               g_nMainThreadID = 0;                // Thread which calls EndFrame
+
+    __declspec(thread) ThreadBuffer * t_pBuffer = NULL;    // This thread's buffer, created on first use
+    __declspec(thread) bool           t_bNoBuffer = false; // No buffer could be created for this thread
+};
+
+//-----------------------------------------------------------------------------
+// Module Local Functions
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CreateThreadBuffer () (Module Local)
+// Desc : Allocates the calling thread's event buffer, and publishes it in the
+//        first free thread slot. Returns NULL if every slot is taken.
+// Note : Only one attempt is made by each thread. After a failure the thread
+//        simply records nothing, rather than claiming further slots.
+//-----------------------------------------------------------------------------
+static ThreadBuffer * CreateThreadBuffer( )
+{
+    ThreadBuffer * pBuffer;
+    LONG           Slot;
+
+    // Never try again once this thread has failed
+    if ( t_bNoBuffer ) return NULL;
+    t_bNoBuffer = true;
+
+    // Claim a slot
+    Slot = InterlockedIncrement( &g_nThreadCount ) - 1;
+    if ( Slot >= (LONG)PROFILE_MAX_THREADS ) return NULL;
+
+    // Allocate the buffer and its event ring
+    pBuffer = new ThreadBuffer;
+    if ( !pBuffer ) return NULL;
+    ZeroMemory( pBuffer, sizeof(ThreadBuffer) );
+    pBuffer->pEvents = new ProfileEvent[ PROFILE_EVENT_COUNT ];
+    if ( !pBuffer->pEvents ) { delete pBuffer; return NULL; }
+    pBuffer->ThreadID = GetCurrentThreadId();
+
+    // Publish it
+    g_pThreads[ Slot ] = pBuffer;
+    t_pBuffer          = pBuffer;
+    t_bNoBuffer        = false;
+    return pBuffer;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetThreadCount () (Module Local)
+// Desc : Returns the number of thread slots which may hold a buffer.
+//-----------------------------------------------------------------------------
+static inline ULONG GetThreadCount( )
+{
+    return min( (ULONG)g_nThreadCount, PROFILE_MAX_THREADS );
+}
+
+//-----------------------------------------------------------------------------
+// CProfiler Member Functions
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : RegisterZone () (Static)
+// Desc : Returns the index of the zone with the name specified, registering
+//        it first if required.
+// Note : The name must remain valid for the life of the application, and
+//        must not contain quotes or backslashes (it is written to the trace
+//        as is). Returns PROFILE_MAX_ZONES, which is never recorded, if too
+//        many zones have been registered.
+//-----------------------------------------------------------------------------
+ULONG CProfiler::RegisterZone( const char * strName )
+{
+    __int64 Frequency;
+    ULONG   Zone;
+
+    // Take the registration lock
+    while ( InterlockedExchange( &g_ZoneLock, 1 ) != 0 ) Sleep( 0 );
+
+    // Set up timing on first use
+    if ( g_fTickScale == 0.0 )
+    {
+        QueryPerformanceFrequency( (LARGE_INTEGER*)&Frequency );
+        g_fTickScale = 1000.0 / (double)Frequency;
+        g_BaseTime   = GetCounter();
+
+    } // End if first zone
+
+    // Has it already been registered?
+    for ( Zone = 0; Zone < (ULONG)g_nZoneCount; Zone++ )
+    {
+        if ( strcmp( g_Zones[ Zone ].strName, strName ) == 0 ) break;
+
+    } // Next Zone
+
+    // Add a new zone (published only once it is initialized)
+    if ( Zone == (ULONG)g_nZoneCount && Zone < PROFILE_MAX_ZONES )
+    {
+        ZeroMemory( &g_Zones[ Zone ], sizeof(ZoneData) );
+        g_Zones[ Zone ].strName = strName;
+        g_nZoneCount++;
+
+    } // End if new zone
+
+    // Release the lock
+    InterlockedExchange( &g_ZoneLock, 0 );
+    return Zone;
+}
+
+//-----------------------------------------------------------------------------
+// Name : RecordZone () (Static)
+// Desc : Appends a completed zone to the calling thread's buffer.
+//-----------------------------------------------------------------------------
+void CProfiler::RecordZone( ULONG Zone, __int64 Start, __int64 End )
+{
+    ThreadBuffer * pBuffer = t_pBuffer;
+
+    // Validate, and create this thread's buffer if it has none yet
+    if ( Zone >= PROFILE_MAX_ZONES ) return;
+    if ( !pBuffer && !(pBuffer = CreateThreadBuffer()) ) return;
+
+    // Overwrite the oldest event
+    ProfileEvent & Event = pBuffer->pEvents[ pBuffer->EventCount & (PROFILE_EVENT_COUNT - 1) ];
+    Event.Zone  = Zone;
+    Event.Start = Start;
+    Event.End   = End;
+    pBuffer->EventCount++;
+
+    // Add to the zone totals
+    pBuffer->ZoneTicks[ Zone ] += (ULONG)(End - Start);
+    pBuffer->ZoneCalls[ Zone ]++;
+}
+
+//-----------------------------------------------------------------------------
+// Name : EndFrame () (Static)
+// Desc : Collects the time spent in each zone, by every thread, since the
+//        previous call and adds it to the zone's rolling history.
+// Note : Call once per frame, from the main thread.
+//-----------------------------------------------------------------------------
+void CProfiler::EndFrame( )
+{
+    ULONG Zone, Thread, Ticks, Calls, Total;
+
+    // Remember which thread is the main thread (named as such in the trace)
+    g_nMainThreadID = GetCurrentThreadId();
+
+    for ( Zone = 0; Zone < (ULONG)g_nZoneCount; Zone++ )
+    {
+        ZoneData & Data = g_Zones[ Zone ];
+
+        // Sum the growth of each thread's running totals (wrapping is harmless)
+        Ticks = 0; Calls = 0;
+        for ( Thread = 0; Thread < GetThreadCount(); Thread++ )
+        {
+            ThreadBuffer * pBuffer = g_pThreads[ Thread ];
+            if ( !pBuffer ) continue;
+
+            Total  = pBuffer->ZoneTicks[ Zone ];
+            Ticks += Total - pBuffer->LastTicks[ Zone ];
+            pBuffer->LastTicks[ Zone ] = Total;
+
+            Total  = pBuffer->ZoneCalls[ Zone ];
+            Calls += Total - pBuffer->LastCalls[ Zone ];
+            pBuffer->LastCalls[ Zone ] = Total;
+
+        } // Next Thread
+
+        // Replace the oldest frame in the history, keeping the sums up to date
+        Data.TimeSum -= Data.Time[ g_nHistoryIndex ];
+        Data.CallSum -= Data.Calls[ g_nHistoryIndex ];
+        Data.Time [ g_nHistoryIndex ] = (float)(Ticks * g_fTickScale);
+        Data.Calls[ g_nHistoryIndex ] = Calls;
+        Data.TimeSum += Data.Time[ g_nHistoryIndex ];
+        Data.CallSum += Calls;
+
+    } // Next Zone
+
+    // Move on to the next history slot
+    g_nHistoryIndex = (g_nHistoryIndex + 1) % PROFILE_HISTORY;
+    if ( g_nHistoryCount < PROFILE_HISTORY ) g_nHistoryCount++;
+}
+
+//-----------------------------------------------------------------------------
+// Name : WriteTrace () (Static)
+// Desc : Writes every thread's retained events to the file specified, in the
+//        Chrome trace event JSON format (load it via 'about:tracing' or at
+//        ui.perfetto.dev).
+// Note : Events still being written by other threads may be missed, so this
+//        is best called once the application has gone idle (at shut down).
+//-----------------------------------------------------------------------------
+bool CProfiler::WriteTrace( LPCTSTR strFileName )
+{
+    FILE  * pFile;
+    ULONG   Thread, Count, First, i;
+    double  Scale = g_fTickScale * 1000.0;
+    bool    bFirst = true;
+    DWORD   MainThreadID = g_nMainThreadID ? g_nMainThreadID : GetCurrentThreadId();
+
+    // Open the file
+    pFile = _tfopen( strFileName, _T("w") );
+    if ( !pFile ) return false;
+
+    fprintf( pFile, "{\n\"displayTimeUnit\" : \"ms\",\n\"traceEvents\" : [\n" );
+
+    for ( Thread = 0; Thread < GetThreadCount(); Thread++ )
+    {
+        ThreadBuffer * pBuffer = g_pThreads[ Thread ];
+        if ( !pBuffer ) continue;
+
+        // Name the thread's track
+        fprintf( pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s %lu\"}}",
+                 bFirst ? "" : ",\n", (unsigned long)pBuffer->ThreadID, pBuffer->ThreadID == MainThreadID ? "Main" : "Worker",
+                 (unsigned long)Thread );
+        bFirst = false;
+
+        // Write out the retained events, oldest first ('ts' / 'dur' are microseconds)
+        Count = min( (ULONG)pBuffer->EventCount, PROFILE_EVENT_COUNT );
+        First = pBuffer->EventCount - Count;
+        for ( i = 0; i < Count; i++ )
+        {
+            const ProfileEvent & Event = pBuffer->pEvents[ (First + i) & (PROFILE_EVENT_COUNT - 1) ];
+
+            fprintf( pFile, ",\n{\"name\":\"%s\",\"cat\":\"zone\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu}",
+                     g_Zones[ Event.Zone ].strName, (Event.Start - g_BaseTime) * Scale,
+                     (Event.End - Event.Start) * Scale, (unsigned long)pBuffer->ThreadID );
+
+        } // Next Event
+
+    } // Next Thread
+
+    fprintf( pFile, "\n]\n}\n" );
+
+    // Success!
+    fclose( pFile );
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetZoneCount () (Static)
+// Desc : Returns the number of zones registered so far.
+//-----------------------------------------------------------------------------
+ULONG CProfiler::GetZoneCount( )
+{
+    return (ULONG)g_nZoneCount;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetZoneName () (Static)
+// Desc : Returns the name of the zone specified.
+//-----------------------------------------------------------------------------
+const char * CProfiler::GetZoneName( ULONG Zone )
+{
+    return ( Zone < (ULONG)g_nZoneCount ) ? g_Zones[ Zone ].strName : "";
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetZoneAverage () (Static)
+// Desc : Returns the average time spent in the zone each frame, over the
+//        last PROFILE_HISTORY frames (Milliseconds, summed over all threads).
+//-----------------------------------------------------------------------------
+float CProfiler::GetZoneAverage( ULONG Zone )
+{
+    if ( Zone >= (ULONG)g_nZoneCount || g_nHistoryCount == 0 ) return 0.0f;
+    return (float)(g_Zones[ Zone ].TimeSum / g_nHistoryCount);
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetZoneCalls () (Static)
+// Desc : Returns the average number of times the zone was entered each frame,
+//        over the last PROFILE_HISTORY frames.
+//-----------------------------------------------------------------------------
+float CProfiler::GetZoneCalls( ULONG Zone )
+{
+    if ( Zone >= (ULONG)g_nZoneCount || g_nHistoryCount == 0 ) return 0.0f;
+    return (float)g_Zones[ Zone ].CallSum / g_nHistoryCount;
+}
+
+#endif // PROFILER_ENABLED
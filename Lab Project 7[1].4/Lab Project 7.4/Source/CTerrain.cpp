@@ -15,15 +15,533 @@
 #include "..\\Includes\\CPlayer.h"
 #include "..\\Includes\\CCamera.h"
 #include "..\\Includes\\CGameApp.h"
+#include "..\\Includes\\CProfiler.h"
+#include <emmintrin.h>
 
 //-----------------------------------------------------------------------------
 // Modulate Local Constants
 //-----------------------------------------------------------------------------
 namespace
 {
-    const char DataPath[] = "Data\\";               // The path to the data files.
+    const char  DataPath[]        = "Data\\";       // The path to the data files.
+    const ULONG FILTER_MAX_RADIUS = 32;             // Largest heightmap filter radius supported
+    const ULONG FILTER_JOB_ROWS   = 16;             // Heightmap rows filtered by each thread pool job
+    const ULONG COVERAGE_MAX_ROW  = 4096;           // Blend texels combined at once when building coverage maps
+    const ULONG HASH_CHUNK_SIZE   = 65536;          // Bytes read at a time when hashing an input file
+
+    // Block edges which can be stitched to a coarser neighbour, and the
+    // m_pNeighbours entry lying across each of them
+    const USHORT LOD_EDGE_NEGZ    = 1;
+    const USHORT LOD_EDGE_POSX    = 2;
+    const USHORT LOD_EDGE_POSZ    = 4;
+    const USHORT LOD_EDGE_NEGX    = 8;
+    const USHORT LOD_EDGE_FLAG[4]      = { LOD_EDGE_NEGZ, LOD_EDGE_POSX, LOD_EDGE_POSZ, LOD_EDGE_NEGX };
+    const ULONG  LOD_EDGE_NEIGHBOUR[4] = { 1, 5, 7, 3 };
+
+    // Cooked terrain file identification
+    const ULONG COOKED_MAGIC      = 0x4B435254;     // 'TRCK'
+    const ULONG COOKED_VERSION    = 5;              // Increment whenever the layout or build output changes
+
+    // Stored at the start of the cooked terrain file. The cooked data is only
+    // used when 'Hash' matches the hash of the current input files.
+    struct CookedHeader
+    {
+        ULONG               Magic;          // COOKED_MAGIC
+        ULONG               Version;        // COOKED_VERSION
+        unsigned __int64    Hash;           // Hash of the input files (see HashTerrainInputs)
+        ULONG               FileSize;       // Total size of the file, in bytes
+        ULONG               TerrainWidth;   // Heightmap samples in each row
+        ULONG               TerrainHeight;  // Heightmap rows
+        ULONG               BlockWidth;     // Samples along each side of a block
+        ULONG               BlockHeight;
+        ULONG               BlockCount;     // Number of CookedBlock records
+        ULONG               LayerCount;     // Splat levels stored with each block
+        ULONG               VertexSize;     // sizeof(CVertex) when written
+    };
+
+    // Stored for each block, followed by its layer usage (padded to four bytes),
+    // its vertices, its packed blend texels, and a CookedSplat for each layer
+    struct CookedBlock
+    {
+        D3DXVECTOR3         BoundsMin;                  // Bounding box minimum extents
+        D3DXVECTOR3         BoundsMax;                  // Bounding box maximum extents
+        float               LODError[TERRAIN_MAX_LOD];  // World space error at each detail level
+        ULONG               BlendTexels;                // Number of packed blend texels (all layer groups), zero if none
+    };
+
+    // Stored for each splat level, followed by its indices (padded to four bytes)
+    struct CookedSplat
+    {
+        ULONG               Present;        // Zero if the block does not use this layer
+        ULONG               IndexCount;     // Number of indices
+        ULONG               PrimitiveCount; // Number of triangles
+    };
+
+    // Texture factor used to select each colour channel of a packed blend
+    // texture with the DOTPRODUCT3 texture operation (see PackBlendRow). The
+    // two unselected channels use 0x80 and 0x7F, whose small offsets either
+    // side of 0.5 cancel, rather than both leaking the other layers' weights.
+    const D3DCOLOR BLEND_CHANNEL_MASK[3] = { 0xFFFF807F, 0xFF7FFF80, 0xFF807FFF };
+
+    // Details of the block build being run by the thread pool
+    struct BlockBuildPass
+    {
+        CTerrain      * pTerrain;       // Terrain being built
+        const UCHAR  ** ppBlendMaps;    // Blend map of each layer
+        const UCHAR  ** ppCoverage;     // Coverage map of each layer
+    };
+
+    // Details of the heightmap filter pass being run by the thread pool
+    struct FilterPass
+    {
+        const float   * pSrc;       // Heightmap data to read
+        float         * pDest;      // Heightmap data to write
+        const float   * pKernel;    // Kernel weights, indexed from -Radius to +Radius
+        long            Radius;     // Kernel radius
+        long            Width;      // Heightmap width
+        long            Height;     // Heightmap height
+        bool            SSE;        // Use the SSE path ?
+    };
+
+    // Details of the page file being built, passed to each LoadPageBand call
+    struct PageBuildPass
+    {
+        CTerrain      * pTerrain;           // Terrain whose page file is being built
+        CTerrain      * pBand;              // Receives the source data of each band
+        LPCTSTR         DefFile;            // Terrain definition file
+        LPCTSTR         HeightMapFile;      // Heightmap file
+        CTerrain::HEIGHTMAP_FORMAT Format;  // Heightmap sample format
+        ULONG           FilterRadius;       // Heightmap filter settings (see FilterHeightMap)
+        ULONG           FilterIterations;
+        bool            FilterGaussian;
+    };
 };
 
+// Not defined by older platform SDK headers
+#ifndef PF_XMMI_INSTRUCTIONS_AVAILABLE
+#define PF_XMMI_INSTRUCTIONS_AVAILABLE   6
+#endif
+#ifndef PF_XMMI64_INSTRUCTIONS_AVAILABLE
+#define PF_XMMI64_INSTRUCTIONS_AVAILABLE 10
+#endif
+
+//-----------------------------------------------------------------------------
+// Name : SourceNormal () (Module Local)
+// Desc : Retrieves a normal from the block source, relative to the block's
+//        first sample. Normals beyond the edge of the terrain point up.
+//-----------------------------------------------------------------------------
+static inline D3DXVECTOR3 SourceNormal( const BLOCK_SOURCE & Source, ULONG x, ULONG z )
+{
+    if ( x >= Source.NormalWidth || z >= Source.NormalHeight ) return D3DXVECTOR3( 0.0f, 1.0f, 0.0f );
+
+    ULONG Index = x + z * Source.NormalPitch;
+    return D3DXVECTOR3( Source.pNormalX[Index], Source.pNormalY[Index], Source.pNormalZ[Index] );
+}
+
+//-----------------------------------------------------------------------------
+// Name : PackBlendRow () (Module Local)
+// Desc : Interleaves a row from each of up to four layer blend maps into
+//        packed A8R8G8B8 blend texels. The layers held in the red, green and
+//        blue channels are stored as 127 + (Weight + 1) / 2, so that a
+//        DOTPRODUCT3 texture stage against BLEND_CHANNEL_MASK returns the
+//        weight, while the alpha channel layer is stored as is. Missing layers
+//        (NULL rows) have no weight.
+// Note : A weight of zero is stored as 127, which the DOTPRODUCT3 stage
+//        returns as -1/255. This absorbs the other two channels' leakage
+//        (at most 1/255 with the balanced masks), so an uncovered layer
+//        rounds to zero rather than tinting blocks drawn at a coarser LOD.
+//        Sixteen texels are converted at a time where SSE2 is available.
+//-----------------------------------------------------------------------------
+static void PackBlendRow( ULONG * pDest, const UCHAR * const * ppRows, ULONG Count, bool SSE2 )
+{
+    ULONG x = 0, k;
+    UCHAR Weight[ TERRAIN_BLEND_CHANNELS ];
+
+    if ( SSE2 )
+    {
+        const __m128i Bias = _mm_set1_epi8( (char)0xFE );
+        __m128i       Channel[ TERRAIN_BLEND_CHANNELS ];
+
+        for ( ; x + 16 <= Count; x += 16 )
+        {
+            for ( k = 0; k < TERRAIN_BLEND_CHANNELS; k++ )
+            {
+                Channel[k] = ppRows[k] ? _mm_loadu_si128( (const __m128i*)(ppRows[k] + x) ) : _mm_setzero_si128();
+
+            } // Next Channel
+
+            // Bias the colour channels, the rounded average with 254 is (Weight + 255) / 2
+            __m128i R = _mm_avg_epu8( Channel[0], Bias );
+            __m128i G = _mm_avg_epu8( Channel[1], Bias );
+            __m128i B = _mm_avg_epu8( Channel[2], Bias );
+
+            // Interleave into texels (B, G, R, A byte order)
+            __m128i BGLow  = _mm_unpacklo_epi8( B, G ), BGHigh = _mm_unpackhi_epi8( B, G );
+            __m128i RALow  = _mm_unpacklo_epi8( R, Channel[3] ), RAHigh = _mm_unpackhi_epi8( R, Channel[3] );
+            _mm_storeu_si128( (__m128i*)(pDest + x     ), _mm_unpacklo_epi16( BGLow , RALow  ) );
+            _mm_storeu_si128( (__m128i*)(pDest + x + 4 ), _mm_unpackhi_epi16( BGLow , RALow  ) );
+            _mm_storeu_si128( (__m128i*)(pDest + x + 8 ), _mm_unpacklo_epi16( BGHigh, RAHigh ) );
+            _mm_storeu_si128( (__m128i*)(pDest + x + 12), _mm_unpackhi_epi16( BGHigh, RAHigh ) );
+
+        } // Next Sixteen Texels
+
+    } // End if SSE2
+
+    // Any remaining texels
+    for ( ; x < Count; x++ )
+    {
+        for ( k = 0; k < TERRAIN_BLEND_CHANNELS; k++ ) Weight[k] = ppRows[k] ? ppRows[k][x] : 0;
+        pDest[x] = D3DCOLOR_ARGB( Weight[3], (Weight[0] + 255) >> 1, (Weight[1] + 255) >> 1, (Weight[2] + 255) >> 1 );
+
+    } // Next Texel
+}
+
+//-----------------------------------------------------------------------------
+// Name : RoundUpPow2 () (Module Local)
+// Desc : Returns the smallest power of two not less than the value specified.
+//-----------------------------------------------------------------------------
+static inline ULONG RoundUpPow2( ULONG Value )
+{
+    ULONG Result = 1;
+
+    while ( Result < Value ) Result <<= 1;
+    return Result;
+}
+
+//-----------------------------------------------------------------------------
+// Name : HashBytes () (Module Local)
+// Desc : Folds the data specified into a 64 bit FNV-1a hash.
+//-----------------------------------------------------------------------------
+static void HashBytes( unsigned __int64 & Hash, const void * pData, ULONG Size )
+{
+    const unsigned __int64 Prime = ((unsigned __int64)0x00000100 << 32) | 0x000001B3;
+    const UCHAR * pBytes = (const UCHAR*)pData;
+
+    for ( ULONG i = 0; i < Size; i++ ) Hash = (Hash ^ pBytes[i]) * Prime;
+}
+
+//-----------------------------------------------------------------------------
+// Name : HashFile () (Module Local)
+// Desc : Folds the size and contents of the file specified into the hash.
+// Note : The file is read a fixed size chunk at a time, so files of any
+//        size can be hashed without mapping them into the address space.
+//-----------------------------------------------------------------------------
+static bool HashFile( unsigned __int64 & Hash, LPCTSTR FileName )
+{
+    HANDLE  hFile = NULL;
+    UCHAR * pBuffer = NULL;
+    ULONG   SizeLow, SizeHigh = 0, Read;
+    bool    Result = true;
+
+    // Open up the file
+    hFile = CreateFile( FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if ( hFile == INVALID_HANDLE_VALUE ) return false;
+
+    // Include the full 64 bit size
+    SizeLow = GetFileSize( hFile, &SizeHigh );
+    HashBytes( Hash, &SizeLow, sizeof(ULONG) );
+    HashBytes( Hash, &SizeHigh, sizeof(ULONG) );
+
+    // Allocate the read buffer
+    pBuffer = new UCHAR[ HASH_CHUNK_SIZE ];
+    if ( !pBuffer ) { CloseHandle( hFile ); return false; }
+
+    // Hash the contents
+    for ( ; ; )
+    {
+        if ( !ReadFile( hFile, pBuffer, HASH_CHUNK_SIZE, &Read, NULL ) ) { Result = false; break; }
+        if ( Read == 0 ) break;
+        HashBytes( Hash, pBuffer, Read );
+
+    } // Next Chunk
+
+    // Clean up
+    delete []pBuffer;
+    CloseHandle( hFile );
+
+    // Success?
+    return Result;
+}
+
+//-----------------------------------------------------------------------------
+// Name : HashFileStamp () (Module Local)
+// Desc : Folds the size and last write time of the file specified into the
+//        hash, without opening or reading the file itself.
+//-----------------------------------------------------------------------------
+static bool HashFileStamp( unsigned __int64 & Hash, LPCTSTR FileName )
+{
+    WIN32_FILE_ATTRIBUTE_DATA Data;
+
+    if ( !GetFileAttributesEx( FileName, GetFileExInfoStandard, &Data ) ) return false;
+    HashBytes( Hash, &Data.nFileSizeLow, sizeof(ULONG) );
+    HashBytes( Hash, &Data.nFileSizeHigh, sizeof(ULONG) );
+    HashBytes( Hash, &Data.ftLastWriteTime, sizeof(FILETIME) );
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : HashTerrainInputs () (Module Local)
+// Desc : Hashes every file the built terrain data depends upon; the terrain
+//        definition, the heightmap and each layer map.
+// Note : Only the definition's contents are hashed. The heightmap and layer
+//        maps can be very large, so just their size and last write time are
+//        used. Textures are loaded as normal and so are not included.
+//-----------------------------------------------------------------------------
+static bool HashTerrainInputs( LPCTSTR DefFile, LPCTSTR HeightMapFile, unsigned __int64 & Hash )
+{
+    char  Section[100], FileName[MAX_PATH], Path[MAX_PATH];
+    ULONG i, LayerCount, Version = COOKED_VERSION;
+
+    // Start from the FNV-1a offset basis, and include the format version
+    Hash = ((unsigned __int64)0xCBF29CE4 << 32) | 0x84222325;
+    HashBytes( Hash, &Version, sizeof(ULONG) );
+
+    // Definition and heightmap
+    if ( !HashFile( Hash, DefFile ) ) return false;
+    if ( !HashFileStamp( Hash, HeightMapFile ) ) return false;
+
+    // Layer maps (the base layer has none)
+    LayerCount = GetPrivateProfileInt( "General", "LayerCount", 1, DefFile );
+    for ( i = 1; i < LayerCount; i++ )
+    {
+        sprintf( Section, "Layer %i", i );
+        GetPrivateProfileString( Section, "LayerMap", "", FileName, MAX_PATH - 1, DefFile );
+        strcpy( Path, DataPath );
+        strcat( Path, FileName );
+        if ( !HashFileStamp( Hash, Path ) ) return false;
+
+    } // Next Layer
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : WriteData () (Module Local)
+// Desc : Writes to the current position of the file specified, optionally
+//        padding the data to a multiple of four bytes.
+//-----------------------------------------------------------------------------
+static bool WriteData( HANDLE hFile, const void * pBuffer, ULONG Size, bool Pad = false )
+{
+    DWORD Written = 0, Zero = 0;
+
+    if ( Size > 0 && (!WriteFile( hFile, pBuffer, Size, &Written, NULL ) || Written != Size) ) return false;
+    if ( !Pad || (Size & 3) == 0 ) return true;
+
+    // Pad to the next four byte boundary
+    Size = 4 - (Size & 3);
+    if ( !WriteFile( hFile, &Zero, Size, &Written, NULL ) ) return false;
+    return ( Written == Size );
+}
+
+//-----------------------------------------------------------------------------
+// Name : ConvertHeights8 () (Module Local)
+// Desc : Converts unsigned 8 bit heightmap samples to floating point, sixteen
+//        at a time where SSE2 is available.
+//-----------------------------------------------------------------------------
+static void ConvertHeights8( float * pDest, const UCHAR * pSrc, ULONG Count, bool SSE2 )
+{
+    ULONG i = 0;
+
+    if ( SSE2 )
+    {
+        __m128i Zero = _mm_setzero_si128(), Value, Lo, Hi;
+        for ( ; i + 16 <= Count; i += 16 )
+        {
+            // Widen sixteen bytes to sixteen 32 bit integers, then convert
+            Value = _mm_loadu_si128( (const __m128i*)(pSrc + i) );
+            Lo    = _mm_unpacklo_epi8( Value, Zero );
+            Hi    = _mm_unpackhi_epi8( Value, Zero );
+            _mm_storeu_ps( pDest + i,      _mm_cvtepi32_ps( _mm_unpacklo_epi16( Lo, Zero ) ) );
+            _mm_storeu_ps( pDest + i + 4,  _mm_cvtepi32_ps( _mm_unpackhi_epi16( Lo, Zero ) ) );
+            _mm_storeu_ps( pDest + i + 8,  _mm_cvtepi32_ps( _mm_unpacklo_epi16( Hi, Zero ) ) );
+            _mm_storeu_ps( pDest + i + 12, _mm_cvtepi32_ps( _mm_unpackhi_epi16( Hi, Zero ) ) );
+
+        } // Next Sample Group
+
+    } // End if SSE2
+
+    // Convert any remaining samples
+    for ( ; i < Count; i++ ) pDest[i] = (float)pSrc[i];
+}
+
+//-----------------------------------------------------------------------------
+// Name : ConvertHeights16 () (Module Local)
+// Desc : Converts unsigned 16 bit heightmap samples (of either byte order) to
+//        floating point, eight at a time where SSE2 is available.
+//-----------------------------------------------------------------------------
+static void ConvertHeights16( float * pDest, const UCHAR * pSrc, ULONG Count, bool BigEndian, bool SSE2 )
+{
+    ULONG i = 0;
+
+    if ( SSE2 )
+    {
+        __m128i Zero = _mm_setzero_si128(), Value;
+        for ( ; i + 8 <= Count; i += 8 )
+        {
+            // Swap bytes if required, widen to 32 bit integers and convert
+            Value = _mm_loadu_si128( (const __m128i*)(pSrc + i * 2) );
+            if ( BigEndian ) Value = _mm_or_si128( _mm_slli_epi16( Value, 8 ), _mm_srli_epi16( Value, 8 ) );
+            _mm_storeu_ps( pDest + i,     _mm_cvtepi32_ps( _mm_unpacklo_epi16( Value, Zero ) ) );
+            _mm_storeu_ps( pDest + i + 4, _mm_cvtepi32_ps( _mm_unpackhi_epi16( Value, Zero ) ) );
+
+        } // Next Sample Group
+
+    } // End if SSE2
+
+    // Convert any remaining samples
+    for ( ; i < Count; i++ )
+    {
+        const UCHAR * pSample = pSrc + i * 2;
+        if ( BigEndian )
+            pDest[i] = (float)((pSample[0] << 8) | pSample[1]);
+        else
+            pDest[i] = (float)(pSample[0] | (pSample[1] << 8));
+
+    } // Next Sample
+}
+
+//-----------------------------------------------------------------------------
+// Name : FilterSample () (Module Local)
+// Desc : Applies the kernel to a single sample of a row, clamping any reads
+//        which would fall outside of the row.
+//-----------------------------------------------------------------------------
+static inline float FilterSample( const float * pSrc, long x, long Count, const float * pKernel, long Radius )
+{
+    float Sum = 0.0f;
+    long  k, i;
+
+    for ( k = -Radius; k <= Radius; k++ )
+    {
+        i = x + k;
+        if ( i < 0 ) i = 0; else if ( i >= Count ) i = Count - 1;
+        Sum += pKernel[k] * pSrc[i];
+
+    } // Next Weight
+
+    return Sum;
+}
+
+//-----------------------------------------------------------------------------
+// Name : FilterRowsJob () (Module Local)
+// Desc : Thread pool job callback, filters a group of heightmap rows
+//        horizontally. Wherever the whole kernel lies within the row, eight
+//        samples are filtered at a time using SSE.
+//-----------------------------------------------------------------------------
+static void FilterRowsJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex )
+{
+    const FilterPass & Pass = *(const FilterPass*)pContext;
+    long  x, z, k, zEnd, w = Pass.Width, r = Pass.Radius;
+
+    zEnd = (long)((JobIndex + 1) * FILTER_JOB_ROWS);
+    if ( zEnd > Pass.Height ) zEnd = Pass.Height;
+
+    for ( z = (long)(JobIndex * FILTER_JOB_ROWS); z < zEnd; z++ )
+    {
+        const float * pSrc  = Pass.pSrc  + z * w;
+        float       * pDest = Pass.pDest + z * w;
+
+        // Edge samples are retained
+        pDest[0]     = pSrc[0];
+        pDest[w - 1] = pSrc[w - 1];
+
+        // Samples whose kernel is clamped at the start of the row
+        for ( x = 1; x < r && x < w - 1; x++ ) pDest[x] = FilterSample( pSrc, x, w, Pass.pKernel, r );
+
+        // Unclamped samples, eight at a time
+        if ( Pass.SSE )
+        {
+            for ( ; x + 8 + r <= w; x += 8 )
+            {
+                __m128 Sum0 = _mm_setzero_ps(), Sum1 = _mm_setzero_ps(), Weight;
+                for ( k = -r; k <= r; k++ )
+                {
+                    Weight = _mm_set1_ps( Pass.pKernel[k] );
+                    Sum0   = _mm_add_ps( Sum0, _mm_mul_ps( Weight, _mm_loadu_ps( pSrc + x + k ) ) );
+                    Sum1   = _mm_add_ps( Sum1, _mm_mul_ps( Weight, _mm_loadu_ps( pSrc + x + k + 4 ) ) );
+
+                } // Next Weight
+                _mm_storeu_ps( pDest + x,     Sum0 );
+                _mm_storeu_ps( pDest + x + 4, Sum1 );
+
+            } // Next Sample Group
+
+        } // End if SSE
+
+        // Any remaining samples
+        for ( ; x < w - 1; x++ ) pDest[x] = FilterSample( pSrc, x, w, Pass.pKernel, r );
+
+    } // Next Row
+}
+
+//-----------------------------------------------------------------------------
+// Name : FilterColumnsJob () (Module Local)
+// Desc : Thread pool job callback, filters a group of heightmap rows
+//        vertically. Each output row combines whole source rows, so it is
+//        processed eight samples at a time using SSE.
+// Note : The first and last rows, and the edge of each row, are not written.
+//-----------------------------------------------------------------------------
+static void FilterColumnsJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex )
+{
+    const FilterPass & Pass = *(const FilterPass*)pContext;
+    const float * pRows[ FILTER_MAX_RADIUS * 2 + 1 ];
+    long  x, z, k, i, zEnd, w = Pass.Width, r = Pass.Radius;
+    float Sum;
+
+    zEnd = (long)((JobIndex + 1) * FILTER_JOB_ROWS);
+    if ( zEnd > Pass.Height - 1 ) zEnd = Pass.Height - 1;
+
+    for ( z = (long)(JobIndex * FILTER_JOB_ROWS); z < zEnd; z++ )
+    {
+        // Edge rows are retained
+        if ( z == 0 ) continue;
+
+        // Gather the (clamped) source rows covered by the kernel
+        for ( k = -r; k <= r; k++ )
+        {
+            i = z + k;
+            if ( i < 0 ) i = 0; else if ( i >= Pass.Height ) i = Pass.Height - 1;
+            pRows[ k + r ] = Pass.pSrc + i * w;
+
+        } // Next Weight
+
+        float * pDest = Pass.pDest + z * w;
+
+        // Eight samples at a time
+        x = 1;
+        if ( Pass.SSE )
+        {
+            for ( ; x + 8 <= w - 1; x += 8 )
+            {
+                __m128 Sum0 = _mm_setzero_ps(), Sum1 = _mm_setzero_ps(), Weight;
+                for ( k = -r; k <= r; k++ )
+                {
+                    Weight = _mm_set1_ps( Pass.pKernel[k] );
+                    Sum0   = _mm_add_ps( Sum0, _mm_mul_ps( Weight, _mm_loadu_ps( pRows[ k + r ] + x ) ) );
+                    Sum1   = _mm_add_ps( Sum1, _mm_mul_ps( Weight, _mm_loadu_ps( pRows[ k + r ] + x + 4 ) ) );
+
+                } // Next Weight
+                _mm_storeu_ps( pDest + x,     Sum0 );
+                _mm_storeu_ps( pDest + x + 4, Sum1 );
+
+            } // Next Sample Group
+
+        } // End if SSE
+
+        // Any remaining samples
+        for ( ; x < w - 1; x++ )
+        {
+            Sum = 0.0f;
+            for ( k = -r; k <= r; k++ ) Sum += Pass.pKernel[k] * pRows[ k + r ][x];
+            pDest[x] = Sum;
+
+        } // Next Sample
+
+    } // Next Row
+}
+
 //-----------------------------------------------------------------------------
 // Name : CTerrain () (Constructor)
 // Desc : CTerrain Class Constructor
@@ -34,6 +552,9 @@ CTerrain::CTerrain()
     m_pD3DDevice        = NULL;
 
     m_pHeightMap        = NULL;
+    m_pNormalX          = NULL;
+    m_pNormalY          = NULL;
+    m_pNormalZ          = NULL;
     m_nHeightMapWidth   = 0;
     m_nHeightMapHeight  = 0;
     m_nBlockWidth       = 0;
@@ -42,6 +563,15 @@ CTerrain::CTerrain()
     m_nQuadsHigh        = 0;
     m_nLayerCount       = 0;
     m_nBlendTexRatio    = 1;
+
+    m_nAtlasMaxSize     = 1024;
+    m_nAtlasBlocksWide  = 1;
+    m_nAtlasBlocksHigh  = 1;
+    m_nAtlasPagesWide   = 0;
+    m_nAtlasPageCount   = 0;
+    m_nAtlasWidth       = 0;
+    m_nAtlasHeight      = 0;
+    m_pBlendAtlas       = NULL;
     
     m_pBlock            = NULL;
     m_nBlockCount       = 0;
@@ -49,9 +579,33 @@ CTerrain::CTerrain()
     m_nLayerCount       = 0;
     m_pTexture          = NULL;
     m_nTextureCount     = 0;
+    m_pQuadNodes        = NULL;
+    m_nQuadNodeCount    = 0;
+    m_pQuadBlocks       = NULL;
+    m_nQuadBlockCount   = 0;
+    m_pVisibleBlocks    = NULL;
+    m_nVisibleCount     = 0;
+    m_pLODBlocks        = NULL;
+    m_nLODBlockCount    = 0;
+    m_pLODQueue         = NULL;
+    m_nLODFrame         = 0;
 
     m_vecScale          = D3DXVECTOR3( 1.0f, 1.0f, 1.0f );
 
+    m_pFilterScratch     = NULL;
+    m_nFilterScratchSize = 0;
+    m_nBlockFailures     = 0;
+
+    m_nLODCount          = 1;
+    m_fLODMaxError       = 2.0f;
+    m_pLODIndexBuffer    = NULL;
+    m_fPageRadius        = 0.0f;
+    m_nPageUploads       = 0;
+    m_pCookedData        = NULL;
+    m_nCookedSize        = 0;
+    ZeroMemory( m_nLODStart, sizeof(m_nLODStart) );
+    ZeroMemory( m_nLODPrimitives, sizeof(m_nLODPrimitives) );
+
 }
 
 //-----------------------------------------------------------------------------
@@ -70,8 +624,17 @@ CTerrain::~CTerrain()
 //-----------------------------------------------------------------------------
 void CTerrain::Release()
 {
-    // Release Heightmap
+    // Stop paging before the blocks are destroyed
+    m_Pager.Close();
+
+    // Unmap any cooked data left by a failed load
+    CloseCookedTerrain();
+
+    // Release Heightmap & normal field
     if ( m_pHeightMap ) delete[]m_pHeightMap;
+    if ( m_pNormalX   ) delete[]m_pNormalX;
+    if ( m_pNormalY   ) delete[]m_pNormalY;
+    if ( m_pNormalZ   ) delete[]m_pNormalZ;
     
     // Release Blocks
     if ( m_pBlock ) 
@@ -88,6 +651,13 @@ void CTerrain::Release()
     
     } // End if
 
+    // Release the quadtree, visible block and LOD lists
+    if ( m_pQuadNodes     ) delete []m_pQuadNodes;
+    if ( m_pQuadBlocks    ) delete []m_pQuadBlocks;
+    if ( m_pVisibleBlocks ) delete []m_pVisibleBlocks;
+    if ( m_pLODBlocks     ) delete []m_pLODBlocks;
+    if ( m_pLODQueue      ) delete []m_pLODQueue;
+
     // Release Layers
     if ( m_pLayer ) 
     {
@@ -118,12 +688,34 @@ void CTerrain::Release()
     
     } // End if
 
+    // Release the blend atlas (the blocks hold their own references)
+    if ( m_pBlendAtlas )
+    {
+        for ( ULONG i = 0; i < m_nAtlasPageCount * GetBlendGroupCount(); i++ )
+        {
+            if ( m_pBlendAtlas[i] ) m_pBlendAtlas[i]->Release();
+
+        } // Next Texture
+
+        delete []m_pBlendAtlas;
+
+    } // End if
+
+    // Release the filter scratch buffer
+    if ( m_pFilterScratch ) delete []m_pFilterScratch;
+
+    // Release the shared detail level indices
+    if ( m_pLODIndexBuffer ) m_pLODIndexBuffer->Release();
+
     // Release our D3D Object ownership
     if ( m_pD3DDevice     ) m_pD3DDevice->Release();
 
     // Clear Variables
     m_pD3DDevice        = NULL;
     m_pHeightMap        = NULL;
+    m_pNormalX          = NULL;
+    m_pNormalY          = NULL;
+    m_pNormalZ          = NULL;
     m_nHeightMapWidth   = 0;
     m_nHeightMapHeight  = 0;
     m_nBlockWidth       = 0;
@@ -132,6 +724,13 @@ void CTerrain::Release()
     m_nQuadsHigh        = 0;
     m_nLayerCount       = 0;
     m_nBlendTexRatio    = 1;
+    m_nAtlasBlocksWide  = 1;
+    m_nAtlasBlocksHigh  = 1;
+    m_nAtlasPagesWide   = 0;
+    m_nAtlasPageCount   = 0;
+    m_nAtlasWidth       = 0;
+    m_nAtlasHeight      = 0;
+    m_pBlendAtlas       = NULL;
 
     m_pBlock            = NULL;
     m_nBlockCount       = 0;
@@ -139,6 +738,20 @@ void CTerrain::Release()
     m_nLayerCount       = 0;
     m_pTexture          = NULL;
     m_nTextureCount     = 0;
+    m_pQuadNodes        = NULL;
+    m_nQuadNodeCount    = 0;
+    m_pQuadBlocks       = NULL;
+    m_nQuadBlockCount   = 0;
+    m_pVisibleBlocks    = NULL;
+    m_nVisibleCount     = 0;
+    m_pLODBlocks        = NULL;
+    m_nLODBlockCount    = 0;
+    m_pLODQueue         = NULL;
+    m_nLODFrame         = 0;
+    m_pFilterScratch    = NULL;
+    m_nFilterScratchSize = 0;
+    m_nLODCount         = 1;
+    m_pLODIndexBuffer   = NULL;
     
 }
 
@@ -162,9 +775,13 @@ void CTerrain::SetTextureFormat( const D3DFORMAT & Format, const D3DFORMAT & Alp
 //-----------------------------------------------------------------------------
 bool CTerrain::LoadTerrain( LPCTSTR DefFile )
 {
-    FILE  * pFile = NULL;
-    char    Buffer  [1025], Section [100], Value[100], FileName[MAX_PATH];
-    ULONG   i;
+    char    Buffer  [1025], Section [100], Value[100], FileName[MAX_PATH], PageFile[MAX_PATH], CookedFile[MAX_PATH];
+    char    HeightMapFile[MAX_PATH];
+    ULONG   i, FilterRadius, FilterIterations, PageMaxResident, PageLoaders;
+    bool    FilterGaussian, Paged = false, Cooked = false;
+    unsigned __int64 InputHash = 0;
+    HEIGHTMAP_FORMAT Format;
+    PROFILE_ZONE( "CTerrain::LoadTerrain" );
 
     // Cannot load if already allocated (must be explicitly released for reuse)
     if ( m_pBlock ) return false;
@@ -175,6 +792,7 @@ bool CTerrain::LoadTerrain( LPCTSTR DefFile )
     // Read in the terrain definition values specified by the file
     strcpy( Section, "General" );
     GetPrivateProfileString( Section, "Heightmap", "", FileName, MAX_PATH - 1, DefFile );
+    GetPrivateProfileString( Section, "HeightmapFormat", "8Bit", Value, 99, DefFile );
     GetPrivateProfileString( Section, "Scale", "1, 1, 1", Buffer, 1024, DefFile );
     sscanf( Buffer, "%g,%g,%g", &m_vecScale.x, &m_vecScale.y, &m_vecScale.z );
     GetPrivateProfileString( Section, "TerrainSize", "257, 257", Buffer, 1024, DefFile );
@@ -183,39 +801,95 @@ bool CTerrain::LoadTerrain( LPCTSTR DefFile )
     sscanf( Buffer, "%i,%i", &m_nBlockWidth, &m_nBlockHeight );
     GetPrivateProfileString( Section, "BlendTexRatio", "1", Buffer, 1024, DefFile );
     sscanf( Buffer, "%i", &m_nBlendTexRatio );
+    m_nAtlasMaxSize  = GetPrivateProfileInt( Section, "BlendAtlasSize", 1024, DefFile );
+    FilterRadius     = GetPrivateProfileInt( Section, "FilterRadius", 1, DefFile );
+    FilterIterations = GetPrivateProfileInt( Section, "FilterIterations", 1, DefFile );
+    GetPrivateProfileString( Section, "FilterType", "Box", Buffer, 1024, DefFile );
+    FilterGaussian   = ( _stricmp( Buffer, "Gaussian" ) == 0 );
+    GetPrivateProfileString( Section, "LODMaxError", "2.0", Buffer, 1024, DefFile );
+    sscanf( Buffer, "%g", &m_fLODMaxError );
+
+    // Read in the paging values
+    GetPrivateProfileString( Section, "PageFile", "", FileName, MAX_PATH - 1, DefFile );
+    GetPrivateProfileString( Section, "PageRadius", "6000", Buffer, 1024, DefFile );
+    sscanf( Buffer, "%g", &m_fPageRadius );
+    PageMaxResident = GetPrivateProfileInt( Section, "PageMaxResident", 1024, DefFile );
+    PageLoaders     = GetPrivateProfileInt( Section, "PageLoaders", 2, DefFile );
+    m_nPageUploads  = GetPrivateProfileInt( Section, "PageUploads", 4, DefFile );
+
+    // Page from the file if one is specified (it is built below if required)
+    PageFile[0] = '\0';
+    if ( FileName[0] )
+    {
+        strcpy( PageFile, DataPath );
+        strcat( PageFile, FileName );
+        Paged = true;
+
+    } // End if page file specified
+
+    // The cooked terrain file is not used when paging
+    CookedFile[0] = '\0';
+    GetPrivateProfileString( Section, "CookedFile", "", FileName, MAX_PATH - 1, DefFile );
+    if ( FileName[0] && !Paged )
+    {
+        strcpy( CookedFile, DataPath );
+        strcat( CookedFile, FileName );
+
+    } // End if cooked file specified
+    GetPrivateProfileString( Section, "Heightmap", "", FileName, MAX_PATH - 1, DefFile );
+    strcpy( HeightMapFile, DataPath );
+    strcat( HeightMapFile, FileName );
 
     // Store secondary data
     m_nQuadsWide = m_nBlockWidth - 1;
     m_nQuadsHigh = m_nBlockHeight - 1;
 
-    // Attempt to allocate space for this heightmap information
-    m_pHeightMap = new float[m_nHeightMapWidth * m_nHeightMapHeight];
-    if (!m_pHeightMap) return false;
+    // Each detail level halves the quads along both sides of a block, for as
+    // long as they still divide evenly
+    for ( m_nLODCount = 1; m_nLODCount < TERRAIN_MAX_LOD; m_nLODCount++ )
+    {
+        ULONG Step = 1 << m_nLODCount;
+        if ( (m_nQuadsWide % Step) != 0 || (m_nQuadsHigh % Step) != 0 ) break;
 
-    // Build the heightmap path / filename
-    strcpy( Buffer, DataPath );
-    strcat( Buffer, FileName );
+    } // Next Level
 
-    // Open up the heightmap file
-    pFile = _tfopen( Buffer, _T("rb") );
-    if (!pFile) return false;
+    // Determine the heightmap sample format
+    if      ( _stricmp( Value, "8Bit"    ) == 0 ) Format = HEIGHTMAP_8BIT;
+    else if ( _stricmp( Value, "16Bit"   ) == 0 ) Format = HEIGHTMAP_16BIT;
+    else if ( _stricmp( Value, "16BitBE" ) == 0 ) Format = HEIGHTMAP_16BIT_BE;
+    else if ( _stricmp( Value, "Float"   ) == 0 ) Format = HEIGHTMAP_FLOAT;
+    else return false;
+
+    // Spin up the worker threads used to process the terrain data
+    if ( m_ThreadPool.GetThreadCount() == 0 ) m_ThreadPool.Create();
 
-    // Read the heightmap data
-    for ( i = 0; i < m_nHeightMapWidth * m_nHeightMapHeight; i++ )
+    // Use the cooked terrain if it was built from these same input files,
+    // otherwise build it (and cook it again) as normal. The page file is
+    // checked in the same way. Neither can be built without its inputs.
+    if ( CookedFile[0] || Paged )
     {
-        UCHAR HeightValue;
-        fread( &HeightValue, 1, 1, pFile );
+        if ( !HashTerrainInputs( DefFile, HeightMapFile, InputHash ) ) return false;
+        if ( CookedFile[0] ) Cooked = OpenCookedTerrain( CookedFile, InputHash );
 
-        // Store it as floating point
-        m_pHeightMap[i] = (float)HeightValue;
-    
-    } // Next Value
-    
-    // Finish up
-    fclose( pFile );
+    } // End if cooked or paged
+
+    // The heightmap is only loaded when not paging or cooked
+    if ( !Paged && !Cooked )
+    {
+        // Attempt to allocate space for this heightmap information
+        m_pHeightMap = new float[m_nHeightMapWidth * m_nHeightMapHeight];
+        if (!m_pHeightMap) return false;
+
+        // Load the heightmap data
+        if ( !LoadHeightMap( HeightMapFile, Format ) ) return false;
+
+        // Filter the heightmap data
+        FilterHeightMap( FilterRadius, FilterIterations, FilterGaussian );
+
+        // Build the normal field from the final heightmap
+        if ( !GenerateNormals() ) return false;
 
-    // Filter the heightmap data
-    FilterHeightMap();
+    } // End if not paged
 
     // Load in the texture data
     strcpy( Section, "Textures" );
@@ -248,16 +922,32 @@ bool CTerrain::LoadTerrain( LPCTSTR DefFile )
 
     } // If any textures
 
-    // Generate the terrain layer data
-    if ( !GenerateLayers( DefFile ) ) return false;
+    // Generate the terrain layer data (the blend maps of a paged terrain are
+    // read along with each block)
+    if ( !GenerateLayers( DefFile, !Paged && !Cooked ) ) return false;
 
-    // Build the terrain blocks
-    if ( !GenerateTerrainBlocks() ) return false;
+    // Open the page file, building it first if it is missing or was built from
+    // other input files. Only the overview is loaded now, blocks are read as
+    // the viewer approaches them.
+    if ( Paged && !m_Pager.Open( this, PageFile, InputHash, PageMaxResident, PageLoaders ) )
+    {
+        if ( !BuildPageFile( PageFile, DefFile, HeightMapFile, Format, FilterRadius, FilterIterations, FilterGaussian, InputHash ) ) return false;
+        if ( !m_Pager.Open( this, PageFile, InputHash, PageMaxResident, PageLoaders ) ) return false;
+
+    } // End if page file not opened
+
+    // Build the terrain blocks, cooking them if requested
+    if ( !GenerateTerrainBlocks( (CookedFile[0] && !Cooked) ? CookedFile : NULL, InputHash ) ) return false;
+    CloseCookedTerrain();
+
+    // Build the detail level index lists shared by the blocks
+    if ( !GenerateLODIndices() ) return false;
 
-    // Erase the blend maps, they are no longer required
+    // Erase the blend and coverage maps, they are no longer required
     for ( i = 0; i < m_nLayerCount; i++ ) 
     {
         if ( m_pLayer[i]->m_pBlendMap ) { delete []m_pLayer[i]->m_pBlendMap; m_pLayer[i]->m_pBlendMap = NULL; }    
+        if ( m_pLayer[i]->m_pCoverage ) { delete []m_pLayer[i]->m_pCoverage; m_pLayer[i]->m_pCoverage = NULL; }    
     
     } // Next Layer
 
@@ -268,8 +958,11 @@ bool CTerrain::LoadTerrain( LPCTSTR DefFile )
 //-----------------------------------------------------------------------------
 // Name : GenerateLayers()
 // Desc : Generate the layer data for this terrain.
+// Note : 'FirstRow' is the heightmap row held in the first row of this
+//        terrain (see LoadPageBand), the blend maps are read from the matching
+//        rows of each layer map.
 //-----------------------------------------------------------------------------
-bool CTerrain::GenerateLayers( LPCTSTR DefFile )
+bool CTerrain::GenerateLayers( LPCTSTR DefFile, bool LoadBlendMaps, ULONG FirstRow )
 {
     ULONG Width  = (m_nHeightMapWidth  - 1) * m_nBlendTexRatio;
     ULONG Height = (m_nHeightMapHeight - 1) * m_nBlendTexRatio;
@@ -281,6 +974,7 @@ bool CTerrain::GenerateLayers( LPCTSTR DefFile )
 
     HRESULT             hRet;
     D3DXIMAGE_INFO      Info;
+    RECT                SrcRect;
     LPDIRECT3DSURFACE9  pSurface = NULL;
 
     // Read in the terrain layer data
@@ -327,6 +1021,9 @@ bool CTerrain::GenerateLayers( LPCTSTR DefFile )
         pLayer->m_mtxTexture._11 *= Scale.x; pLayer->m_mtxTexture._21 *= Scale.x; pLayer->m_mtxTexture._31 *= Scale.x;
         pLayer->m_mtxTexture._12 *= Scale.y; pLayer->m_mtxTexture._22 *= Scale.y; pLayer->m_mtxTexture._32 *= Scale.y;
         
+        // Skip the blend map if it is not required
+        if ( !LoadBlendMaps ) continue;
+
         // Allocate our layer blend map array (these are temporary arrays)
         pLayer->m_pBlendMap = new UCHAR[ Width * Height ];
         if (!pLayer->m_pBlendMap) return false;
@@ -346,14 +1043,21 @@ bool CTerrain::GenerateLayers( LPCTSTR DefFile )
 
         // Get the source file info
         if ( FAILED(D3DXGetImageInfoFromFile( Buffer, &Info ) )) return false;
+
+        // The area of the image covering our rows (texels beyond it are left clear)
+        SrcRect.left   = 0;
+        SrcRect.top    = min( FirstRow * m_nBlendTexRatio, Info.Height );
+        SrcRect.right  = min( Info.Width, Width );
+        SrcRect.bottom = min( SrcRect.top + Height, Info.Height );
+        if ( SrcRect.right <= 0 || SrcRect.bottom <= SrcRect.top ) continue;
         
         // Create the off screen surface in sys mem, in a format useful to us
-        hRet = m_pD3DDevice->CreateOffscreenPlainSurface( Info.Width, Info.Height, D3DFMT_X8R8G8B8, 
+        hRet = m_pD3DDevice->CreateOffscreenPlainSurface( SrcRect.right, SrcRect.bottom - SrcRect.top, D3DFMT_X8R8G8B8, 
                                                           D3DPOOL_SYSTEMMEM, &pSurface, NULL  );
         if ( FAILED(hRet) ) return false;
 
         // Load in the image
-        hRet = D3DXLoadSurfaceFromFile( pSurface, NULL, NULL, Buffer, NULL, D3DX_DEFAULT, 0, NULL );
+        hRet = D3DXLoadSurfaceFromFile( pSurface, NULL, NULL, Buffer, &SrcRect, D3DX_DEFAULT, 0, NULL );
         if ( FAILED(hRet) ) { pSurface->Release(); return false; }
         
         // Lock the surface and copy over the data into our blend map array
@@ -364,10 +1068,10 @@ bool CTerrain::GenerateLayers( LPCTSTR DefFile )
         ULONG * pBits = (ULONG*)LockedRect.pBits;
         
         // Loop through each row
-        for ( z = 0; z < Info.Height; ++z )
+        for ( z = 0; z < (ULONG)(SrcRect.bottom - SrcRect.top); ++z )
         {
             // Loop through each column and extract just the blue pixel data
-            for ( x = 0; x < Info.Width; ++x ) pLayer->m_pBlendMap[ x + z * Width ] = (UCHAR)(pBits[x] & (0x000000FF));
+            for ( x = 0; x < (ULONG)SrcRect.right; ++x ) pLayer->m_pBlendMap[ x + z * Width ] = (UCHAR)(pBits[x] & (0x000000FF));
             
             // Move to the next row
             pBits += LockedRect.Pitch / 4;
@@ -394,6 +1098,9 @@ bool CTerrain::GenerateLayers( LPCTSTR DefFile )
 
     } // Next Layer
 
+    // Nothing more to do without the blend maps
+    if ( !LoadBlendMaps ) return true;
+
     // Now we need to parse the layers and determine which alpha pixels are occluded
     for ( i = 0; i < m_nLayerCount; i++ )
     {
@@ -428,6 +1135,13 @@ bool CTerrain::GenerateLayers( LPCTSTR DefFile )
 
     } // Next Layer
 
+    // Summarise the final blend maps for each terrain quad
+    for ( i = 0; i < m_nLayerCount; i++ )
+    {
+        if ( !m_pLayer[i]->BuildCoverage( m_nBlendTexRatio ) ) return false;
+
+    } // Next Layer
+
     // Success!!
     return true;
 }
@@ -435,10 +1149,17 @@ bool CTerrain::GenerateLayers( LPCTSTR DefFile )
 //-----------------------------------------------------------------------------
 // Name : GenerateTerrainBlocks()
 // Desc : Generate each of the individual blocks required.
+// Note : The vertex, index and blend map data for every block is built in
+//        parallel on the thread pool. The Direct3D resources are then created
+//        and filled here, on the calling thread. When a cooked file is open
+//        the blocks are uploaded directly from it instead, and when a cooked
+//        file name is passed in the built data is written to it.
 //-----------------------------------------------------------------------------
-bool CTerrain::GenerateTerrainBlocks( )
+bool CTerrain::GenerateTerrainBlocks( LPCTSTR CookedFile, unsigned __int64 CookedHash )
 {
-    ULONG x, z, ax, az, Counter;
+    ULONG x, z, Counter;
+    long  ax, az;
+    PROFILE_ZONE( "CTerrain::GenerateTerrainBlocks" );
 
     // Calculate block values
     m_nBlocksWide = (USHORT)(m_nHeightMapWidth - 1) / m_nQuadsWide;
@@ -450,7 +1171,7 @@ bool CTerrain::GenerateTerrainBlocks( )
     // Initialize each terrain block
     for ( z = 0; z < m_nBlocksHigh; z++ )
     {
-        for ( x = 0; x < m_nBlocksHigh; x++ )
+        for ( x = 0; x < m_nBlocksWide; x++ )
         {
             CTerrainBlock * pBlock = m_pBlock[ x + z * m_nBlocksWide ];
 
@@ -464,10 +1185,10 @@ bool CTerrain::GenerateTerrainBlocks( )
                     pBlock->m_pNeighbours[Counter] = NULL;
                     
                     // Bail if we are out of bounds
-                    if ( (x + ax) < 0 || (z + az) < 0 || (x + ax) >= m_nBlocksWide || (z + az) >= m_nBlocksHigh ) continue;
+                    if ( ((long)x + ax) < 0 || ((long)z + az) < 0 || ((long)x + ax) >= (long)m_nBlocksWide || ((long)z + az) >= (long)m_nBlocksHigh ) continue;
                 
                     // Store Neighbour
-                    pBlock->m_pNeighbours[Counter] = m_pBlock[ (x + ax) + (z + az) * m_nBlocksWide ]; 
+                    pBlock->m_pNeighbours[Counter] = m_pBlock[ ((long)x + ax) + ((long)z + az) * (long)m_nBlocksWide ]; 
 
                 } // Next Adjacent Column
 
@@ -477,111 +1198,1089 @@ bool CTerrain::GenerateTerrainBlocks( )
     
     } // Next Row
 
-    // Generate each terrain block
-    for ( z = 0; z < m_nBlocksHigh; z++ )
+    // Lay out the blend atlas, the block vertices address it
+    if ( !CreateBlendAtlas() ) return false;
+
+    if ( m_Pager.IsOpen() )
+    {
+        // Blocks are built as they are paged in, only their bounds are required now
+        if ( !m_Pager.InitBlocks() ) return false;
+
+    } // End if paged
+    else if ( m_pCookedData )
     {
-        for ( x = 0; x < m_nBlocksHigh; x++ )
+        // Upload the blocks straight from the cooked file
+        if ( !LoadCookedBlocks() ) return false;
+
+    } // End if cooked
+    else
+    {
+        BlockBuildPass Pass;
+
+        // Gather the layer blend and coverage maps
+        Pass.pTerrain    = this;
+        Pass.ppBlendMaps = new const UCHAR*[ m_nLayerCount ];
+        Pass.ppCoverage  = new const UCHAR*[ m_nLayerCount ];
+        if ( !Pass.ppBlendMaps || !Pass.ppCoverage ) return false;
+        for ( Counter = 0; Counter < m_nLayerCount; Counter++ )
         {
-            CTerrainBlock * pBlock = m_pBlock[ x + z * m_nBlocksWide ];
-            
-            // Generate the block
-            if (!pBlock->GenerateBlock( this, x * m_nQuadsWide, z * m_nQuadsHigh, m_nBlockWidth, m_nBlockHeight )) return false;
+            Pass.ppBlendMaps[Counter] = m_pLayer[Counter]->m_pBlendMap;
+            Pass.ppCoverage[Counter]  = m_pLayer[Counter]->m_pCoverage;
+
+        } // Next Layer
+
+        // Build the data for each terrain block, one job per block
+        m_nBlockFailures = 0;
+        m_ThreadPool.Execute( BuildBlockJob, &Pass, m_nBlockCount );
+        delete []Pass.ppBlendMaps;
+        delete []Pass.ppCoverage;
+        if ( m_nBlockFailures > 0 ) return false;
+
+        // Cook the built data (before upload releases it). Failure is not
+        // fatal, the terrain is simply built again next time.
+        if ( CookedFile ) WriteCookedTerrain( CookedFile, CookedHash );
+
+        // Create the device resources for each block
+        for ( Counter = 0; Counter < m_nBlockCount; Counter++ )
+        {
+            if ( !m_pBlock[Counter]->CreateResources() ) return false;
+
+        } // Next Block
+
+    } // End if not paged
+
+    // Build the quadtree used to cull the blocks
+    if ( !BuildQuadTree() ) return false;
+
+    // Success!!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : CreateBlendAtlas () (Private)
+// Desc : Lays out the blend textures of every block across one or more atlas
+//        pages, and creates the page textures. Each page covers a rectangle
+//        of neighbouring blocks in their terrain order, so the blend maps
+//        filter correctly across the edges the blocks share, and only one
+//        texture per layer group is required for every block on the page.
+// Note : Blocks of a paged terrain come and go, and so each is laid out on a
+//        page of its own, creating its own blend textures (CreateResources).
+//-----------------------------------------------------------------------------
+bool CTerrain::CreateBlendAtlas( )
+{
+    HRESULT hRet;
+    ULONG   i, BlendWidth  = m_nQuadsWide * m_nBlendTexRatio;
+    ULONG   BlendHeight = m_nQuadsHigh * m_nBlendTexRatio;
+    USHORT  GroupCount  = GetBlendGroupCount();
+
+    // Place as many blocks as required (and will fit) on each page. A block's
+    // blend texture need not be a power of two in size, so neither is the
+    // area the blocks cover, and the page is rounded up to one below.
+    m_nAtlasBlocksWide = 1;
+    m_nAtlasBlocksHigh = 1;
+    if ( !m_Pager.IsOpen() )
+    {
+        while ( m_nAtlasBlocksWide < m_nBlocksWide && RoundUpPow2( BlendWidth  * m_nAtlasBlocksWide * 2 ) <= m_nAtlasMaxSize ) m_nAtlasBlocksWide *= 2;
+        while ( m_nAtlasBlocksHigh < m_nBlocksHigh && RoundUpPow2( BlendHeight * m_nAtlasBlocksHigh * 2 ) <= m_nAtlasMaxSize ) m_nAtlasBlocksHigh *= 2;
+
+    } // End if not paged
+
+    // Store the page layout
+    m_nAtlasPagesWide = (m_nBlocksWide + m_nAtlasBlocksWide - 1) / m_nAtlasBlocksWide;
+    m_nAtlasPageCount = m_nAtlasPagesWide * ((m_nBlocksHigh + m_nAtlasBlocksHigh - 1) / m_nAtlasBlocksHigh);
+    m_nAtlasWidth     = RoundUpPow2( BlendWidth  * m_nAtlasBlocksWide );
+    m_nAtlasHeight    = RoundUpPow2( BlendHeight * m_nAtlasBlocksHigh );
+
+    // Nothing to create when paging, or when there are no layers to blend
+    if ( m_Pager.IsOpen() || GroupCount == 0 ) return true;
+
+    // Allocate the page textures, filled in as each block is uploaded
+    m_pBlendAtlas = new LPDIRECT3DTEXTURE9[ m_nAtlasPageCount * GroupCount ];
+    if ( !m_pBlendAtlas ) return false;
+    ZeroMemory( m_pBlendAtlas, m_nAtlasPageCount * GroupCount * sizeof(LPDIRECT3DTEXTURE9) );
+
+    for ( i = 0; i < m_nAtlasPageCount * GroupCount; i++ )
+    {
+        hRet = m_pD3DDevice->CreateTexture( m_nAtlasWidth, m_nAtlasHeight, 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &m_pBlendAtlas[i], NULL );
+        if ( FAILED(hRet) ) return false;
+
+    } // Next Texture
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetBlendAtlasPlacement ()
+// Desc : Retrieves the blend atlas page, and the area of it in texels, which
+//        holds the blend textures of the block starting at the position
+//        specified.
+//-----------------------------------------------------------------------------
+void CTerrain::GetBlendAtlasPlacement( ULONG StartX, ULONG StartZ, ULONG & Page, RECT & Rect ) const
+{
+    ULONG BlockX = StartX / m_nQuadsWide, BlockZ = StartZ / m_nQuadsHigh;
+    ULONG Width  = m_nQuadsWide * m_nBlendTexRatio, Height = m_nQuadsHigh * m_nBlendTexRatio;
+
+    Page        = (BlockX / m_nAtlasBlocksWide) + (BlockZ / m_nAtlasBlocksHigh) * m_nAtlasPagesWide;
+    Rect.left   = (BlockX % m_nAtlasBlocksWide) * Width;
+    Rect.top    = (BlockZ % m_nAtlasBlocksHigh) * Height;
+    Rect.right  = Rect.left + Width;
+    Rect.bottom = Rect.top  + Height;
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildQuadTree () (Private)
+// Desc : Builds a quadtree over the grid of terrain blocks. Each node stores
+//        the combined bounds of the blocks beneath it, and those blocks form
+//        a contiguous run of m_pQuadBlocks so that a node lying wholly within
+//        the frustum can be accepted without visiting its children.
+//-----------------------------------------------------------------------------
+bool CTerrain::BuildQuadTree( )
+{
+    // Validate requirements
+    if ( m_nBlockCount == 0 || !m_pBlock ) return false;
+
+    // Every node which is not a leaf has at least two children, so no more
+    // than twice the number of blocks are ever required
+    m_pQuadNodes     = new QuadNode[ m_nBlockCount * 2 ];
+    m_pQuadBlocks    = new CTerrainBlock*[ m_nBlockCount ];
+    m_pVisibleBlocks = new CTerrainBlock*[ m_nBlockCount ];
+    m_pLODBlocks     = new CTerrainBlock*[ m_nBlockCount ];
+    m_pLODQueue      = new CTerrainBlock*[ m_nBlockCount ];
+    if ( !m_pQuadNodes || !m_pQuadBlocks || !m_pVisibleBlocks || !m_pLODBlocks || !m_pLODQueue ) return false;
+
+    // Build from the root down
+    m_nQuadNodeCount  = 1;
+    m_nQuadBlockCount = 0;
+    m_nVisibleCount   = 0;
+    BuildQuadNode( 0, 0, 0, m_nBlocksWide, m_nBlocksHigh );
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildQuadNode () (Private)
+// Desc : Fills out the node specified, covering the blocks in the range
+//        [X0, X1) x [Z0, Z1), splitting the range in half along each side
+//        which spans more than one block.
+//-----------------------------------------------------------------------------
+void CTerrain::BuildQuadNode( ULONG Node, ULONG X0, ULONG Z0, ULONG X1, ULONG Z1 )
+{
+    ULONG i, MidX, MidZ, RangeX[3], RangeZ[3], CountX, CountZ, x, z;
+
+    // Note : The node array is never reallocated, so this stays valid
+    QuadNode & N = m_pQuadNodes[ Node ];
+    N.FirstBlock = m_nQuadBlockCount;
+    N.FirstChild = 0;
+    N.ChildCount = 0;
+
+    // A single block becomes a leaf
+    if ( X1 - X0 == 1 && Z1 - Z0 == 1 )
+    {
+        CTerrainBlock * pBlock = m_pBlock[ X0 + Z0 * m_nBlocksWide ];
+        m_pQuadBlocks[ m_nQuadBlockCount++ ] = pBlock;
+        N.BoundsMin  = pBlock->m_BoundsMin;
+        N.BoundsMax  = pBlock->m_BoundsMax;
+        N.BlockCount = 1;
+        return;
+
+    } // End if leaf
+
+    // Split each side in half where possible
+    MidX = ( X1 - X0 > 1 ) ? (X0 + X1) / 2 : X1;
+    MidZ = ( Z1 - Z0 > 1 ) ? (Z0 + Z1) / 2 : Z1;
+    RangeX[0] = X0; RangeX[1] = MidX; RangeX[2] = X1; CountX = ( MidX < X1 ) ? 2 : 1;
+    RangeZ[0] = Z0; RangeZ[1] = MidZ; RangeZ[2] = Z1; CountZ = ( MidZ < Z1 ) ? 2 : 1;
+
+    // Reserve the children together, then build each
+    N.FirstChild      = m_nQuadNodeCount;
+    N.ChildCount      = CountX * CountZ;
+    m_nQuadNodeCount += N.ChildCount;
+
+    for ( i = 0, z = 0; z < CountZ; z++ )
+    {
+        for ( x = 0; x < CountX; x++, i++ )
+        {
+            BuildQuadNode( N.FirstChild + i, RangeX[x], RangeZ[z], RangeX[x + 1], RangeZ[z + 1] );
 
         } // Next Column
-    
+
     } // Next Row
 
-    // Success!!
+    // Combine the child bounds
+    N.BoundsMin = m_pQuadNodes[ N.FirstChild ].BoundsMin;
+    N.BoundsMax = m_pQuadNodes[ N.FirstChild ].BoundsMax;
+    for ( i = 1; i < N.ChildCount; i++ )
+    {
+        const QuadNode & Child = m_pQuadNodes[ N.FirstChild + i ];
+        D3DXVec3Minimize( &N.BoundsMin, &N.BoundsMin, &Child.BoundsMin );
+        D3DXVec3Maximize( &N.BoundsMax, &N.BoundsMax, &Child.BoundsMax );
+
+    } // Next Child
+
+    N.BlockCount = m_nQuadBlockCount - N.FirstBlock;
+}
+
+//-----------------------------------------------------------------------------
+// Name : CollectVisibleBlocks () (Private)
+// Desc : Builds the list of blocks which lie within the camera's frustum, by
+//        walking the quadtree from the root with all six planes enabled.
+//-----------------------------------------------------------------------------
+void CTerrain::CollectVisibleBlocks( CCamera * pCamera )
+{
+    m_nVisibleCount = 0;
+    if ( !m_pQuadNodes ) return;
+
+    // Without a camera every block is visible
+    if ( !pCamera )
+    {
+        memcpy( m_pVisibleBlocks, m_pQuadBlocks, m_nBlockCount * sizeof(CTerrainBlock*) );
+        m_nVisibleCount = m_nBlockCount;
+        return;
+
+    } // End if no camera
+
+    // Walk the tree
+    CullQuadNode( 0, 0x3F, pCamera );
+}
+
+//-----------------------------------------------------------------------------
+// Name : CullQuadNode () (Private)
+// Desc : Tests the node against each frustum plane still set in 'PlaneMask'.
+//        Nodes outside the frustum are skipped, nodes wholly inside have all
+//        of their blocks added without further tests, and the children of
+//        any others are visited testing only the planes they may still cross.
+//-----------------------------------------------------------------------------
+void CTerrain::CullQuadNode( ULONG Node, ULONG PlaneMask, CCamera * pCamera )
+{
+    ULONG i;
+    const QuadNode & N = m_pQuadNodes[ Node ];
+
+    // Skip the node if it is outside of the frustum
+    if ( PlaneMask && !pCamera->BoundsInFrustum( N.BoundsMin, N.BoundsMax, PlaneMask ) ) return;
+
+    // Wholly inside (or a leaf), accept every block beneath it
+    if ( PlaneMask == 0 || N.ChildCount == 0 )
+    {
+        memcpy( &m_pVisibleBlocks[ m_nVisibleCount ], &m_pQuadBlocks[ N.FirstBlock ], N.BlockCount * sizeof(CTerrainBlock*) );
+        m_nVisibleCount += N.BlockCount;
+        return;
+
+    } // End if accept
+
+    // Otherwise test the children
+    for ( i = 0; i < N.ChildCount; i++ ) CullQuadNode( N.FirstChild + i, PlaneMask, pCamera );
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildBlockJob () (Static, Private)
+// Desc : Thread pool job callback, builds the data for a single terrain block.
+//-----------------------------------------------------------------------------
+void CTerrain::BuildBlockJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex )
+{
+    const BlockBuildPass & Pass = *(const BlockBuildPass*)pContext;
+    CTerrain      * pTerrain = Pass.pTerrain;
+    CTerrainBlock * pBlock   = pTerrain->m_pBlock[ JobIndex ];
+    ULONG           x        = (JobIndex % pTerrain->m_nBlocksWide) * pTerrain->m_nQuadsWide;
+    ULONG           z        = (JobIndex / pTerrain->m_nBlocksWide) * pTerrain->m_nQuadsHigh;
+    BLOCK_SOURCE    Source;
+
+    // Build the block, recording any failure for the caller
+    pTerrain->GetBlockSource( x, z, Source, Pass.ppBlendMaps, Pass.ppCoverage );
+    if ( !pBlock->BuildBlock( pTerrain, Source, x, z, pTerrain->m_nBlockWidth, pTerrain->m_nBlockHeight ) )
+    {
+        InterlockedIncrement( &pTerrain->m_nBlockFailures );
+
+    } // End if failed
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetBlockSource ()
+// Desc : Describes the data for the block starting at the sample specified,
+//        within the full heightmap, normal field and blend maps.
+// Note : 'ppBlendMaps' and 'ppCoverage' must contain the blend and coverage
+//        maps of each layer, and remain valid for as long as the source is used.
+//-----------------------------------------------------------------------------
+void CTerrain::GetBlockSource( ULONG StartX, ULONG StartZ, BLOCK_SOURCE & Source, const UCHAR ** ppBlendMaps, const UCHAR ** ppCoverage )
+{
+    ULONG Index = StartX + StartZ * m_nHeightMapWidth;
+
+    Source.pHeights     = m_pHeightMap + Index;
+    Source.HeightPitch  = m_nHeightMapWidth;
+    Source.pNormalX     = m_pNormalX + Index;
+    Source.pNormalY     = m_pNormalY + Index;
+    Source.pNormalZ     = m_pNormalZ + Index;
+    Source.NormalPitch  = m_nHeightMapWidth;
+    Source.NormalWidth  = m_nHeightMapWidth  - StartX;
+    Source.NormalHeight = m_nHeightMapHeight - StartZ;
+    Source.ppBlendMaps  = ppBlendMaps;
+    Source.BlendPitch   = (m_nHeightMapWidth - 1) * m_nBlendTexRatio;
+    Source.BlendOffset  = (StartX * m_nBlendTexRatio) + (StartZ * m_nBlendTexRatio) * Source.BlendPitch;
+    Source.ppCoverage   = ppCoverage;
+    Source.CoveragePitch  = m_nHeightMapWidth - 1;
+    Source.CoverageOffset = StartX + StartZ * Source.CoveragePitch;
+}
+
+//-----------------------------------------------------------------------------
+// Name : OpenCookedTerrain () (Private)
+// Desc : Maps the cooked terrain file into memory and, if it was built from
+//        input files matching the hash specified, takes the processed
+//        heightmap and normal field from it. The blocks are read later by
+//        LoadCookedBlocks.
+// Note : Returns false if the file is missing, out of date or invalid, in
+//        which case nothing is modified.
+//-----------------------------------------------------------------------------
+bool CTerrain::OpenCookedTerrain( LPCTSTR FileName, unsigned __int64 Hash )
+{
+    HANDLE  hFile = NULL, hMapping = NULL;
+    ULONG   Count = m_nHeightMapWidth * m_nHeightMapHeight;
+    ULONG   BlockCount;
+    PROFILE_ZONE( "CTerrain::OpenCookedTerrain" );
+
+    // Release any previous view
+    CloseCookedTerrain();
+    if ( m_nQuadsWide == 0 || m_nQuadsHigh == 0 ) return false;
+    BlockCount = ((m_nHeightMapWidth - 1) / m_nQuadsWide) * ((m_nHeightMapHeight - 1) / m_nQuadsHigh);
+
+    // Open up the cooked file
+    hFile = CreateFile( FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if ( hFile == INVALID_HANDLE_VALUE ) return false;
+
+    // Must at least contain the header, heightmap and normal field
+    m_nCookedSize = GetFileSize( hFile, NULL );
+    if ( m_nCookedSize < sizeof(CookedHeader) + Count * 4 * sizeof(float) ) { CloseHandle( hFile ); m_nCookedSize = 0; return false; }
+
+    // Map the whole file (the view keeps the file open until unmapped)
+    hMapping = CreateFileMapping( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+    CloseHandle( hFile );
+    if ( !hMapping ) { m_nCookedSize = 0; return false; }
+
+    m_pCookedData = (const UCHAR*)MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+    CloseHandle( hMapping );
+    if ( !m_pCookedData ) { m_nCookedSize = 0; return false; }
+
+    // Validate the header against the inputs and the terrain definition
+    const CookedHeader * pHeader = (const CookedHeader*)m_pCookedData;
+    if ( pHeader->Magic         != COOKED_MAGIC      ||
+         pHeader->Version       != COOKED_VERSION    ||
+         pHeader->Hash          != Hash              ||
+         pHeader->FileSize      != m_nCookedSize     ||
+         pHeader->TerrainWidth  != m_nHeightMapWidth ||
+         pHeader->TerrainHeight != m_nHeightMapHeight||
+         pHeader->BlockWidth    != m_nBlockWidth     ||
+         pHeader->BlockHeight   != m_nBlockHeight    ||
+         pHeader->BlockCount    != BlockCount        ||
+         pHeader->VertexSize    != sizeof(CVertex) ) { CloseCookedTerrain(); return false; }
+
+    // Allocate the heightmap and normal field
+    float * pHeightMap = new float[ Count ];
+    float * pNormalX   = new float[ Count ];
+    float * pNormalY   = new float[ Count ];
+    float * pNormalZ   = new float[ Count ];
+    if ( !pHeightMap || !pNormalX || !pNormalY || !pNormalZ )
+    {
+        if ( pHeightMap ) delete []pHeightMap;
+        if ( pNormalX   ) delete []pNormalX;
+        if ( pNormalY   ) delete []pNormalY;
+        if ( pNormalZ   ) delete []pNormalZ;
+        CloseCookedTerrain();
+        return false;
+
+    } // End if failed
+
+    // Copy them from the file
+    const float * pData = (const float*)(m_pCookedData + sizeof(CookedHeader));
+    memcpy( pHeightMap, pData,             Count * sizeof(float) );
+    memcpy( pNormalX,   pData + Count,     Count * sizeof(float) );
+    memcpy( pNormalY,   pData + Count * 2, Count * sizeof(float) );
+    memcpy( pNormalZ,   pData + Count * 3, Count * sizeof(float) );
+    m_pHeightMap = pHeightMap;
+    m_pNormalX   = pNormalX;
+    m_pNormalY   = pNormalY;
+    m_pNormalZ   = pNormalZ;
+
+    // Success!
     return true;
 }
 
 //-----------------------------------------------------------------------------
-// Name : FilterHeightMap ()
-// Desc : Filter the heightmap to smooth out those bumps.
+// Name : CloseCookedTerrain () (Private)
+// Desc : Unmaps the cooked terrain file, if open.
+//-----------------------------------------------------------------------------
+void CTerrain::CloseCookedTerrain( )
+{
+    if ( m_pCookedData ) UnmapViewOfFile( (void*)m_pCookedData );
+    m_pCookedData = NULL;
+    m_nCookedSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : LoadCookedBlocks () (Private)
+// Desc : Reads each block from the open cooked terrain file, uploading its
+//        vertices, indices and blend textures directly from the mapped view.
 //-----------------------------------------------------------------------------
-void CTerrain::FilterHeightMap( )
+bool CTerrain::LoadCookedBlocks( )
 {
-    ULONG x, z;
-    float Value;
+    ULONG Counter, Count = m_nHeightMapWidth * m_nHeightMapHeight;
+    PROFILE_ZONE( "CTerrain::LoadCookedBlocks" );
 
     // Validate requirements
-    if (!m_pHeightMap) return;
-    
-    // Allocate the result
-    float * pResult = new float[m_nHeightMapWidth * m_nHeightMapHeight];
-    if (!pResult) return;
+    if ( !m_pCookedData ) return false;
+    const CookedHeader * pHeader = (const CookedHeader*)m_pCookedData;
+    if ( pHeader->BlockCount != m_nBlockCount || pHeader->LayerCount != m_nLayerCount ) return false;
+
+    // The blocks follow the heightmap and normal field
+    const UCHAR * pData = m_pCookedData + sizeof(CookedHeader) + Count * 4 * sizeof(float);
+    const UCHAR * pEnd  = m_pCookedData + m_nCookedSize;
+
+    for ( Counter = 0; Counter < m_nBlockCount; Counter++ )
+    {
+        ULONG x = (Counter % m_nBlocksWide) * m_nQuadsWide;
+        ULONG z = (Counter / m_nBlocksWide) * m_nQuadsHigh;
+        if ( !m_pBlock[Counter]->ReadCooked( this, x, z, pData, pEnd ) ) return false;
+
+    } // Next Block
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : WriteCookedTerrain () (Private)
+// Desc : Writes the processed heightmap, normal field and built block data
+//        to the cooked terrain file, tagged with the input hash specified.
+// Note : Must be called after the blocks are built, but before their data is
+//        released by CreateResources. Any partial file is deleted on failure.
+//-----------------------------------------------------------------------------
+bool CTerrain::WriteCookedTerrain( LPCTSTR FileName, unsigned __int64 Hash )
+{
+    CookedHeader Header;
+    HANDLE       hFile;
+    ULONG        Counter, Count = m_nHeightMapWidth * m_nHeightMapHeight;
+    bool         Result;
+    PROFILE_ZONE( "CTerrain::WriteCookedTerrain" );
+
+    // Validate requirements
+    if ( !m_pHeightMap || !m_pNormalX || !m_pNormalY || !m_pNormalZ ) return false;
+
+    // Build the header (the size is filled in once known)
+    ZeroMemory( &Header, sizeof(CookedHeader) );
+    Header.Magic         = COOKED_MAGIC;
+    Header.Version       = COOKED_VERSION;
+    Header.Hash          = Hash;
+    Header.TerrainWidth  = m_nHeightMapWidth;
+    Header.TerrainHeight = m_nHeightMapHeight;
+    Header.BlockWidth    = m_nBlockWidth;
+    Header.BlockHeight   = m_nBlockHeight;
+    Header.BlockCount    = m_nBlockCount;
+    Header.LayerCount    = m_nLayerCount;
+    Header.VertexSize    = sizeof(CVertex);
+
+    // Create the file
+    hFile = CreateFile( FileName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if ( hFile == INVALID_HANDLE_VALUE ) return false;
+
+    // Write the header, heightmap and normal field
+    Result = WriteData( hFile, &Header, sizeof(CookedHeader) ) &&
+             WriteData( hFile, m_pHeightMap, Count * sizeof(float) ) &&
+             WriteData( hFile, m_pNormalX, Count * sizeof(float) ) &&
+             WriteData( hFile, m_pNormalY, Count * sizeof(float) ) &&
+             WriteData( hFile, m_pNormalZ, Count * sizeof(float) );
+
+    // Write each block
+    for ( Counter = 0; Result && Counter < m_nBlockCount; Counter++ )
+    {
+        Result = m_pBlock[Counter]->WriteCooked( hFile );
+
+    } // Next Block
+
+    // Rewrite the header with the final size
+    if ( Result )
+    {
+        Header.FileSize = GetFileSize( hFile, NULL );
+        Result = ( SetFilePointer( hFile, 0, NULL, FILE_BEGIN ) == 0 ) && WriteData( hFile, &Header, sizeof(CookedHeader) );
 
-    // Copy over data to retain edges
-    memcpy( pResult, m_pHeightMap, m_nHeightMapWidth * m_nHeightMapHeight * sizeof(float) );
+    } // End if written
 
-    // Loop through and filter values (simple box style filter)
-    for ( z = 1; z < m_nHeightMapHeight - 1; ++z )
+    // Clean up, removing the file if it is incomplete
+    CloseHandle( hFile );
+    if ( !Result ) DeleteFile( FileName );
+    return Result;
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildPageFile () (Private)
+// Desc : Writes the page file from the input files a band of block rows at a
+//        time (see CTerrainPager::WritePageFile), so that the heightmap, its
+//        normal field and the layer blend maps are never held in full.
+// Note : Each band is loaded into a separate terrain, with worker threads of
+//        its own, leaving this terrain's definition untouched.
+//-----------------------------------------------------------------------------
+bool CTerrain::BuildPageFile( LPCTSTR FileName, LPCTSTR DefFile, LPCTSTR HeightMapFile, HEIGHTMAP_FORMAT Format,
+                              ULONG FilterRadius, ULONG FilterIterations, bool FilterGaussian, unsigned __int64 Hash )
+{
+    CTerrain      Band;
+    PageBuildPass Pass;
+    PROFILE_ZONE( "CTerrain::BuildPageFile" );
+
+    // The band filters its heightmap and builds its normals in parallel
+    if ( !Band.m_ThreadPool.Create() ) return false;
+
+    // Describe the source data
+    Pass.pTerrain         = this;
+    Pass.pBand            = &Band;
+    Pass.DefFile          = DefFile;
+    Pass.HeightMapFile    = HeightMapFile;
+    Pass.Format           = Format;
+    Pass.FilterRadius     = FilterRadius;
+    Pass.FilterIterations = FilterIterations;
+    Pass.FilterGaussian   = FilterGaussian;
+
+    // Write the file
+    return CTerrainPager::WritePageFile( this, FileName, Hash, LoadPageBand, &Pass );
+}
+
+//-----------------------------------------------------------------------------
+// Name : LoadPageBand () (Static, Private)
+// Desc : Page file band callback (see BuildPageFile). Loads the heightmap
+//        rows requested into the band terrain, then filters them and builds
+//        their normals and blend maps just as LoadTerrain would.
+// Note : Enough rows either side are included that the filter, the normals
+//        and the layer occlusion test give the same result for the rows
+//        requested as they would for the whole heightmap.
+//-----------------------------------------------------------------------------
+CTerrain * CTerrain::LoadPageBand( void * pContext, ULONG FirstRow, ULONG RowCount, ULONG & BandRow )
+{
+    const PageBuildPass & Pass = *(const PageBuildPass*)pContext;
+    CTerrain * pTerrain = Pass.pTerrain, * pBand = Pass.pBand;
+    ULONG      Margin, EndRow;
+
+    // The edge rows of the band are not filtered, and each filter iteration
+    // spreads that Radius rows further in. One more row either side is
+    // needed by the normals and the occlusion test.
+    Margin = 1;
+    if ( Pass.FilterRadius > 0 ) Margin += min( Pass.FilterRadius, FILTER_MAX_RADIUS ) * Pass.FilterIterations;
+    BandRow = ( FirstRow > Margin ) ? FirstRow - Margin : 0;
+    EndRow  = min( FirstRow + RowCount + Margin, pTerrain->m_nHeightMapHeight );
+
+    // Discard the previous band, and describe this one
+    pBand->Release();
+    pBand->SetD3DDevice( pTerrain->m_pD3DDevice, pTerrain->m_bHardwareTnL );
+    pBand->m_vecScale         = pTerrain->m_vecScale;
+    pBand->m_nBlendTexRatio   = pTerrain->m_nBlendTexRatio;
+    pBand->m_nHeightMapWidth  = pTerrain->m_nHeightMapWidth;
+    pBand->m_nHeightMapHeight = EndRow - BandRow;
+
+    // Load and process the band's rows
+    pBand->m_pHeightMap = new float[ pBand->m_nHeightMapWidth * pBand->m_nHeightMapHeight ];
+    if ( !pBand->m_pHeightMap ) return NULL;
+    if ( !pBand->LoadHeightMap( Pass.HeightMapFile, Pass.Format, BandRow, pTerrain->m_nHeightMapHeight ) ) return NULL;
+    pBand->FilterHeightMap( Pass.FilterRadius, Pass.FilterIterations, Pass.FilterGaussian );
+    if ( !pBand->GenerateNormals() ) return NULL;
+    if ( !pBand->GenerateLayers( Pass.DefFile, true, BandRow ) ) return NULL;
+
+    // Success!
+    return pBand;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GenerateLODIndices () (Private)
+// Desc : Builds the triangle lists used to render a block at each detail
+//        level. Every level below the coarsest has a list for each of the 16
+//        combinations of edges which border a coarser neighbour. Along those
+//        edges every other vertex is collapsed onto its predecessor, so the
+//        edge matches the neighbour exactly and no cracks appear.
+// Note : The lists are shared by every block, and are stored in a single
+//        index buffer.
+//-----------------------------------------------------------------------------
+bool CTerrain::GenerateLODIndices( )
+{
+    HRESULT hRet;
+    ULONG   Level, Edges, EdgeCount, Step, CellsWide, CellsHigh, cx, cz, t, v;
+    ULONG   IndexCount = 0, Corner[4][2], Index[4];
+    long    gx, gz;
+    USHORT *pIndices = NULL, *pIndex = NULL;
+    ULONG   Usage = D3DUSAGE_WRITEONLY;
+    void   *pData = NULL;
+
+    // Vertex order of the two triangles in each cell (as used by the splats)
+    static const ULONG Triangles[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+
+    // Validate requirements
+    if ( !m_pD3DDevice || m_nQuadsWide == 0 || m_nQuadsHigh == 0 ) return false;
+
+    // Count the indices required by every list
+    for ( Level = 0; Level < m_nLODCount; Level++ )
     {
-        for ( x = 1; x < m_nHeightMapWidth - 1; ++x )
+        Step      = 1 << Level;
+        EdgeCount = ( Level + 1 < m_nLODCount ) ? TERRAIN_LOD_EDGES : 1;
+        IndexCount += EdgeCount * (m_nQuadsWide / Step) * (m_nQuadsHigh / Step) * 6;
+
+    } // Next Level
+
+    // Allocate the index data
+    pIndices = new USHORT[ IndexCount ];
+    if ( !pIndices ) return false;
+    pIndex = pIndices;
+
+    for ( Level = 0; Level < m_nLODCount; Level++ )
+    {
+        Step      = 1 << Level;
+        CellsWide = m_nQuadsWide / Step;
+        CellsHigh = m_nQuadsHigh / Step;
+
+        // The coarsest level never borders a coarser neighbour
+        EdgeCount = ( Level + 1 < m_nLODCount ) ? TERRAIN_LOD_EDGES : 1;
+
+        for ( Edges = 0; Edges < TERRAIN_LOD_EDGES; Edges++ )
         {
-            Value  = m_pHeightMap[ (x - 1) + (z - 1) * m_nHeightMapWidth ]; 
-            Value += m_pHeightMap[ (x    ) + (z - 1) * m_nHeightMapWidth ]; 
-            Value += m_pHeightMap[ (x + 1) + (z - 1) * m_nHeightMapWidth ]; 
+            // Edge combinations which cannot occur share the plain list
+            if ( Edges >= EdgeCount )
+            {
+                m_nLODStart[Level][Edges]      = m_nLODStart[Level][0];
+                m_nLODPrimitives[Level][Edges] = m_nLODPrimitives[Level][0];
+                continue;
 
-            Value += m_pHeightMap[ (x - 1) + (z    ) * m_nHeightMapWidth ]; 
-            Value += m_pHeightMap[ (x    ) + (z    ) * m_nHeightMapWidth ]; 
-            Value += m_pHeightMap[ (x + 1) + (z    ) * m_nHeightMapWidth ]; 
+            } // End if unused
 
-            Value += m_pHeightMap[ (x - 1) + (z + 1) * m_nHeightMapWidth ]; 
-            Value += m_pHeightMap[ (x    ) + (z + 1) * m_nHeightMapWidth ]; 
-            Value += m_pHeightMap[ (x + 1) + (z + 1) * m_nHeightMapWidth ]; 
+            m_nLODStart[Level][Edges]      = (ULONG)(pIndex - pIndices);
+            m_nLODPrimitives[Level][Edges] = 0;
 
-            // Store the result
-            pResult[ x + z * m_nHeightMapWidth ] = Value / 9.0f;
+            for ( cz = 0; cz < CellsHigh; cz++ )
+            {
+                for ( cx = 0; cx < CellsWide; cx++ )
+                {
+                    // Corners of this cell, in cells (x,z), (x,z+1), (x+1,z+1), (x+1,z)
+                    Corner[0][0] = cx;     Corner[0][1] = cz;
+                    Corner[1][0] = cx;     Corner[1][1] = cz + 1;
+                    Corner[2][0] = cx + 1; Corner[2][1] = cz + 1;
+                    Corner[3][0] = cx + 1; Corner[3][1] = cz;
 
-        } // Next X
+                    for ( v = 0; v < 4; v++ )
+                    {
+                        gx = (long)Corner[v][0];
+                        gz = (long)Corner[v][1];
+
+                        // Collapse odd vertices on stitched edges
+                        if ( (Edges & LOD_EDGE_NEGZ) && gz == 0                && (gx & 1) ) gx--;
+                        if ( (Edges & LOD_EDGE_POSZ) && gz == (long)CellsHigh  && (gx & 1) ) gx--;
+                        if ( (Edges & LOD_EDGE_NEGX) && gx == 0                && (gz & 1) ) gz--;
+                        if ( (Edges & LOD_EDGE_POSX) && gx == (long)CellsWide  && (gz & 1) ) gz--;
+
+                        Index[v] = (gx * Step) + (gz * Step) * m_nBlockWidth;
+
+                    } // Next Corner
+
+                    // Store each triangle which has not collapsed
+                    for ( t = 0; t < 2; t++ )
+                    {
+                        ULONG i0 = Index[ Triangles[t][0] ], i1 = Index[ Triangles[t][1] ], i2 = Index[ Triangles[t][2] ];
+                        if ( i0 == i1 || i1 == i2 || i0 == i2 ) continue;
+
+                        *pIndex++ = (USHORT)i0;
+                        *pIndex++ = (USHORT)i1;
+                        *pIndex++ = (USHORT)i2;
+                        m_nLODPrimitives[Level][Edges]++;
+
+                    } // Next Triangle
 
-    } // Next Z
+                } // Next Cell Column
 
-    // Release the old array
-    delete []m_pHeightMap;
+            } // Next Cell Row
 
-    // Store the new one
-    m_pHeightMap = pResult;
+        } // Next Edge Combination
 
+    } // Next Level
+
+    // Create the index buffer, sized to the indices actually written
+    IndexCount = (ULONG)(pIndex - pIndices);
+    if ( !m_bHardwareTnL ) Usage |= D3DUSAGE_SOFTWAREPROCESSING;
+    hRet = m_pD3DDevice->CreateIndexBuffer( IndexCount * sizeof(USHORT), Usage, D3DFMT_INDEX16, D3DPOOL_MANAGED, &m_pLODIndexBuffer, NULL );
+    if ( FAILED(hRet) ) { delete []pIndices; return false; }
+
+    // Fill it
+    hRet = m_pLODIndexBuffer->Lock( 0, IndexCount * sizeof(USHORT), &pData, 0 );
+    if ( FAILED(hRet) ) { delete []pIndices; return false; }
+    memcpy( pData, pIndices, IndexCount * sizeof(USHORT) );
+    m_pLODIndexBuffer->Unlock();
+
+    // Clean up
+    delete []pIndices;
+
+    // Success!
+    return true;
 }
 
 //-----------------------------------------------------------------------------
-// Name : GetHeightMapNormal ()
-// Desc : Retrieves the normal at this position in the heightmap
+// Name : UpdateLOD () (Private)
+// Desc : Selects the detail level used to render each visible block this
+//        frame. Each block uses the coarsest level whose height error,
+//        projected to the screen at the block's distance from the camera, is
+//        within the maximum error allowed. Neighbouring blocks are then
+//        limited to within one level of each other, and the edges to stitch
+//        recorded.
+// Note : Must follow CollectVisibleBlocks. Only the visible blocks and those
+//        across their edges are considered, the rest are not rendered and
+//        keep whatever level they last had.
+//-----------------------------------------------------------------------------
+void CTerrain::UpdateLOD( CCamera * pCamera )
+{
+    ULONG       i, e, QueueCount;
+    USHORT      Level;
+    float       Distance, MaxError;
+    D3DXVECTOR3 Position, Nearest;
+
+    // Without a camera, everything is rendered in full
+    if ( !pCamera || m_nLODCount < 2 )
+    {
+        for ( i = 0; i < m_nVisibleCount; i++ ) { m_pVisibleBlocks[i]->m_nLOD = 0; m_pVisibleBlocks[i]->m_nLODEdges = 0; }
+        return;
+
+    } // End if no camera
+
+    // Build the list of visible blocks and their edge neighbours, each block
+    // is added once (marked with the current LOD frame)
+    m_nLODFrame++;
+    m_nLODBlockCount = 0;
+    for ( i = 0; i < m_nVisibleCount; i++ )
+    {
+        for ( e = 0; e < 5; e++ )
+        {
+            CTerrainBlock * pBlock = ( e < 4 ) ? m_pVisibleBlocks[i]->m_pNeighbours[ LOD_EDGE_NEIGHBOUR[e] ] : m_pVisibleBlocks[i];
+            if ( !pBlock || pBlock->m_nLODFrame == m_nLODFrame ) continue;
+
+            pBlock->m_nLODFrame = m_nLODFrame;
+            m_pLODBlocks[ m_nLODBlockCount++ ] = pBlock;
+
+        } // Next Edge
+
+    } // Next Visible Block
+
+    // Pixels covered by one world unit at unit distance
+    const D3DVIEWPORT9 & Viewport = pCamera->GetViewport();
+    float PixelScale = (float)Viewport.Height / (2.0f * tanf( D3DXToRadian( pCamera->GetFOV() ) * 0.5f ));
+    Position = pCamera->GetRenderPosition();
+
+    // Select the level for each block, and queue it to check its neighbours
+    for ( i = 0; i < m_nLODBlockCount; i++ )
+    {
+        CTerrainBlock * pBlock = m_pLODBlocks[i];
+
+        // Distance to the nearest point of the block's bounds
+        Nearest.x = max( pBlock->m_BoundsMin.x, min( Position.x, pBlock->m_BoundsMax.x ) );
+        Nearest.y = max( pBlock->m_BoundsMin.y, min( Position.y, pBlock->m_BoundsMax.y ) );
+        Nearest.z = max( pBlock->m_BoundsMin.z, min( Position.z, pBlock->m_BoundsMax.z ) );
+        Distance  = D3DXVec3Length( &(Nearest - Position) );
+
+        // Largest world space error which projects within the limit
+        MaxError = m_fLODMaxError * Distance / PixelScale;
+        for ( Level = m_nLODCount - 1; Level > 0; Level-- )
+        {
+            if ( pBlock->m_fLODError[Level] <= MaxError ) break;
+
+        } // Next Level
+
+        pBlock->m_nLOD       = Level;
+        pBlock->m_bLODQueued = true;
+        m_pLODQueue[i]       = pBlock;
+
+    } // Next Block
+    QueueCount = m_nLODBlockCount;
+
+    // Refine any neighbour more than one level coarser than the block taken
+    // from the queue, queueing it in turn. Levels only ever decrease, so each
+    // block is queued no more than m_nLODCount times, and is never in the
+    // queue twice at once.
+    while ( QueueCount > 0 )
+    {
+        CTerrainBlock * pBlock = m_pLODQueue[ --QueueCount ];
+        pBlock->m_bLODQueued = false;
+
+        for ( e = 0; e < 4; e++ )
+        {
+            CTerrainBlock * pNeighbour = pBlock->m_pNeighbours[ LOD_EDGE_NEIGHBOUR[e] ];
+            if ( !pNeighbour || pNeighbour->m_nLODFrame != m_nLODFrame ) continue;
+            if ( pNeighbour->m_nLOD <= pBlock->m_nLOD + 1 ) continue;
+
+            pNeighbour->m_nLOD = pBlock->m_nLOD + 1;
+            if ( !pNeighbour->m_bLODQueued )
+            {
+                pNeighbour->m_bLODQueued = true;
+                m_pLODQueue[ QueueCount++ ] = pNeighbour;
+
+            } // End if not queued
+
+        } // Next Edge
+
+    } // Next Queued Block
+
+    // Record the edges of each visible block bordering a coarser neighbour
+    for ( i = 0; i < m_nVisibleCount; i++ )
+    {
+        CTerrainBlock * pBlock = m_pVisibleBlocks[i];
+        pBlock->m_nLODEdges = 0;
+        for ( e = 0; e < 4; e++ )
+        {
+            CTerrainBlock * pNeighbour = pBlock->m_pNeighbours[ LOD_EDGE_NEIGHBOUR[e] ];
+            if ( pNeighbour && pNeighbour->m_nLOD > pBlock->m_nLOD ) pBlock->m_nLODEdges |= LOD_EDGE_FLAG[e];
+
+        } // Next Edge
+
+    } // Next Block
+}
+
 //-----------------------------------------------------------------------------
-D3DXVECTOR3 CTerrain::GetHeightMapNormal( ULONG x, ULONG z )
+// Name : LoadHeightMap () (Private)
+// Desc : Maps the RAW heightmap file specified into memory and converts its
+//        samples to the floating point heightmap in a single pass.
+// Note : The file must contain exactly one sample for each point of the
+//        TerrainSize specified. Samples are stored unscaled, i.e. 16 bit data
+//        ranges from 0 to 65535 and the 'Scale' y component should reflect this.
+//        When 'FileRows' is specified the file holds that many rows, and only
+//        the view of our rows, starting at 'FirstRow', is mapped.
+//-----------------------------------------------------------------------------
+bool CTerrain::LoadHeightMap( LPCTSTR FileName, HEIGHTMAP_FORMAT Format, ULONG FirstRow, ULONG FileRows )
 {
-	D3DXVECTOR3 Normal, Edge1, Edge2;
-	ULONG       HMIndex, HMAddX, HMAddZ;
-    float       y1, y2, y3;
+    HANDLE  hFile = NULL, hMapping = NULL;
+    UCHAR * pView = NULL, * pData = NULL;
+    ULONG   SampleSize, Count = m_nHeightMapWidth * m_nHeightMapHeight;
+    DWORD   SizeLow, SizeHigh, Skip;
+    bool    SSE2  = IsProcessorFeaturePresent( PF_XMMI64_INSTRUCTIONS_AVAILABLE ) != FALSE;
+    unsigned __int64 Offset;
+    SYSTEM_INFO      Info;
+
+    // Validate requirements
+    if ( FileRows == 0 ) FileRows = m_nHeightMapHeight;
+    if ( !m_pHeightMap || Count == 0 || FirstRow + m_nHeightMapHeight > FileRows ) return false;
 
+    // Size of each sample in the file
+    switch ( Format )
+    {
+        case HEIGHTMAP_8BIT:     SampleSize = 1; break;
+        case HEIGHTMAP_16BIT:
+        case HEIGHTMAP_16BIT_BE: SampleSize = 2; break;
+        case HEIGHTMAP_FLOAT:    SampleSize = 4; break;
+        default:                 return false;
+
+    } // End Switch
+
+    // Open up the heightmap file
+    hFile = CreateFile( FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if ( hFile == INVALID_HANDLE_VALUE ) return false;
+
+    // Validate the file size against the dimensions specified
+    SizeLow = GetFileSize( hFile, &SizeHigh );
+    if ( (((unsigned __int64)SizeHigh << 32) | SizeLow) != (unsigned __int64)m_nHeightMapWidth * FileRows * SampleSize ) { CloseHandle( hFile ); return false; }
+
+    // Map the file (the view keeps the file open until unmapped)
+    hMapping = CreateFileMapping( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+    CloseHandle( hFile );
+    if ( !hMapping ) return false;
+
+    // Map just our rows, the view must start on an allocation boundary
+    GetSystemInfo( &Info );
+    Offset = (unsigned __int64)m_nHeightMapWidth * FirstRow * SampleSize;
+    Skip   = (DWORD)(Offset % Info.dwAllocationGranularity);
+    Offset -= Skip;
+    pView  = (UCHAR*)MapViewOfFile( hMapping, FILE_MAP_READ, (DWORD)(Offset >> 32), (DWORD)(Offset & 0xFFFFFFFF), Skip + Count * SampleSize );
+    CloseHandle( hMapping );
+    if ( !pView ) return false;
+    pData = pView + Skip;
+
+    // Convert the samples
+    switch ( Format )
+    {
+        case HEIGHTMAP_8BIT:     ConvertHeights8 ( m_pHeightMap, pData, Count, SSE2 ); break;
+        case HEIGHTMAP_16BIT:    ConvertHeights16( m_pHeightMap, pData, Count, false, SSE2 ); break;
+        case HEIGHTMAP_16BIT_BE: ConvertHeights16( m_pHeightMap, pData, Count, true, SSE2 ); break;
+        case HEIGHTMAP_FLOAT:    memcpy( m_pHeightMap, pData, Count * sizeof(float) ); break;
+
+    } // End Switch
+
+    // Finish up
+    UnmapViewOfFile( pView );
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : FilterHeightMap ()
+// Desc : Filter the heightmap to smooth out those bumps. The (box or gaussian)
+//        kernel is applied as separate horizontal and vertical passes, each of
+//        which is split by rows across the thread pool.
+// Note : The outer edge of the heightmap is left unaltered, and samples beyond
+//        it are clamped to the edge. A radius of 1 is the original 3x3 box.
+//-----------------------------------------------------------------------------
+void CTerrain::FilterHeightMap( ULONG Radius, ULONG Iterations, bool Gaussian )
+{
+    float       Weights[ FILTER_MAX_RADIUS * 2 + 1 ], Total = 0.0f, Sigma;
+    ULONG       i, JobCount, Count = m_nHeightMapWidth * m_nHeightMapHeight;
+    long        k;
+    FilterPass  Pass;
+
+    // Validate requirements
+    if ( !m_pHeightMap || Radius == 0 || Iterations == 0 ) return;
+    if ( m_nHeightMapWidth < 3 || m_nHeightMapHeight < 3 ) return;
+    if ( Radius > FILTER_MAX_RADIUS ) Radius = FILTER_MAX_RADIUS;
+
+    // Grow the scratch buffer if required (it is retained for later calls)
+    if ( m_nFilterScratchSize < Count )
+    {
+        if ( m_pFilterScratch ) delete []m_pFilterScratch;
+        m_nFilterScratchSize = 0;
+        m_pFilterScratch     = new float[ Count ];
+        if ( !m_pFilterScratch ) return;
+        m_nFilterScratchSize = Count;
+
+    } // End if grow scratch
+
+    // Build the normalized kernel weights
+    Sigma = (float)Radius * 0.5f;
+    for ( k = -(long)Radius; k <= (long)Radius; k++ )
+    {
+        Weights[ k + Radius ] = Gaussian ? expf( -(float)(k * k) / (2.0f * Sigma * Sigma) ) : 1.0f;
+        Total += Weights[ k + Radius ];
+
+    } // Next Weight
+    for ( i = 0; i < Radius * 2 + 1; i++ ) Weights[i] /= Total;
+
+    // Set up the details shared by both passes
+    Pass.pKernel = Weights + Radius;
+    Pass.Radius  = (long)Radius;
+    Pass.Width   = (long)m_nHeightMapWidth;
+    Pass.Height  = (long)m_nHeightMapHeight;
+    Pass.SSE     = IsProcessorFeaturePresent( PF_XMMI_INSTRUCTIONS_AVAILABLE ) != FALSE;
+    JobCount     = (m_nHeightMapHeight + FILTER_JOB_ROWS - 1) / FILTER_JOB_ROWS;
+
+    for ( i = 0; i < Iterations; i++ )
+    {
+        // Filter horizontally into the scratch buffer
+        Pass.pSrc  = m_pHeightMap;
+        Pass.pDest = m_pFilterScratch;
+        m_ThreadPool.Execute( FilterRowsJob, &Pass, JobCount );
+
+        // Then vertically back into the heightmap
+        Pass.pSrc  = m_pFilterScratch;
+        Pass.pDest = m_pHeightMap;
+        m_ThreadPool.Execute( FilterColumnsJob, &Pass, JobCount );
+
+    } // Next Iteration
+
+}
+
+//-----------------------------------------------------------------------------
+// Name : GenerateNormals () (Private)
+// Desc : Builds the normal field, one normal for each heightmap sample, in
+//        parallel across the thread pool. Must be called again whenever the
+//        heightmap is altered.
+//-----------------------------------------------------------------------------
+bool CTerrain::GenerateNormals( )
+{
+    ULONG Count = m_nHeightMapWidth * m_nHeightMapHeight;
+
+    // Validate requirements
+    if ( !m_pHeightMap || m_nHeightMapWidth < 2 || m_nHeightMapHeight < 2 ) return false;
+
+    // Allocate the field (separate arrays for each component)
+    if ( !m_pNormalX ) m_pNormalX = new float[ Count ];
+    if ( !m_pNormalY ) m_pNormalY = new float[ Count ];
+    if ( !m_pNormalZ ) m_pNormalZ = new float[ Count ];
+    if ( !m_pNormalX || !m_pNormalY || !m_pNormalZ ) return false;
+
+    // Generate each row
+    m_ThreadPool.Execute( GenerateNormalsJob, this, m_nHeightMapHeight );
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : GenerateNormalsJob () (Static, Private)
+// Desc : Thread pool job callback, generates a single row of normals.
+//-----------------------------------------------------------------------------
+void CTerrain::GenerateNormalsJob( void * pContext, ULONG JobIndex, ULONG ThreadIndex )
+{
+    ((CTerrain*)pContext)->GenerateNormalRow( JobIndex );
+}
+
+//-----------------------------------------------------------------------------
+// Name : GenerateNormalRow () (Private)
+// Desc : Calculates the normals for the row of heightmap samples specified.
+//        Each is the normalized cross product of the edges to the next sample
+//        in x and z (or the previous one on the far edges of the heightmap).
+//        All but the last sample in the row are processed four at a time
+//        using SSE.
+//-----------------------------------------------------------------------------
+void CTerrain::GenerateNormalRow( ULONG z )
+{
+    ULONG         x = 0, Width = m_nHeightMapWidth;
+    long          AddZ;
+    float         dX, dZ, nx, ny, nz, Length;
+    const float * pRow = m_pHeightMap + z * Width;
+    float       * pNX  = m_pNormalX   + z * Width;
+    float       * pNY  = m_pNormalY   + z * Width;
+    float       * pNZ  = m_pNormalZ   + z * Width;
+
+    // Offset to the neighbouring row (the previous row at the far edge)
+    AddZ = ( z < m_nHeightMapHeight - 1 ) ? (long)Width : -(long)Width;
+
+    // The normal is (-ScaleZ * dX, ScaleX * ScaleZ, -ScaleX * dZ) where dX and dZ
+    // are the scaled height differences to the neighbouring samples in x and z.
+    if ( IsProcessorFeaturePresent( PF_XMMI_INSTRUCTIONS_AVAILABLE ) )
+    {
+        __m128 ScaleY = _mm_set1_ps( m_vecScale.y );
+        __m128 NegSX  = _mm_set1_ps( -m_vecScale.x );
+        __m128 NegSZ  = _mm_set1_ps( -m_vecScale.z );
+        __m128 NY     = _mm_set1_ps( m_vecScale.x * m_vecScale.z );
+        __m128 NY2    = _mm_mul_ps( NY, NY );
+        __m128 H, X, Z, Len;
+
+        for ( ; x + 4 < Width; x += 4 )
+        {
+            H   = _mm_loadu_ps( pRow + x );
+            X   = _mm_mul_ps( NegSZ, _mm_mul_ps( ScaleY, _mm_sub_ps( _mm_loadu_ps( pRow + x + 1 ), H ) ) );
+            Z   = _mm_mul_ps( NegSX, _mm_mul_ps( ScaleY, _mm_sub_ps( _mm_loadu_ps( pRow + x + AddZ ), H ) ) );
+            Len = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( X, X ), _mm_mul_ps( Z, Z ) ), NY2 ) );
+            _mm_storeu_ps( pNX + x, _mm_div_ps( X, Len ) );
+            _mm_storeu_ps( pNY + x, _mm_div_ps( NY, Len ) );
+            _mm_storeu_ps( pNZ + x, _mm_div_ps( Z, Len ) );
+
+        } // Next Sample Group
+
+    } // End if SSE
+
+    // Any remaining samples (always including the last in the row)
+    for ( ; x < Width; x++ )
+    {
+        dX = ( x < Width - 1 ) ? pRow[x + 1] - pRow[x] : pRow[x - 1] - pRow[x];
+        dZ = pRow[x + AddZ] - pRow[x];
+        nx = -m_vecScale.z * (dX * m_vecScale.y);
+        ny =  m_vecScale.x * m_vecScale.z;
+        nz = -m_vecScale.x * (dZ * m_vecScale.y);
+
+        Length = sqrtf( nx * nx + ny * ny + nz * nz );
+        pNX[x] = nx / Length;
+        pNY[x] = ny / Length;
+        pNZ[x] = nz / Length;
+
+    } // Next Sample
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetHeightMapNormal ()
+// Desc : Retrieves the normal at this position in the heightmap, from the
+//        precomputed normal field.
+//-----------------------------------------------------------------------------
+D3DXVECTOR3 CTerrain::GetHeightMapNormal( ULONG x, ULONG z ) const
+{
 	// Make sure we are not out of bounds
-	if ( x < 0.0f || z < 0.0f || x >= m_nHeightMapWidth || z >= m_nHeightMapHeight ) return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+	if ( !m_pNormalX || x >= m_nHeightMapWidth || z >= m_nHeightMapHeight ) return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
 
-    // Calculate the index in the heightmap array
-    HMIndex = x + z * m_nHeightMapWidth;
-    
-    // Calculate the number of pixels to add in either direction to
-    // obtain the best neighbouring heightmap pixel.
-    if ( x < (m_nHeightMapWidth - 1))  HMAddX = 1; else HMAddX = -1;
-	if ( z < (m_nHeightMapHeight - 1)) HMAddZ = m_nHeightMapWidth; else HMAddZ = -(signed)m_nHeightMapWidth;
-	
-    // Get the three height values
-	y1 = m_pHeightMap[HMIndex] * m_vecScale.y;
-	y2 = m_pHeightMap[HMIndex + HMAddX] * m_vecScale.y; 
-	y3 = m_pHeightMap[HMIndex + HMAddZ] * m_vecScale.y;
-			
-	// Calculate Edges
-	Edge1 = D3DXVECTOR3( 0.0f, y3 - y1, m_vecScale.z );
-	Edge2 = D3DXVECTOR3( m_vecScale.x, y2 - y1, 0.0f );
-			
-	// Calculate Resulting Normal
-	D3DXVec3Cross( &Normal, &Edge1, &Edge2);
-	D3DXVec3Normalize( &Normal, &Normal );
-	
     // Return it.
-	return Normal;
+    ULONG Index = x + z * m_nHeightMapWidth;
+	return D3DXVECTOR3( m_pNormalX[Index], m_pNormalY[Index], m_pNormalZ[Index] );
 }
 
 //-----------------------------------------------------------------------------
@@ -594,6 +2293,8 @@ D3DXVECTOR3 CTerrain::GetHeightMapNormal( ULONG x, ULONG z )
 float CTerrain::GetHeight( float x, float z, bool ReverseQuad )
 {
     float fTopLeft, fTopRight, fBottomLeft, fBottomRight;
+    const float * pHeightMap = m_pHeightMap;
+    ULONG         Pitch      = m_nHeightMapWidth;
 
     // Adjust Input Values
     x = x / m_vecScale.x;
@@ -610,22 +2311,39 @@ float CTerrain::GetHeight( float x, float z, bool ReverseQuad )
     float fPercentX = x - ((float)ix);
     float fPercentZ = z - ((float)iz);
 
+    // When paging, read the heights of the block containing this quad
+    if ( m_Pager.IsOpen() )
+    {
+        ULONG bx = min( (ULONG)ix / m_nQuadsWide, (ULONG)m_nBlocksWide - 1 );
+        ULONG bz = min( (ULONG)iz / m_nQuadsHigh, (ULONG)m_nBlocksHigh - 1 );
+        CTerrainBlock * pBlock = m_pBlock[ bx + bz * m_nBlocksWide ];
+
+        // Fall back to the overview if the block is not resident
+        if ( pBlock->m_nPageState != CTerrainBlock::PAGE_RESIDENT ) return m_Pager.GetOverviewHeight( x, z ) * m_vecScale.y;
+
+        pHeightMap = pBlock->m_pHeights;
+        Pitch      = m_nBlockWidth;
+        ix        -= pBlock->m_nStartX;
+        iz        -= pBlock->m_nStartZ;
+
+    } // End if paged
+
     if ( ReverseQuad )
     {
         // First retrieve the height of each point in the dividing edge
-        fTopLeft     = m_pHeightMap[ix + iz * m_nHeightMapWidth] * m_vecScale.y;
-        fBottomRight = m_pHeightMap[(ix + 1) + (iz + 1) * m_nHeightMapWidth] * m_vecScale.y;
+        fTopLeft     = pHeightMap[ix + iz * Pitch] * m_vecScale.y;
+        fBottomRight = pHeightMap[(ix + 1) + (iz + 1) * Pitch] * m_vecScale.y;
 
         // Which triangle of the quad are we in ?
         if ( fPercentX < fPercentZ )
         {
-            fBottomLeft = m_pHeightMap[ix + (iz + 1) * m_nHeightMapWidth] * m_vecScale.y;
+            fBottomLeft = pHeightMap[ix + (iz + 1) * Pitch] * m_vecScale.y;
 		    fTopRight = fTopLeft + (fBottomRight - fBottomLeft);
         
         } // End if Left Triangle
         else
         {
-            fTopRight   = m_pHeightMap[(ix + 1) + iz * m_nHeightMapWidth] * m_vecScale.y;
+            fTopRight   = pHeightMap[(ix + 1) + iz * Pitch] * m_vecScale.y;
 		    fBottomLeft = fTopLeft + (fBottomRight - fTopRight);
 
         } // End if Right Triangle
@@ -634,19 +2352,19 @@ float CTerrain::GetHeight( float x, float z, bool ReverseQuad )
     else
     {
         // First retrieve the height of each point in the dividing edge
-        fTopRight   = m_pHeightMap[(ix + 1) + iz * m_nHeightMapWidth] * m_vecScale.y;
-        fBottomLeft = m_pHeightMap[ix + (iz + 1) * m_nHeightMapWidth] * m_vecScale.y;
+        fTopRight   = pHeightMap[(ix + 1) + iz * Pitch] * m_vecScale.y;
+        fBottomLeft = pHeightMap[ix + (iz + 1) * Pitch] * m_vecScale.y;
 
         // Calculate which triangle of the quad are we in ?
         if ( fPercentX < (1.0f - fPercentZ)) 
         {
-            fTopLeft = m_pHeightMap[ix + iz * m_nHeightMapWidth] * m_vecScale.y;
+            fTopLeft = pHeightMap[ix + iz * Pitch] * m_vecScale.y;
             fBottomRight = fBottomLeft + (fTopRight - fTopLeft);
         
         } // End if Left Triangle
         else
         {
-            fBottomRight = m_pHeightMap[(ix + 1) + (iz + 1) * m_nHeightMapWidth] * m_vecScale.y;
+            fBottomRight = pHeightMap[(ix + 1) + (iz + 1) * Pitch] * m_vecScale.y;
             fTopLeft = fTopRight + (fBottomLeft - fBottomRight);
 
         } // End if Right Triangle
@@ -667,67 +2385,164 @@ float CTerrain::GetHeight( float x, float z, bool ReverseQuad )
 //-----------------------------------------------------------------------------
 void CTerrain::Render( CCamera * pCamera )
 {
-    USHORT i;
-    ULONG  j;
+    USHORT                  i;
+    ULONG                   j;
+    bool                    LayerSet;
+    LPDIRECT3DTEXTURE9      pBlendTexture;
+    LPDIRECT3DVERTEXBUFFER9 pStream;
+    PROFILE_ZONE( "CTerrain::Render" );
     
     // Validate parameters
     if( !m_pD3DDevice ) return;
 
+    // Page blocks in and out around the camera
+    if ( m_Pager.IsOpen() && pCamera ) m_Pager.Update( pCamera->GetRenderPosition(), m_fPageRadius, m_nPageUploads );
+
+    // Find the blocks to render, and select the detail level of each
+    CollectVisibleBlocks( pCamera );
+    UpdateLOD( pCamera );
+
     // Setup our terrain render states
     m_pD3DDevice->SetRenderState( D3DRS_ALPHABLENDENABLE, true );
     m_pD3DDevice->SetRenderState( D3DRS_SRCBLEND, D3DBLEND_SRCALPHA );
     m_pD3DDevice->SetRenderState( D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA );
 
-    // stage 0 coloring : get color from texture0*diffuse
-    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_COLOROP, D3DTOP_MODULATE );
+    // stage 0 : the layer's weight from the packed blend texture (see
+    // SetBlendChannel), using the second set of coordinates
+    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_TEXCOORDINDEX, 1 );
     m_pD3DDevice->SetTextureStageState( 0, D3DTSS_COLORARG1, D3DTA_TEXTURE );
-    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_COLORARG2, D3DTA_DIFFUSE );
-
-    // stage 0 alpha : nada
-    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_ALPHAOP, D3DTOP_SELECTARG1 );
-    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_ALPHAARG1, D3DTA_CURRENT );
-    
-    // stage 1 coloring : nada
-    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_COLOROP, D3DTOP_SELECTARG1 );
-    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_COLORARG1, D3DTA_CURRENT );
-    
-    // stage 1 alpha : get alpha from texture1
+    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_COLORARG2, D3DTA_TFACTOR );
+    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE );
+    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_ALPHAARG2, D3DTA_TFACTOR );
+    m_pD3DDevice->SetSamplerState( 0, D3DSAMP_ADDRESSU, D3DTADDRESS_CLAMP );
+    m_pD3DDevice->SetSamplerState( 0, D3DSAMP_ADDRESSV, D3DTADDRESS_CLAMP );
+
+    // stage 1 coloring : get color from texture1*diffuse, using the first
+    // set of coordinates
+    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_TEXCOORDINDEX, 0 );
+    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_COLOROP, D3DTOP_MODULATE );
+    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_COLORARG1, D3DTA_TEXTURE );
+    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_COLORARG2, D3DTA_DIFFUSE );
+    m_pD3DDevice->SetSamplerState( 1, D3DSAMP_ADDRESSU, D3DTADDRESS_WRAP );
+    m_pD3DDevice->SetSamplerState( 1, D3DSAMP_ADDRESSV, D3DTADDRESS_WRAP );
+
+    // stage 1 alpha : the weight from stage 0
     m_pD3DDevice->SetTextureStageState( 1, D3DTSS_ALPHAOP, D3DTOP_SELECTARG1 );
-    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_ALPHAARG1, D3DTA_TEXTURE );
+    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_ALPHAARG1, D3DTA_CURRENT );
 
     // Enable Stage Texture Transforms
-    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_TEXTURETRANSFORMFLAGS, D3DTTFF_COUNT2 );
+    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_TEXTURETRANSFORMFLAGS, D3DTTFF_COUNT2 );
     
     // Setup our terrain vertex FVF code
     m_pD3DDevice->SetFVF( VERTEX_FVF );
 
-    // Loop through blocks and signal a render
-    for ( j = 0; j < m_nBlockCount; j++ )
+    // Render layer by layer, so that each layer's texture and matrix are set
+    // just once, and only the stream and blend texture change between the
+    // visible blocks. Blocks never overlap, so each pixel still receives its
+    // layers in order.
+    pStream       = NULL;
+    pBlendTexture = NULL;
+    for ( i = 0; i < m_nLayerCount; i++ )
     {
-        // Skip if block is not within the viewing frustum
-        if ( pCamera && (!pCamera->BoundsInFrustum( m_pBlock[j]->m_BoundsMin, m_pBlock[j]->m_BoundsMax )) ) continue;
+        // Skip if this layer is disabled
+        if ( GetGameApp()->GetRenderLayer( i ) == false ) continue;
 
-        m_pD3DDevice->SetStreamSource( 0, m_pBlock[j]->m_pVertexBuffer, 0, sizeof(CVertex) );
+        CTerrainLayer * pLayer = m_pLayer[i];
+        LayerSet = false;
 
-        // Loop through all active layers
-        for ( i = 0; i < m_nLayerCount; i++ )
+        // Loop through the visible blocks and signal a render
+        for ( j = 0; j < m_nVisibleCount; j++ )
         {
-            // Skip if this layer is disabled
-            if ( GetGameApp()->GetRenderLayer( i ) == false ) continue;
+            CTerrainBlock * pBlock = m_pVisibleBlocks[j];
 
-            CTerrainLayer * pLayer = m_pLayer[i];
-            if ( !m_pBlock[j]->m_pLayerUsage[ i ] ) continue;
+            // Skip blocks which have not been paged in, or do not use this layer
+            if ( !pBlock->m_pVertexBuffer || !pBlock->m_pLayerUsage[ i ] ) continue;
 
-            // Set our texturing information
-            m_pD3DDevice->SetTexture( 0, m_pTexture[pLayer->m_nTextureIndex] );
-            m_pD3DDevice->SetTransform( D3DTS_TEXTURE0, &pLayer->m_mtxTexture );
+            // Set our texturing information, the first time the layer is used
+            if ( !LayerSet )
+            {
+                SetBlendChannel( i );
+                m_pD3DDevice->SetTexture( 1, m_pTexture[pLayer->m_nTextureIndex] );
+                m_pD3DDevice->SetTransform( D3DTS_TEXTURE1, &pLayer->m_mtxTexture );
+                LayerSet = true;
+
+            } // End if layer not set
+
+            // Set the blend texture holding this layer (the base layer has none),
+            // blocks sharing an atlas page share the same texture
+            if ( i > 0 && pBlock->m_pBlendTexture && pBlock->m_pBlendTexture[ (i - 1) / TERRAIN_BLEND_CHANNELS ] != pBlendTexture )
+            {
+                pBlendTexture = pBlock->m_pBlendTexture[ (i - 1) / TERRAIN_BLEND_CHANNELS ];
+                m_pD3DDevice->SetTexture( 0, pBlendTexture );
+
+            } // End if blend texture changed
+
+            // Set the block's vertices
+            if ( pBlock->m_pVertexBuffer != pStream )
+            {
+                pStream = pBlock->m_pVertexBuffer;
+                m_pD3DDevice->SetStreamSource( 0, pStream, 0, sizeof(CVertex) );
+
+            } // End if stream changed
             
-            m_pBlock[j]->Render( m_pD3DDevice, i );
+            pBlock->Render( m_pD3DDevice, i );
 
         } // Next Block
 
     } // Next Layer
 
+    // Restore the stage states expected by the rest of the scene
+    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_TEXCOORDINDEX, 0 );
+    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_COLOROP, D3DTOP_MODULATE );
+    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_COLORARG2, D3DTA_DIFFUSE );
+    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_ALPHAOP, D3DTOP_SELECTARG1 );
+    m_pD3DDevice->SetTextureStageState( 0, D3DTSS_ALPHAARG1, D3DTA_CURRENT );
+    m_pD3DDevice->SetSamplerState( 0, D3DSAMP_ADDRESSU, D3DTADDRESS_WRAP );
+    m_pD3DDevice->SetSamplerState( 0, D3DSAMP_ADDRESSV, D3DTADDRESS_WRAP );
+    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_TEXCOORDINDEX, 1 );
+    m_pD3DDevice->SetTextureStageState( 1, D3DTSS_TEXTURETRANSFORMFLAGS, D3DTTFF_DISABLE );
+    m_pD3DDevice->SetSamplerState( 1, D3DSAMP_ADDRESSU, D3DTADDRESS_CLAMP );
+    m_pD3DDevice->SetSamplerState( 1, D3DSAMP_ADDRESSV, D3DTADDRESS_CLAMP );
+    m_pD3DDevice->SetTexture( 1, NULL );
+
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetBlendChannel () (Private)
+// Desc : Sets up texture stage 0 to output the weight of the layer specified,
+//        from its channel of the packed blend texture, in both colour and
+//        alpha. The base layer has no blend map, and is always opaque.
+// Note : The red, green and blue channels are selected with DOTPRODUCT3, as
+//        the fixed function pipeline cannot read a single colour channel
+//        alone. This replicates the result into alpha as well.
+//-----------------------------------------------------------------------------
+void CTerrain::SetBlendChannel( USHORT LayerIndex )
+{
+    ULONG Channel = (LayerIndex - 1) % TERRAIN_BLEND_CHANNELS;
+
+    if ( LayerIndex == 0 )
+    {
+        // Base layer, fully opaque
+        m_pD3DDevice->SetRenderState( D3DRS_TEXTUREFACTOR, 0xFFFFFFFF );
+        m_pD3DDevice->SetTextureStageState( 0, D3DTSS_COLOROP, D3DTOP_SELECTARG2 );
+        m_pD3DDevice->SetTextureStageState( 0, D3DTSS_ALPHAOP, D3DTOP_SELECTARG2 );
+
+    } // End if base layer
+    else if ( Channel < 3 )
+    {
+        // Red, green or blue channel
+        m_pD3DDevice->SetRenderState( D3DRS_TEXTUREFACTOR, BLEND_CHANNEL_MASK[ Channel ] );
+        m_pD3DDevice->SetTextureStageState( 0, D3DTSS_COLOROP, D3DTOP_DOTPRODUCT3 );
+        m_pD3DDevice->SetTextureStageState( 0, D3DTSS_ALPHAOP, D3DTOP_SELECTARG1 );
+
+    } // End if colour channel
+    else
+    {
+        // Alpha channel
+        m_pD3DDevice->SetTextureStageState( 0, D3DTSS_COLOROP, D3DTOP_SELECTARG1 );
+        m_pD3DDevice->SetTextureStageState( 0, D3DTSS_ALPHAOP, D3DTOP_SELECTARG1 );
+
+    } // End if alpha channel
 }
 
 //-----------------------------------------------------------------------------
@@ -920,8 +2735,21 @@ CTerrainBlock::CTerrainBlock( )
     m_nSplatCount   = 0;
     m_pSplatLevel   = NULL;
     m_pVertexBuffer = NULL;
+    m_pVertices     = NULL;
+    m_pBlendTexture = NULL;
+    m_pBlendData    = NULL;
+    m_nLOD          = 0;
+    m_nLODEdges     = 0;
+    m_nLODFrame     = 0;
+    m_bLODQueued    = false;
+    m_nPageState    = PAGE_UNLOADED;
+    m_pHeights      = NULL;
+    m_nPageFrame    = 0;
+    m_pPagePrev     = NULL;
+    m_pPageNext     = NULL;
 
     ZeroMemory( m_pNeighbours, 9 * sizeof(CTerrainBlock*) );
+    ZeroMemory( m_fLODError, TERRAIN_MAX_LOD * sizeof(float) );
 }
 
 //-----------------------------------------------------------------------------
@@ -929,6 +2757,18 @@ CTerrainBlock::CTerrainBlock( )
 // Desc : CTerrainBlock Class Destructor
 //-----------------------------------------------------------------------------
 CTerrainBlock::~CTerrainBlock()
+{
+    // Release all block data
+    ReleaseResources();
+}
+
+//-----------------------------------------------------------------------------
+// Name : ReleaseResources ()
+// Desc : Releases the block's geometry, splat levels and device resources.
+//        The block's position, bounds and detail level errors are retained,
+//        so it can be built again later (used when paging blocks out).
+//-----------------------------------------------------------------------------
+void CTerrainBlock::ReleaseResources( )
 {
     ULONG i;
 
@@ -946,35 +2786,89 @@ CTerrainBlock::~CTerrainBlock()
 
     } // End if Allocated
 
+    // Release the blend textures (or our references to the atlas pages)
+    if ( m_pBlendTexture )
+    {
+        for ( i = 0; i < m_pParent->GetBlendGroupCount(); i++ )
+        {
+            if ( m_pBlendTexture[i] ) m_pBlendTexture[i]->Release();
+
+        } // Next Layer Group
+
+        delete []m_pBlendTexture;
+
+    } // End if Allocated
+
     // Release flat arrays
     if ( m_pLayerUsage ) delete []m_pLayerUsage;
+    if ( m_pVertices   ) delete []m_pVertices;
+    if ( m_pBlendData  ) delete []m_pBlendData;
+    if ( m_pHeights    ) delete []m_pHeights;
 
     // Release Direct3D Resources
     if ( m_pVertexBuffer ) m_pVertexBuffer->Release();
 
     // Reset pointers
     m_pSplatLevel   = NULL;
+    m_nSplatCount   = 0;
     m_pLayerUsage   = NULL;
+    m_pVertices     = NULL;
+    m_pBlendTexture = NULL;
+    m_pBlendData    = NULL;
+    m_pHeights      = NULL;
     m_pVertexBuffer = NULL;
 }
 
 //-----------------------------------------------------------------------------
 // Name : GenerateBlock ()
-// Desc : Generate this terrain block.
+// Desc : Generate this terrain block, building its data and then creating
+//        the device resources straight away.
 //-----------------------------------------------------------------------------
 bool CTerrainBlock::GenerateBlock( CTerrain * pParent, ULONG StartX, ULONG StartZ, ULONG BlockWidth, ULONG BlockHeight )
+{
+    BLOCK_SOURCE Source;
+    bool         Result;
+
+    // Validate requirements
+    if ( !pParent || !pParent->GetHeightMap() ) return false;
+
+    // Gather the layer blend and coverage maps
+    const UCHAR ** ppBlendMaps = new const UCHAR*[ pParent->GetLayerCount() * 2 ];
+    if ( !ppBlendMaps ) return false;
+    for ( USHORT i = 0; i < pParent->GetLayerCount(); i++ )
+    {
+        ppBlendMaps[i] = pParent->GetLayer(i)->m_pBlendMap;
+        ppBlendMaps[i + pParent->GetLayerCount()] = pParent->GetLayer(i)->m_pCoverage;
+
+    } // Next Layer
+
+    // Build the data, then upload it
+    pParent->GetBlockSource( StartX, StartZ, Source, ppBlendMaps, ppBlendMaps + pParent->GetLayerCount() );
+    Result = BuildBlock( pParent, Source, StartX, StartZ, BlockWidth, BlockHeight );
+    delete []ppBlendMaps;
+    if ( !Result ) return false;
+    return CreateResources();
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildBlock ()
+// Desc : Builds the vertex, index and blend map data for this terrain block
+//        into system memory, ready for CreateResources.
+// Note : Makes no use of the device, and only reads the parent terrain and
+//        the source data, so separate blocks can safely be built on different
+//        threads.
+//-----------------------------------------------------------------------------
+bool CTerrainBlock::BuildBlock( CTerrain * pParent, const BLOCK_SOURCE & Source, ULONG StartX, ULONG StartZ, ULONG BlockWidth, ULONG BlockHeight )
 {
     ULONG             x, z;
-    HRESULT           hRet;
-    ULONG             Usage      = D3DUSAGE_WRITEONLY;
-    USHORT           *pIndex     = NULL;
+    ULONG             BlendPage, BlendTexels;
+    RECT              BlendRect;
     CVertex          *pVertex    = NULL;
-    float            *pHeightMap = NULL;
-    LPDIRECT3DDEVICE9 pD3DDevice = NULL;
-    D3DXVECTOR3       VertexPos, LightDir = D3DXVECTOR3( 0.650945f, -0.390567f, 0.650945f );
+    D3DXVECTOR3       VertexPos, BoundsMin, BoundsMax, LightDir = D3DXVECTOR3( 0.650945f, -0.390567f, 0.650945f );
+    PROFILE_ZONE( "CTerrainBlock::BuildBlock" );
 
     // Validate requirements
-    if (!pParent || !pParent->GetD3DDevice() || !pParent->GetHeightMap()) return false;
+    if (!pParent || !Source.pHeights) return false;
 
     // Store some values
     m_pParent      = pParent;
@@ -982,44 +2876,42 @@ bool CTerrainBlock::GenerateBlock( CTerrain * pParent, ULONG StartX, ULONG Start
     m_nStartZ      = StartZ;
     m_nBlockWidth  = BlockWidth;
     m_nBlockHeight = BlockHeight;
-    m_nQuadsHigh   = BlockHeight - 1;
     m_nQuadsWide   = BlockWidth - 1;
     m_nQuadsHigh   = BlockHeight - 1;
-    pHeightMap     = pParent->GetHeightMap();
-    pD3DDevice     = pParent->GetD3DDevice();
-
-    // Calculate buffer usage
-    if ( !m_pParent->UseHardwareTnL() ) Usage |= D3DUSAGE_SOFTWAREPROCESSING;
 
-    // Create the vertex buffer ready for generation
-    hRet = pD3DDevice->CreateVertexBuffer((BlockWidth * BlockHeight) * sizeof(CVertex), Usage, VERTEX_FVF, D3DPOOL_MANAGED, &m_pVertexBuffer, NULL );
-    if (FAILED(hRet)) return false;
+    // The area of the blend atlas addressed by the second set of coordinates
+    pParent->GetBlendAtlasPlacement( StartX, StartZ, BlendPage, BlendRect );
+    BlendTexels = pParent->GetBlendTexRatio();
 
-    // Lock the vertex buffer ready to fill data
-    hRet = m_pVertexBuffer->Lock( 0, (BlockWidth * BlockHeight) * sizeof(CVertex), (LPVOID*)&pVertex, 0 );
-    if (FAILED(hRet)) return false;
+    // Allocate the vertex data ready for generation
+    m_pVertices = new CVertex[ BlockWidth * BlockHeight ];
+    if (!m_pVertices) return false;
+    pVertex = m_pVertices;
 
-    // Reset bounding box data
-    m_BoundsMin = D3DXVECTOR3( 999999.0f, 999999.0f, 999999.0f );
-    m_BoundsMax = D3DXVECTOR3( -999999.0f, -999999.0f, -999999.0f );
+    // Reset bounding box data (only stored once complete, the bounds of a
+    // paged block are in use while it is being built)
+    BoundsMin = D3DXVECTOR3( 999999.0f, 999999.0f, 999999.0f );
+    BoundsMax = D3DXVECTOR3( -999999.0f, -999999.0f, -999999.0f );
 
     // Loop through and generate the vertex data
     for ( z = StartZ; z < StartZ + BlockHeight; z++ )
     {
         for ( x = StartX; x < StartX + BlockWidth; x++ )
         {
+            ULONG lx = x - StartX, lz = z - StartZ;
+
             VertexPos.x = (float)x * m_pParent->GetScale().x;
-            VertexPos.y = pHeightMap[ x + z * pParent->GetTerrainWidth() ] * m_pParent->GetScale().y;
+            VertexPos.y = Source.pHeights[ lx + lz * Source.HeightPitch ] * m_pParent->GetScale().y;
             VertexPos.z = (float)z * m_pParent->GetScale().z;
 
             // Calculate vertex colour scale
             float fRed = 1.0f, fGreen = 1.0f, fBlue = 1.0f, fScale = 0.25f;
             
             // Generate average scale (for diffuse lighting calc)
-            fScale  = D3DXVec3Dot( &pParent->GetHeightMapNormal( x, z ), &(-LightDir));
-            fScale += D3DXVec3Dot( &pParent->GetHeightMapNormal( x + 1, z ), &(-LightDir));
-            fScale += D3DXVec3Dot( &pParent->GetHeightMapNormal( x + 1, z + 1 ), &(-LightDir));
-            fScale += D3DXVec3Dot( &pParent->GetHeightMapNormal( x, z + 1 ), &(-LightDir));
+            fScale  = D3DXVec3Dot( &SourceNormal( Source, lx, lz ), &(-LightDir));
+            fScale += D3DXVec3Dot( &SourceNormal( Source, lx + 1, lz ), &(-LightDir));
+            fScale += D3DXVec3Dot( &SourceNormal( Source, lx + 1, lz + 1 ), &(-LightDir));
+            fScale += D3DXVec3Dot( &SourceNormal( Source, lx, lz + 1 ), &(-LightDir));
             fScale /= 4.0f;
 
             // Increase Saturation
@@ -1036,16 +2928,16 @@ bool CTerrainBlock::GenerateBlock( CTerrain * pParent, ULONG StartX, ULONG Start
             pVertex->Diffuse = D3DCOLOR_COLORVALUE( fRed * fScale, fGreen * fScale, fBlue * fScale, 1.0f );
             pVertex->tu      = (float)x;
             pVertex->tv      = (float)z;
-            pVertex->tu2     = (float)(x - StartX) / m_nQuadsWide;
-            pVertex->tv2     = (float)(z - StartZ) / m_nQuadsHigh;
+            pVertex->tu2     = (float)(BlendRect.left + lx * BlendTexels) / pParent->GetBlendAtlasWidth();
+            pVertex->tv2     = (float)(BlendRect.top  + lz * BlendTexels) / pParent->GetBlendAtlasHeight();
 
             // Calculate bounding box data
-            if ( VertexPos.x < m_BoundsMin.x ) m_BoundsMin.x = VertexPos.x;
-            if ( VertexPos.y < m_BoundsMin.y ) m_BoundsMin.y = VertexPos.y;
-            if ( VertexPos.z < m_BoundsMin.z ) m_BoundsMin.z = VertexPos.z;
-            if ( VertexPos.x > m_BoundsMax.x ) m_BoundsMax.x = VertexPos.x;
-            if ( VertexPos.y > m_BoundsMax.y ) m_BoundsMax.y = VertexPos.y;
-            if ( VertexPos.z > m_BoundsMax.z ) m_BoundsMax.z = VertexPos.z;
+            if ( VertexPos.x < BoundsMin.x ) BoundsMin.x = VertexPos.x;
+            if ( VertexPos.y < BoundsMin.y ) BoundsMin.y = VertexPos.y;
+            if ( VertexPos.z < BoundsMin.z ) BoundsMin.z = VertexPos.z;
+            if ( VertexPos.x > BoundsMax.x ) BoundsMax.x = VertexPos.x;
+            if ( VertexPos.y > BoundsMax.y ) BoundsMax.y = VertexPos.y;
+            if ( VertexPos.z > BoundsMax.z ) BoundsMax.z = VertexPos.z;
             
             // Move to next vertex
             pVertex++;
@@ -1054,63 +2946,377 @@ bool CTerrainBlock::GenerateBlock( CTerrain * pParent, ULONG StartX, ULONG Start
     
     } // Next Row
 
-    // Finished with the vertex buffer
-    m_pVertexBuffer->Unlock();
+    // Store the bounds
+    m_BoundsMin = BoundsMin;
+    m_BoundsMax = BoundsMax;
+
+    // Measure the error introduced by each detail level
+    CalculateLODErrors( Source );
 
     // Determine all the layers used by this block
-    if ( !CountLayerUsage() ) return false;
+    if ( !CountLayerUsage( Source ) ) return false;
 
     // Generate Splat Levels for this block
-    if ( !GenerateSplats() ) return false;
+    if ( !GenerateSplats( Source ) ) return false;
 
     // Generate the blend maps
-    if ( !GenerateBlendMaps() ) return false;
+    if ( !GenerateBlendMaps( Source ) ) return false;
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : CreateResources ()
+// Desc : Creates the vertex buffer, index buffers and blend textures for this
+//        block, and fills them with the data prepared by BuildBlock. The
+//        system memory copies are released once uploaded, unless 'FreeStaging'
+//        is false (the data is not owned by the block).
+// Note : Must be called on the thread which owns the device.
+//-----------------------------------------------------------------------------
+bool CTerrainBlock::CreateResources( bool FreeStaging )
+{
+    HRESULT           hRet;
+    ULONG             i, z, Width, Height, Page;
+    ULONG             Usage      = D3DUSAGE_WRITEONLY;
+    USHORT            GroupCount;
+    RECT              Rect;
+    void             *pData      = NULL;
+    LPDIRECT3DDEVICE9 pD3DDevice = NULL;
+    D3DLOCKED_RECT    LockData;
+    PROFILE_ZONE( "CTerrainBlock::CreateResources" );
+
+    // Validate requirements
+    if ( !m_pParent || !m_pParent->GetD3DDevice() || !m_pVertices ) return false;
+    pD3DDevice = m_pParent->GetD3DDevice();
+
+    // Calculate buffer usage
+    if ( !m_pParent->UseHardwareTnL() ) Usage |= D3DUSAGE_SOFTWAREPROCESSING;
+
+    // Create and fill the vertex buffer
+    ULONG VertexSize = (m_nBlockWidth * m_nBlockHeight) * sizeof(CVertex);
+    hRet = pD3DDevice->CreateVertexBuffer( VertexSize, Usage, VERTEX_FVF, D3DPOOL_MANAGED, &m_pVertexBuffer, NULL );
+    if (FAILED(hRet)) return false;
+    hRet = m_pVertexBuffer->Lock( 0, VertexSize, &pData, 0 );
+    if (FAILED(hRet)) return false;
+    memcpy( pData, m_pVertices, VertexSize );
+    m_pVertexBuffer->Unlock();
+
+    // The vertex data is no longer required
+    if ( FreeStaging ) { delete []m_pVertices; m_pVertices = NULL; }
+
+    // Upload each splat level
+    for ( i = 0; i < m_nSplatCount; i++ )
+    {
+        CTerrainSplat * pSplat = m_pSplatLevel[i];
+        if ( !pSplat ) continue;
+
+        // Create and fill the index buffer
+        if ( pSplat->m_pIndices )
+        {
+            ULONG IndexSize = pSplat->m_nIndexCount * sizeof(USHORT);
+            hRet = pD3DDevice->CreateIndexBuffer( IndexSize, Usage, D3DFMT_INDEX16, D3DPOOL_MANAGED, &pSplat->m_pIndexBuffer, NULL );
+            if ( FAILED(hRet) ) return false;
+            hRet = pSplat->m_pIndexBuffer->Lock( 0, IndexSize, &pData, 0 );
+            if ( FAILED(hRet) ) return false;
+            memcpy( pData, pSplat->m_pIndices, IndexSize );
+            pSplat->m_pIndexBuffer->Unlock();
+
+            if ( FreeStaging ) { delete []pSplat->m_pIndices; pSplat->m_pIndices = NULL; }
+
+        } // End if indices
+
+    } // Next Splat Level
+
+    // Bail if there are no blend textures
+    GroupCount = m_pParent->GetBlendGroupCount();
+    if ( !m_pBlendData || GroupCount == 0 ) return true;
+
+    // Size and position of the blend textures within their atlas page
+    Width  = m_nQuadsWide * m_pParent->GetBlendTexRatio();
+    Height = m_nQuadsHigh * m_pParent->GetBlendTexRatio();
+    m_pParent->GetBlendAtlasPlacement( m_nStartX, m_nStartZ, Page, Rect );
+
+    // Allocate the texture array
+    m_pBlendTexture = new LPDIRECT3DTEXTURE9[ GroupCount ];
+    if ( !m_pBlendTexture ) return false;
+    ZeroMemory( m_pBlendTexture, GroupCount * sizeof(LPDIRECT3DTEXTURE9) );
+
+    // Fill in the blend texture of each layer group
+    for ( i = 0; i < GroupCount; i++ )
+    {
+        // Use the atlas page if there is one, otherwise create our own texture
+        // (sized as a page, which holds only this block when paging)
+        m_pBlendTexture[i] = m_pParent->GetBlendAtlas( Page, (USHORT)i );
+        if ( m_pBlendTexture[i] )
+        {
+            m_pBlendTexture[i]->AddRef();
+
+        } // End if atlas page
+        else
+        {
+            hRet = pD3DDevice->CreateTexture( m_pParent->GetBlendAtlasWidth(), m_pParent->GetBlendAtlasHeight(), 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &m_pBlendTexture[i], NULL );
+            if ( FAILED(hRet) ) return false;
+
+        } // End if own texture
+
+        hRet = m_pBlendTexture[i]->LockRect( 0, &LockData, &Rect, 0 );
+        if ( FAILED(hRet) ) return false;
+
+        // Copy each row, respecting the pitch
+        const ULONG * pTexels = m_pBlendData + i * Width * Height;
+        for ( z = 0; z < Height; z++ )
+        {
+            memcpy( (UCHAR*)LockData.pBits + z * LockData.Pitch, pTexels + z * Width, Width * sizeof(ULONG) );
+
+        } // Next Row
+        m_pBlendTexture[i]->UnlockRect( 0 );
+
+    } // Next Layer Group
+
+    // The blend data is no longer required
+    if ( FreeStaging ) { delete []m_pBlendData; m_pBlendData = NULL; }
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ReadCooked ()
+// Desc : Reads this block's record from a mapped cooked terrain file, and
+//        creates its device resources directly from the mapped data.
+// Note : 'pData' is advanced past the record. Must be called on the thread
+//        which owns the device.
+//-----------------------------------------------------------------------------
+bool CTerrainBlock::ReadCooked( CTerrain * pParent, ULONG StartX, ULONG StartZ, const UCHAR *& pData, const UCHAR * pEnd )
+{
+    ULONG   i, Size, Texels;
+    USHORT  LayerCount;
+    bool    Result = false;
+
+    // Validate requirements
+    if ( !pParent ) return false;
+    LayerCount = pParent->GetLayerCount();
+
+    // Store some values
+    m_pParent      = pParent;
+    m_nStartX      = StartX;
+    m_nStartZ      = StartZ;
+    m_nBlockWidth  = pParent->GetBlockWidth();
+    m_nBlockHeight = pParent->GetBlockHeight();
+    m_nQuadsWide   = m_nBlockWidth - 1;
+    m_nQuadsHigh   = m_nBlockHeight - 1;
+    Texels         = (m_nQuadsWide * pParent->GetBlendTexRatio()) * (m_nQuadsHigh * pParent->GetBlendTexRatio()) * pParent->GetBlendGroupCount();
+
+    // Bounds and detail level errors
+    if ( pData + sizeof(CookedBlock) > pEnd ) return false;
+    const CookedBlock * pBlock = (const CookedBlock*)pData;
+    if ( pBlock->BlendTexels != 0 && pBlock->BlendTexels != Texels ) return false;
+    m_BoundsMin = pBlock->BoundsMin;
+    m_BoundsMax = pBlock->BoundsMax;
+    memcpy( m_fLODError, pBlock->LODError, sizeof(m_fLODError) );
+    pData += sizeof(CookedBlock);
+
+    // Layer usage (copied, the block owns this table)
+    Size = (LayerCount * sizeof(USHORT) + 3) & ~3;
+    if ( pData + Size > pEnd ) return false;
+    m_pLayerUsage = new USHORT[ LayerCount ];
+    if ( !m_pLayerUsage ) return false;
+    memcpy( m_pLayerUsage, pData, LayerCount * sizeof(USHORT) );
+    pData += Size;
+
+    // Vertices (uploaded straight from the file)
+    Size = m_nBlockWidth * m_nBlockHeight * sizeof(CVertex);
+    if ( pData + Size > pEnd ) return false;
+    m_pVertices = (CVertex*)pData;
+    pData += Size;
+
+    // Packed blend texels (also uploaded straight from the file)
+    Size = pBlock->BlendTexels * sizeof(ULONG);
+    if ( pData + Size > pEnd ) { m_pVertices = NULL; return false; }
+    if ( pBlock->BlendTexels ) m_pBlendData = (ULONG*)pData;
+    pData += Size;
+
+    // Splat levels
+    if ( AddSplatLevel( LayerCount ) < 0 ) { m_pVertices = NULL; m_pBlendData = NULL; return false; }
+    for ( i = 0; i < LayerCount; i++ )
+    {
+        if ( pData + sizeof(CookedSplat) > pEnd ) break;
+        const CookedSplat * pCooked = (const CookedSplat*)pData;
+        pData += sizeof(CookedSplat);
+
+        // Layer not in use by this block ?
+        if ( !pCooked->Present ) continue;
+
+        CTerrainSplat * pSplat = new CTerrainSplat;
+        if ( !pSplat ) break;
+        m_pSplatLevel[i]          = pSplat;
+        pSplat->m_nLayerIndex     = (USHORT)i;
+        pSplat->m_nIndexCount     = pCooked->IndexCount;
+        pSplat->m_nPrimitiveCount = pCooked->PrimitiveCount;
+
+        // Indices
+        Size = (pCooked->IndexCount * sizeof(USHORT) + 3) & ~3;
+        if ( pData + Size > pEnd ) break;
+        if ( pCooked->IndexCount ) pSplat->m_pIndices = (USHORT*)pData;
+        pData += Size;
+
+    } // Next Splat Level
+
+    // Upload everything, if the whole record was read
+    if ( i == LayerCount ) Result = CreateResources( false );
+
+    // The staging pointers address the mapped file, which must never be released
+    m_pVertices  = NULL;
+    m_pBlendData = NULL;
+    for ( i = 0; i < m_nSplatCount; i++ )
+    {
+        if ( !m_pSplatLevel[i] ) continue;
+        m_pSplatLevel[i]->m_pIndices = NULL;
+
+    } // Next Splat Level
+
+    return Result;
+}
+
+//-----------------------------------------------------------------------------
+// Name : WriteCooked ()
+// Desc : Writes this block's record to a cooked terrain file.
+// Note : Must be called after BuildBlock, and before CreateResources releases
+//        the built data.
+//-----------------------------------------------------------------------------
+bool CTerrainBlock::WriteCooked( HANDLE hFile ) const
+{
+    CookedBlock Block;
+    CookedSplat Cooked;
+    USHORT      i, LayerCount = m_pParent->GetLayerCount();
+    ULONG       Texels = (m_nQuadsWide * m_pParent->GetBlendTexRatio()) * (m_nQuadsHigh * m_pParent->GetBlendTexRatio()) * m_pParent->GetBlendGroupCount();
+
+    // Validate requirements
+    if ( !m_pVertices || !m_pLayerUsage ) return false;
+
+    // Bounds, detail level errors, layer usage, vertices and blend texels
+    Block.BoundsMin   = m_BoundsMin;
+    Block.BoundsMax   = m_BoundsMax;
+    Block.BlendTexels = m_pBlendData ? Texels : 0;
+    memcpy( Block.LODError, m_fLODError, sizeof(m_fLODError) );
+    if ( !WriteData( hFile, &Block, sizeof(CookedBlock) ) ) return false;
+    if ( !WriteData( hFile, m_pLayerUsage, LayerCount * sizeof(USHORT), true ) ) return false;
+    if ( !WriteData( hFile, m_pVertices, m_nBlockWidth * m_nBlockHeight * sizeof(CVertex) ) ) return false;
+    if ( !WriteData( hFile, m_pBlendData, Block.BlendTexels * sizeof(ULONG) ) ) return false;
+
+    // Each splat level
+    for ( i = 0; i < LayerCount; i++ )
+    {
+        CTerrainSplat * pSplat = ( i < m_nSplatCount ) ? m_pSplatLevel[i] : NULL;
+
+        ZeroMemory( &Cooked, sizeof(CookedSplat) );
+        if ( pSplat )
+        {
+            Cooked.Present        = 1;
+            Cooked.IndexCount     = pSplat->m_pIndices ? pSplat->m_nIndexCount : 0;
+            Cooked.PrimitiveCount = pSplat->m_nPrimitiveCount;
+
+        } // End if splat
+        if ( !WriteData( hFile, &Cooked, sizeof(CookedSplat) ) ) return false;
+        if ( !pSplat ) continue;
+
+        if ( !WriteData( hFile, pSplat->m_pIndices, Cooked.IndexCount * sizeof(USHORT), true ) ) return false;
+
+    } // Next Splat Level
 
     // Success!
     return true;
 }
 
+//-----------------------------------------------------------------------------
+// Name : CalculateLODErrors ()
+// Desc : Calculates the largest vertical distance between the full detail
+//        block and the surface rendered at each coarser level. Errors never
+//        decrease as the level increases.
+//-----------------------------------------------------------------------------
+void CTerrainBlock::CalculateLODErrors( const BLOCK_SOURCE & Source )
+{
+    ULONG         Level, Step, x, z, cx, cz, CellsWide, CellsHigh;
+    ULONG         Width       = Source.HeightPitch;
+    const float * pHeightMap  = Source.pHeights;
+    float         fx, fz, h00, h01, h10, h11, Height, Error = 0.0f;
+
+    // Full detail is exact
+    m_fLODError[0] = 0.0f;
+
+    for ( Level = 1; Level < m_pParent->GetLODCount(); Level++ )
+    {
+        Step      = 1 << Level;
+        CellsWide = m_nQuadsWide / Step;
+        CellsHigh = m_nQuadsHigh / Step;
+
+        for ( z = 0; z <= m_nQuadsHigh; z++ )
+        {
+            for ( x = 0; x <= m_nQuadsWide; x++ )
+            {
+                // Cell containing this vertex at this level
+                cx = min( x / Step, CellsWide - 1 );
+                cz = min( z / Step, CellsHigh - 1 );
+                fx = (float)(x - cx * Step) / Step;
+                fz = (float)(z - cz * Step) / Step;
+
+                // Heights at the corners of the cell
+                ULONG Base = (cx * Step) + (cz * Step) * Width;
+                h00 = pHeightMap[ Base ];
+                h10 = pHeightMap[ Base + Step ];
+                h01 = pHeightMap[ Base + Step * Width ];
+                h11 = pHeightMap[ Base + Step * Width + Step ];
+
+                // Interpolate across the triangle covering the vertex (the cell is
+                // split from (x,z) to (x+1,z+1))
+                if ( fz >= fx )
+                    Height = h00 + fz * (h01 - h00) + fx * (h11 - h01);
+                else
+                    Height = h00 + fx * (h10 - h00) + fz * (h11 - h10);
+
+                Height = fabsf( Height - pHeightMap[ x + z * Width ] );
+                if ( Height > Error ) Error = Height;
+
+            } // Next Column
+
+        } // Next Row
+
+        m_fLODError[Level] = Error * m_pParent->GetScale().y;
+
+    } // Next Level
+}
 
 //-----------------------------------------------------------------------------
 // Name : CountLayerUsage () (Private)
 // Desc : Count up the number of times a layer is used by this block.
 //-----------------------------------------------------------------------------
-bool CTerrainBlock::CountLayerUsage()
+bool CTerrainBlock::CountLayerUsage( const BLOCK_SOURCE & Source )
 {
     USHORT i;
     ULONG  x, z;
-    UCHAR  Value;
 
     // Allocate the layer usage array
     m_pLayerUsage = new USHORT[ m_pParent->GetLayerCount() ];
     if( !m_pLayerUsage ) return false;
     ZeroMemory( m_pLayerUsage, m_pParent->GetLayerCount() * sizeof(USHORT));
 
-    // Pre-Calculate loop counts
-    ULONG LoopStartX = (m_nStartX * m_pParent->GetBlendTexRatio());
-    ULONG LoopStartZ = (m_nStartZ * m_pParent->GetBlendTexRatio());
-    ULONG LoopEndX   = (m_nStartX + m_nQuadsWide) * m_pParent->GetBlendTexRatio();
-    ULONG LoopEndZ   = (m_nStartZ + m_nQuadsHigh) * m_pParent->GetBlendTexRatio();
-
-    // Determine which layers we are using in this block
-    for ( z = LoopStartZ; z < LoopEndZ; z++ )
+    // Count the quads of this block covered by each layer
+    for ( i = 0; i < m_pParent->GetLayerCount(); i++ )
     {
-        for ( x = LoopStartX; x < LoopEndX; x++ )
+        const UCHAR * pCoverage = Source.ppCoverage[i] + Source.CoverageOffset;
+
+        for ( z = 0; z < m_nQuadsHigh; z++, pCoverage += Source.CoveragePitch )
         {
-            // Loop through each layer
-            for ( i = 0; i < m_pParent->GetLayerCount(); i++ )
+            for ( x = 0; x < m_nQuadsWide; x++ )
             {
-                CTerrainLayer * pLayer = m_pParent->GetLayer(i);
+                if ( pCoverage[x] > 0 ) m_pLayerUsage[i]++;
 
-                // Retrieve alpha value
-                Value = pLayer->m_pBlendMap[ x + z * pLayer->m_nLayerWidth ];
-                if ( Value > 0 ) m_pLayerUsage[i]++;
-
-            } // Next Layer
+            } // Next Column
 
-        } // Next Column
+        } // Next Row
 
-    } // Next Row
+    } // Next Layer
     
     // Success!!
     return true;
@@ -1120,7 +3326,7 @@ bool CTerrainBlock::CountLayerUsage()
 // Name : GenerateSplats () (Private)
 // Desc : Generate the various splat levels required for this block
 //-----------------------------------------------------------------------------
-bool CTerrainBlock::GenerateSplats()
+bool CTerrainBlock::GenerateSplats( const BLOCK_SOURCE & Source )
 {
     USHORT i;
 
@@ -1134,7 +3340,7 @@ bool CTerrainBlock::GenerateSplats()
         if ( !m_pLayerUsage[i] ) continue;
 
         // Generate the splat level for this layer
-        if (!GenerateSplatLevel( i )) return false;
+        if (!GenerateSplatLevel( Source, i )) return false;
 
     } // Next Layer
 
@@ -1146,21 +3352,12 @@ bool CTerrainBlock::GenerateSplats()
 // Name : GenerateSplatLevel () (Private)
 // Desc : Generate an individual splat level for this terrain block.
 //-----------------------------------------------------------------------------
-bool CTerrainBlock::GenerateSplatLevel( USHORT TerrainLayer )
+bool CTerrainBlock::GenerateSplatLevel( const BLOCK_SOURCE & Source, USHORT TerrainLayer )
 {
-    HRESULT   hRet;
     USHORT   *pIndex = NULL;
-    ULONG     x, z, ax, az;
-    UCHAR     Value;
-    float     BlendTexels = m_pParent->GetBlendTexRatio();
+    ULONG     x, z;
 
-    LPDIRECT3DDEVICE9 pD3DDevice = m_pParent->GetD3DDevice();
-    bool HardwareTnL = m_pParent->UseHardwareTnL();
-    CTerrainLayer * pLayer = m_pParent->GetLayer( TerrainLayer );
-
-    // Calculate usage variable
-    ULONG Usage = D3DUSAGE_WRITEONLY;
-    if (!HardwareTnL) Usage |= D3DUSAGE_SOFTWAREPROCESSING;
+    const UCHAR * pCoverage = Source.ppCoverage[ TerrainLayer ] + Source.CoverageOffset;
 
     // Allocate a new splat
     CTerrainSplat * pSplat = new CTerrainSplat;
@@ -1172,45 +3369,18 @@ bool CTerrainBlock::GenerateSplatLevel( USHORT TerrainLayer )
     // Store layer index (handy later on)
     pSplat->m_nLayerIndex = TerrainLayer;
 
-    // Create the index buffer ready for generation
-    hRet = pD3DDevice->CreateIndexBuffer( ((m_nQuadsWide * m_nQuadsHigh) * 6) * sizeof(USHORT), Usage, D3DFMT_INDEX16, D3DPOOL_MANAGED, &pSplat->m_pIndexBuffer, NULL );
-    if ( FAILED(hRet ) ) return false;
-
-    // Lock the index buffer ready to fill data
-    hRet = pSplat->m_pIndexBuffer->Lock( 0, ((m_nQuadsWide * m_nQuadsHigh) * 6) * sizeof(USHORT), (void**)&pIndex, 0 );
-    if ( FAILED(hRet ) ) return false;
+    // Allocate enough indices for every quad in the block
+    pSplat->m_pIndices = new USHORT[ (m_nQuadsWide * m_nQuadsHigh) * 6 ];
+    if ( !pSplat->m_pIndices ) return false;
+    pIndex = pSplat->m_pIndices;
 
     // Calculate the indices for the splat tri-list
-    for ( z = 0; z < m_nQuadsHigh; z++ )
+    for ( z = 0; z < m_nQuadsHigh; z++, pCoverage += Source.CoveragePitch )
     {
-        // Pre-Calc Loop starts / ends
-        ULONG LoopStartZ = ( z + m_nStartZ ) * BlendTexels;
-        ULONG LoopEndZ   = LoopStartZ + BlendTexels;
-
         for ( x = 0; x < m_nQuadsWide; x++ )
         {
-            // Pre-Calc Loop starts / ends
-            ULONG LoopStartX = ( x + m_nStartX ) * BlendTexels;
-            ULONG LoopEndX   = LoopStartX + BlendTexels;
-
-            // Determine if element is visible anywhere
-            for ( az = LoopStartZ; az < LoopEndZ; az++ )
-            {
-                for ( ax = LoopStartX; ax < LoopEndX; ax++ )
-                {
-                    // Retrieve the layer data
-                    Value = pLayer->m_pBlendMap[ ax + az * pLayer->m_nLayerWidth ];
-                    if ( Value > 0 ) break;
-                
-                } // Next Alpha Column
-
-                // Break if we found one
-                if ( Value > 0 ) break;
-
-            } // Next Alpha Row
-
-            // Should we write the quad here ?
-            if ( Value == 0 ) continue;
+            // Should we write the quad here ? (is the layer visible anywhere on it)
+            if ( pCoverage[x] == 0 ) continue;
 
             // Insert next two triangles
             *pIndex++ = (USHORT)(x + z * m_nBlockWidth);
@@ -1229,9 +3399,6 @@ bool CTerrainBlock::GenerateSplatLevel( USHORT TerrainLayer )
     
     } // Next Element ROw
 
-    // Unlock the index buffer
-    pSplat->m_pIndexBuffer->Unlock();
-
     // Success!!
     return true;
 
@@ -1239,67 +3406,55 @@ bool CTerrainBlock::GenerateSplatLevel( USHORT TerrainLayer )
 
 //-----------------------------------------------------------------------------
 // Name : GenerateBlendMaps () (Private)
-// Desc : Now generate the blend maps to blend the splats together.
+// Desc : Now generate the blend maps to blend the splats together. The blend
+//        maps of every layer above the base are packed, four at a time, into
+//        the channels of one texture for each layer group (see PackBlendRow).
 //-----------------------------------------------------------------------------
-bool CTerrainBlock::GenerateBlendMaps( )
+bool CTerrainBlock::GenerateBlendMaps( const BLOCK_SOURCE & Source )
 {
-    HRESULT hRet;
-    ULONG Width, Height, i, x, z;
-    LPDIRECT3DDEVICE9 pD3DDevice = m_pParent->GetD3DDevice();
-    D3DLOCKED_RECT LockData;
-    UCHAR Value;
-    ULONG BlendTexels = m_pParent->GetBlendTexRatio();
-
-    // Bail if we have no data
-    if ( m_nSplatCount == 0 ) return true;
+    ULONG         Width, Height, Group, Channel, Layer, z;
+    const UCHAR * pRows[ TERRAIN_BLEND_CHANNELS ];
+    ULONG         BlendTexels = m_pParent->GetBlendTexRatio();
+    USHORT        GroupCount  = m_pParent->GetBlendGroupCount();
+    bool          SSE2        = IsProcessorFeaturePresent( PF_XMMI64_INSTRUCTIONS_AVAILABLE ) != FALSE;
+
+    // Bail if there are no layers to blend
+    if ( GroupCount == 0 ) return true;
     
     // Calculate width / height of the texture
     Width = (m_nQuadsWide * BlendTexels);
     Height = (m_nQuadsHigh * BlendTexels);
-    
-    // Calculate each splats blend map
-    for ( i = 0; i < m_nSplatCount; i++ )
+
+    // Allocate our blend texels
+    m_pBlendData = new ULONG[ GroupCount * Width * Height ];
+    if ( !m_pBlendData ) return false;
+    ULONG * pBuffer = m_pBlendData;
+
+    // Pack each group of layers
+    for ( Group = 0; Group < GroupCount; Group++ )
     {
-        // Bail if this is an empty splat level
-        if ( !m_pSplatLevel[i] ) continue;
+        // Find the first row of each layer in the group (we never generate an
+        // alpha map for terrain layer 0)
+        for ( Channel = 0; Channel < TERRAIN_BLEND_CHANNELS; Channel++ )
+        {
+            Layer = 1 + Group * TERRAIN_BLEND_CHANNELS + Channel;
+            pRows[Channel] = ( Layer < m_pParent->GetLayerCount() ) ? Source.ppBlendMaps[Layer] + Source.BlendOffset : NULL;
 
-        CTerrainLayer * pLayer = m_pParent->GetLayer( i );
-        
-        // We never generate an alpha map for terrain layer 0
-        if ( m_pSplatLevel[i]->m_nLayerIndex == 0) continue;
-        
-        // Create our blend texture
-        hRet = pD3DDevice->CreateTexture( Width, Height, 1, 0, D3DFMT_A4R4G4B4, D3DPOOL_MANAGED, &m_pSplatLevel[i]->m_pBlendTexture, NULL );
-        if ( FAILED(hRet) ) return false;
-            
-        // Lock the texture
-        hRet = m_pSplatLevel[i]->m_pBlendTexture->LockRect( 0, &LockData, NULL, 0 );
-        if ( FAILED(hRet) ) return false;
-         
-        USHORT * pBuffer = (USHORT*)LockData.pBits;
+        } // Next Channel
 
-        // Loop through each pixel and store
-        for ( z = 0; z < Height; z++ )
+        // Loop through each row and store
+        for ( z = 0; z < Height; z++, pBuffer += Width )
         {
-            for ( x = 0; x < Width; x++, pBuffer++ )
+            PackBlendRow( pBuffer, pRows, Width, SSE2 );
+            for ( Channel = 0; Channel < TERRAIN_BLEND_CHANNELS; Channel++ )
             {
-                // Retrieve alpha value
-                Value = pLayer->m_pBlendMap[ (x + (m_nStartX * BlendTexels)) + (z + (m_nStartZ * BlendTexels)) * pLayer->m_nLayerWidth ];
+                if ( pRows[Channel] ) pRows[Channel] += Source.BlendPitch;
 
-                // Store value in buffer ( Shift right 4 and left 12 )
-                *pBuffer = ((LONG)Value << 8) & 0xF000;
-            
-            } // Next Column
-
-            // Add on pitch tail
-            pBuffer += LockData.Pitch - ( Width * sizeof(USHORT) );
+            } // Next Channel
         
         } // Next Row
 
-        // Unlock the blend texture
-        m_pSplatLevel[i]->m_pBlendTexture->UnlockRect( 0 );
-
-    } // Next Splat Level        
+    } // Next Layer Group
 
     // Success!!
     return true;
@@ -1345,19 +3500,30 @@ long CTerrainBlock::AddSplatLevel( USHORT Count )
 //-----------------------------------------------------------------------------
 // Name : Render ()
 // Desc : Render the terrain block
+// Note : The block's vertex buffer, blend texture and the layer's texturing
+//        states must already be set (see CTerrain::Render).
 //-----------------------------------------------------------------------------
 void CTerrainBlock::Render( LPDIRECT3DDEVICE9 pD3DDevice, USHORT LayerIndex )
 {
     // Bail if this layer is not in use
     if ( !m_pSplatLevel[LayerIndex] ) return;
 
-    // Set up vertex streams & Textures
-    pD3DDevice->SetIndices( m_pSplatLevel[LayerIndex]->m_pIndexBuffer );
-    pD3DDevice->SetTexture( 1, m_pSplatLevel[LayerIndex]->m_pBlendTexture );
+    // At full detail with no stitching, render only the quads this layer covers
+    if ( m_nLOD == 0 && m_nLODEdges == 0 )
+    {
+        if ( m_pSplatLevel[LayerIndex]->m_nPrimitiveCount == 0 ) return;
+        pD3DDevice->SetIndices( m_pSplatLevel[LayerIndex]->m_pIndexBuffer );
+        pD3DDevice->DrawIndexedPrimitive( D3DPT_TRIANGLELIST, 0, 0, (m_nBlockWidth * m_nBlockHeight), 0, m_pSplatLevel[LayerIndex]->m_nPrimitiveCount );
+        return;
+
+    } // End if full detail
 
-    // Render the vertex buffer
-    if ( m_pSplatLevel[LayerIndex]->m_nPrimitiveCount == 0 ) return;
-    pD3DDevice->DrawIndexedPrimitive( D3DPT_TRIANGLELIST, 0, 0, (m_nBlockWidth * m_nBlockHeight), 0, m_pSplatLevel[LayerIndex]->m_nPrimitiveCount );
+    // Otherwise render the whole block at the selected level, the blend map
+    // masks out any area this layer does not cover
+    pD3DDevice->SetIndices( m_pParent->GetLODIndexBuffer() );
+    pD3DDevice->DrawIndexedPrimitive( D3DPT_TRIANGLELIST, 0, 0, (m_nBlockWidth * m_nBlockHeight),
+                                      m_pParent->GetLODStart( m_nLOD, m_nLODEdges ),
+                                      m_pParent->GetLODPrimitives( m_nLOD, m_nLODEdges ) );
 
 }
 
@@ -1372,7 +3538,7 @@ CTerrainSplat::CTerrainSplat( )
     m_nIndexCount       = 0;
     m_nPrimitiveCount   = 0;
     m_nLayerIndex       = 0;
-    m_pBlendTexture     = NULL;
+    m_pIndices          = NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -1383,11 +3549,13 @@ CTerrainSplat::~CTerrainSplat()
 {
     // Release Direct3D Objects
     if ( m_pIndexBuffer  ) m_pIndexBuffer->Release();
-    if ( m_pBlendTexture ) m_pBlendTexture->Release();
+
+    // Release any data not yet uploaded
+    if ( m_pIndices      ) delete []m_pIndices;
    
     // Reset pointers
     m_pIndexBuffer      = NULL;
-    m_pBlendTexture     = NULL;
+    m_pIndices          = NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -1401,6 +3569,7 @@ CTerrainLayer::CTerrainLayer( )
     m_nLayerWidth   = 0;
     m_nLayerHeight  = 0;
     m_pBlendMap     = NULL;
+    m_pCoverage     = NULL;
     D3DXMatrixIdentity( &m_mtxTexture );
 }
 
@@ -1412,9 +3581,105 @@ CTerrainLayer::~CTerrainLayer()
 {
     // Release flat arrays
     if ( m_pBlendMap ) delete []m_pBlendMap;
+    if ( m_pCoverage ) delete []m_pCoverage;
 
     // Reset pointers
     m_pBlendMap = NULL;
+    m_pCoverage = NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildCoverage ()
+// Desc : Builds the coverage map for this layer from its blend map. This
+//        holds the largest blend map value beneath each terrain quad, so
+//        testing whether the layer appears anywhere on a quad is a single
+//        lookup, however many blend texels each quad covers.
+//-----------------------------------------------------------------------------
+bool CTerrainLayer::BuildCoverage( ULONG BlendTexRatio )
+{
+    ULONG QuadsWide, QuadsHigh;
+
+    // Validate requirements
+    if ( !m_pBlendMap || BlendTexRatio == 0 || BlendTexRatio > COVERAGE_MAX_ROW ) return false;
+    QuadsWide = m_nLayerWidth  / BlendTexRatio;
+    QuadsHigh = m_nLayerHeight / BlendTexRatio;
+
+    // Allocate the map
+    if ( m_pCoverage ) delete []m_pCoverage;
+    m_pCoverage = new UCHAR[ QuadsWide * QuadsHigh ];
+    if ( !m_pCoverage ) return false;
+
+    // Build it
+    BuildCoverage( m_pCoverage, QuadsWide, m_pBlendMap, m_nLayerWidth, QuadsWide, QuadsHigh, BlendTexRatio );
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildCoverage () (Static)
+// Desc : Stores the largest value of each BlendTexRatio x BlendTexRatio area
+//        of the source blend map, one per quad, in the destination map.
+// Note : This is the max-reduction level matching the quad size. Rows of
+//        texels are combined sixteen at a time where SSE2 is available.
+//-----------------------------------------------------------------------------
+void CTerrainLayer::BuildCoverage( UCHAR * pDest, ULONG DestPitch, const UCHAR * pSrc, ULONG SrcPitch,
+                                   ULONG QuadsWide, ULONG QuadsHigh, ULONG BlendTexRatio )
+{
+    ULONG  x, z, r, k, Start;
+    UCHAR  RowMax[ COVERAGE_MAX_ROW ];
+    bool   SSE2 = IsProcessorFeaturePresent( PF_XMMI64_INSTRUCTIONS_AVAILABLE ) != FALSE;
+
+    // Validate requirements
+    if ( BlendTexRatio == 0 || BlendTexRatio > COVERAGE_MAX_ROW ) return;
+
+    for ( z = 0; z < QuadsHigh; z++, pDest += DestPitch )
+    {
+        const UCHAR * pRow = pSrc + (z * BlendTexRatio) * SrcPitch;
+
+        // Process the row in sections which fit the scratch buffer
+        for ( Start = 0; Start < QuadsWide; )
+        {
+            ULONG Count = min( QuadsWide - Start, COVERAGE_MAX_ROW / BlendTexRatio );
+            ULONG Texels = Count * BlendTexRatio, Offset = Start * BlendTexRatio;
+
+            // Combine the texel rows under this row of quads
+            memcpy( RowMax, pRow + Offset, Texels );
+            for ( r = 1; r < BlendTexRatio; r++ )
+            {
+                const UCHAR * pNext = pRow + r * SrcPitch + Offset;
+
+                k = 0;
+                if ( SSE2 )
+                {
+                    for ( ; k + 16 <= Texels; k += 16 )
+                    {
+                        __m128i Max = _mm_max_epu8( _mm_loadu_si128( (const __m128i*)(RowMax + k) ),
+                                                    _mm_loadu_si128( (const __m128i*)(pNext + k) ) );
+                        _mm_storeu_si128( (__m128i*)(RowMax + k), Max );
+
+                    } // Next Sixteen Texels
+
+                } // End if SSE2
+                for ( ; k < Texels; k++ ) if ( pNext[k] > RowMax[k] ) RowMax[k] = pNext[k];
+
+            } // Next Texel Row
+
+            // Then the texels across each quad
+            for ( x = 0; x < Count; x++ )
+            {
+                const UCHAR * pQuad = RowMax + x * BlendTexRatio;
+                UCHAR         Max   = pQuad[0];
+
+                for ( k = 1; k < BlendTexRatio; k++ ) if ( pQuad[k] > Max ) Max = pQuad[k];
+                pDest[ Start + x ] = Max;
+
+            } // Next Quad
+            Start += Count;
+
+        } // Next Section
+
+    } // Next Quad Row
 }
 
 //-----------------------------------------------------------------------------
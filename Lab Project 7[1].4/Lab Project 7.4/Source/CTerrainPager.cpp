@@ -0,0 +1,859 @@
+//-----------------------------------------------------------------------------
+// File: CTerrainPager.cpp
+//
+// Desc: Streams terrain blocks in and out of memory from a page file, so that
+//       terrains far larger than available memory can be rendered.
+//
+// Copyright (c) 1997-2002 Daedalus Developments. All rights reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CTerrainPager Specific Includes
+//-----------------------------------------------------------------------------
+#include "..\\Includes\\CTerrainPager.h"
+#include "..\\Includes\\CTerrain.h"
+#include "..\\Includes\\CProfiler.h"
+#include <process.h>
+#include <float.h>
+
+//-----------------------------------------------------------------------------
+// Module Local Constants & Structures
+//-----------------------------------------------------------------------------
+namespace
+{
+    const ULONG PAGE_FILE_MAGIC   = 0x47505254;     // 'TRPG'
+    const ULONG PAGE_FILE_VERSION = 2;              // Increment whenever the layout changes
+    const ULONG PAGE_BAND_SAMPLES = 1 << 22;        // Heightmap samples (roughly) read at once when writing the page file
+
+    // Stored at the start of the page file, must match the terrain definition
+    // and the input files it was built from
+    struct PageFileHeader
+    {
+        ULONG   Magic;              // PAGE_FILE_MAGIC
+        ULONG   Version;            // PAGE_FILE_VERSION
+        ULONG   TerrainWidth;       // Heightmap samples in each row
+        ULONG   TerrainHeight;      // Heightmap rows
+        ULONG   BlockWidth;         // Samples along each side of a block
+        ULONG   BlockHeight;
+        ULONG   BlocksWide;         // Blocks in each row
+        ULONG   BlocksHigh;         // Block rows
+        ULONG   BlendTexRatio;      // Blend texels per quad
+        ULONG   LayerCount;         // Blend maps stored with each block
+        ULONG   LODCount;           // Detail levels stored in each PageFileTile
+        ULONG   TileSize;           // Size of each block's tile data, in bytes
+        unsigned __int64 Hash;      // Hash of the input files (see HashTerrainInputs)
+    };
+
+    // Always resident data for each block (all heights unscaled)
+    struct PageFileTile
+    {
+        float   MinY;                       // Lowest height in the block
+        float   MaxY;                       // Highest height in the block
+        float   LODError[TERRAIN_MAX_LOD];  // Largest height error at each detail level
+    };
+};
+
+//-----------------------------------------------------------------------------
+// Name : GetTileSize () (Module Local)
+// Desc : Returns the size, in bytes, of the tile data stored for each block.
+//-----------------------------------------------------------------------------
+static ULONG GetTileSize( CTerrain * pTerrain )
+{
+    ULONG BlockWidth  = pTerrain->GetBlockWidth();
+    ULONG BlockHeight = pTerrain->GetBlockHeight();
+    ULONG BlendSize   = ((BlockWidth - 1) * pTerrain->GetBlendTexRatio()) * ((BlockHeight - 1) * pTerrain->GetBlendTexRatio());
+
+    return sizeof(float) * BlockWidth * BlockHeight +
+           sizeof(float) * 3 * (BlockWidth + 1) * (BlockHeight + 1) +
+           BlendSize * pTerrain->GetLayerCount();
+}
+
+//-----------------------------------------------------------------------------
+// Name : ReadAt () (Module Local)
+// Desc : Reads from the file offset specified. Safe to call from several
+//        threads at once on the same handle.
+//-----------------------------------------------------------------------------
+static bool ReadAt( HANDLE hFile, __int64 Offset, void * pBuffer, ULONG Size )
+{
+    OVERLAPPED Overlapped;
+    DWORD      Read = 0;
+
+    ZeroMemory( &Overlapped, sizeof(OVERLAPPED) );
+    Overlapped.Offset     = (DWORD)(Offset & 0xFFFFFFFF);
+    Overlapped.OffsetHigh = (DWORD)(Offset >> 32);
+
+    if ( !::ReadFile( hFile, pBuffer, Size, &Read, &Overlapped ) ) return false;
+    return ( Read == Size );
+}
+
+//-----------------------------------------------------------------------------
+// Name : WriteData () (Module Local)
+// Desc : Writes to the current position of the file specified.
+//-----------------------------------------------------------------------------
+static bool WriteData( HANDLE hFile, const void * pBuffer, ULONG Size )
+{
+    DWORD Written = 0;
+
+    if ( !::WriteFile( hFile, pBuffer, Size, &Written, NULL ) ) return false;
+    return ( Written == Size );
+}
+
+//-----------------------------------------------------------------------------
+// Name : CTerrainPager () (Constructor)
+// Desc : CTerrainPager Class Constructor
+//-----------------------------------------------------------------------------
+CTerrainPager::CTerrainPager()
+{
+	// Reset / Clear all required values
+    m_pTerrain          = NULL;
+    m_hFile             = INVALID_HANDLE_VALUE;
+    m_nTileSize         = 0;
+    m_nTileStart        = 0;
+    m_pOverview         = NULL;
+    m_nOverviewWidth    = 0;
+    m_nOverviewHeight   = 0;
+    m_nMaxResident      = 0;
+
+    m_nFrame            = 0;
+    m_nResidentCount    = 0;
+    m_nPendingCount     = 0;
+    m_pLRUHead          = NULL;
+    m_pLRUTail          = NULL;
+
+    m_nLoaderCount      = 0;
+    m_hRequest          = NULL;
+    m_nRequestHead      = 0;
+    m_nRequestCount     = 0;
+    m_nCompletedHead    = 0;
+    m_nCompletedCount   = 0;
+    m_bQuit             = false;
+
+    ::InitializeCriticalSection( &m_Lock );
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CTerrainPager () (Destructor)
+// Desc : CTerrainPager Class Destructor
+//-----------------------------------------------------------------------------
+CTerrainPager::~CTerrainPager()
+{
+    // Stop the loaders and close the file
+    Close();
+    ::DeleteCriticalSection( &m_Lock );
+}
+
+//-----------------------------------------------------------------------------
+// Name : Open ()
+// Desc : Opens the page file, reads the overview and starts the loader
+//        threads. Fails if the file does not match the terrain's definition,
+//        or was built from input files other than those hashed to 'Hash'.
+// Note : The terrain's dimensions, block size, blend texture ratio and layer
+//        count must all be known before calling.
+//-----------------------------------------------------------------------------
+bool CTerrainPager::Open( CTerrain * pTerrain, LPCTSTR FileName, unsigned __int64 Hash, ULONG MaxResident, ULONG LoaderCount )
+{
+    PageFileHeader Header;
+    ULONG          i, OverviewSize;
+
+    // Release any previous file
+    Close();
+
+    // Validate requirements
+    if ( !pTerrain || !FileName ) return false;
+    m_pTerrain = pTerrain;
+
+    // Open the file for reading
+    m_hFile = ::CreateFile( FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL );
+    if ( m_hFile == INVALID_HANDLE_VALUE ) return false;
+
+    // Read and validate the header
+    if ( !ReadAt( m_hFile, 0, &Header, sizeof(PageFileHeader) ) ||
+         Header.Magic         != PAGE_FILE_MAGIC ||
+         Header.Version       != PAGE_FILE_VERSION ||
+         Header.TerrainWidth  != pTerrain->GetTerrainWidth() ||
+         Header.TerrainHeight != pTerrain->GetTerrainHeight() ||
+         Header.BlockWidth    != pTerrain->GetBlockWidth() ||
+         Header.BlockHeight   != pTerrain->GetBlockHeight() ||
+         Header.BlendTexRatio != pTerrain->GetBlendTexRatio() ||
+         Header.LayerCount    != pTerrain->GetLayerCount() ||
+         Header.LODCount      != pTerrain->GetLODCount() ||
+         Header.TileSize      != GetTileSize( pTerrain ) ||
+         Header.Hash          != Hash ) { Close(); return false; }
+
+    // Read the overview
+    m_nOverviewWidth  = Header.BlocksWide + 1;
+    m_nOverviewHeight = Header.BlocksHigh + 1;
+    OverviewSize      = m_nOverviewWidth * m_nOverviewHeight * sizeof(float);
+    m_pOverview       = new float[ m_nOverviewWidth * m_nOverviewHeight ];
+    if ( !m_pOverview || !ReadAt( m_hFile, sizeof(PageFileHeader), m_pOverview, OverviewSize ) ) { Close(); return false; }
+
+    // Store the file layout
+    m_nTileSize    = Header.TileSize;
+    m_nTileStart   = (__int64)sizeof(PageFileHeader) + OverviewSize +
+                     (__int64)Header.BlocksWide * Header.BlocksHigh * sizeof(PageFileTile);
+    m_nMaxResident = MaxResident;
+
+    // Create the synchronisation objects
+    m_hRequest = ::CreateSemaphore( NULL, 0, PAGE_MAX_PENDING + PAGE_MAX_LOADERS, NULL );
+    if ( !m_hRequest ) { Close(); return false; }
+
+    // Spawn the loader threads
+    if ( LoaderCount < 1 ) LoaderCount = 1;
+    if ( LoaderCount > PAGE_MAX_LOADERS ) LoaderCount = PAGE_MAX_LOADERS;
+    m_bQuit = false;
+    for ( i = 0; i < LoaderCount; i++ )
+    {
+        m_hLoaders[i] = (HANDLE)_beginthreadex( NULL, 0, StaticLoaderProc, this, 0, NULL );
+        if ( !m_hLoaders[i] ) break;
+
+        // Thread is now running
+        m_nLoaderCount++;
+
+    } // Next Loader
+
+    // Must have at least one loader
+    if ( m_nLoaderCount == 0 ) { Close(); return false; }
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : InitBlocks ()
+// Desc : Sets up the position, bounds and detail level errors of every block
+//        from the page file. No block data is loaded.
+// Note : The terrain must have allocated its blocks before calling.
+//-----------------------------------------------------------------------------
+bool CTerrainPager::InitBlocks( )
+{
+    ULONG           i, Count;
+    PageFileTile  * pTiles = NULL;
+
+    // Validate requirements
+    if ( !IsOpen() ) return false;
+
+    // The block grid must match the file
+    Count = m_pTerrain->GetBlockCount();
+    if ( (ULONG)m_pTerrain->GetBlocksWide() + 1 != m_nOverviewWidth ||
+         (ULONG)m_pTerrain->GetBlocksHigh() + 1 != m_nOverviewHeight ) return false;
+
+    // Read the tile table
+    pTiles = new PageFileTile[ Count ];
+    if ( !pTiles ) return false;
+    if ( !ReadAt( m_hFile, m_nTileStart - (__int64)Count * sizeof(PageFileTile), pTiles, Count * sizeof(PageFileTile) ) )
+    {
+        delete []pTiles;
+        return false;
+
+    } // End if failed
+
+    const D3DXVECTOR3 & Scale = m_pTerrain->GetScale();
+    for ( i = 0; i < Count; i++ )
+    {
+        CTerrainBlock * pBlock = m_pTerrain->GetBlock( i );
+        ULONG           Level;
+
+        // Position the block
+        pBlock->m_pParent      = m_pTerrain;
+        pBlock->m_nBlockWidth  = m_pTerrain->GetBlockWidth();
+        pBlock->m_nBlockHeight = m_pTerrain->GetBlockHeight();
+        pBlock->m_nQuadsWide   = pBlock->m_nBlockWidth - 1;
+        pBlock->m_nQuadsHigh   = pBlock->m_nBlockHeight - 1;
+        pBlock->m_nStartX      = (i % m_pTerrain->GetBlocksWide()) * pBlock->m_nQuadsWide;
+        pBlock->m_nStartZ      = (i / m_pTerrain->GetBlocksWide()) * pBlock->m_nQuadsHigh;
+        pBlock->m_nPageState   = CTerrainBlock::PAGE_UNLOADED;
+
+        // Store the bounds and errors used to cull and select detail levels
+        pBlock->m_BoundsMin = D3DXVECTOR3( pBlock->m_nStartX * Scale.x, pTiles[i].MinY * Scale.y, pBlock->m_nStartZ * Scale.z );
+        pBlock->m_BoundsMax = D3DXVECTOR3( (pBlock->m_nStartX + pBlock->m_nQuadsWide) * Scale.x, pTiles[i].MaxY * Scale.y,
+                                           (pBlock->m_nStartZ + pBlock->m_nQuadsHigh) * Scale.z );
+        for ( Level = 0; Level < m_pTerrain->GetLODCount(); Level++ )
+            pBlock->m_fLODError[Level] = pTiles[i].LODError[Level] * Scale.y;
+
+    } // Next Block
+
+    // Success!
+    delete []pTiles;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Close ()
+// Desc : Stops the loader threads and closes the page file. Blocks which are
+//        still resident are left for the terrain to release.
+//-----------------------------------------------------------------------------
+void CTerrainPager::Close( )
+{
+    ULONG i;
+
+    // Wake each loader with the quit flag set, and wait for it to finish
+    if ( m_nLoaderCount > 0 )
+    {
+        m_bQuit = true;
+        ::ReleaseSemaphore( m_hRequest, m_nLoaderCount, NULL );
+
+        for ( i = 0; i < m_nLoaderCount; i++ )
+        {
+            ::WaitForSingleObject( m_hLoaders[i], INFINITE );
+            ::CloseHandle( m_hLoaders[i] );
+
+        } // Next Loader
+
+    } // End if loaders running
+
+    // Release the file and synchronisation objects
+    if ( m_hRequest ) ::CloseHandle( m_hRequest );
+    if ( m_hFile != INVALID_HANDLE_VALUE ) ::CloseHandle( m_hFile );
+    if ( m_pOverview ) delete []m_pOverview;
+
+    // Reset all values
+    m_pTerrain          = NULL;
+    m_hFile             = INVALID_HANDLE_VALUE;
+    m_hRequest          = NULL;
+    m_pOverview         = NULL;
+    m_nOverviewWidth    = 0;
+    m_nOverviewHeight   = 0;
+    m_nLoaderCount      = 0;
+    m_nResidentCount    = 0;
+    m_nPendingCount     = 0;
+    m_pLRUHead          = NULL;
+    m_pLRUTail          = NULL;
+    m_nRequestHead      = 0;
+    m_nRequestCount     = 0;
+    m_nCompletedHead    = 0;
+    m_nCompletedCount   = 0;
+    m_bQuit             = false;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Update ()
+// Desc : Called once per frame. Uploads blocks finished by the loaders,
+//        requests blocks within the radius of the position specified (nearest
+//        first), and evicts the least recently used blocks once over budget.
+//-----------------------------------------------------------------------------
+void CTerrainPager::Update( const D3DXVECTOR3 & Position, float Radius, ULONG MaxUploads )
+{
+    ULONG           Block, Uploads, Ring, Rings, i, Side;
+    long            cx, cz, x, z;
+    float           dx, dz;
+    CTerrainBlock * pBlock;
+    PROFILE_ZONE( "CTerrainPager::Update" );
+
+    // Validate requirements
+    if ( !IsOpen() ) return;
+    m_nFrame++;
+
+    // Upload blocks the loaders have finished building
+    for ( Uploads = 0; Uploads < MaxUploads; )
+    {
+        ::EnterCriticalSection( &m_Lock );
+        if ( m_nCompletedCount == 0 ) { ::LeaveCriticalSection( &m_Lock ); break; }
+        Block = m_Completed[ m_nCompletedHead ];
+        m_nCompletedHead = (m_nCompletedHead + 1) % PAGE_MAX_PENDING;
+        m_nCompletedCount--;
+        ::LeaveCriticalSection( &m_Lock );
+
+        m_nPendingCount--;
+        pBlock = m_pTerrain->GetBlock( Block );
+
+        // Blocks which failed to load or upload are requested again later
+        if ( pBlock->m_nPageState != CTerrainBlock::PAGE_BUILT || !pBlock->CreateResources() )
+        {
+            pBlock->ReleaseResources();
+            pBlock->m_nPageState = CTerrainBlock::PAGE_UNLOADED;
+            continue;
+
+        } // End if failed
+
+        // Block is now resident
+        pBlock->m_nPageState = CTerrainBlock::PAGE_RESIDENT;
+        m_nResidentCount++;
+        TouchBlock( pBlock );
+        Uploads++;
+
+    } // Next Upload
+
+    // Find the block containing the position, and the number of rings of
+    // blocks around it which could lie within the radius
+    float BlockSizeX = (m_pTerrain->GetBlockWidth()  - 1) * m_pTerrain->GetScale().x;
+    float BlockSizeZ = (m_pTerrain->GetBlockHeight() - 1) * m_pTerrain->GetScale().z;
+    cx    = (long)floorf( Position.x / BlockSizeX );
+    cz    = (long)floorf( Position.z / BlockSizeZ );
+    Rings = (ULONG)ceilf( max( Radius / BlockSizeX, Radius / BlockSizeZ ) );
+
+    // Walk outwards ring by ring, so the nearest blocks are requested first
+    for ( Ring = 0; Ring <= Rings; Ring++ )
+    {
+        Side = (Ring == 0) ? 1 : Ring * 8;
+        for ( i = 0; i < Side; i++ )
+        {
+            long r = (long)Ring, j = (long)i;
+
+            // Position of the i'th block around this ring
+            if      ( Ring == 0 ) { x = cx;               z = cz; }
+            else if ( j < 2 * r ) { x = cx - r + j;       z = cz - r; }
+            else if ( j < 4 * r ) { x = cx + r;           z = cz - r + (j - 2 * r); }
+            else if ( j < 6 * r ) { x = cx + r - (j - 4 * r); z = cz + r; }
+            else                  { x = cx - r;           z = cz + r - (j - 6 * r); }
+
+            // Skip blocks off the edge of the terrain
+            if ( x < 0 || z < 0 || x >= (long)m_pTerrain->GetBlocksWide() || z >= (long)m_pTerrain->GetBlocksHigh() ) continue;
+            pBlock = m_pTerrain->GetBlock( x + z * m_pTerrain->GetBlocksWide() );
+
+            // Skip blocks beyond the radius
+            dx = max( max( pBlock->m_BoundsMin.x - Position.x, Position.x - pBlock->m_BoundsMax.x ), 0.0f );
+            dz = max( max( pBlock->m_BoundsMin.z - Position.z, Position.z - pBlock->m_BoundsMax.z ), 0.0f );
+            if ( dx * dx + dz * dz > Radius * Radius ) continue;
+
+            // Keep resident blocks, and request any others
+            if ( pBlock->m_nPageState == CTerrainBlock::PAGE_RESIDENT )
+                TouchBlock( pBlock );
+            else if ( pBlock->m_nPageState == CTerrainBlock::PAGE_UNLOADED && m_nPendingCount < PAGE_MAX_PENDING )
+                RequestBlock( x + z * m_pTerrain->GetBlocksWide() );
+
+        } // Next Block
+
+    } // Next Ring
+
+    // Evict the least recently used blocks while over budget. Blocks within
+    // the radius this frame are never evicted.
+    pBlock = m_pLRUTail;
+    while ( m_nResidentCount > m_nMaxResident && pBlock && pBlock->m_nPageFrame != m_nFrame )
+    {
+        CTerrainBlock * pPrev = pBlock->m_pPagePrev;
+
+        UnlinkBlock( pBlock );
+        pBlock->ReleaseResources();
+        pBlock->m_nPageState = CTerrainBlock::PAGE_UNLOADED;
+        m_nResidentCount--;
+        pBlock = pPrev;
+
+    } // Next Block
+}
+
+//-----------------------------------------------------------------------------
+// Name : GetOverviewHeight ()
+// Desc : Interpolates the overview at the heightmap position specified. The
+//        result is unscaled, and only as accurate as the block corners.
+//-----------------------------------------------------------------------------
+float CTerrainPager::GetOverviewHeight( float x, float z ) const
+{
+    float fx, fz, h0, h1;
+    ULONG ix, iz;
+
+    // Validate requirements
+    if ( !m_pOverview ) return 0.0f;
+
+    // Position in overview samples, clamped to the overview
+    fx = x / (float)(m_pTerrain->GetBlockWidth()  - 1);
+    fz = z / (float)(m_pTerrain->GetBlockHeight() - 1);
+    fx = min( max( fx, 0.0f ), (float)(m_nOverviewWidth  - 1) );
+    fz = min( max( fz, 0.0f ), (float)(m_nOverviewHeight - 1) );
+    ix = min( (ULONG)fx, m_nOverviewWidth  - 2 );
+    iz = min( (ULONG)fz, m_nOverviewHeight - 2 );
+    fx -= ix;
+    fz -= iz;
+
+    // Bilinear interpolation between the surrounding corners
+    const float * pRow = m_pOverview + ix + iz * m_nOverviewWidth;
+    h0 = pRow[0] + (pRow[1] - pRow[0]) * fx;
+    h1 = pRow[m_nOverviewWidth] + (pRow[m_nOverviewWidth + 1] - pRow[m_nOverviewWidth]) * fx;
+    return h0 + (h1 - h0) * fz;
+}
+
+//-----------------------------------------------------------------------------
+// Name : RequestBlock () (Private)
+// Desc : Queues the block specified for one of the loaders.
+//-----------------------------------------------------------------------------
+void CTerrainPager::RequestBlock( ULONG Block )
+{
+    m_pTerrain->GetBlock( Block )->m_nPageState = CTerrainBlock::PAGE_QUEUED;
+    m_nPendingCount++;
+
+    // Add to the request queue, and wake a loader
+    ::EnterCriticalSection( &m_Lock );
+    m_Requests[ (m_nRequestHead + m_nRequestCount) % PAGE_MAX_PENDING ] = Block;
+    m_nRequestCount++;
+    ::LeaveCriticalSection( &m_Lock );
+    ::ReleaseSemaphore( m_hRequest, 1, NULL );
+}
+
+//-----------------------------------------------------------------------------
+// Name : TouchBlock () (Private)
+// Desc : Marks the resident block specified as used this frame, and moves it
+//        to the head of the LRU list.
+//-----------------------------------------------------------------------------
+void CTerrainPager::TouchBlock( CTerrainBlock * pBlock )
+{
+    pBlock->m_nPageFrame = m_nFrame;
+    if ( m_pLRUHead == pBlock ) return;
+
+    // Move to the head of the list
+    UnlinkBlock( pBlock );
+    pBlock->m_pPageNext = m_pLRUHead;
+    if ( m_pLRUHead ) m_pLRUHead->m_pPagePrev = pBlock;
+    m_pLRUHead = pBlock;
+    if ( !m_pLRUTail ) m_pLRUTail = pBlock;
+}
+
+//-----------------------------------------------------------------------------
+// Name : UnlinkBlock () (Private)
+// Desc : Removes the block specified from the LRU list, if present.
+//-----------------------------------------------------------------------------
+void CTerrainPager::UnlinkBlock( CTerrainBlock * pBlock )
+{
+    if ( pBlock->m_pPagePrev ) pBlock->m_pPagePrev->m_pPageNext = pBlock->m_pPageNext;
+    if ( pBlock->m_pPageNext ) pBlock->m_pPageNext->m_pPagePrev = pBlock->m_pPagePrev;
+    if ( m_pLRUHead == pBlock ) m_pLRUHead = pBlock->m_pPageNext;
+    if ( m_pLRUTail == pBlock ) m_pLRUTail = pBlock->m_pPagePrev;
+
+    pBlock->m_pPagePrev = NULL;
+    pBlock->m_pPageNext = NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Name : StaticLoaderProc () (Private, Static)
+// Desc : Entry point for each loader thread.
+//-----------------------------------------------------------------------------
+unsigned __stdcall CTerrainPager::StaticLoaderProc( void * pParam )
+{
+    ((CTerrainPager*)pParam)->LoaderProc();
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : LoaderProc () (Private)
+// Desc : Loader thread loop. Takes each requested block, reads and builds it,
+//        then passes it back to the main thread for upload.
+//-----------------------------------------------------------------------------
+void CTerrainPager::LoaderProc( )
+{
+    ULONG Block;
+
+    // Each loader reads into its own buffers
+    ULONG          LayerCount  = m_pTerrain->GetLayerCount();
+    UCHAR        * pTile       = new UCHAR[ m_nTileSize ];
+    const UCHAR ** ppBlendMaps = new const UCHAR*[ LayerCount ];
+    UCHAR        * pCoverage   = new UCHAR[ LayerCount * (m_pTerrain->GetBlockWidth() - 1) * (m_pTerrain->GetBlockHeight() - 1) ];
+    const UCHAR ** ppCoverage  = new const UCHAR*[ LayerCount ];
+
+    for ( ; ; )
+    {
+        // Wait for a request
+        ::WaitForSingleObject( m_hRequest, INFINITE );
+        if ( m_bQuit ) break;
+
+        ::EnterCriticalSection( &m_Lock );
+        Block = m_Requests[ m_nRequestHead ];
+        m_nRequestHead = (m_nRequestHead + 1) % PAGE_MAX_PENDING;
+        m_nRequestCount--;
+        ::LeaveCriticalSection( &m_Lock );
+
+        // Build the block, the main thread discards it on failure
+        CTerrainBlock * pBlock = m_pTerrain->GetBlock( Block );
+        if ( pTile && ppBlendMaps && pCoverage && ppCoverage && LoadBlock( Block, pTile, ppBlendMaps, pCoverage, ppCoverage ) )
+            ::InterlockedExchange( &pBlock->m_nPageState, CTerrainBlock::PAGE_BUILT );
+
+        // Pass back to the main thread
+        ::EnterCriticalSection( &m_Lock );
+        m_Completed[ (m_nCompletedHead + m_nCompletedCount) % PAGE_MAX_PENDING ] = Block;
+        m_nCompletedCount++;
+        ::LeaveCriticalSection( &m_Lock );
+
+    } // Next Request
+
+    // Release the buffers
+    if ( pTile       ) delete []pTile;
+    if ( ppBlendMaps ) delete []ppBlendMaps;
+    if ( pCoverage   ) delete []pCoverage;
+    if ( ppCoverage  ) delete []ppCoverage;
+}
+
+//-----------------------------------------------------------------------------
+// Name : LoadBlock () (Private)
+// Desc : Reads the tile data of the block specified and builds it, keeping a
+//        copy of its heights for collision.
+// Note : Called on the loader threads. The tile's coverage maps are built
+//        into 'pCoverage'.
+//-----------------------------------------------------------------------------
+bool CTerrainPager::LoadBlock( ULONG Block, UCHAR * pTile, const UCHAR ** ppBlendMaps, UCHAR * pCoverage, const UCHAR ** ppCoverage )
+{
+    CTerrainBlock * pBlock      = m_pTerrain->GetBlock( Block );
+    ULONG           BlockWidth  = m_pTerrain->GetBlockWidth();
+    ULONG           BlockHeight = m_pTerrain->GetBlockHeight();
+    ULONG           BlendWidth  = (BlockWidth  - 1) * m_pTerrain->GetBlendTexRatio();
+    ULONG           BlendHeight = (BlockHeight - 1) * m_pTerrain->GetBlendTexRatio();
+    ULONG           NormalCount = (BlockWidth + 1) * (BlockHeight + 1);
+    ULONG           QuadCount   = (BlockWidth - 1) * (BlockHeight - 1);
+    BLOCK_SOURCE    Source;
+    USHORT          i;
+
+    // Read the tile
+    if ( !ReadAt( m_hFile, m_nTileStart + (__int64)Block * m_nTileSize, pTile, m_nTileSize ) ) return false;
+
+    // Describe the tile layout
+    Source.pHeights     = (const float*)pTile;
+    Source.HeightPitch  = BlockWidth;
+    Source.pNormalX     = Source.pHeights + BlockWidth * BlockHeight;
+    Source.pNormalY     = Source.pNormalX + NormalCount;
+    Source.pNormalZ     = Source.pNormalY + NormalCount;
+    Source.NormalPitch  = BlockWidth + 1;
+    Source.NormalWidth  = BlockWidth + 1;
+    Source.NormalHeight = BlockHeight + 1;
+    Source.ppBlendMaps  = ppBlendMaps;
+    Source.BlendOffset  = 0;
+    Source.BlendPitch   = BlendWidth;
+    Source.ppCoverage   = ppCoverage;
+    Source.CoverageOffset = 0;
+    Source.CoveragePitch  = BlockWidth - 1;
+    for ( i = 0; i < m_pTerrain->GetLayerCount(); i++ )
+    {
+        ppBlendMaps[i] = (const UCHAR*)(Source.pNormalZ + NormalCount) + i * BlendWidth * BlendHeight;
+        ppCoverage[i]  = pCoverage + i * QuadCount;
+
+        // Summarise each quad of the tile's blend map
+        CTerrainLayer::BuildCoverage( pCoverage + i * QuadCount, BlockWidth - 1, ppBlendMaps[i], BlendWidth,
+                                      BlockWidth - 1, BlockHeight - 1, m_pTerrain->GetBlendTexRatio() );
+
+    } // Next Layer
+
+    // Build the block
+    if ( !pBlock->BuildBlock( m_pTerrain, Source, pBlock->m_nStartX, pBlock->m_nStartZ, BlockWidth, BlockHeight ) ) return false;
+
+    // Keep the heights for GetHeight
+    pBlock->m_pHeights = new float[ BlockWidth * BlockHeight ];
+    if ( !pBlock->m_pHeights ) return false;
+    memcpy( pBlock->m_pHeights, Source.pHeights, BlockWidth * BlockHeight * sizeof(float) );
+
+    // Success!
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : WritePageFile () (Static)
+// Desc : Writes the page file for the terrain specified, one band of block
+//        rows at a time. 'pLoadBand' supplies the heightmap, normal field and
+//        layer blend maps of each band, so that the source data is never
+//        held in memory all at once.
+// Note : Only the terrain's definition (dimensions, block size, blend texture
+//        ratio, scale and layers) is required, its blocks need not exist.
+//        The header is written last, and any partially written file is
+//        deleted on failure.
+//-----------------------------------------------------------------------------
+bool CTerrainPager::WritePageFile( CTerrain * pTerrain, LPCTSTR FileName, unsigned __int64 Hash, PAGEBANDFUNC pLoadBand, void * pContext )
+{
+    PageFileHeader  Header, Blank;
+    PageFileTile  * pTiles      = NULL;
+    float         * pOverview   = NULL;
+    UCHAR         * pTile       = NULL;
+    const UCHAR  ** ppBlendMaps = NULL;
+    CTerrain      * pBand;
+    CTerrainBlock   Block;
+    BLOCK_SOURCE    Source;
+    HANDLE          hFile = INVALID_HANDLE_VALUE;
+    ULONG           i, j, x, z, Level, BandZ, BandEnd, BandRows, BandRow, FirstRow, RowCount, OverviewCount, TileCount;
+    bool            Result = false;
+    PROFILE_ZONE( "CTerrainPager::WritePageFile" );
+
+    // Validate requirements
+    if ( !pTerrain || !pLoadBand || pTerrain->GetBlockWidth() < 2 || pTerrain->GetBlockHeight() < 2 ) return false;
+
+    ULONG         Width       = pTerrain->GetTerrainWidth();
+    ULONG         Height      = pTerrain->GetTerrainHeight();
+    ULONG         BlockWidth  = pTerrain->GetBlockWidth();
+    ULONG         BlockHeight = pTerrain->GetBlockHeight();
+    ULONG         QuadsWide   = BlockWidth  - 1;
+    ULONG         QuadsHigh   = BlockHeight - 1;
+    ULONG         BlendWidth  = QuadsWide * pTerrain->GetBlendTexRatio();
+    ULONG         BlendHeight = QuadsHigh * pTerrain->GetBlendTexRatio();
+    ULONG         NormalCount = (BlockWidth + 1) * (BlockHeight + 1);
+    float         fScaleY     = pTerrain->GetScale().y;
+
+    // Build the header (the block grid is worked out here, as the terrain's
+    // blocks are not allocated until the page file is opened)
+    ZeroMemory( &Header, sizeof(PageFileHeader) );
+    ZeroMemory( &Blank, sizeof(PageFileHeader) );
+    Header.Magic         = PAGE_FILE_MAGIC;
+    Header.Version       = PAGE_FILE_VERSION;
+    Header.TerrainWidth  = Width;
+    Header.TerrainHeight = Height;
+    Header.BlockWidth    = BlockWidth;
+    Header.BlockHeight   = BlockHeight;
+    Header.BlocksWide    = (Width  - 1) / QuadsWide;
+    Header.BlocksHigh    = (Height - 1) / QuadsHigh;
+    Header.BlendTexRatio = pTerrain->GetBlendTexRatio();
+    Header.LayerCount    = pTerrain->GetLayerCount();
+    Header.LODCount      = pTerrain->GetLODCount();
+    Header.TileSize      = GetTileSize( pTerrain );
+    Header.Hash          = Hash;
+    if ( Header.BlocksWide == 0 || Header.BlocksHigh == 0 ) return false;
+
+    // Process as many block rows at once as fit within the band size
+    BandRows = PAGE_BAND_SAMPLES / (Width * QuadsHigh);
+    if ( BandRows < 1 ) BandRows = 1;
+
+    // Allocate the overview and tile table (kept until the end), the tile buffer
+    // and the band's blend and coverage map pointers
+    OverviewCount = (Header.BlocksWide + 1) * (Header.BlocksHigh + 1);
+    TileCount     = Header.BlocksWide * Header.BlocksHigh;
+    pOverview     = new float[ OverviewCount ];
+    pTiles        = new PageFileTile[ TileCount ];
+    pTile         = new UCHAR[ Header.TileSize ];
+    ppBlendMaps   = new const UCHAR*[ Header.LayerCount * 2 ];
+
+    // The block used to measure the detail level errors of each tile
+    Block.m_pParent    = pTerrain;
+    Block.m_nQuadsWide = QuadsWide;
+    Block.m_nQuadsHigh = QuadsHigh;
+
+    for ( ; ; )
+    {
+        if ( !pOverview || !pTiles || !pTile || !ppBlendMaps ) break;
+        ZeroMemory( pOverview, OverviewCount * sizeof(float) );
+        ZeroMemory( pTiles, TileCount * sizeof(PageFileTile) );
+
+        // Create the file
+        hFile = ::CreateFile( FileName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+        if ( hFile == INVALID_HANDLE_VALUE ) break;
+
+        // Reserve the space for the header, overview and tile table
+        if ( !WriteData( hFile, &Blank, sizeof(PageFileHeader) ) ||
+             !WriteData( hFile, pOverview, OverviewCount * sizeof(float) ) ||
+             !WriteData( hFile, pTiles, TileCount * sizeof(PageFileTile) ) ) break;
+
+        // Write the tiles of each band in turn
+        for ( BandZ = 0; BandZ < Header.BlocksHigh; BandZ = BandEnd )
+        {
+            BandEnd = min( BandZ + BandRows, Header.BlocksHigh );
+
+            // The band's blocks cover the rows up to BandEnd * QuadsHigh, and
+            // their normals one row further
+            FirstRow = BandZ * QuadsHigh;
+            RowCount = min( BandEnd * QuadsHigh + 2, Height ) - FirstRow;
+            pBand    = pLoadBand( pContext, FirstRow, RowCount, BandRow );
+            if ( !pBand || pBand->GetLayerCount() != Header.LayerCount ) break;
+
+            for ( i = 0; i < Header.LayerCount; i++ )
+            {
+                ppBlendMaps[i]                     = pBand->GetLayer( (USHORT)i )->m_pBlendMap;
+                ppBlendMaps[i + Header.LayerCount] = pBand->GetLayer( (USHORT)i )->m_pCoverage;
+
+            } // Next Layer
+
+            // Overview heights at the corners of the band's blocks
+            for ( z = BandZ; z <= BandEnd; z++ )
+            {
+                for ( x = 0; x <= Header.BlocksWide; x++ )
+                {
+                    ULONG sx = min( x * QuadsWide, Width  - 1 );
+                    ULONG sz = min( z * QuadsHigh, Height - 1 );
+                    pOverview[ x + z * (Header.BlocksWide + 1) ] = pBand->GetHeightMap()[ sx + (sz - BandRow) * Width ];
+
+                } // Next Column
+
+            } // Next Row
+
+            for ( z = BandZ; z < BandEnd; z++ )
+            {
+                for ( x = 0; x < Header.BlocksWide; x++ )
+                {
+                    PageFileTile & Tile     = pTiles[ x + z * Header.BlocksWide ];
+                    float        * pHeights = (float*)pTile;
+                    float        * pNormalX = pHeights + BlockWidth * BlockHeight;
+                    float        * pNormalY = pNormalX + NormalCount;
+                    float        * pNormalZ = pNormalY + NormalCount;
+                    UCHAR        * pBlend   = (UCHAR*)(pNormalZ + NormalCount);
+
+                    // Locate the block within the band
+                    pBand->GetBlockSource( x * QuadsWide, z * QuadsHigh - BandRow, Source, ppBlendMaps, ppBlendMaps + Header.LayerCount );
+
+                    // Heights, measuring their unscaled range
+                    Tile.MinY =  FLT_MAX;
+                    Tile.MaxY = -FLT_MAX;
+                    for ( j = 0; j < BlockHeight; j++ )
+                    {
+                        memcpy( pHeights + j * BlockWidth, Source.pHeights + j * Source.HeightPitch, BlockWidth * sizeof(float) );
+                        for ( i = 0; i < BlockWidth; i++ )
+                        {
+                            float h = pHeights[ i + j * BlockWidth ];
+                            if ( h < Tile.MinY ) Tile.MinY = h;
+                            if ( h > Tile.MaxY ) Tile.MaxY = h;
+
+                        } // Next Column
+
+                    } // Next Row
+
+                    // Normals, including the extra row and column used for lighting
+                    for ( j = 0; j <= BlockHeight; j++ )
+                    {
+                        for ( i = 0; i <= BlockWidth; i++, pNormalX++, pNormalY++, pNormalZ++ )
+                        {
+                            // Normals beyond the edge of the terrain point up
+                            if ( i >= Source.NormalWidth || j >= Source.NormalHeight ) { *pNormalX = 0.0f; *pNormalY = 1.0f; *pNormalZ = 0.0f; continue; }
+
+                            *pNormalX = Source.pNormalX[ i + j * Source.NormalPitch ];
+                            *pNormalY = Source.pNormalY[ i + j * Source.NormalPitch ];
+                            *pNormalZ = Source.pNormalZ[ i + j * Source.NormalPitch ];
+
+                        } // Next Column
+
+                    } // Next Row
+
+                    // Blend maps
+                    for ( i = 0; i < Header.LayerCount; i++ )
+                    {
+                        for ( j = 0; j < BlendHeight; j++, pBlend += BlendWidth )
+                            memcpy( pBlend, Source.ppBlendMaps[i] + Source.BlendOffset + j * Source.BlendPitch, BlendWidth );
+
+                    } // Next Layer
+
+                    // Store the unscaled detail level errors
+                    Block.CalculateLODErrors( Source );
+                    for ( Level = 0; Level < TERRAIN_MAX_LOD; Level++ )
+                    {
+                        if ( Level < Header.LODCount && fScaleY != 0.0f )
+                            Tile.LODError[Level] = fabsf( Block.m_fLODError[Level] / fScaleY );
+                        else
+                            Tile.LODError[Level] = 0.0f;
+
+                    } // Next Level
+
+                    if ( !WriteData( hFile, pTile, Header.TileSize ) ) break;
+
+                } // Next Column
+                if ( x < Header.BlocksWide ) break;
+
+            } // Next Block Row
+            if ( z < BandEnd ) break;
+
+        } // Next Band
+        if ( BandZ < Header.BlocksHigh ) break;
+
+        // Fill in the space reserved at the start of the file
+        if ( ::SetFilePointer( hFile, 0, NULL, FILE_BEGIN ) != 0 ) break;
+        if ( !WriteData( hFile, &Header, sizeof(PageFileHeader) ) ||
+             !WriteData( hFile, pOverview, OverviewCount * sizeof(float) ) ||
+             !WriteData( hFile, pTiles, TileCount * sizeof(PageFileTile) ) ) break;
+
+        // Success!
+        Result = true;
+        break;
+
+    } // Write Once
+
+    // Close the file, removing it if it is incomplete
+    if ( hFile != INVALID_HANDLE_VALUE )
+    {
+        ::CloseHandle( hFile );
+        if ( !Result ) ::DeleteFile( FileName );
+
+    } // End if file created
+
+    // Release the buffers
+    if ( pOverview   ) delete []pOverview;
+    if ( pTiles      ) delete []pTiles;
+    if ( pTile       ) delete []pTile;
+    if ( ppBlendMaps ) delete []ppBlendMaps;
+    return Result;
+}
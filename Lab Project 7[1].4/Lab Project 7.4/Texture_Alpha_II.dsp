@@ -43,7 +43,7 @@ RSC=rc.exe
 # PROP Ignore_Export_Lib 0
 # PROP Target_Dir ""
 # ADD BASE CPP /nologo /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /c
-# ADD CPP /nologo /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /c
+# ADD CPP /nologo /MT /W3 /GX /O2 /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /c
 # SUBTRACT CPP /Fr
 # ADD BASE MTL /nologo /D "NDEBUG" /mktyplib203 /win32
 # ADD MTL /nologo /D "NDEBUG" /mktyplib203 /win32
@@ -70,7 +70,7 @@ LINK32=link.exe
 # PROP Ignore_Export_Lib 0
 # PROP Target_Dir ""
 # ADD BASE CPP /nologo /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /GZ /c
-# ADD CPP /nologo /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /GZ /c
+# ADD CPP /nologo /MTd /W3 /Gm /GX /ZI /Od /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_MBCS" /YX /FD /GZ /c
 # SUBTRACT CPP /Fr
 # ADD BASE MTL /nologo /D "_DEBUG" /mktyplib203 /win32
 # ADD MTL /nologo /D "_DEBUG" /mktyplib203 /win32
@@ -118,10 +118,22 @@ SOURCE=.\Source\CPlayer.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\Source\CProfiler.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\Source\CTerrain.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\Source\CTerrainPager.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\Source\CThreadPool.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\Source\CTimer.cpp
 # End Source File
 # Begin Source File
@@ -158,10 +170,22 @@ SOURCE=.\Includes\CPlayer.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\Includes\CProfiler.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\Includes\CTerrain.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\Includes\CTerrainPager.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\Includes\CThreadPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\Includes\CTimer.h
 # End Source File
 # Begin Source File